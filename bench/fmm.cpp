@@ -0,0 +1,62 @@
+/// Accuracy versus cost of the fast multipole solver, against the direct summation.
+/// For each dimension, number of particles and expansion order, prints the time of one force evaluation
+/// and the relative RMS error of the forces.
+#include <chrono>
+#include <random>
+#include <vector>
+#include <iostream>
+#include "quark/world/long_range/direct_summation.hpp"
+#include "quark/world/long_range/fmm.hpp"
+
+template<unsigned int D>
+std::vector<Particle<D>> generateParticles(unsigned int count) {
+    std::default_random_engine rnd{42};
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+    std::vector<Particle<D>> particles(count);
+    for(unsigned int i = 0; i < count; i++) {
+        Vector<double, D> pos = Vector<double, D>([&]() { return dist(rnd); });
+        particles[i] = Particle<D>(pos, Vector<double, D>(), Vector<double, D>(), 0.5 + dist(rnd));
+    }
+    return particles;
+}
+
+template<typename Solver, unsigned int D>
+double timeSolver(Solver& solver, std::vector<Particle<D>>& particles) {
+    for(Particle<D>& particle: particles) {
+        particle.resetForce();
+    }
+    auto start = std::chrono::steady_clock::now();
+    solver.addForces(particles.data(), particles.size(), 0.0);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template<unsigned int D>
+void benchmark(unsigned int count) {
+    std::vector<Particle<D>> reference = generateParticles<D>(count);
+    DirectSummationSolver<D> direct(1.0);
+    double direct_time = timeSolver(direct, reference);
+    std::cout << "D=" << D << " N=" << count << " direct: " << direct_time << "s" << std::endl;
+
+    for(unsigned int order = 2; order <= 8; order += 2) {
+        std::vector<Particle<D>> particles = generateParticles<D>(count);
+        FastMultipoleSolver<D> fmm(1.0, order);
+        double fmm_time = timeSolver(fmm, particles);
+        double error_sq = 0;
+        double norm_sq = 0;
+        for(unsigned int i = 0; i < count; i++) {
+            error_sq += (particles[i].getForce() - reference[i].getForce()).sq_magnitude();
+            norm_sq += reference[i].getForce().sq_magnitude();
+        }
+        std::cout << "    order " << order << ": " << fmm_time << "s, relative error " << sqrt(error_sq / norm_sq)
+                  << ", energy error " << std::abs(fmm.getPotentialEnergy() / direct.getPotentialEnergy() - 1) << std::endl;
+    }
+}
+
+int main() {
+    for(unsigned int count: {1000, 4000, 16000}) {
+        benchmark<2>(count);
+    }
+    for(unsigned int count: {1000, 4000, 16000}) {
+        benchmark<3>(count);
+    }
+}
@@ -0,0 +1,173 @@
+/// Accuracy versus cost of the integrators, on reference scenes: a solar system, a warm Lennard-Jones crystal and a collision.
+/// For each scene, integrator, time step and kernel variant, prints the energy drift, the momentum drift
+/// and the wall time per simulated time unit, then the cheapest settings within the error budget.
+/// Usage: integrators_bench [energy budget, 1e-4 by default] [thread count, 1 by default]
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <iomanip>
+#include <iostream>
+#include "quark/world/universe.hpp"
+#include "quark/world/initializers.hpp"
+#include "quark/world/interactions/gravity.hpp"
+#include "quark/world/interactions/lennard_jones.hpp"
+#include "quark/world/integrators/stormer_verlet.hpp"
+#include "quark/world/integrators/forest_ruth.hpp"
+#include "quark/world/integrators/runge_kutta.hpp"
+#include "quark/world/analysis/energy.hpp"
+
+const char* INTEGRATORS[] = {"stormer_verlet", "position_verlet", "forest_ruth", "runge_kutta"};
+
+/// @brief A way to run the force kernel of the universe.
+struct Variant {
+    const char* name;
+    GRID_TYPE grid_type;
+    unsigned int cell_division;
+    bool reproducible;
+};
+
+const Variant VARIANTS[] = {
+    {"dense", GRID_TYPE::dense, 1, false},
+    {"sparse", GRID_TYPE::sparse, 1, false},
+    {"cells2", GRID_TYPE::dense, 2, false},
+    {"reproducible", GRID_TYPE::dense, 1, true},
+};
+
+struct Result {
+    std::string integrator;
+    std::string variant;
+    double delta_time;
+    double energy_drift;
+    double momentum_drift;
+    double seconds_per_time_unit;
+};
+
+template<unsigned int D>
+std::unique_ptr<Integrator<D>> createIntegrator(const std::string& name) {
+    if(name == "position_verlet") {
+        return std::make_unique<PositionVerletIntegrator<D>>();
+    }
+    if(name == "forest_ruth") {
+        return std::make_unique<ForestRuthIntegrator<D>>();
+    }
+    if(name == "runge_kutta") {
+        return std::make_unique<RungeKuttaIntegrator<D>>();
+    }
+    return std::make_unique<StormerVerletIntegrator<D>>();
+}
+
+/// @brief Runs a scene for a duration, sampling the energy a hundred times.
+template<unsigned int D, unsigned int N, double LD, double RCUT>
+Result measure(const std::vector<Particle<D>>& particles, Interactor<D>* interactor, const std::string& integrator_name,
+               const Variant& variant, double delta_time, double duration, unsigned int thread_count) {
+    auto universe = std::make_unique<Universe<D, N, LD, RCUT>>(particles.data(), particles.size());
+    std::unique_ptr<Integrator<D>> integrator = createIntegrator<D>(integrator_name);
+    universe->setIntegrator(integrator.get());
+    universe->registerInteractor(interactor);
+    universe->setGridType(variant.grid_type);
+    universe->setCellDivision(variant.cell_division);
+    universe->setReproducible(variant.reproducible);
+    universe->setThreadCount(thread_count);
+    EnergyTracker<D> tracker(RCUT);
+    tracker.registerInteractor(interactor);
+    universe->registerPairAnalyzer(&tracker);
+    universe->registerStepAnalyzer(&tracker);
+    unsigned int steps = (unsigned int)round(duration / delta_time);
+    universe->setAnalysisInterval(std::max(steps / 100, 1u));
+    auto start = std::chrono::steady_clock::now();
+    for(unsigned int step = 0; step < steps; step++) {
+        universe->step(delta_time);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return Result{integrator_name, variant.name, delta_time, tracker.getEnergyDrift(), tracker.getMomentumDrift(), seconds / duration};
+}
+
+/// @brief Runs every integrator, time step and variant of a scene, and prints the results.
+template<unsigned int D, unsigned int N, double LD, double RCUT>
+void benchmark(const std::string& scene, const std::vector<Particle<D>>& particles, Interactor<D>* interactor,
+               const std::vector<double>& delta_times, unsigned int variant_count, double duration, double budget, unsigned int thread_count) {
+    std::cout << scene << ": " << particles.size() << " particles for " << duration << " time units" << std::endl;
+    std::cout << "    " << std::left << std::setw(16) << "integrator" << std::setw(14) << "variant" << std::setw(10) << "dt"
+              << std::setw(14) << "energy drift" << std::setw(16) << "momentum drift" << "s / time unit" << std::endl;
+    std::vector<Result> results;
+    for(const char* integrator: INTEGRATORS) {
+        for(double delta_time: delta_times) {
+            for(unsigned int variant = 0; variant < variant_count; variant++) {
+                Result result = measure<D, N, LD, RCUT>(particles, interactor, integrator, VARIANTS[variant], delta_time, duration, thread_count);
+                std::cout << "    " << std::setw(16) << result.integrator << std::setw(14) << result.variant << std::setw(10) << result.delta_time
+                          << std::setw(14) << result.energy_drift << std::setw(16) << result.momentum_drift << result.seconds_per_time_unit << std::endl;
+                results.push_back(result);
+            }
+        }
+    }
+    const Result* cheapest = nullptr;
+    for(const Result& result: results) {
+        if(result.energy_drift <= budget && (cheapest == nullptr || result.seconds_per_time_unit < cheapest->seconds_per_time_unit)) {
+            cheapest = &result;
+        }
+    }
+    if(cheapest == nullptr) {
+        std::cout << "    no settings within an energy drift of " << budget << std::endl << std::endl;
+    }
+    else {
+        std::cout << "    cheapest within " << budget << ": " << cheapest->integrator << ", " << cheapest->variant
+                  << ", dt " << cheapest->delta_time << std::endl << std::endl;
+    }
+}
+
+/// @brief A sun, two planets and an eccentric comet, with G = 1. The orbit of the inner planet lasts 2 pi.
+std::vector<Particle<2>> solarSystem() {
+    double positions[4][2] = {{50, 50}, {51, 50}, {55.2, 50}, {60, 50}};
+    double velocities[4][2] = {{0, 0}, {0, 1}, {0, sqrt(1 / 5.2)}, {0, 0.15}};
+    double masses[4] = {1, 0.000003, 0.000955, 0.00000001};
+    std::vector<Particle<2>> particles;
+    for(unsigned int i = 0; i < 4; i++) {
+        particles.push_back(Particle<2>(i, Vector<double, 2>(positions[i]), Vector<double, 2>(velocities[i]), masses[i]));
+    }
+    return particles;
+}
+
+/// @brief A triangular Lennard-Jones crystal, with thermal motion.
+std::vector<Particle<2>> crystal() {
+    const double spacing = 1.12246204831;
+    std::vector<Particle<2>> particles;
+    for(unsigned int row = 0; row < 30; row++) {
+        for(unsigned int column = 0; column < 30; column++) {
+            double position[2] = {20 + (column + 0.5 * (row % 2)) * spacing, 20 + row * spacing * sqrt(3) / 2};
+            particles.push_back(Particle<2>(particles.size(), Vector<double, 2>(position), Vector<double, 2>(), 1.0));
+        }
+    }
+    Initializers::maxwellBoltzmann<2>(particles.data(), particles.size(), 0.05, 11);
+    return particles;
+}
+
+/// @brief A small block thrown at a larger one, like the collision demo.
+std::vector<Particle<2>> collision() {
+    const double spacing = 1.12246204831;
+    std::vector<Particle<2>> particles(10 * 10 + 40 * 10);
+    double cube_corner[2] = {40 - 5 * spacing, 10};
+    unsigned int cube_cells[2] = {10, 10};
+    unsigned int cube_count = Initializers::cubic<2>(particles.data(), Vector<double, 2>(cube_corner), Vector<unsigned int, 2>(cube_cells), spacing);
+    double velocity[2] = {0, 10};
+    for(unsigned int i = 0; i < cube_count; i++) {
+        particles[i].setVelocity(Vector<double, 2>(velocity));
+    }
+    double rectangle_corner[2] = {40 - 20 * spacing, 30};
+    unsigned int rectangle_cells[2] = {40, 10};
+    Initializers::cubic<2>(particles.data() + cube_count, Vector<double, 2>(rectangle_corner), Vector<unsigned int, 2>(rectangle_cells), spacing);
+    return particles;
+}
+
+int main(int argc, char** argv) {
+    double budget = argc > 1 ? std::stod(argv[1]) : 1e-4;
+    unsigned int thread_count = argc > 2 ? std::stoi(argv[2]) : 1;
+
+    // the whole system is in one chunk, so every pair interacts
+    GravityInteractor<2> gravity(1.0);
+    benchmark<2, 4, 100.0, 100.0>("solar system", solarSystem(), &gravity, {0.02, 0.01, 0.005}, 1, 20.0, budget, thread_count);
+
+    LennardJonesInteractor<2> lennard_jones;
+    benchmark<2, 900, 80.0, 2.5>("crystal", crystal(), &lennard_jones, {0.005, 0.0025, 0.00125}, 4, 2.0, budget, thread_count);
+    benchmark<2, 500, 80.0, 2.5>("collision", collision(), &lennard_jones, {0.002, 0.001, 0.0005}, 4, 2.0, budget, thread_count);
+}
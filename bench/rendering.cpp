@@ -0,0 +1,79 @@
+/// Cost of drawing the particles with the SDL visualizer, for each render and colour mode.
+/// Runs on the dummy video driver and the software renderer by default, so it works without a display:
+/// set SDL_VIDEODRIVER to measure on a real one.
+/// Then draws a large universe zoomed out and in: only the chunks in the view port are gone through, and the chunks
+/// smaller than a pixel are drawn from their particle count, so the frame time follows what is on the screen.
+#include <chrono>
+#include <memory>
+#include <cstdlib>
+#include <iostream>
+#include "quark/world/universe.hpp"
+#include "quark/world/snapshot.hpp"
+#include "quark/world/initializers.hpp"
+#include "quark/visualizer/sdl/sdl_visualizer.hpp"
+
+const unsigned int FRAMES = 20;
+
+constexpr unsigned int LARGE_COUNT = 2000000;
+constexpr double LARGE_LENGTH = 2000.0;
+typedef Universe<2, LARGE_COUNT, LARGE_LENGTH, 2.5> LargeUniverse;
+
+template<typename Drawn>
+double timeDraw(SDLVisualizer<Drawn>& visualizer, Drawn& drawn) {
+    // one frame to warm the buffers up
+    visualizer.draw(&drawn);
+    auto start = std::chrono::steady_clock::now();
+    for(unsigned int frame = 0; frame < FRAMES; frame++) {
+        visualizer.draw(&drawn);
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / FRAMES;
+}
+
+int main() {
+    setenv("SDL_VIDEODRIVER", "dummy", 0);
+    SDLVisualizer<Snapshot<2>> visualizer = SDLVisualizer<Snapshot<2>>();
+    double size[2] = {100, 100};
+    visualizer.setViewportSize(size);
+
+    std::cout << "particles\tmode\tms per frame" << std::endl;
+    for(unsigned int count: {10000u, 100000u, 1000000u}) {
+        std::vector<Particle<2>> particles(count);
+        Initializers::uniform<2>(particles.data(), count, Vector<double, 2>(), Vector<double, 2>(size), 1);
+        Initializers::maxwellBoltzmann<2>(particles.data(), count, 1.0, 2);
+        Snapshot<2> snapshot;
+        snapshot.capture(particles.begin(), particles.end(), 0, 0.0);
+
+        visualizer.setRenderMode(RENDER_MODE::points);
+        std::cout << count << "\tpoints\t" << timeDraw(visualizer, snapshot) * 1e3 << std::endl;
+        visualizer.setRenderMode(RENDER_MODE::framebuffer);
+        visualizer.setColorMode(COLOR_MODE::plain);
+        std::cout << count << "\tframebuffer\t" << timeDraw(visualizer, snapshot) * 1e3 << std::endl;
+        visualizer.setColorMode(COLOR_MODE::density);
+        std::cout << count << "\tdensity\t" << timeDraw(visualizer, snapshot) * 1e3 << std::endl;
+        visualizer.setColorMode(COLOR_MODE::velocity);
+        std::cout << count << "\tvelocity\t" << timeDraw(visualizer, snapshot) * 1e3 << std::endl;
+    }
+
+    // zoomed out to twice the universe, its chunks are half a pixel wide
+    std::cout << std::endl << "universe of " << LARGE_COUNT << " particles" << std::endl;
+    std::cout << "view width\tmode\tms per frame" << std::endl;
+    std::vector<Particle<2>> particles(LARGE_COUNT);
+    double large_size[2] = {LARGE_LENGTH, LARGE_LENGTH};
+    Initializers::uniform<2>(particles.data(), particles.size(), Vector<double, 2>(), Vector<double, 2>(large_size), 3);
+    auto universe = std::make_unique<LargeUniverse>(particles.data(), particles.size());
+    SDLVisualizer<LargeUniverse> universe_visualizer = SDLVisualizer<LargeUniverse>();
+    for(double width: {2 * LARGE_LENGTH, LARGE_LENGTH, LARGE_LENGTH / 4, LARGE_LENGTH / 40}) {
+        double corner[2] = {(LARGE_LENGTH - width) / 2, (LARGE_LENGTH - width) / 2};
+        double view_size[2] = {width, width * 450 / 800};
+        universe_visualizer.setViewportCorner(corner);
+        universe_visualizer.setViewportSize(view_size);
+        universe_visualizer.setRenderMode(RENDER_MODE::points);
+        std::cout << width << "\tpoints\t" << timeDraw(universe_visualizer, *universe) * 1e3 << std::endl;
+        universe_visualizer.setRenderMode(RENDER_MODE::framebuffer);
+        universe_visualizer.setColorMode(COLOR_MODE::density);
+        std::cout << width << "\tdensity\t" << timeDraw(universe_visualizer, *universe) * 1e3 << std::endl;
+        // no aggregation for the velocity colour
+        universe_visualizer.setColorMode(COLOR_MODE::velocity);
+        std::cout << width << "\tvelocity\t" << timeDraw(universe_visualizer, *universe) * 1e3 << std::endl;
+    }
+}
@@ -31,29 +31,19 @@ int main() {
 
     double spacing = 1.12246204831;
 
-    // small cube 
-    for(unsigned int i = 0; i < 40; i++) {
-        for(unsigned int j = 0; j < 40; j++) {
-            double pos[2] {125 - 20 * spacing + i * spacing, 20 + j * spacing};
-            double vel[2] {0, 10};
-            Vector<double, 2> pos_vec(pos);
-            Vector<double, 2> vel_vec(vel);
-            Vector<double, 2> force_vec = Vector<double, 2>();
-            arrayParticles[i * 40 + j] = Particle<2>(pos_vec, vel_vec, force_vec, 1);
-        }
+    // small cube, thrown at the rectangle
+    double cube_corner[2] {125 - 20 * spacing, 20};
+    unsigned int cube_cells[2] {40, 40};
+    unsigned int cube_count = Initializers::cubic<2>(arrayParticles, Vector<double, 2>(cube_corner), Vector<unsigned int, 2>(cube_cells), spacing);
+    double vel[2] {0, 10};
+    for(unsigned int i = 0; i < cube_count; i++) {
+        arrayParticles[i].setVelocity(Vector<double, 2>(vel));
     }
 
     // large rectangle
-    for(unsigned int i = 0; i < 160; i++) {
-        for(unsigned int j = 0; j < 40; j++) {
-            double pos[2] {125 - 80 * spacing + i * spacing, 100 + j * spacing};
-            double vel[2] {0, 0};
-            Vector<double, 2> pos_vec(pos);
-            Vector<double, 2> vel_vec(vel);
-            Vector<double, 2> force_vec = Vector<double, 2>();
-            arrayParticles[1600 + i * 40 + j] = Particle<2>(pos_vec, vel_vec, force_vec, 1);
-        }
-    }
+    double rectangle_corner[2] {125 - 80 * spacing, 100};
+    unsigned int rectangle_cells[2] {160, 40};
+    Initializers::cubic<2>(arrayParticles + cube_count, Vector<double, 2>(rectangle_corner), Vector<unsigned int, 2>(rectangle_cells), spacing);
 
     // create the universe
     MyUniverse universe(arrayParticles);
@@ -74,9 +64,18 @@ int main() {
     unsigned int dim[2] {0, 1};
     visualizer.setViewportDimensions(dim);
 
+    // fragments: particles closer than 1.5 sigma are bound, checked every 500 steps
+    ClusterAnalyzer<2> fragments(1.5);
+    universe.registerPairAnalyzer(&fragments);
+    universe.setAnalysisInterval(500);
+
     // main simulation loop
     for(unsigned int i = 0; i < 400000; i++) {
         universe.step(0.00005); // simulate hour by hour 
+        if(i % 20000 == 0) {
+            std::cout << "step " << i << ": " << fragments.getClusterCount() << " fragments, largest of "
+                << fragments.getLargestClusterSize() << " particles" << std::endl;
+        }
     }
 
 
@@ -0,0 +1,84 @@
+#include "quark/quark.hpp"
+
+/*
+
+Sweeps the impact velocity of the collision demo, on a smaller scale :
+each member drops a small square on a rectangle at a different speed,
+until the square stops catching up with the rectangle or the step limit is reached.
+All the members run at once on a shared thread pool.
+
+    member  steps  kinetic energy left at the end
+
+*/
+
+typedef Universe<2, 500, 60.0, 2.5> MyUniverse;
+
+// interactors hold no state, so every member can share them
+GravityInteractor<2> grav_interactor = GravityInteractor<2>();
+LennardJonesInteractor<2> lj_interactor = LennardJonesInteractor<2>();
+
+const unsigned int SQUARE_PARTICLES = 100;
+
+MyUniverse* createMember(unsigned int member) {
+    Particle<2> arrayParticles[500];
+    double spacing = 1.12246204831;
+    double speed = 5.0 + member * 0.5;
+
+    // small square
+    for(unsigned int i = 0; i < 10; i++) {
+        for(unsigned int j = 0; j < 10; j++) {
+            double pos[2] {30 - 5 * spacing + i * spacing, 10 + j * spacing};
+            double vel[2] {0, speed};
+            arrayParticles[i * 10 + j] = Particle<2>(Vector<double, 2>(pos), Vector<double, 2>(vel), Vector<double, 2>(), 1);
+        }
+    }
+
+    // large rectangle
+    for(unsigned int i = 0; i < 40; i++) {
+        for(unsigned int j = 0; j < 10; j++) {
+            double pos[2] {30 - 20 * spacing + i * spacing, 30 + j * spacing};
+            double vel[2] {0, 0};
+            arrayParticles[SQUARE_PARTICLES + i * 10 + j] = Particle<2>(Vector<double, 2>(pos), Vector<double, 2>(vel), Vector<double, 2>(), 1);
+        }
+    }
+
+    MyUniverse* universe = new MyUniverse(arrayParticles);
+    universe->set_border_type(BORDER_TYPE::reflexive);
+    universe->registerInteractor(&grav_interactor);
+    universe->registerInteractor(&lj_interactor);
+    return universe;
+}
+
+int main() {
+    Ensemble<MyUniverse, double> ensemble(16, createMember, [](unsigned int member, MyUniverse& universe, unsigned int steps) {
+        double energy = 0;
+        for(const Particle<2>& particle: universe.getParticles()) {
+            energy += 0.5 * particle.getMass() * particle.getVelocity().sq_magnitude();
+        }
+        return energy;
+    });
+    ensemble.setTimeStep(0.0002);
+    // slower squares take longer to reach the rectangle
+    ensemble.setMaxSteps([](unsigned int member) { return 30000u - member * 500u; });
+    // stop once the square is no faster than the rectangle : the impact is over
+    ensemble.setStopCondition([](unsigned int member, MyUniverse& universe, unsigned int step) {
+        if(step % 100 != 0) {
+            return false;
+        }
+        double square_velocity = 0;
+        double rectangle_velocity = 0;
+        const auto& particles = universe.getParticles();
+        for(unsigned int i = 0; i < particles.size(); i++) {
+            if(i < SQUARE_PARTICLES) {
+                square_velocity += particles[i].getVelocity()[1] / SQUARE_PARTICLES;
+            }
+            else {
+                rectangle_velocity += particles[i].getVelocity()[1] / (particles.size() - SQUARE_PARTICLES);
+            }
+        }
+        return square_velocity <= rectangle_velocity;
+    });
+
+    ensemble.run();
+    ensemble.writeResults(std::cout);
+}
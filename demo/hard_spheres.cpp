@@ -0,0 +1,50 @@
+#include "quark/quark.hpp"
+
+/*
+
+The collision demo, with hard disks instead of Lennard-Jones particles.
+There is no time step to resolve the collisions: the universe jumps from one collision to the next,
+so each frame can cover a much longer time.
+
+*/
+
+int main() {
+    // create a universe, a visualizer, and register it
+    typedef HardSphereUniverse<2, 8000, 250.0> MyUniverse;
+
+    Particle<2> arrayParticles[8000];
+
+    double spacing = 1.12246204831;
+
+    // small cube, thrown at the rectangle
+    double cube_corner[2] {125 - 20 * spacing, 20};
+    unsigned int cube_cells[2] {40, 40};
+    unsigned int cube_count = Initializers::cubic<2>(arrayParticles, Vector<double, 2>(cube_corner), Vector<unsigned int, 2>(cube_cells), spacing);
+    double vel[2] {0, 10};
+    for(unsigned int i = 0; i < cube_count; i++) {
+        arrayParticles[i].setVelocity(Vector<double, 2>(vel));
+    }
+
+    // large rectangle
+    double rectangle_corner[2] {125 - 80 * spacing, 100};
+    unsigned int rectangle_cells[2] {160, 40};
+    Initializers::cubic<2>(arrayParticles + cube_count, Vector<double, 2>(rectangle_corner), Vector<unsigned int, 2>(rectangle_cells), spacing);
+
+    // create the universe, with disks of diameter 1 and slightly inelastic collisions
+    MyUniverse universe(arrayParticles, 1.0);
+    universe.setRestitution(0.95);
+
+    // visualizer
+    SDLVisualizer<MyUniverse> visualizer = SDLVisualizer<MyUniverse>();
+    universe.registerVisualizer(&visualizer);
+
+    double size[2] = {250, 150};
+    visualizer.setViewportSize(size);
+    unsigned int dim[2] {0, 1};
+    visualizer.setViewportDimensions(dim);
+
+    // main simulation loop
+    for(unsigned int i = 0; i < 4000; i++) {
+        universe.step(0.005);
+    }
+}
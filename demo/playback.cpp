@@ -0,0 +1,70 @@
+#include <string>
+#include <memory>
+#include "quark/quark.hpp"
+
+/*
+
+Plays back a recorded 2D run in a window, without simulating it again.
+
+    playback <trajectory.qtrj | vtu prefix> [speed] [first frame]
+
+A path ending with .qtrj is read as a trajectory written by a TrajectoryVisualizer,
+anything else as the prefix of the .vtu files written by an XMLVisualizer.
+
+*/
+
+int main(int argc, char** argv) {
+    if(argc < 2) {
+        std::cout << "usage: playback <trajectory.qtrj | vtu prefix> [speed] [first frame]" << std::endl;
+        return 1;
+    }
+    std::string path = argv[1];
+    double speed = argc > 2 ? std::stod(argv[2]) : 1.0;
+    unsigned int first_frame = argc > 3 ? std::stoul(argv[3]) : 0;
+
+    // declared before the playback, so it outlives the prefetch thread
+    std::unique_ptr<FrameSource<2>> source;
+    if(path.size() > 5 && path.substr(path.size() - 5) == ".qtrj") {
+        source = std::make_unique<TrajectoryFrameSource<2>>(path);
+    }
+    else {
+        source = std::make_unique<VTUFrameSource<2>>(path);
+    }
+    if(source->getFrameCount() == 0) {
+        std::cout << "ERROR : No frame to play." << std::endl;
+        return 1;
+    }
+
+    // frame the particles of the first frame in the view port.
+    // read before the playback starts, as its prefetch thread is then the only one using the source
+    std::vector<Particle<2>> particles;
+    source->readFrame(first_frame, particles);
+    double corner[2] = {0, 0};
+    double size[2] = {1, 1};
+    if(!particles.empty()) {
+        double max_corner[2] = {particles[0].getPosition()[0], particles[0].getPosition()[1]};
+        corner[0] = max_corner[0];
+        corner[1] = max_corner[1];
+        for(auto particle: particles) {
+            for(unsigned int dim = 0; dim < 2; dim++) {
+                corner[dim] = std::min(corner[dim], particle.getPosition()[dim]);
+                max_corner[dim] = std::max(max_corner[dim], particle.getPosition()[dim]);
+            }
+        }
+        for(unsigned int dim = 0; dim < 2; dim++) {
+            size[dim] = std::max(max_corner[dim] - corner[dim], 1e-9) * 1.2;
+            corner[dim] -= size[dim] / 12;
+        }
+    }
+
+    Playback<2> playback(source.get());
+    playback.setSpeed(speed);
+    playback.seek(first_frame);
+
+    SDLVisualizer<Playback<2>> visualizer = SDLVisualizer<Playback<2>>();
+    visualizer.setViewportCorner(corner);
+    visualizer.setViewportSize(size);
+    playback.registerVisualizer(&visualizer);
+
+    while(playback.step()) {}
+}
@@ -0,0 +1,128 @@
+#include <string>
+#include "quark/quark.hpp"
+
+/*
+
+Runs a scenario file, or writes the scenarios of the demos as files to start from.
+
+    scenario <file.qsc>
+    scenario write <collision | falling> <file.qsc>
+
+The header of a scenario file is text, and can be edited to change the physics, the border or the outputs:
+
+    output sdl <viewport width> <viewport height>
+    output trajectory <file.qtrj>
+    output shared_memory <segment name, like /quark>, shown by the shm_viewer program
+
+The length, cut distance and capacity of a universe are template parameters: this program is built with
+the universe types listed in main, and a scenario must match one of them.
+
+*/
+
+/// @brief Creates the universe of the scenario with the outputs of its header, and steps it.
+template<unsigned int N, double LD, double RCUT>
+int run(Scenario<2>& scenario) {
+    typedef Universe<2, N, LD, RCUT> ScenarioUniverse;
+    auto load_start = std::chrono::steady_clock::now();
+    ScenarioUniverse* universe = scenario.createUniverse<N, LD, RCUT>();
+    if(universe == nullptr) {
+        return 1;
+    }
+    double load_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - load_start).count();
+    std::cout << "loaded " << universe->getActiveCount() << " particles in " << load_time << " s" << std::endl;
+
+    std::vector<std::unique_ptr<Visualizer<ScenarioUniverse>>> visualizers;
+    for(const ScenarioSettings::Directive& output: scenario.getSettings().outputs) {
+        if(output[0] == "sdl" && output.size() == 3) {
+            SDLVisualizer<ScenarioUniverse>* visualizer = new SDLVisualizer<ScenarioUniverse>();
+            double size[2] = {std::stod(output[1]), std::stod(output[2])};
+            visualizer->setViewportSize(size);
+            unsigned int dim[2] {0, 1};
+            visualizer->setViewportDimensions(dim);
+            visualizers.emplace_back(visualizer);
+        }
+        else if(output[0] == "trajectory" && output.size() == 2) {
+            visualizers.emplace_back(new TrajectoryVisualizer<ScenarioUniverse>(output[1]));
+        }
+        else if(output[0] == "shared_memory" && output.size() == 2) {
+            visualizers.emplace_back(new SharedMemoryVisualizer<ScenarioUniverse>(output[1], universe->getActiveCount()));
+        }
+        else {
+            std::cout << "ERROR : Unknown output: " << output[0] << std::endl;
+            delete universe;
+            return 1;
+        }
+        universe->registerVisualizer(visualizers.back().get());
+    }
+
+    for(unsigned long i = 0; i < scenario.getSettings().steps; i++) {
+        universe->step(scenario.getSettings().time_step);
+    }
+    delete universe;
+    return 0;
+}
+
+/// @brief The collision and falling demos, as scenario files.
+int write(std::string name, std::string file_name) {
+    ScenarioSettings settings;
+    settings.length = 250.0;
+    settings.cut = 2.5;
+    settings.time_step = 0.00005;
+    settings.steps = 400000;
+    settings.interactors = {{"gravity"}, {"lennard_jones"}};
+    settings.outputs = {{"sdl", "250", "150"}};
+
+    std::vector<Particle<2>> particles(8000);
+    double spacing = 1.12246204831;
+    unsigned int cube_cells[2] {40, 40};
+    unsigned int rectangle_cells[2] {160, 40};
+    if(name == "collision") {
+        double cube_corner[2] {125 - 20 * spacing, 20};
+        double rectangle_corner[2] {125 - 80 * spacing, 100};
+        unsigned int cube_count = Initializers::cubic<2>(particles.data(), Vector<double, 2>(cube_corner), Vector<unsigned int, 2>(cube_cells), spacing);
+        double vel[2] {0, 10};
+        for(unsigned int i = 0; i < cube_count; i++) {
+            particles[i].setVelocity(Vector<double, 2>(vel));
+        }
+        Initializers::cubic<2>(particles.data() + cube_count, Vector<double, 2>(rectangle_corner), Vector<unsigned int, 2>(rectangle_cells), spacing);
+    }
+    else if(name == "falling") {
+        double cube_corner[2] {125 - 20 * spacing, 120};
+        double rectangle_corner[2] {125 - 80 * spacing, 200};
+        unsigned int cube_count = Initializers::cubic<2>(particles.data(), Vector<double, 2>(cube_corner), Vector<unsigned int, 2>(cube_cells), spacing);
+        Initializers::cubic<2>(particles.data() + cube_count, Vector<double, 2>(rectangle_corner), Vector<unsigned int, 2>(rectangle_cells), spacing);
+        settings.border = BORDER_TYPE::reflexive;
+        settings.restrain_energy = 0.005;
+        settings.forces = {{"gravity", "-12"}};
+        settings.outputs = {{"sdl", "250", "250"}};
+    }
+    else {
+        std::cout << "ERROR : Unknown scenario: " << name << std::endl;
+        return 1;
+    }
+    return Scenario<2>::write(file_name, settings, particles.data(), particles.size()) ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    if(argc == 4 && std::string(argv[1]) == "write") {
+        return write(argv[2], argv[3]);
+    }
+    if(argc != 2) {
+        std::cout << "usage: scenario <file.qsc> | scenario write <collision | falling> <file.qsc>" << std::endl;
+        return 1;
+    }
+    Scenario<2> scenario(argv[1]);
+    if(!scenario.isOpen()) {
+        return 1;
+    }
+    // pick the universe type the scenario fits in
+    const ScenarioSettings& settings = scenario.getSettings();
+    if(settings.length == 250.0 && settings.cut == 2.5 && settings.particle_count <= 8000) {
+        return run<8000, 250.0, 2.5>(scenario);
+    }
+    if(settings.length == 5000.0 && settings.cut == 2.5) {
+        return run<10000000, 5000.0, 2.5>(scenario);
+    }
+    std::cout << "ERROR : No universe type of this program fits the scenario, add one to main." << std::endl;
+    return 1;
+}
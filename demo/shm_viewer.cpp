@@ -0,0 +1,66 @@
+#include <string>
+#include <thread>
+#include "quark/quark.hpp"
+
+/*
+
+Shows the frames a run publishes with a SharedMemoryVisualizer, from another process.
+
+    shm_viewer <segment name, like /quark> [viewport width] [viewport height]
+
+The viewer can be started before the run, closed and started again at any time: the run never waits for it.
+Without a viewport size, the view port frames the particles of the first frame.
+
+*/
+
+int main(int argc, char** argv) {
+    if(argc < 2) {
+        std::cout << "usage: shm_viewer <segment name> [viewport width] [viewport height]" << std::endl;
+        return 1;
+    }
+    SharedFrameReader<2> reader(argv[1]);
+    std::cout << "waiting for frames on " << argv[1] << std::endl;
+    while(!reader.update()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+
+    // frame the particles of the first frame in the view port
+    double corner[2] = {0, 0};
+    double size[2] = {1, 1};
+    const std::vector<Particle<2>>& particles = reader.getParticles();
+    if(argc > 3) {
+        size[0] = std::stod(argv[2]);
+        size[1] = std::stod(argv[3]);
+    }
+    else if(!particles.empty()) {
+        double max_corner[2] = {particles[0].getPosition()[0], particles[0].getPosition()[1]};
+        corner[0] = max_corner[0];
+        corner[1] = max_corner[1];
+        for(const Particle<2>& particle: particles) {
+            for(unsigned int dim = 0; dim < 2; dim++) {
+                corner[dim] = std::min(corner[dim], particle.getPosition()[dim]);
+                max_corner[dim] = std::max(max_corner[dim], particle.getPosition()[dim]);
+            }
+        }
+        for(unsigned int dim = 0; dim < 2; dim++) {
+            size[dim] = std::max(max_corner[dim] - corner[dim], 1e-9) * 1.2;
+            corner[dim] -= size[dim] / 12;
+        }
+    }
+
+    SDLVisualizer<SharedFrameReader<2>> visualizer = SDLVisualizer<SharedFrameReader<2>>();
+    visualizer.setViewportCorner(corner);
+    visualizer.setViewportSize(size);
+
+    // the window keeps responding between frames, showing the last one
+    bool attached = true;
+    while(true) {
+        reader.update();
+        if(attached != reader.isAttached()) {
+            attached = reader.isAttached();
+            std::cout << (attached ? "attached" : "the run stopped, waiting for the next one") << std::endl;
+        }
+        visualizer.draw(&reader);
+        std::this_thread::sleep_for(std::chrono::milliseconds(16));
+    }
+}
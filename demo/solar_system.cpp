@@ -66,9 +66,13 @@ int main() {
     unsigned int dim[2] {0, 1};
     visualizer.setViewportDimensions(dim);
 
+    // the orbits are smooth, a fourth order integrator keeps them accurate with a larger time step
+    ForestRuthIntegrator<2> integrator = ForestRuthIntegrator<2>();
+    universe.setIntegrator(&integrator);
+
     // main simulation loop
-    for(unsigned int i = 0; i < 500000; i++) {
-        universe.step(0.000001); // simulate hour by hour
+    for(unsigned int i = 0; i < 5000; i++) {
+        universe.step(0.0001);
     }
 
 
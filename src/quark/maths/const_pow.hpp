@@ -1,3 +1,5 @@
+#pragma once
+
 // from https://stackoverflow.com/questions/16443682/c-power-of-integer-template-meta-programming
 // allow to do compile time exponent, for template usage.
 
@@ -6,5 +8,5 @@ template<class T>
 inline constexpr T const_pow(const T base, unsigned const exponent)
 {
     // (parentheses not required in next line)
-    return (exponent == 0) ? 1 : (base * pow(base, exponent-1));
+    return (exponent == 0) ? 1 : (base * const_pow(base, exponent-1));
 }
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include <complex>
+
+/// @brief Radix 2 fast fourier transform, for sizes that are powers of two.
+///         The twiddle factors and the bit reversal permutation are computed once for the size.
+class FFT {
+    private:
+    unsigned int size;
+    std::vector<std::complex<double>> twiddles;
+    std::vector<unsigned int> bit_reversal;
+
+    public:
+    FFT() : FFT(1) {}
+    /// @brief Creates a transform of the given size.
+    /// @param size the number of elements to transform, must be a power of two.
+    FFT(unsigned int size) : size(size), twiddles(size / 2), bit_reversal(size) {
+        for(unsigned int i = 0; i < size / 2; i++) {
+            double angle = -2 * M_PI * i / size;
+            this->twiddles[i] = std::complex<double>(cos(angle), sin(angle));
+        }
+        unsigned int bits = 0;
+        while((1u << bits) < size) {
+            bits++;
+        }
+        for(unsigned int i = 0; i < size; i++) {
+            unsigned int reversed = 0;
+            for(unsigned int bit = 0; bit < bits; bit++) {
+                reversed |= ((i >> bit) & 1) << (bits - 1 - bit);
+            }
+            this->bit_reversal[i] = reversed;
+        }
+    }
+
+    public:
+    unsigned int getSize() const {
+        return this->size;
+    }
+
+    /// @brief Transforms the line data[0], data[stride], ..., data[(size - 1) * stride] in place.
+    ///         The inverse transform is not normalized: a forward and an inverse transform multiply the data by size.
+    /// @param data the first element of the line.
+    /// @param stride the distance between two elements of the line.
+    /// @param inverse whether to compute the inverse transform.
+    void transform(std::complex<double>* data, unsigned int stride, bool inverse) const {
+        for(unsigned int i = 0; i < this->size; i++) {
+            unsigned int j = this->bit_reversal[i];
+            if(i < j) {
+                std::swap(data[i * stride], data[j * stride]);
+            }
+        }
+        for(unsigned int length = 2; length <= this->size; length *= 2) {
+            unsigned int half = length / 2;
+            unsigned int twiddle_step = this->size / length;
+            for(unsigned int start = 0; start < this->size; start += length) {
+                for(unsigned int k = 0; k < half; k++) {
+                    std::complex<double> twiddle = this->twiddles[k * twiddle_step];
+                    if(inverse) {
+                        twiddle = std::conj(twiddle);
+                    }
+                    std::complex<double> even = data[(start + k) * stride];
+                    std::complex<double> odd = data[(start + k + half) * stride] * twiddle;
+                    data[(start + k) * stride] = even + odd;
+                    data[(start + k + half) * stride] = even - odd;
+                }
+            }
+        }
+    }
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+/// @brief Philox 4x32 counter based random generator, with 10 rounds (Salmon et al., Random123).
+///         There is no state: the output is a bijection of the counter, keyed by the seed.
+///         Giving each particle its own counter makes the random numbers independent of the order
+///         and of the thread they are drawn in.
+class Philox {
+    private:
+    constexpr static uint32_t M0 = 0xD2511F53;
+    constexpr static uint32_t M1 = 0xCD9E8D57;
+    constexpr static uint32_t W0 = 0x9E3779B9;
+    constexpr static uint32_t W1 = 0xBB67AE85;
+
+    std::array<uint32_t, 2> key;
+
+    public:
+    /// @brief Creates a generator from a seed.
+    Philox(uint64_t seed) {
+        this->key = {(uint32_t)seed, (uint32_t)(seed >> 32)};
+    }
+
+    /// @brief Computes the 4 random words of a counter.
+    std::array<uint32_t, 4> generate(std::array<uint32_t, 4> counter) const {
+        uint32_t k0 = this->key[0];
+        uint32_t k1 = this->key[1];
+        for(unsigned int round = 0; round < 10; round++) {
+            uint64_t product0 = (uint64_t)M0 * counter[0];
+            uint64_t product1 = (uint64_t)M1 * counter[2];
+            counter = {
+                (uint32_t)(product1 >> 32) ^ counter[1] ^ k0,
+                (uint32_t)product1,
+                (uint32_t)(product0 >> 32) ^ counter[3] ^ k1,
+                (uint32_t)product0
+            };
+            k0 += W0;
+            k1 += W1;
+        }
+        return counter;
+    }
+
+    /// @brief Two uniform doubles in [0, 1), for an index and a stream.
+    /// @param index the index of the element the numbers are for, usually a particle index.
+    /// @param stream separates the numbers drawn for different purposes on the same element.
+    /// @param block the pair of numbers to draw, when an element needs more than two.
+    std::array<double, 2> uniform(uint64_t index, uint32_t stream, uint32_t block) const {
+        std::array<uint32_t, 4> words = this->generate({(uint32_t)index, (uint32_t)(index >> 32), block, stream});
+        return {
+            Philox::toDouble(words[0], words[1]),
+            Philox::toDouble(words[2], words[3])
+        };
+    }
+
+    /// @brief Two independent standard normal doubles, for an index and a stream, from the Box-Muller transform.
+    std::array<double, 2> normal(uint64_t index, uint32_t stream, uint32_t block) const {
+        std::array<double, 2> u = this->uniform(index, stream, block);
+        // 1 - u is in (0, 1], so the log is finite
+        double radius = sqrt(-2.0 * log(1.0 - u[0]));
+        double angle = 2.0 * M_PI * u[1];
+        return {radius * cos(angle), radius * sin(angle)};
+    }
+
+    private:
+    /// @brief Uses the 53 high bits of two words as the mantissa of a double in [0, 1).
+    static double toDouble(uint32_t high, uint32_t low) {
+        uint64_t bits = ((uint64_t)high << 32) | low;
+        return (bits >> 11) * (1.0 / 9007199254740992.0);
+    }
+};
@@ -5,12 +5,56 @@
 #include <functional>
 #include <algorithm>
 #include <array>
+#include <type_traits>
+
+template<typename T, unsigned int D>
+class Vector;
+
+/// @brief Base of every vector expression: a vector, or an operation on vectors that is not computed yet.
+///         Operators on expressions build a tree of nodes, and the whole tree is evaluated element by element
+///         when it is assigned to a vector. An expression like a + b * s is then one loop, with no intermediate vector.
+///         Expressions keep references to the vectors they use, so they should not outlive the statement that builds them:
+///         store the result in a Vector, not in an auto.
+/// @tparam E the type of the expression, deriving from this class.
+/// @tparam T the type of the elements.
+/// @tparam D the dimension of the vector.
+template<typename E, typename T, unsigned int D>
+class VectorExpression {
+    public:
+    /// @brief Computes the element i of the expression.
+    inline T operator[](unsigned int i) const {
+        return static_cast<const E&>(*this)[i];
+    }
+
+    /// @brief Returns the squared magnitude of the vector.
+    ///         The result is not rooted, as we are not sure sqrt is defined for T.
+    /// @return The sum of the squarred elements of values.
+    T sq_magnitude() const {
+        T sum = {};
+        for(unsigned int i = 0; i < D; i++) {
+            T elem = (*this)[i];
+            sum += elem * elem;
+        }
+        return sum;
+    }
+};
+
+/// @brief How an expression node stores its operands: vectors by reference, other nodes by value.
+template<typename E>
+struct VectorOperand {
+    typedef const E type;
+};
+
+template<typename T, unsigned int D>
+struct VectorOperand<Vector<T, D>> {
+    typedef const Vector<T, D>& type;
+};
 
 /// @brief Vector of any dimensions, from any types.
 /// @tparam T the type of the vector. should implement addition and multiplication, and have a default value.
 /// @tparam D the dimension of the vector.
 template<typename T, unsigned int D>
-class Vector {
+class Vector : public VectorExpression<Vector<T, D>, T, D> {
     private:
     T values[D];
 
@@ -19,19 +63,28 @@ class Vector {
     Vector() = default;
     /// @brief Creates a new vector with the given values.
     /// @param values the value to construct the vector with.
-    Vector(T values [D])  {
+    Vector(const T values [D])  {
         for(unsigned int i = 0; i < D; i++) {
             this->values[i] = values[i];
         }
     }
     /// @brief Creates a new vector with the given generator function.
     /// @param generator the function to evaluate for each element of the vector.
-    Vector(std::function<T()> generator) {
+    template<typename Generator>
+    requires std::is_invocable_r_v<T, Generator&>
+    Vector(Generator generator) {
         for(unsigned int i = 0; i < D; i++) {
             this->values[i] = generator();
         }
     }
-    
+    /// @brief Creates a new vector by evaluating an expression.
+    template<typename E>
+    Vector(const VectorExpression<E, T, D>& expression) {
+        for(unsigned int i = 0; i < D; i++) {
+            this->values[i] = expression[i];
+        }
+    }
+
     // intern operators
     public:
     inline T& operator[](unsigned int i) {
@@ -43,13 +96,25 @@ class Vector {
         return this->values[i];
     }
 
-    void operator+=(const Vector<T, D>& v) {
+    /// @brief Evaluates an expression into this vector. Each element only depends on the same element of the operands,
+    ///         so the vector may appear in the expression.
+    template<typename E>
+    Vector<T, D>& operator=(const VectorExpression<E, T, D>& expression) {
+        for(unsigned int i = 0; i < D; i++) {
+            this->values[i] = expression[i];
+        }
+        return *this;
+    }
+
+    template<typename E>
+    void operator+=(const VectorExpression<E, T, D>& v) {
         for(unsigned int i = 0; i < D; i++) {
             this->values[i] += v[i];
         }
     }
 
-    void operator-=(const Vector<T, D>& v) {
+    template<typename E>
+    void operator-=(const VectorExpression<E, T, D>& v) {
         for(unsigned int i = 0; i < D; i++) {
             this->values[i] -= v[i];
         }
@@ -67,7 +132,7 @@ class Vector {
         }
     }
 
-    bool operator==(const Vector<T, D>& v2) {
+    bool operator==(const Vector<T, D>& v2) const {
         for(unsigned int i = 0; i < D; i++) {
             if(this->values[i] != v2[i]) {
                 return false;
@@ -78,17 +143,6 @@ class Vector {
 
     // intern use functions
 
-    /// @brief Returns the squared magnitude of the vector.
-    ///         The result is not rooted, as we are not sure sqrt is defined for T.
-    /// @return The sum of the squarred elements of values.
-    T sq_magnitude() {
-        T sum = {};
-        for(auto elem: this->values) {
-            sum += elem * elem;
-        }
-        return sum;
-    }
-
     /// @brief reset the vector in place, sets all its value to zero
     void reset() {
         for(unsigned int i = 0; i < D; i++) {
@@ -98,6 +152,75 @@ class Vector {
 
 };
 
+/// @brief Expression node for -v.
+template<typename E, typename T, unsigned int D>
+class VectorNegation : public VectorExpression<VectorNegation<E, T, D>, T, D> {
+    private:
+    typename VectorOperand<E>::type v;
+
+    public:
+    VectorNegation(const E& v) : v(v) {}
+    inline T operator[](unsigned int i) const {
+        return - this->v[i];
+    }
+};
+
+/// @brief Expression node for v1 + v2.
+template<typename E1, typename E2, typename T, unsigned int D>
+class VectorSum : public VectorExpression<VectorSum<E1, E2, T, D>, T, D> {
+    private:
+    typename VectorOperand<E1>::type v1;
+    typename VectorOperand<E2>::type v2;
+
+    public:
+    VectorSum(const E1& v1, const E2& v2) : v1(v1), v2(v2) {}
+    inline T operator[](unsigned int i) const {
+        return this->v1[i] + this->v2[i];
+    }
+};
+
+/// @brief Expression node for v1 - v2.
+template<typename E1, typename E2, typename T, unsigned int D>
+class VectorDifference : public VectorExpression<VectorDifference<E1, E2, T, D>, T, D> {
+    private:
+    typename VectorOperand<E1>::type v1;
+    typename VectorOperand<E2>::type v2;
+
+    public:
+    VectorDifference(const E1& v1, const E2& v2) : v1(v1), v2(v2) {}
+    inline T operator[](unsigned int i) const {
+        return this->v1[i] - this->v2[i];
+    }
+};
+
+/// @brief Expression node for v * s, with s a scalar.
+template<typename E, typename T, unsigned int D>
+class VectorScaling : public VectorExpression<VectorScaling<E, T, D>, T, D> {
+    private:
+    typename VectorOperand<E>::type v;
+    T s;
+
+    public:
+    VectorScaling(const E& v, const T& s) : v(v), s(s) {}
+    inline T operator[](unsigned int i) const {
+        return this->v[i] * this->s;
+    }
+};
+
+/// @brief Expression node for v / s, with s a scalar.
+template<typename E, typename T, unsigned int D>
+class VectorDivision : public VectorExpression<VectorDivision<E, T, D>, T, D> {
+    private:
+    typename VectorOperand<E>::type v;
+    T s;
+
+    public:
+    VectorDivision(const E& v, const T& s) : v(v), s(s) {}
+    inline T operator[](unsigned int i) const {
+        return this->v[i] / this->s;
+    }
+};
+
 /// @brief Flux operator
 /// @tparam T type of the vector
 /// @tparam D size of the vector
@@ -115,77 +238,64 @@ std::ostream& operator<<(std::ostream& os, const Vector<T, D>& vec) {
 }
 
 /// @brief unary minus operator
+/// @tparam E type of the expression
 /// @tparam T type of the vector
 /// @tparam D size of the vector
 /// @param v vector to oppose
 /// @return -v
-template<typename T, unsigned int D>
-Vector<T, D> operator-(const Vector<T, D>& v) {
-    T values [D];
-    for(unsigned int i = 0; i < D; i++) {
-        values[i] = - v[i];
-    }
-    return Vector<T, D>(values);
+template<typename E, typename T, unsigned int D>
+inline VectorNegation<E, T, D> operator-(const VectorExpression<E, T, D>& v) {
+    return VectorNegation<E, T, D>(static_cast<const E&>(v));
 }
 
 /// @brief Addition operator
+/// @tparam E1 type of the first expression
+/// @tparam E2 type of the second expression
 /// @tparam T type of the vector
 /// @tparam D size of the vector
 /// @param v1 first vector to add
 /// @param v2 second vector to add
 /// @return the sum of v1 and v2
-template<typename T, unsigned int D>
-Vector<T, D> operator+(const Vector<T, D>& v1, const Vector<T, D>& v2) {
-    T values [D];
-    for(unsigned int i = 0; i < D; i++) {
-        values[i] = v1[i] + v2[i];
-    }
-    return Vector<T, D>(values);
+template<typename E1, typename E2, typename T, unsigned int D>
+inline VectorSum<E1, E2, T, D> operator+(const VectorExpression<E1, T, D>& v1, const VectorExpression<E2, T, D>& v2) {
+    return VectorSum<E1, E2, T, D>(static_cast<const E1&>(v1), static_cast<const E2&>(v2));
 }
 
 /// @brief Substraction operator
+/// @tparam E1 type of the first expression
+/// @tparam E2 type of the second expression
 /// @tparam T type of the vector
 /// @tparam D size of the vector
 /// @param v1 vector to substract from
 /// @param v2 vector to substract
 /// @return the difference between v1 and v2
-template<typename T, unsigned int D>
-Vector<T, D> operator-(const Vector<T, D>& v1, const Vector<T, D>& v2) {
-    T values [D];
-    for(unsigned int i = 0; i < D; i++) {
-        values[i] = v1[i] - v2[i];
-    }
-    return Vector<T, D>(values);
+template<typename E1, typename E2, typename T, unsigned int D>
+inline VectorDifference<E1, E2, T, D> operator-(const VectorExpression<E1, T, D>& v1, const VectorExpression<E2, T, D>& v2) {
+    return VectorDifference<E1, E2, T, D>(static_cast<const E1&>(v1), static_cast<const E2&>(v2));
 }
 
 /// @brief scalar multiplication operator
+/// @tparam E type of the expression
 /// @tparam T type of the vector and the scalar
 /// @tparam D size of the vector
 /// @param v vector to mulitply
 /// @param s the scalar to multiply by
 /// @return the vector multiplied by the scalar
-template<typename T, unsigned int D>
-Vector<T, D> operator*(const Vector<T, D>& v, const T& s) {
-    T values [D];
-    for(unsigned int i = 0; i < D; i++) {
-        values[i] = v[i] * s;
-    }
-    return Vector<T, D>(values);
+template<typename E, typename T, unsigned int D>
+inline VectorScaling<E, T, D> operator*(const VectorExpression<E, T, D>& v, const std::type_identity_t<T>& s) {
+    return VectorScaling<E, T, D>(static_cast<const E&>(v), s);
 }
 
 /// @brief scalar division operator
+/// @tparam E type of the expression
 /// @tparam T type of the vector and the scalar
 /// @tparam D size of the vector
 /// @param v vector to mulitply
 /// @param s the scalar to divide by
 /// @return the vector multiplied by the scalar
-template<typename T, unsigned int D>
-Vector<T, D> operator/(const Vector<T, D>& v, const T& s) {
-    T values [D];
-    for(unsigned int i = 0; i < D; i++) {
-        values[i] = v[i] / s;
-    }
-    return Vector<T, D>(values);
+template<typename E, typename T, unsigned int D>
+inline VectorDivision<E, T, D> operator/(const VectorExpression<E, T, D>& v, const std::type_identity_t<T>& s) {
+    return VectorDivision<E, T, D>(static_cast<const E&>(v), s);
 }
 
 /// @brief Concatenation operator. Append elements of v2 to v1, creating a new vector of size D + M
@@ -198,20 +308,25 @@ Vector<T, D> operator/(const Vector<T, D>& v, const T& s) {
 template<typename T, unsigned int D, unsigned int M>
 Vector<T, D + M> operator<<(const Vector<T, D>& v1, const Vector<T, M>& v2) {
     T values [D + M];
-    unsigned int i = 0;
-    std::generate_n(values, D, [&] { return v1[i++]; });
-    std::generate_n(values, M, [&] { return v2[i++]; });
+    for(unsigned int i = 0; i < D; i++) {
+        values[i] = v1[i];
+    }
+    for(unsigned int i = 0; i < M; i++) {
+        values[D + i] = v2[i];
+    }
     return Vector<T, D + M>(values);
 }
 
 /// @brief Equality check operator
+/// @tparam E1 type of the first expression
+/// @tparam E2 type of the second expression
 /// @tparam T type of the vector
 /// @tparam D size of the vector
 /// @param v1 vector to check from
 /// @param v2 vector to check
 /// @return if v1 == v2
-template<typename T, unsigned int D>
-bool operator==(const Vector<T, D>& v1, const Vector<T, D>& v2) {
+template<typename E1, typename E2, typename T, unsigned int D>
+bool operator==(const VectorExpression<E1, T, D>& v1, const VectorExpression<E2, T, D>& v2) {
     for(unsigned int i = 0; i < D; i++) {
         if(v1[i] != v2[i]) {
             return false;
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+#include <sched.h>
+#include <pthread.h>
+
+/// @brief Cpus the threads of a parallel loop are pinned to: thread t runs on cpu threadCpus()[t % size].
+///         Empty by default, leaving the threads to the scheduler. Set it before starting parallel work.
+inline std::vector<int>& threadCpus() {
+    static std::vector<int> cpus;
+    return cpus;
+}
+
+/// @brief Cpu of a thread of a parallel loop, or -1 if threads are not pinned.
+inline int threadCpu(unsigned int thread) {
+    const std::vector<int>& cpus = threadCpus();
+    return cpus.empty() ? -1 : cpus[thread % cpus.size()];
+}
+
+/// @brief Pins the calling thread to a cpu.
+/// @return whether the thread is pinned. A negative cpu leaves it as it is.
+inline bool pinCurrentThread(int cpu) {
+    if(cpu < 0 || cpu >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set) == 0;
+}
+
+/// @brief Moves the calling thread to a cpu, or back to the cpus it had at its first call for a negative one.
+///         For the long-lived threads of a pool, which follow threadCpus() from task to task:
+///         the current cpu is remembered, so asking for it again costs no system call.
+inline void followThreadCpu(int cpu) {
+    static thread_local int current = -1;
+    static thread_local bool saved = false;
+    static thread_local cpu_set_t initial;
+    if(cpu == current) {
+        return;
+    }
+    if(!saved) {
+        saved = pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &initial) == 0;
+    }
+    if(cpu < 0) {
+        if(saved && pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &initial) == 0) {
+            current = -1;
+        }
+    }
+    else if(pinCurrentThread(cpu)) {
+        current = cpu;
+    }
+}
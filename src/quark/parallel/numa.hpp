@@ -0,0 +1,264 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <ostream>
+#include <cstdint>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include "affinity.hpp"
+#include "parallel_for.hpp"
+
+/// @brief NUMA nodes of the machine and their cpus, read once from sysfs.
+///         A machine without NUMA, or without sysfs, shows a single node holding every cpu.
+class NumaTopology {
+    private:
+    std::vector<std::vector<int>> node_cpus;
+    std::vector<int> cpu_nodes;
+
+    NumaTopology() {
+        std::ifstream online("/sys/devices/system/node/online");
+        std::string nodes;
+        if(online >> nodes) {
+            for(int node: NumaTopology::parseList(nodes)) {
+                std::ifstream cpulist("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+                std::string cpus;
+                cpulist >> cpus;
+                std::vector<int> node_cpus = NumaTopology::parseList(cpus);
+                // nodes without cpus only hold memory
+                if(!node_cpus.empty()) {
+                    this->addNode(node, node_cpus);
+                }
+            }
+        }
+        if(this->node_cpus.empty()) {
+            std::vector<int> cpus;
+            for(unsigned int cpu = 0; cpu < defaultThreadCount(); cpu++) {
+                cpus.push_back(cpu);
+            }
+            this->addNode(0, cpus);
+        }
+    }
+
+    void addNode(int node, const std::vector<int>& cpus) {
+        if((int)this->node_cpus.size() <= node) {
+            this->node_cpus.resize(node + 1);
+        }
+        this->node_cpus[node] = cpus;
+        for(int cpu: cpus) {
+            if((int)this->cpu_nodes.size() <= cpu) {
+                this->cpu_nodes.resize(cpu + 1, -1);
+            }
+            this->cpu_nodes[cpu] = node;
+        }
+    }
+
+    public:
+    static const NumaTopology& get() {
+        static NumaTopology topology;
+        return topology;
+    }
+
+    /// @brief Parses a sysfs list, like "0-3,8,10-11".
+    static std::vector<int> parseList(const std::string& list) {
+        std::vector<int> values;
+        std::stringstream stream(list);
+        std::string range;
+        while(std::getline(stream, range, ',')) {
+            if(range.empty()) {
+                continue;
+            }
+            size_t dash = range.find('-');
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for(int value = first; value <= last; value++) {
+                values.push_back(value);
+            }
+        }
+        return values;
+    }
+
+    /// @brief Number of node slots. Node numbers may have holes, their cpu list is then empty.
+    unsigned int getNodeCount() const {
+        return this->node_cpus.size();
+    }
+
+    const std::vector<int>& getNodeCpus(unsigned int node) const {
+        return this->node_cpus[node];
+    }
+
+    /// @brief Node of a cpu, or -1 for an unknown cpu.
+    int getCpuNode(int cpu) const {
+        return cpu >= 0 && cpu < (int)this->cpu_nodes.size() ? this->cpu_nodes[cpu] : -1;
+    }
+};
+
+/// @brief How the threads of the parallel loops are spread over the cpus.
+enum class AFFINITY {
+    none, // default: the scheduler moves the threads freely
+    compact, // fill the cpus of a node before going to the next one
+    scatter, // alternate the nodes, to use the memory bandwidth of all of them with few threads
+};
+
+/// @brief Pins the threads of the parallel loops following a policy.
+///         The thread calling the loops keeps its own affinity: pin it with pinCurrentThread if its block should follow.
+inline void setThreadAffinity(AFFINITY affinity) {
+    std::vector<int>& cpus = threadCpus();
+    cpus.clear();
+    const NumaTopology& topology = NumaTopology::get();
+    if(affinity == AFFINITY::compact) {
+        for(unsigned int node = 0; node < topology.getNodeCount(); node++) {
+            cpus.insert(cpus.end(), topology.getNodeCpus(node).begin(), topology.getNodeCpus(node).end());
+        }
+    }
+    else if(affinity == AFFINITY::scatter) {
+        for(unsigned int rank = 0;; rank++) {
+            bool any = false;
+            for(unsigned int node = 0; node < topology.getNodeCount(); node++) {
+                if(rank < topology.getNodeCpus(node).size()) {
+                    cpus.push_back(topology.getNodeCpus(node)[rank]);
+                    any = true;
+                }
+            }
+            if(!any) {
+                break;
+            }
+        }
+    }
+}
+
+/// @brief Pins thread t of the parallel loops to cpus[t % size]. An empty list unpins them.
+inline void setThreadAffinity(const std::vector<int>& cpus) {
+    threadCpus() = cpus;
+}
+
+/// @brief Node the parallel loops' thread t runs on, or -1 if the threads are not pinned.
+inline int threadNode(unsigned int thread) {
+    return NumaTopology::get().getCpuNode(threadCpu(thread));
+}
+
+/// @brief Size of a memory page.
+inline uintptr_t pageSize() {
+    static uintptr_t size = sysconf(_SC_PAGESIZE);
+    return size;
+}
+
+/// @brief Start addresses of the pages covering [begin, begin + bytes).
+inline std::vector<void*> pagesOf(const void* begin, size_t bytes) {
+    std::vector<void*> pages;
+    if(bytes == 0) {
+        return pages;
+    }
+    uintptr_t first = (uintptr_t)begin & ~(pageSize() - 1);
+    uintptr_t last = ((uintptr_t)begin + bytes - 1) & ~(pageSize() - 1);
+    for(uintptr_t page = first; page <= last; page += pageSize()) {
+        pages.push_back((void*)page);
+    }
+    return pages;
+}
+
+/// @brief Node of each page, from the move_pages system call. Pages never touched are reported as -1.
+///         Without NUMA support in the kernel, every page is on node 0.
+inline std::vector<int> pageNodes(const std::vector<void*>& pages) {
+    std::vector<int> status(pages.size(), 0);
+    if(pages.empty()) {
+        return status;
+    }
+    long result = syscall(SYS_move_pages, 0, pages.size(), pages.data(), nullptr, status.data(), 0);
+    if(result != 0) {
+        std::fill(status.begin(), status.end(), 0);
+        return status;
+    }
+    for(int& node: status) {
+        node = node < 0 ? -1 : node;
+    }
+    return status;
+}
+
+/// @brief Moves pages to a node, with the move_pages system call. Pages shared with other processes are left in place.
+/// @return the number of pages on the node afterwards.
+inline unsigned int movePages(const std::vector<void*>& pages, int node) {
+    if(pages.empty() || node < 0) {
+        return 0;
+    }
+    // MPOL_MF_MOVE, from numaif.h, which we do not depend on
+    const int MOVE_OWN_PAGES = 1 << 1;
+    std::vector<int> nodes(pages.size(), node);
+    std::vector<int> status(pages.size(), 0);
+    if(syscall(SYS_move_pages, 0, pages.size(), pages.data(), nodes.data(), status.data(), MOVE_OWN_PAGES) < 0) {
+        return 0;
+    }
+    unsigned int moved = 0;
+    for(int page_node: status) {
+        moved += page_node == node;
+    }
+    return moved;
+}
+
+/// @brief Where the pages of a parallel data structure are, compared to the nodes of the threads working on them.
+struct NumaReport {
+    /// @brief Pages of one kind of storage, counted per thread block.
+    struct Region {
+        std::string name;
+        unsigned long pages = 0;
+        // pages on another node than the thread owning them
+        unsigned long remote_pages = 0;
+        // pages on no node yet, never touched
+        unsigned long untouched_pages = 0;
+
+        double getRemoteRatio() const {
+            return this->pages == 0 ? 0.0 : (double)this->remote_pages / this->pages;
+        }
+    };
+
+    unsigned int node_count = 1;
+    unsigned int thread_count = 1;
+    // without pinned threads, there is no owner node to compare with, and nothing is counted as remote
+    bool pinned = false;
+    std::vector<Region> regions;
+    // pages on each node, all regions together
+    std::vector<unsigned long> node_pages;
+
+    /// @brief Counts the pages of a thread block, against the node of the thread.
+    void addPages(unsigned int region, const std::vector<void*>& pages, int home_node) {
+        std::vector<int> nodes = pageNodes(pages);
+        for(int node: nodes) {
+            this->regions[region].pages++;
+            if(node < 0) {
+                this->regions[region].untouched_pages++;
+                continue;
+            }
+            if((int)this->node_pages.size() <= node) {
+                this->node_pages.resize(node + 1, 0);
+            }
+            this->node_pages[node]++;
+            if(home_node >= 0 && node != home_node) {
+                this->regions[region].remote_pages++;
+            }
+        }
+    }
+
+    /// @brief Ratio of remote pages over all the regions.
+    double getRemoteRatio() const {
+        unsigned long pages = 0;
+        unsigned long remote_pages = 0;
+        for(const Region& region: this->regions) {
+            pages += region.pages;
+            remote_pages += region.remote_pages;
+        }
+        return pages == 0 ? 0.0 : (double)remote_pages / pages;
+    }
+
+    void write(std::ostream& stream) const {
+        stream << "numa nodes: " << this->node_count << ", threads: " << this->thread_count << (this->pinned ? ", pinned" : ", not pinned") << std::endl;
+        for(const Region& region: this->regions) {
+            stream << region.name << ": " << region.pages << " pages, " << region.remote_pages << " remote ("
+                   << 100.0 * region.getRemoteRatio() << "%), " << region.untouched_pages << " untouched" << std::endl;
+        }
+        for(unsigned int node = 0; node < this->node_pages.size(); node++) {
+            stream << "node " << node << ": " << this->node_pages[node] << " pages" << std::endl;
+        }
+    }
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <condition_variable>
+#include "affinity.hpp"
+#include "thread_pool.hpp"
+
+/// @brief Blocks of one parallelFor call: which ones a thread took, and how many are not done yet.
+///         Shared with the tasks of the call, which may only start once the call is over and then find no block left.
+class LoopBlocks {
+    private:
+    std::unique_ptr<std::atomic<bool>[]> claimed;
+    std::atomic<unsigned int> remaining;
+    std::mutex mutex;
+    std::condition_variable done;
+
+    public:
+    LoopBlocks(unsigned int count) : claimed(new std::atomic<bool>[count]), remaining(count) {
+        for(unsigned int block = 0; block < count; block++) {
+            this->claimed[block] = false;
+        }
+    }
+
+    /// @brief Takes a block for the calling thread.
+    /// @return false if another thread took it first.
+    bool claim(unsigned int block) {
+        return !this->claimed[block].exchange(true);
+    }
+
+    /// @brief Marks a block done.
+    void finish() {
+        if(--this->remaining == 0) {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->done.notify_all();
+        }
+    }
+
+    /// @brief Blocks until every block is done.
+    void wait() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->done.wait(lock, [this]() { return this->remaining == 0; });
+    }
+};
+
+/// @brief Splits [begin, end) in contiguous blocks, one per thread, and runs function(block_begin, block_end, thread) on each.
+///         The blocks go to the workers of sharedThreadPool(), so no thread is started per call. The calling thread runs
+///         the last block, then any block no worker has started yet, and the call returns once all the blocks are done.
+///         Block t is given t as its thread index, whichever thread runs it, so the split and the per thread
+///         accumulators do not depend on the pool. When threadCpus() is set, a worker running block t runs on cpu
+///         threadCpu(t). The calling thread is never pinned: its affinity belongs to the caller, and a single thread
+///         loop runs on it as it is.
+/// @tparam Function callable as function(unsigned int, unsigned int, unsigned int).
+/// @param thread_count the number of threads to split the range over.
+/// @param begin first index of the range.
+/// @param end last index of the range, excluded.
+/// @param function the function to run on each block.
+template<typename Function>
+void parallelFor(unsigned int thread_count, unsigned int begin, unsigned int end, Function function) {
+    if(end <= begin) {
+        return;
+    }
+    thread_count = std::max(1u, std::min(thread_count, end - begin));
+    if(thread_count == 1) {
+        function(begin, end, 0);
+        return;
+    }
+    unsigned int length = end - begin;
+    auto runBlock = [&](unsigned int block) {
+        unsigned int block_begin = begin + (unsigned long long)length * block / thread_count;
+        unsigned int block_end = begin + (unsigned long long)length * (block + 1) / thread_count;
+        function(block_begin, block_end, block);
+    };
+    std::shared_ptr<LoopBlocks> blocks = std::make_shared<LoopBlocks>(thread_count);
+    ThreadPool& pool = sharedThreadPool();
+    for(unsigned int block = 0; block < thread_count - 1; block++) {
+        // the task only uses the loop once it took a block, and the call waits for the blocks taken
+        pool.submit([blocks, &runBlock, block]() {
+            if(blocks->claim(block)) {
+                followThreadCpu(threadCpu(block));
+                runBlock(block);
+                blocks->finish();
+            }
+        });
+    }
+    for(unsigned int block = thread_count; block-- > 0;) {
+        if(blocks->claim(block)) {
+            runBlock(block);
+            blocks->finish();
+        }
+    }
+    blocks->wait();
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+#include "parallel_for.hpp"
+
+/// @brief Number of terms summed one after the other before the tree reduction.
+const unsigned int REDUCTION_BLOCK_SIZE = 256;
+
+/// @brief Sums term(i) for i in [0, count), in an order that does not depend on the number of threads.
+///         The range is cut in fixed blocks of REDUCTION_BLOCK_SIZE terms, each summed in index order,
+///         then the block sums are added pairwise in a binary tree. Threads only decide who computes which block,
+///         so the result is bitwise identical for any thread count.
+/// @tparam T the type of the terms, needs a value initialization to zero and operator+.
+/// @tparam Function callable as term(unsigned int) -> T.
+/// @param thread_count the number of threads to compute the blocks with.
+/// @param count the number of terms.
+/// @param term the function giving each term.
+template<typename T, typename Function>
+T deterministicSum(unsigned int thread_count, unsigned int count, Function term) {
+    unsigned int block_count = (count + REDUCTION_BLOCK_SIZE - 1) / REDUCTION_BLOCK_SIZE;
+    if(block_count == 0) {
+        return T();
+    }
+    std::vector<T> sums(block_count);
+    parallelFor(thread_count, 0, block_count, [&](unsigned int begin, unsigned int end, unsigned int thread) {
+        for(unsigned int block = begin; block < end; block++) {
+            T sum = T();
+            unsigned int last = std::min(count, (block + 1) * REDUCTION_BLOCK_SIZE);
+            for(unsigned int i = block * REDUCTION_BLOCK_SIZE; i < last; i++) {
+                sum = sum + term(i);
+            }
+            sums[block] = sum;
+        }
+    });
+    // pairwise tree over the blocks
+    for(unsigned int stride = 1; stride < block_count; stride *= 2) {
+        for(unsigned int block = 0; block + stride < block_count; block += 2 * stride) {
+            sums[block] = sums[block] + sums[block + stride];
+        }
+    }
+    return sums[0];
+}
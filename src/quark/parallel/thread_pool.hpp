@@ -0,0 +1,183 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <condition_variable>
+#include "affinity.hpp"
+
+/// @brief Number of threads to use when none is given: one per hardware thread.
+inline unsigned int defaultThreadCount() {
+    return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+/// @brief Pool of worker threads running submitted tasks, with work stealing.
+///         Each worker owns a queue: it runs its own tasks last in first out, and when it runs dry
+///         it steals the oldest task of another worker. Tasks submitted from a worker go to its own queue,
+///         others are spread over the workers in turn. Worker w is pinned to cpu threadCpu(w).
+class ThreadPool {
+    private:
+    /// @brief Queue of tasks owned by one worker.
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<WorkerQueue> queues;
+    // submitted tasks that have not finished yet, and the ones still waiting in a queue
+    std::atomic<unsigned long> pending_count;
+    std::atomic<long> queued_count;
+    std::atomic<unsigned int> next_queue;
+    // protects the sleeping workers and the waiting callers
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::condition_variable all_done;
+    bool stopping = false;
+
+    /// @brief Pool and index of the worker running on the calling thread.
+    struct WorkerIdentity {
+        const ThreadPool* pool = nullptr;
+        unsigned int worker = 0;
+    };
+    static WorkerIdentity& currentWorker() {
+        static thread_local WorkerIdentity identity;
+        return identity;
+    }
+
+    public:
+    /// @brief Creates a pool and starts its workers.
+    /// @param thread_count number of worker threads.
+    ThreadPool(unsigned int thread_count = defaultThreadCount()) : queues(std::max(thread_count, 1u)) {
+        this->pending_count = 0;
+        this->queued_count = 0;
+        this->next_queue = 0;
+        for(unsigned int worker = 0; worker < this->queues.size(); worker++) {
+            this->workers.emplace_back(&ThreadPool::work, this, worker);
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// @brief Waits for the remaining tasks, then stops the workers.
+    ~ThreadPool() {
+        this->wait();
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->stopping = true;
+        }
+        this->work_available.notify_all();
+        for(std::thread& worker: this->workers) {
+            worker.join();
+        }
+    }
+
+    unsigned int getThreadCount() const {
+        return this->queues.size();
+    }
+
+    /// @brief Queues a task. It may be run by any worker.
+    void submit(std::function<void()> task) {
+        const WorkerIdentity& identity = ThreadPool::currentWorker();
+        unsigned int queue = identity.pool == this ? identity.worker : this->next_queue++ % this->queues.size();
+        this->pending_count++;
+        {
+            std::lock_guard<std::mutex> lock(this->queues[queue].mutex);
+            this->queues[queue].tasks.push_back(std::move(task));
+        }
+        // counted under the lock, so a worker about to sleep sees the new task
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->queued_count++;
+        this->work_available.notify_one();
+    }
+
+    /// @brief Whether the calling thread is one of the workers of this pool.
+    bool isWorkerThread() const {
+        return ThreadPool::currentWorker().pool == this;
+    }
+
+    /// @brief Runs one queued task on the calling worker, so a task waiting for other tasks can help instead of
+    ///         blocking its worker. Must be called from a worker of this pool.
+    /// @return false if no task was queued.
+    bool runPendingTask() {
+        std::function<void()> task;
+        if(!this->takeTask(ThreadPool::currentWorker().worker, task)) {
+            return false;
+        }
+        this->runTask(task);
+        return true;
+    }
+
+    /// @brief Blocks until every submitted task is done, including the ones submitted by running tasks.
+    ///         Called from a task, it never returns as the task itself is pending: wait for the tasks it submitted instead.
+    void wait() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->all_done.wait(lock, [this]() { return this->pending_count == 0; });
+    }
+
+    private:
+    /// @brief Takes a task, from the back of the worker's own queue first, then from the front of the others.
+    bool takeTask(unsigned int worker, std::function<void()>& task) {
+        {
+            WorkerQueue& own = this->queues[worker];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if(!own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                this->queued_count--;
+                return true;
+            }
+        }
+        for(unsigned int offset = 1; offset < this->queues.size(); offset++) {
+            WorkerQueue& victim = this->queues[(worker + offset) % this->queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if(!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                this->queued_count--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void runTask(std::function<void()>& task) {
+        task();
+        task = nullptr;
+        if(--this->pending_count == 0) {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->all_done.notify_all();
+        }
+    }
+
+    /// @brief Main loop of a worker thread.
+    void work(unsigned int worker) {
+        followThreadCpu(threadCpu(worker));
+        ThreadPool::currentWorker().pool = this;
+        ThreadPool::currentWorker().worker = worker;
+        std::function<void()> task;
+        while(true) {
+            if(this->takeTask(worker, task)) {
+                this->runTask(task);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->work_available.wait(lock, [this]() { return this->stopping || this->queued_count > 0; });
+            if(this->stopping && this->queued_count <= 0) {
+                return;
+            }
+        }
+    }
+};
+
+/// @brief Pool running the blocks of the parallel loops, started on first use with one worker per hardware thread.
+///         It is never destroyed, so a loop run from a static destructor still finds it.
+inline ThreadPool& sharedThreadPool() {
+    static ThreadPool* pool = new ThreadPool(defaultThreadCount());
+    return *pool;
+}
@@ -3,14 +3,62 @@
 // common world elements
 #include "world/universe.hpp"
 #include "world/particle.hpp"
+#include "world/ensemble.hpp"
+#include "world/initializers.hpp"
+#include "world/snapshot.hpp"
+#include "world/step_pipeline.hpp"
+#include "world/hard_sphere_universe.hpp"
 
 // common interactors.
 #include "world/interactions/gravity.hpp"
 #include "world/interactions/lennard_jones.hpp"
 
+// bonded terms
+#include "world/bonds/bonded_network.hpp"
+#include "world/bonds/harmonic.hpp"
+#include "world/bonds/fene.hpp"
+#include "world/bonds/angle.hpp"
+
+// integrators
+#include "world/integrators/stormer_verlet.hpp"
+#include "world/integrators/forest_ruth.hpp"
+#include "world/integrators/runge_kutta.hpp"
+#include "world/integrators/rattle.hpp"
+
+// in-situ analysis
+#include "world/analysis/radial_distribution.hpp"
+#include "world/analysis/coordination.hpp"
+#include "world/analysis/pair_energy.hpp"
+#include "world/analysis/mean_squared_displacement.hpp"
+#include "world/analysis/clusters.hpp"
+#include "world/analysis/energy.hpp"
+
+// long range solvers
+#include "world/long_range/direct_summation.hpp"
+#include "world/long_range/fmm.hpp"
+#include "world/long_range/particle_mesh.hpp"
+
 // common forces
 #include "world/forces/gravity.hpp"
 
+// particle sources
+#include "world/sources/box_source.hpp"
+
+// common walls
+#include "world/walls/lennard_jones.hpp"
+#include "world/walls/harmonic.hpp"
+#include "world/walls/specular.hpp"
+
 // common visualizer
 #include "visualizer/sdl/sdl_visualizer.hpp"
 #include "visualizer/xml_visualizer.hpp"
+#include "visualizer/trajectory_visualizer.hpp"
+#include "visualizer/shared_memory_visualizer.hpp"
+#include "visualizer/shared_memory/shared_frame_reader.hpp"
+
+// scenarios
+#include "scenario/scenario.hpp"
+
+// trajectories
+#include "trajectory/frame_source.hpp"
+#include "trajectory/playback.hpp"
@@ -0,0 +1,566 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <charconv>
+#include <cstring>
+#include <cctype>
+#include <cstddef>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "scenario_format.hpp"
+#include "../world/universe.hpp"
+#include "../world/interactions/lennard_jones.hpp"
+#include "../world/interactions/gravity.hpp"
+#include "../world/forces/gravity.hpp"
+#include "../world/walls/lennard_jones.hpp"
+#include "../world/walls/harmonic.hpp"
+#include "../world/walls/specular.hpp"
+#include "../world/integrators/stormer_verlet.hpp"
+#include "../world/integrators/forest_ruth.hpp"
+#include "../world/integrators/runge_kutta.hpp"
+#include "../parallel/parallel_for.hpp"
+
+/// @brief The settings of a scenario, as written in the text header of its file.
+///         Interactors, forces, walls, integrators and outputs are kept as their words, a name then its parameters:
+///
+///         interactor lennard_jones [sigma epsilon] | gravity
+///         force gravity <g>
+///         wall lennard_jones [sigma epsilon] | harmonic <stiffness> <range> | specular
+///         integrator stormer_verlet | position_verlet | forest_ruth | runge_kutta
+///         output <anything>, left to the program running the scenario
+struct ScenarioSettings {
+    typedef std::vector<std::string> Directive;
+
+    unsigned int dimension = 2;
+    double length = 1.0;
+    double cut = 1.0;
+    BORDER_TYPE border = BORDER_TYPE::absorbent;
+    // empty to let the universe choose
+    std::string grid;
+    unsigned int cell_division = 1;
+    unsigned int thread_count = 1;
+    double time_step = 0.001;
+    unsigned long steps = 1000;
+    // cinetic energy the universe is brought back to, 0 to let it evolve freely
+    double restrain_energy = 0.0;
+    Directive wall;
+    Directive integrator;
+    std::vector<Directive> interactors;
+    std::vector<Directive> forces;
+    std::vector<Directive> outputs;
+    unsigned long particle_count = 0;
+
+    /// @brief Writes the text header, up to and including the end line.
+    void write(std::ostream& stream) const {
+        static const char* BORDER_NAMES[] = {"absorbent", "reflexive", "periodic"};
+        stream << ScenarioFormat::MAGIC << " " << ScenarioFormat::VERSION << "\n";
+        stream << "dimension " << this->dimension << "\n";
+        stream << "length " << formatNumber(this->length) << "\n";
+        stream << "cut " << formatNumber(this->cut) << "\n";
+        stream << "border " << BORDER_NAMES[this->border] << "\n";
+        if(!this->grid.empty()) {
+            stream << "grid " << this->grid << "\n";
+        }
+        stream << "cell_division " << this->cell_division << "\n";
+        stream << "threads " << this->thread_count << "\n";
+        stream << "time_step " << formatNumber(this->time_step) << "\n";
+        stream << "steps " << this->steps << "\n";
+        if(this->restrain_energy > 0) {
+            stream << "restrain_energy " << formatNumber(this->restrain_energy) << "\n";
+        }
+        writeDirective(stream, "wall", this->wall);
+        writeDirective(stream, "integrator", this->integrator);
+        for(const Directive& interactor: this->interactors) {
+            writeDirective(stream, "interactor", interactor);
+        }
+        for(const Directive& force: this->forces) {
+            writeDirective(stream, "force", force);
+        }
+        for(const Directive& output: this->outputs) {
+            writeDirective(stream, "output", output);
+        }
+        stream << "particles " << this->particle_count << "\n";
+        stream << ScenarioFormat::END << "\n";
+    }
+
+    /// @brief Reads the text header, up to and including the end line. Empty lines and lines starting with # are skipped.
+    /// @return false if the header is not valid, after printing the faulty line.
+    bool parse(std::istream& stream) {
+        std::string line;
+        unsigned int version = 0;
+        if(!std::getline(stream, line) || !(std::istringstream(line) >> std::ws >> line >> version)
+            || line != ScenarioFormat::MAGIC || version != ScenarioFormat::VERSION) {
+            std::cout << "ERROR : The file is not a scenario of version " << ScenarioFormat::VERSION << "." << std::endl;
+            return false;
+        }
+        while(std::getline(stream, line)) {
+            Directive words;
+            std::istringstream line_stream(line);
+            std::string word;
+            while(line_stream >> word) {
+                words.push_back(word);
+            }
+            if(words.empty() || words[0][0] == '#') {
+                continue;
+            }
+            if(words[0] == ScenarioFormat::END) {
+                return true;
+            }
+            if(!this->parseDirective(words)) {
+                std::cout << "ERROR : Invalid scenario line: " << line << std::endl;
+                return false;
+            }
+        }
+        std::cout << "ERROR : The scenario header has no end line." << std::endl;
+        return false;
+    }
+
+    private:
+    /// @brief Shortest text reading back as the same double, so headers stay readable and exact.
+    static std::string formatNumber(double value) {
+        char buffer[32];
+        return std::string(buffer, std::to_chars(buffer, buffer + sizeof(buffer), value).ptr);
+    }
+
+    static void writeDirective(std::ostream& stream, const char* name, const Directive& directive) {
+        if(directive.empty()) {
+            return;
+        }
+        stream << name;
+        for(const std::string& word: directive) {
+            stream << " " << word;
+        }
+        stream << "\n";
+    }
+
+    template<typename T>
+    static bool parseValue(const Directive& words, T& value) {
+        if(words.size() != 2) {
+            return false;
+        }
+        std::istringstream stream(words[1]);
+        return (bool)(stream >> value) && stream.eof();
+    }
+
+    bool parseDirective(const Directive& words) {
+        const std::string& name = words[0];
+        Directive arguments(words.begin() + 1, words.end());
+        if(name == "dimension") {
+            return parseValue(words, this->dimension);
+        }
+        if(name == "length") {
+            return parseValue(words, this->length);
+        }
+        if(name == "cut") {
+            return parseValue(words, this->cut);
+        }
+        if(name == "cell_division") {
+            return parseValue(words, this->cell_division);
+        }
+        if(name == "threads") {
+            return parseValue(words, this->thread_count);
+        }
+        if(name == "time_step") {
+            return parseValue(words, this->time_step);
+        }
+        if(name == "steps") {
+            return parseValue(words, this->steps);
+        }
+        if(name == "restrain_energy") {
+            return parseValue(words, this->restrain_energy);
+        }
+        if(name == "particles") {
+            return parseValue(words, this->particle_count);
+        }
+        if(name == "border") {
+            static const char* BORDER_NAMES[] = {"absorbent", "reflexive", "periodic"};
+            for(unsigned int border = 0; border < 3; border++) {
+                if(words.size() == 2 && words[1] == BORDER_NAMES[border]) {
+                    this->border = (BORDER_TYPE)border;
+                    return true;
+                }
+            }
+            return false;
+        }
+        if(name == "grid") {
+            this->grid = words.size() == 2 ? words[1] : "";
+            return this->grid == "dense" || this->grid == "sparse";
+        }
+        if(arguments.empty()) {
+            return false;
+        }
+        if(name == "wall") {
+            this->wall = arguments;
+        }
+        else if(name == "integrator") {
+            this->integrator = arguments;
+        }
+        else if(name == "interactor") {
+            this->interactors.push_back(arguments);
+        }
+        else if(name == "force") {
+            this->forces.push_back(arguments);
+        }
+        else if(name == "output") {
+            this->outputs.push_back(arguments);
+        }
+        else {
+            return false;
+        }
+        return true;
+    }
+};
+
+/// @brief A scenario file, mapped in memory: the settings of the header, and the particle block.
+///         Particles are decoded straight from the mapping into the storage of the universe by several threads,
+///         so loading is bound by the disk, and the page cache is shared between runs of the same scenario.
+///         The scenario owns the interactors, forces, wall and integrator of the universes it creates, it must outlive them.
+/// @tparam D The number of dimensions of the simulation.
+template<unsigned int D>
+class Scenario {
+    private:
+    ScenarioSettings settings;
+    bool open = false;
+    const uint8_t* mapping = nullptr;
+    size_t mapping_size = 0;
+    // the records, not aligned once the header was edited
+    const uint8_t* block = nullptr;
+    // physics of the created universes
+    std::vector<std::unique_ptr<Interactor<D>>> interactors;
+    std::vector<std::unique_ptr<Force<D>>> forces;
+    std::vector<std::unique_ptr<Wall>> walls;
+    std::vector<std::unique_ptr<Integrator<D>>> integrators;
+
+    public:
+    /// @brief Maps a scenario file and reads its header.
+    /// @param file_name the path of the file.
+    Scenario(std::string file_name) {
+        int file = ::open(file_name.c_str(), O_RDONLY);
+        struct stat status;
+        if(file < 0 || fstat(file, &status) != 0 || status.st_size == 0) {
+            std::cout << "ERROR : The file can not be open." << std::endl;
+            if(file >= 0) {
+                ::close(file);
+            }
+            return;
+        }
+        this->mapping_size = status.st_size;
+        void* mapping = mmap(nullptr, this->mapping_size, PROT_READ, MAP_PRIVATE, file, 0);
+        // the mapping keeps the file alive
+        ::close(file);
+        if(mapping == MAP_FAILED) {
+            std::cout << "ERROR : The file can not be mapped." << std::endl;
+            return;
+        }
+        this->mapping = (const uint8_t*)mapping;
+
+        // the header is text, up to the end line. It holds no zeros, the padding after it does
+        const char* text = (const char*)this->mapping;
+        size_t header_size = 0;
+        bool has_end = false;
+        for(size_t line = 0; line < this->mapping_size && text[line] != '\0' && !has_end;) {
+            size_t line_end = line;
+            while(line_end < this->mapping_size && text[line_end] != '\n' && text[line_end] != '\0') {
+                line_end++;
+            }
+            std::istringstream words(std::string(text + line, line_end - line));
+            std::string first;
+            has_end = (words >> first) && first == ScenarioFormat::END;
+            line = line_end < this->mapping_size && text[line_end] == '\n' ? line_end + 1 : line_end;
+            header_size = line;
+        }
+        if(!has_end) {
+            std::cout << "ERROR : The scenario header has no end line." << std::endl;
+            return;
+        }
+        std::istringstream header(std::string(text, header_size));
+        if(!this->settings.parse(header)) {
+            return;
+        }
+        if(this->settings.dimension != D) {
+            std::cout << "ERROR : The scenario is in " << this->settings.dimension << " dimensions, not " << D << "." << std::endl;
+            return;
+        }
+        // the block ends the file, the header before it may have been edited
+        uint64_t block_size = this->settings.particle_count * sizeof(ScenarioFormat::ParticleRecord<D>);
+        if(block_size > this->mapping_size - header_size) {
+            std::cout << "ERROR : The scenario file is truncated." << std::endl;
+            return;
+        }
+        uint64_t block_offset = this->mapping_size - block_size;
+        // anything else than padding between the header and the block means the particle count is wrong
+        for(uint64_t offset = header_size; offset < block_offset; offset++) {
+            if(text[offset] != '\0' && !std::isspace((unsigned char)text[offset])) {
+                std::cout << "ERROR : The scenario file does not hold " << this->settings.particle_count << " particles." << std::endl;
+                return;
+            }
+        }
+        this->block = this->mapping + block_offset;
+        // a count too large starts the block in the header or its padding
+        uint32_t marker;
+        if(block_size > 0) {
+            std::memcpy(&marker, this->block + offsetof(ScenarioFormat::ParticleRecord<D>, marker), sizeof(marker));
+            if(marker != ScenarioFormat::RECORD_MARKER) {
+                std::cout << "ERROR : The scenario file does not hold " << this->settings.particle_count << " particles." << std::endl;
+                return;
+            }
+        }
+        // start reading ahead the whole block, before the threads fault on it
+        madvise((void*)this->mapping, this->mapping_size, MADV_WILLNEED);
+        this->open = true;
+    }
+
+    ~Scenario() {
+        if(this->mapping != nullptr) {
+            munmap((void*)this->mapping, this->mapping_size);
+        }
+    }
+
+    Scenario(const Scenario&) = delete;
+    Scenario& operator=(const Scenario&) = delete;
+
+    public:
+    bool isOpen() const {
+        return this->open;
+    }
+
+    const ScenarioSettings& getSettings() const {
+        return this->settings;
+    }
+
+    unsigned long getParticleCount() const {
+        return this->open ? this->settings.particle_count : 0;
+    }
+
+    /// @brief Decodes the particles of the file. Ids are taken from the file, and reserved so new particles do not reuse them.
+    /// @param particles output, room for capacity particles.
+    /// @param capacity the number of particles to read at most.
+    /// @param thread_count the number of threads decoding the particles.
+    /// @return the number of particles written.
+    unsigned int readParticles(Particle<D>* particles, unsigned int capacity, unsigned int thread_count) const {
+        unsigned int count = std::min<unsigned long>(this->getParticleCount(), capacity);
+        std::vector<int> max_ids(std::max(thread_count, 1u), -1);
+        parallelFor(thread_count, 0, count, [&](unsigned int begin, unsigned int end, unsigned int thread) {
+            for(unsigned int i = begin; i < end; i++) {
+                ScenarioFormat::ParticleRecord<D> record;
+                std::memcpy(&record, this->block + i * sizeof(record), sizeof(record));
+                particles[i] = Particle<D>(record.id, Vector<double, D>(record.position), Vector<double, D>(record.velocity), record.mass);
+                max_ids[thread] = std::max(max_ids[thread], record.id);
+            }
+        });
+        Particle<D>::reserveIdsUpTo(*std::max_element(max_ids.begin(), max_ids.end()));
+        return count;
+    }
+
+    /// @brief Creates a universe from the scenario: its particles, border, grid, threads, wall, integrator, interactors and forces.
+    ///         The outputs are left to the caller.
+    /// @return the universe, or nullptr if the scenario does not fit in this universe type.
+    template<unsigned int N, double LD, double RCUT>
+    Universe<D, N, LD, RCUT>* createUniverse() {
+        if(!this->open) {
+            return nullptr;
+        }
+        if(this->settings.length != LD || this->settings.cut != RCUT || this->settings.particle_count > N) {
+            std::cout << "ERROR : The scenario needs a universe of length " << this->settings.length << ", cut " << this->settings.cut
+                << " and " << this->settings.particle_count << " particles." << std::endl;
+            return nullptr;
+        }
+        // check the physics before loading a large particle block
+        Wall* wall = this->createWall(this->settings.wall);
+        Integrator<D>* integrator = this->createIntegrator(this->settings.integrator);
+        std::vector<Interactor<D>*> interactors;
+        for(const ScenarioSettings::Directive& directive: this->settings.interactors) {
+            interactors.push_back(this->createInteractor(directive));
+        }
+        std::vector<Force<D>*> forces;
+        for(const ScenarioSettings::Directive& directive: this->settings.forces) {
+            forces.push_back(this->createForce(directive));
+        }
+        if((!this->settings.wall.empty() && wall == nullptr) || (!this->settings.integrator.empty() && integrator == nullptr)
+            || std::find(interactors.begin(), interactors.end(), nullptr) != interactors.end()
+            || std::find(forces.begin(), forces.end(), nullptr) != forces.end()) {
+            return nullptr;
+        }
+
+        unsigned int thread_count = std::max(this->settings.thread_count, 1u);
+        Universe<D, N, LD, RCUT>* universe = new Universe<D, N, LD, RCUT>([&](Particle<D>* particles) {
+            return this->readParticles(particles, N, thread_count);
+        });
+        universe->setThreadCount(thread_count);
+        universe->set_border_type(this->settings.border);
+        if(!this->settings.grid.empty()) {
+            universe->setGridType(this->settings.grid == "sparse" ? GRID_TYPE::sparse : GRID_TYPE::dense);
+        }
+        if(this->settings.restrain_energy > 0) {
+            universe->restrainCineticEnergy(this->settings.restrain_energy);
+        }
+        if(this->settings.cell_division > 1) {
+            universe->setCellDivision(this->settings.cell_division);
+        }
+        if(wall != nullptr) {
+            universe->setWall(wall);
+        }
+        if(integrator != nullptr) {
+            universe->setIntegrator(integrator);
+        }
+        for(Interactor<D>* interactor: interactors) {
+            universe->registerInteractor(interactor);
+        }
+        for(Force<D>* force: forces) {
+            universe->registerForce(force);
+        }
+        return universe;
+    }
+
+    /// @brief Writes a scenario file: the header of the settings, with their particle count set to count, and the particle block.
+    /// @return false if the file can not be written.
+    static bool write(std::string file_name, ScenarioSettings settings, const Particle<D>* particles, unsigned int count) {
+        std::ofstream file(file_name, std::ios::binary);
+        if(!file) {
+            std::cout << "ERROR : The file can not be open." << std::endl;
+            return false;
+        }
+        settings.dimension = D;
+        settings.particle_count = count;
+        std::ostringstream header;
+        settings.write(header);
+        std::string text = header.str();
+        file.write(text.data(), text.size());
+        std::vector<char> padding(blockOffset(text.size()) - text.size(), 0);
+        file.write(padding.data(), padding.size());
+        // written in slices, so the records of large scenarios are not all in memory twice
+        std::vector<ScenarioFormat::ParticleRecord<D>> records;
+        const unsigned int SLICE = 1 << 16;
+        for(unsigned int begin = 0; begin < count; begin += SLICE) {
+            unsigned int end = std::min(begin + SLICE, count);
+            records.assign(end - begin, ScenarioFormat::ParticleRecord<D>());
+            for(unsigned int i = begin; i < end; i++) {
+                ScenarioFormat::ParticleRecord<D>& record = records[i - begin];
+                record.id = particles[i].getId();
+                record.marker = ScenarioFormat::RECORD_MARKER;
+                for(unsigned int dim = 0; dim < D; dim++) {
+                    record.position[dim] = particles[i].getPosition()[dim];
+                    record.velocity[dim] = particles[i].getVelocity()[dim];
+                }
+                record.mass = particles[i].getMass();
+            }
+            file.write((const char*)records.data(), records.size() * sizeof(ScenarioFormat::ParticleRecord<D>));
+        }
+        return (bool)file;
+    }
+
+    private:
+    static uint64_t blockOffset(uint64_t header_size) {
+        return (header_size + ScenarioFormat::BLOCK_ALIGNMENT - 1) / ScenarioFormat::BLOCK_ALIGNMENT * ScenarioFormat::BLOCK_ALIGNMENT;
+    }
+
+    /// @brief Reads the numbers after the name of a directive.
+    /// @return false if there are not between min and max of them, or if one is not a number.
+    static bool parseParameters(const ScenarioSettings::Directive& directive, std::vector<double>& parameters, unsigned int min, unsigned int max) {
+        parameters.clear();
+        for(unsigned int i = 1; i < directive.size(); i++) {
+            std::istringstream stream(directive[i]);
+            double value;
+            if(!(stream >> value) || !stream.eof()) {
+                return false;
+            }
+            parameters.push_back(value);
+        }
+        return parameters.size() >= min && parameters.size() <= max;
+    }
+
+    static void printUnknown(const char* kind, const ScenarioSettings::Directive& directive) {
+        std::cout << "ERROR : Unknown " << kind << ":";
+        for(const std::string& word: directive) {
+            std::cout << " " << word;
+        }
+        std::cout << std::endl;
+    }
+
+    Interactor<D>* createInteractor(const ScenarioSettings::Directive& directive) {
+        std::vector<double> parameters;
+        if(directive[0] == "lennard_jones" && parseParameters(directive, parameters, 0, 2)) {
+            this->interactors.emplace_back(new LennardJonesInteractor<D>(
+                parameters.size() > 0 ? parameters[0] : 1.0, parameters.size() > 1 ? parameters[1] : 1.0
+            ));
+        }
+        else if(directive[0] == "gravity" && parseParameters(directive, parameters, 0, 0)) {
+            this->interactors.emplace_back(new GravityInteractor<D>());
+        }
+        else {
+            printUnknown("interactor", directive);
+            return nullptr;
+        }
+        return this->interactors.back().get();
+    }
+
+    Force<D>* createForce(const ScenarioSettings::Directive& directive) {
+        std::vector<double> parameters;
+        if(directive[0] == "gravity" && parseParameters(directive, parameters, 1, 1)) {
+            this->forces.emplace_back(new GravityForce<D>(parameters[0]));
+        }
+        else {
+            printUnknown("force", directive);
+            return nullptr;
+        }
+        return this->forces.back().get();
+    }
+
+    Wall* createWall(const ScenarioSettings::Directive& directive) {
+        std::vector<double> parameters;
+        if(directive.empty()) {
+            return nullptr;
+        }
+        if(directive[0] == "lennard_jones" && parseParameters(directive, parameters, 0, 2)) {
+            this->walls.emplace_back(new LennardJonesMirrorWall(
+                parameters.size() > 0 ? parameters[0] : 1.0, parameters.size() > 1 ? parameters[1] : 1.0
+            ));
+        }
+        else if(directive[0] == "harmonic" && parseParameters(directive, parameters, 2, 2)) {
+            this->walls.emplace_back(new HarmonicWall(parameters[0], parameters[1]));
+        }
+        else if(directive[0] == "specular" && parseParameters(directive, parameters, 0, 0)) {
+            this->walls.emplace_back(new SpecularWall());
+        }
+        else {
+            printUnknown("wall", directive);
+            return nullptr;
+        }
+        return this->walls.back().get();
+    }
+
+    Integrator<D>* createIntegrator(const ScenarioSettings::Directive& directive) {
+        if(directive.empty()) {
+            return nullptr;
+        }
+        if(directive.size() != 1) {
+            printUnknown("integrator", directive);
+            return nullptr;
+        }
+        if(directive[0] == "stormer_verlet") {
+            this->integrators.emplace_back(new StormerVerletIntegrator<D>());
+        }
+        else if(directive[0] == "position_verlet") {
+            this->integrators.emplace_back(new PositionVerletIntegrator<D>());
+        }
+        else if(directive[0] == "forest_ruth") {
+            this->integrators.emplace_back(new ForestRuthIntegrator<D>());
+        }
+        else if(directive[0] == "runge_kutta") {
+            this->integrators.emplace_back(new RungeKuttaIntegrator<D>());
+        }
+        else {
+            printUnknown("integrator", directive);
+            return nullptr;
+        }
+        return this->integrators.back().get();
+    }
+};
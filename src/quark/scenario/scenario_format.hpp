@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+/// Layout of the scenario files:
+///
+///     text header    : "quark-scenario <version>", then one setting per line, "particles <count>", and "end"
+///     padding        : zeros up to a multiple of BLOCK_ALIGNMENT bytes
+///     particle block : one ParticleRecord per particle, in the byte order of the host, up to the end of the file
+///
+/// The header is meant to be edited by hand: the physics of a scenario can change without touching the particles.
+/// The block is found from the end of the file, so the header may grow or shrink, and only zeros or whitespace
+/// may sit between the end line and the block.
+/// The particle block is fixed size records, so it is mapped in memory and decoded by several threads at once.
+namespace ScenarioFormat {
+    constexpr const char* MAGIC = "quark-scenario";
+    constexpr const char* END = "end";
+    constexpr uint32_t VERSION = 1;
+    constexpr uint64_t BLOCK_ALIGNMENT = 64;
+    /// Written in every record, so a block that does not start where it should is caught.
+    constexpr uint32_t RECORD_MARKER = 0x6b727571;
+
+    template<unsigned int D>
+    struct ParticleRecord {
+        int32_t id;
+        uint32_t marker;
+        double position[D];
+        double velocity[D];
+        double mass;
+    };
+}
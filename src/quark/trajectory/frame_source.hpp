@@ -0,0 +1,141 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <algorithm>
+#include "trajectory_reader.hpp"
+#include "../world/particle.hpp"
+
+/// @brief Virtual class for anything that gives access to the recorded frames of a run.
+/// @tparam D The number of dimensions of the simulation.
+template<unsigned int D>
+class FrameSource {
+    public:
+    virtual ~FrameSource() {}
+    /// @brief Number of frames available.
+    virtual unsigned int getFrameCount() = 0;
+    /// @brief Loads a frame.
+    /// @param frame the index of the frame.
+    /// @param particles filled with the particles of the frame.
+    /// @return false if the frame could not be read.
+    virtual bool readFrame(unsigned int frame, std::vector<Particle<D>>& particles) = 0;
+};
+
+/// @brief Frames of a compressed trajectory file, written by a TrajectoryVisualizer.
+template<unsigned int D>
+class TrajectoryFrameSource : public FrameSource<D> {
+    private:
+    TrajectoryReader<D> reader;
+
+    public:
+    TrajectoryFrameSource(std::string file_name) : reader(file_name) {}
+
+    public:
+    unsigned int getFrameCount() override {
+        return this->reader.getFrameCount();
+    }
+
+    bool readFrame(unsigned int frame, std::vector<Particle<D>>& particles) override {
+        return this->reader.readFrame(frame, particles);
+    }
+};
+
+/// @brief Frames of a series of .vtu files, written by an XMLVisualizer: prefix0.vtu, prefix1.vtu, ...
+///         The series ends at the first missing file. The particles keep their recorded ids, files without ids
+///         get new ones.
+template<unsigned int D>
+class VTUFrameSource : public FrameSource<D> {
+    private:
+    std::string prefix;
+    unsigned int frame_count = 0;
+
+    public:
+    VTUFrameSource(std::string prefix) : prefix(prefix) {
+        while(std::ifstream(this->getFileName(this->frame_count)).good()) {
+            this->frame_count++;
+        }
+    }
+
+    public:
+    unsigned int getFrameCount() override {
+        return this->frame_count;
+    }
+
+    bool readFrame(unsigned int frame, std::vector<Particle<D>>& particles) override {
+        std::ifstream file(this->getFileName(frame));
+        if(!file) {
+            return false;
+        }
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        std::string content = buffer.str();
+
+        // number of points, from the piece tag
+        size_t points_attribute = content.find("NumberOfPoints=\"");
+        if(points_attribute == std::string::npos) {
+            return false;
+        }
+        unsigned int count = std::strtoul(content.c_str() + points_attribute + 16, nullptr, 10);
+        std::vector<double> positions;
+        std::vector<double> velocities;
+        std::vector<double> masses;
+        if(!this->readArray(content, "\"Position\"", 3 * count, positions)
+            || !this->readArray(content, "\"Velocity\"", 3 * count, velocities)
+            || !this->readArray(content, "\"Masse\"", count, masses)) {
+            return false;
+        }
+        std::vector<double> ids;
+        bool has_ids = this->readArray(content, "\"Id\"", count, ids);
+        particles.resize(count);
+        int max_id = -1;
+        for(unsigned int i = 0; i < count; i++) {
+            Vector<double, D> pos;
+            Vector<double, D> vel;
+            // the files always store 3 components
+            for(unsigned int dim = 0; dim < D; dim++) {
+                pos[dim] = dim < 3 ? positions[3 * i + dim] : 0;
+                vel[dim] = dim < 3 ? velocities[3 * i + dim] : 0;
+            }
+            if(has_ids) {
+                particles[i] = Particle<D>((int)ids[i], pos, vel, masses[i]);
+                max_id = std::max(max_id, (int)ids[i]);
+            }
+            else {
+                particles[i] = Particle<D>(pos, vel, Vector<double, D>(), masses[i]);
+            }
+        }
+        Particle<D>::reserveIdsUpTo(max_id);
+        return true;
+    }
+
+    private:
+    std::string getFileName(unsigned int frame) const {
+        return this->prefix + std::to_string(frame) + ".vtu";
+    }
+
+    /// @brief Reads the values of the data array with the given name.
+    bool readArray(const std::string& content, const char* name, unsigned int count, std::vector<double>& values) const {
+        size_t attribute = content.find(name);
+        if(attribute == std::string::npos) {
+            return false;
+        }
+        size_t start = content.find('>', attribute);
+        if(start == std::string::npos) {
+            return false;
+        }
+        const char* cursor = content.c_str() + start + 1;
+        values.resize(count);
+        for(unsigned int i = 0; i < count; i++) {
+            char* end;
+            values[i] = std::strtod(cursor, &end);
+            if(end == cursor) {
+                return false;
+            }
+            cursor = end;
+        }
+        return true;
+    }
+};
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <map>
+#include <list>
+#include <mutex>
+#include <cmath>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+#include "frame_source.hpp"
+#include "../visualizer/visualizer.hpp"
+
+/// @brief Plays back recorded frames to visualizers, without simulating anything.
+///         It exposes the particles of the current frame like a universe does, so any Visualizer<Playback<D>>
+///         can draw it. A background thread decodes the next frames ahead of the playhead, following the speed.
+/// @tparam D The number of dimensions of the simulation.
+template<unsigned int D>
+class Playback {
+    private:
+    FrameSource<D>* source;
+    unsigned int frame_count;
+    unsigned int prefetch_count;
+    std::list<Visualizer<Playback<D>>*> registered_visualizers;
+    std::vector<Particle<D>> current;
+    unsigned int current_frame = 0;
+
+    // shared with the prefetch thread
+    std::mutex mutex;
+    std::condition_variable condition;
+    double position = 0;
+    double speed = 1;
+    bool stopping = false;
+    std::map<unsigned int, std::vector<Particle<D>>> cache;
+    std::thread prefetcher;
+
+    public:
+    /// @brief Creates a playback of the given frames.
+    /// @param source where the frames are read from. Only used by the prefetch thread.
+    /// @param prefetch_count how many frames are decoded in advance.
+    Playback(FrameSource<D>* source, unsigned int prefetch_count = 8) :
+        source(source),
+        frame_count(source->getFrameCount()),
+        prefetch_count(std::max(prefetch_count, 1u)) {
+        this->prefetcher = std::thread(&Playback<D>::prefetch, this);
+    }
+
+    ~Playback() {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->stopping = true;
+        }
+        this->condition.notify_all();
+        this->prefetcher.join();
+    }
+
+    public:
+    // getters, as for a universe
+    const std::vector<Particle<D>>& getParticles() const {
+        return this->current;
+    }
+
+    unsigned int getFrame() const {
+        return this->current_frame;
+    }
+
+    unsigned int getFrameCount() const {
+        return this->frame_count;
+    }
+
+    public:
+    void registerVisualizer(Visualizer<Playback<D>>* visualizer) {
+        this->registered_visualizers.push_back(visualizer);
+    }
+
+    /// @brief Sets how many frames the playhead moves at each step. Can be fractional, or negative to play backward.
+    void setSpeed(double speed) {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->speed = speed;
+        }
+        this->condition.notify_all();
+    }
+
+    /// @brief Moves the playhead to the given frame.
+    void seek(unsigned int frame) {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->position = std::min(frame, this->frame_count > 0 ? this->frame_count - 1 : 0);
+        }
+        this->condition.notify_all();
+    }
+
+    /// @brief Shows the frame under the playhead to all visualizers, then moves the playhead.
+    /// @return false once the playhead left the recording, nothing is drawn then.
+    bool step();
+
+    private:
+    void prefetch();
+    /// @brief Frame under the playhead, k steps from now. Must be called with the mutex locked.
+    long predictFrame(unsigned int k) const {
+        return (long)floor(this->position + k * this->speed);
+    }
+};
+
+template<unsigned int D>
+bool Playback<D>::step() {
+    long frame;
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        // wake up the prefetcher, and wait for the frame if it is not ready yet.
+        // the frame is read again after each wake up, as the playhead may have been moved by a seek.
+        this->condition.notify_all();
+        this->condition.wait(lock, [&]() {
+            frame = this->predictFrame(0);
+            return this->stopping || frame < 0 || frame >= (long)this->frame_count || this->cache.contains(frame);
+        });
+        if(this->stopping || frame < 0 || frame >= (long)this->frame_count) {
+            return false;
+        }
+        if(frame != this->current_frame || this->current.empty()) {
+            this->current = this->cache[frame];
+            this->current_frame = frame;
+        }
+        this->position += this->speed;
+    }
+    this->condition.notify_all();
+
+    for(Visualizer<Playback<D>>* visualizer: this->registered_visualizers) {
+        visualizer->draw(this);
+    }
+    return true;
+}
+
+/// @brief Prefetch thread: decodes the next frames that the playhead will reach, and drops the ones it will not.
+template<unsigned int D>
+void Playback<D>::prefetch() {
+    std::vector<Particle<D>> particles;
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while(!this->stopping) {
+        // first upcoming frame that is not decoded yet
+        long wanted = -1;
+        for(unsigned int k = 0; k < this->prefetch_count; k++) {
+            long frame = this->predictFrame(k);
+            if(frame < 0 || frame >= (long)this->frame_count) {
+                break;
+            }
+            if(!this->cache.contains(frame)) {
+                wanted = frame;
+                break;
+            }
+        }
+        if(wanted < 0) {
+            this->condition.wait(lock);
+            continue;
+        }
+
+        // decode without holding the lock, so the playback keeps going
+        lock.unlock();
+        bool success = this->source->readFrame(wanted, particles);
+        lock.lock();
+        if(!success) {
+            particles.clear(); // shown as an empty frame
+        }
+        this->cache[wanted] = particles;
+
+        // drop the frames the playhead will not reach anymore
+        for(auto it = this->cache.begin(); it != this->cache.end();) {
+            bool upcoming = false;
+            for(unsigned int k = 0; k < this->prefetch_count; k++) {
+                upcoming = upcoming || this->predictFrame(k) == (long)it->first;
+            }
+            it = upcoming ? std::next(it) : this->cache.erase(it);
+        }
+        this->condition.notify_all();
+    }
+}
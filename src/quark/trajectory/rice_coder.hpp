@@ -0,0 +1,161 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <cstddef>
+
+/// @brief Zig zag mapping of signed integers on unsigned ones, so small residuals of any sign give small codes.
+inline uint64_t zigzagEncode(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+inline int64_t zigzagDecode(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+/// @brief Writes bits in a byte buffer, least significant bits first.
+class BitWriter {
+    private:
+    std::vector<uint8_t>& buffer;
+    uint64_t accumulator = 0;
+    unsigned int accumulated_bits = 0;
+
+    public:
+    BitWriter(std::vector<uint8_t>& buffer) : buffer(buffer) {}
+
+    public:
+    /// @brief Writes the count lowest bits of value. count must be at most 57.
+    inline void write(uint64_t value, unsigned int count) {
+        if(count == 0) {
+            return;
+        }
+        this->accumulator |= (value & ((1ull << count) - 1)) << this->accumulated_bits;
+        this->accumulated_bits += count;
+        while(this->accumulated_bits >= 8) {
+            this->buffer.push_back((uint8_t)this->accumulator);
+            this->accumulator >>= 8;
+            this->accumulated_bits -= 8;
+        }
+    }
+
+    /// @brief Writes the pending bits, padding the last byte with zeros.
+    void flush() {
+        if(this->accumulated_bits > 0) {
+            this->buffer.push_back((uint8_t)this->accumulator);
+        }
+        this->accumulator = 0;
+        this->accumulated_bits = 0;
+    }
+};
+
+/// @brief Reads bits written by a BitWriter. Reading past the end gives zeros.
+class BitReader {
+    private:
+    const uint8_t* data;
+    size_t size;
+    size_t position = 0;
+    uint64_t accumulator = 0;
+    unsigned int accumulated_bits = 0;
+
+    public:
+    BitReader(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+    public:
+    /// @brief Reads count bits. count must be at most 57.
+    inline uint64_t read(unsigned int count) {
+        if(count == 0) {
+            return 0;
+        }
+        while(this->accumulated_bits < count) {
+            uint64_t byte = this->position < this->size ? this->data[this->position] : 0;
+            this->position++;
+            this->accumulator |= byte << this->accumulated_bits;
+            this->accumulated_bits += 8;
+        }
+        uint64_t result = this->accumulator & ((1ull << count) - 1);
+        this->accumulator >>= count;
+        this->accumulated_bits -= count;
+        return result;
+    }
+};
+
+/// @brief Adaptive Golomb-Rice coder for blocks of residuals.
+///         Each block of BLOCK_SIZE values picks the Rice parameter k that minimizes its size: a value u is written as
+///         u >> k in unary followed by the k low bits of u. Geometrically distributed residuals, as given by a good
+///         predictor, are then coded close to their entropy. Outliers are escaped and written raw.
+namespace RiceCoder {
+    constexpr unsigned int BLOCK_SIZE = 64;
+    constexpr unsigned int ESCAPE = 24; // unary length from which the value is written raw
+
+    /// @brief Size in bits of a value with the parameter k.
+    inline uint64_t codeLength(uint64_t value, unsigned int k) {
+        uint64_t quotient = value >> k;
+        return quotient < ESCAPE ? quotient + 1 + k : ESCAPE + 64;
+    }
+
+    /// @brief Encodes the zig zagged values.
+    inline void encode(const uint64_t* values, size_t count, BitWriter& writer) {
+        for(size_t block = 0; block < count; block += BLOCK_SIZE) {
+            size_t end = std::min(count, block + BLOCK_SIZE);
+            // k is close to log2 of the mean, try the neighbors of that guess
+            uint64_t sum = 0;
+            for(size_t i = block; i < end; i++) {
+                // saturate the outliers so the sum can not overflow
+                sum += std::min(values[i], (uint64_t)1 << 50);
+            }
+            uint64_t mean = sum / (end - block);
+            unsigned int guess = 0;
+            while(guess < 56 && (1ull << (guess + 1)) <= mean) {
+                guess++;
+            }
+            unsigned int best_k = guess;
+            uint64_t best_length = UINT64_MAX;
+            for(unsigned int k = guess > 1 ? guess - 1 : 0; k <= std::min(guess + 1, 56u); k++) {
+                uint64_t length = 0;
+                for(size_t i = block; i < end; i++) {
+                    length += codeLength(values[i], k);
+                }
+                if(length < best_length) {
+                    best_length = length;
+                    best_k = k;
+                }
+            }
+            writer.write(best_k, 6);
+            for(size_t i = block; i < end; i++) {
+                uint64_t quotient = values[i] >> best_k;
+                if(quotient < ESCAPE) {
+                    // quotient ones then a zero
+                    writer.write((1ull << quotient) - 1, quotient + 1);
+                    writer.write(values[i], best_k);
+                }
+                else {
+                    writer.write((1ull << ESCAPE) - 1, ESCAPE);
+                    writer.write(values[i], 32);
+                    writer.write(values[i] >> 32, 32);
+                }
+            }
+        }
+    }
+
+    /// @brief Decodes count zig zagged values.
+    inline void decode(uint64_t* values, size_t count, BitReader& reader) {
+        for(size_t block = 0; block < count; block += BLOCK_SIZE) {
+            size_t end = std::min(count, block + BLOCK_SIZE);
+            unsigned int k = reader.read(6);
+            for(size_t i = block; i < end; i++) {
+                uint64_t quotient = 0;
+                while(quotient < ESCAPE && reader.read(1) == 1) {
+                    quotient++;
+                }
+                if(quotient < ESCAPE) {
+                    values[i] = (quotient << k) | reader.read(k);
+                }
+                else {
+                    uint64_t low = reader.read(32);
+                    values[i] = low | (reader.read(32) << 32);
+                }
+            }
+        }
+    }
+}
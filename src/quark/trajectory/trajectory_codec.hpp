@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include "rice_coder.hpp"
+
+/// @brief Quantized state of the last frames. The encoder and the decoder keep the same state,
+///         so they make the same predictions.
+class TrajectoryCodecState {
+    public:
+    /// @brief number of frames available for the predictions since the last keyframe, at most 2.
+    unsigned int history = 0;
+    unsigned int particle_count = 0;
+    /// @brief quantized components of the last frame [0] and of the one before [1].
+    std::vector<int64_t> positions[2];
+    std::vector<int64_t> velocities[2];
+    std::vector<double> masses;
+    std::vector<int> ids;
+
+    public:
+    /// @brief Pushes a new frame in the history.
+    void push(std::vector<int64_t>& new_positions, std::vector<int64_t>& new_velocities, bool keyframe) {
+        this->history = keyframe ? 1 : std::min(this->history + 1, 2u);
+        std::swap(this->positions[1], this->positions[0]);
+        std::swap(this->positions[0], new_positions);
+        std::swap(this->velocities[1], this->velocities[0]);
+        std::swap(this->velocities[0], new_velocities);
+    }
+};
+
+namespace TrajectoryCodec {
+    inline int64_t quantize(double value, double precision) {
+        return std::isfinite(value) ? std::llround(value / precision) : 0;
+    }
+
+    /// @brief Prediction of a component of the next frame. Positions are extrapolated linearly from the last two frames,
+    ///         velocities are predicted constant, as they are much noisier.
+    inline int64_t predict(const TrajectoryCodecState& state, bool is_position, size_t i) {
+        const std::vector<int64_t>* history = is_position ? state.positions : state.velocities;
+        if(is_position && state.history >= 2) {
+            return 2 * history[0][i] - history[1][i];
+        }
+        return history[0][i];
+    }
+
+    /// @brief Residuals of a component stream: with the previous particle for keyframes, with the prediction otherwise.
+    inline void computeResiduals(const TrajectoryCodecState& state, const std::vector<int64_t>& values, unsigned int dimension, bool is_position, bool keyframe, std::vector<uint64_t>& residuals) {
+        residuals.resize(values.size());
+        for(size_t i = 0; i < values.size(); i++) {
+            int64_t reference;
+            if(keyframe) {
+                reference = i >= dimension ? values[i - dimension] : 0;
+            }
+            else {
+                reference = predict(state, is_position, i);
+            }
+            residuals[i] = zigzagEncode(values[i] - reference);
+        }
+    }
+
+    /// @brief Inverse of computeResiduals.
+    inline void applyResiduals(const TrajectoryCodecState& state, const std::vector<uint64_t>& residuals, unsigned int dimension, bool is_position, bool keyframe, std::vector<int64_t>& values) {
+        values.resize(residuals.size());
+        for(size_t i = 0; i < residuals.size(); i++) {
+            int64_t reference;
+            if(keyframe) {
+                reference = i >= dimension ? values[i - dimension] : 0;
+            }
+            else {
+                reference = predict(state, is_position, i);
+            }
+            values[i] = reference + zigzagDecode(residuals[i]);
+        }
+    }
+
+    /// @brief Writes the masses as runs of equal values.
+    inline void encodeMasses(const std::vector<double>& masses, BitWriter& writer) {
+        std::vector<std::pair<double, uint32_t>> runs;
+        for(double mass: masses) {
+            if(!runs.empty() && runs.back().first == mass) {
+                runs.back().second++;
+            }
+            else {
+                runs.push_back({mass, 1});
+            }
+        }
+        writer.write(runs.size(), 32);
+        for(auto& run: runs) {
+            uint64_t bits;
+            std::memcpy(&bits, &run.first, sizeof(bits));
+            writer.write(bits, 32);
+            writer.write(bits >> 32, 32);
+            writer.write(run.second, 32);
+        }
+    }
+
+    /// @brief Writes the particle ids as their difference with the id following the previous one,
+    ///         so particles created together cost a bit each.
+    inline void encodeIds(const std::vector<int>& ids, std::vector<uint64_t>& residuals, BitWriter& writer) {
+        residuals.resize(ids.size());
+        int64_t expected = 0;
+        for(size_t i = 0; i < ids.size(); i++) {
+            residuals[i] = zigzagEncode(ids[i] - expected);
+            expected = (int64_t)ids[i] + 1;
+        }
+        RiceCoder::encode(residuals.data(), residuals.size(), writer);
+    }
+
+    inline void decodeIds(std::vector<int>& ids, unsigned int count, std::vector<uint64_t>& residuals, BitReader& reader) {
+        residuals.resize(count);
+        RiceCoder::decode(residuals.data(), count, reader);
+        ids.resize(count);
+        int64_t expected = 0;
+        for(size_t i = 0; i < count; i++) {
+            ids[i] = expected + zigzagDecode(residuals[i]);
+            expected = (int64_t)ids[i] + 1;
+        }
+    }
+
+    inline void decodeMasses(std::vector<double>& masses, BitReader& reader) {
+        masses.clear();
+        uint64_t run_count = reader.read(32);
+        for(uint64_t run = 0; run < run_count; run++) {
+            uint64_t bits = reader.read(32);
+            bits |= reader.read(32) << 32;
+            double mass;
+            std::memcpy(&mass, &bits, sizeof(mass));
+            masses.insert(masses.end(), reader.read(32), mass);
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+/// Layout of the trajectory files, in the byte order of the host:
+///
+///     file header  : "QTRJ", version, dimension, keyframe interval, position precision, velocity precision
+///     frames       : "QFRM", flags, particle count, payload size, payload
+///     frame index  : "QIDX", frame count, offset and flags of each frame
+///     footer       : offset of the frame index, "QEND"
+///
+/// Positions and velocities are quantized to a fixed precision. The payload of a keyframe holds the masses
+/// (run length encoded), the particle ids and the difference between consecutive particles, the payload of the other frames
+/// holds the difference with a prediction from the previous frames. These residuals are coded with an
+/// adaptive Rice code. The index is written when the file is closed, a file without it can still be read sequentially.
+namespace TrajectoryFormat {
+    constexpr char FILE_MAGIC[4] = {'Q', 'T', 'R', 'J'};
+    constexpr char FRAME_MAGIC[4] = {'Q', 'F', 'R', 'M'};
+    constexpr char INDEX_MAGIC[4] = {'Q', 'I', 'D', 'X'};
+    constexpr char END_MAGIC[4] = {'Q', 'E', 'N', 'D'};
+    constexpr uint32_t VERSION = 2;
+    constexpr uint32_t KEYFRAME_FLAG = 1;
+
+    struct FileHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t dimension;
+        uint32_t keyframe_interval;
+        double position_precision;
+        double velocity_precision;
+    };
+
+    struct FrameHeader {
+        char magic[4];
+        uint32_t flags;
+        uint32_t particle_count;
+        uint32_t padding;
+        uint64_t payload_size;
+    };
+
+    struct IndexEntry {
+        uint64_t offset;
+        uint32_t flags;
+        uint32_t particle_count;
+    };
+
+    struct Footer {
+        uint64_t index_offset;
+        char magic[4];
+        uint32_t padding;
+    };
+}
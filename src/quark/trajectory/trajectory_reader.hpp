@@ -0,0 +1,190 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include "trajectory_format.hpp"
+#include "trajectory_codec.hpp"
+#include "../world/particle.hpp"
+
+/// @brief Random access to the frames of a trajectory file written by a TrajectoryWriter.
+///         Reading a frame decodes from the closest keyframe before it, or from the last decoded frame
+///         when reading forward, so sequential reads cost one frame each.
+/// @tparam D The number of dimensions of the simulation.
+template<unsigned int D>
+class TrajectoryReader {
+    private:
+    std::ifstream file;
+    TrajectoryFormat::FileHeader header;
+    std::vector<TrajectoryFormat::IndexEntry> index;
+    TrajectoryCodecState state;
+    long decoded_frame = -1;
+    // buffers reused between frames
+    std::vector<uint8_t> payload;
+    std::vector<uint64_t> residuals;
+    std::vector<int64_t> positions;
+    std::vector<int64_t> velocities;
+
+    public:
+    /// @brief Opens a trajectory file, and loads its frame index.
+    /// @param file_name the path of the file.
+    TrajectoryReader(std::string file_name) {
+        this->file.open(file_name, std::ios::binary);
+        if(!this->file || !this->file.read((char*)&this->header, sizeof(this->header))
+            || std::memcmp(this->header.magic, TrajectoryFormat::FILE_MAGIC, 4) != 0
+            || this->header.version != TrajectoryFormat::VERSION || this->header.dimension != D) {
+            std::cout << "ERROR : The file is not a trajectory of this version and dimension." << std::endl;
+            this->file.close();
+            return;
+        }
+        if(!this->readIndex()) {
+            this->scanFrames();
+        }
+    }
+
+    public:
+    bool isOpen() const {
+        return this->file.is_open();
+    }
+
+    unsigned int getFrameCount() const {
+        return this->index.size();
+    }
+
+    unsigned int getParticleCount(unsigned int frame) const {
+        return frame < this->index.size() ? this->index[frame].particle_count : 0;
+    }
+
+    /// @brief Decodes a frame. The particles keep their recorded ids, which are never given to new particles.
+    /// @param frame the index of the frame.
+    /// @param particles filled with the particles of the frame.
+    /// @return false if the frame does not exist or can not be read.
+    bool readFrame(unsigned int frame, std::vector<Particle<D>>& particles);
+
+    private:
+    bool readIndex();
+    void scanFrames();
+    bool decodeFrame(unsigned int frame);
+};
+
+template<unsigned int D>
+bool TrajectoryReader<D>::readFrame(unsigned int frame, std::vector<Particle<D>>& particles) {
+    if(!this->isOpen() || frame >= this->index.size()) {
+        return false;
+    }
+    // decode forward from the last decoded frame, or from the keyframe before the requested one
+    unsigned int start = frame;
+    while(start > 0 && !(this->index[start].flags & TrajectoryFormat::KEYFRAME_FLAG) && (long)start - 1 != this->decoded_frame) {
+        start--;
+    }
+    if(!(this->index[start].flags & TrajectoryFormat::KEYFRAME_FLAG) && (long)start - 1 != this->decoded_frame) {
+        return false; // no keyframe to start from
+    }
+    if((long)frame == this->decoded_frame) {
+        start = frame + 1; // already decoded
+    }
+    for(unsigned int current = start; current <= frame; current++) {
+        if(!this->decodeFrame(current)) {
+            this->decoded_frame = -1;
+            return false;
+        }
+    }
+
+    unsigned int count = this->state.particle_count;
+    particles.resize(count);
+    int max_id = -1;
+    for(unsigned int i = 0; i < count; i++) {
+        Vector<double, D> pos;
+        Vector<double, D> vel;
+        for(unsigned int dim = 0; dim < D; dim++) {
+            pos[dim] = this->state.positions[0][i * D + dim] * this->header.position_precision;
+            vel[dim] = this->state.velocities[0][i * D + dim] * this->header.velocity_precision;
+        }
+        particles[i] = Particle<D>(this->state.ids[i], pos, vel, this->state.masses[i]);
+        max_id = std::max(max_id, this->state.ids[i]);
+    }
+    Particle<D>::reserveIdsUpTo(max_id);
+    return true;
+}
+
+template<unsigned int D>
+bool TrajectoryReader<D>::decodeFrame(unsigned int frame) {
+    TrajectoryFormat::FrameHeader frame_header;
+    this->file.clear();
+    this->file.seekg(this->index[frame].offset);
+    if(!this->file.read((char*)&frame_header, sizeof(frame_header)) || std::memcmp(frame_header.magic, TrajectoryFormat::FRAME_MAGIC, 4) != 0) {
+        return false;
+    }
+    this->payload.resize(frame_header.payload_size);
+    if(!this->file.read((char*)this->payload.data(), this->payload.size())) {
+        return false;
+    }
+    bool keyframe = frame_header.flags & TrajectoryFormat::KEYFRAME_FLAG;
+    unsigned int components = frame_header.particle_count * D;
+    BitReader reader(this->payload.data(), this->payload.size());
+    if(keyframe) {
+        TrajectoryCodec::decodeMasses(this->state.masses, reader);
+        TrajectoryCodec::decodeIds(this->state.ids, frame_header.particle_count, this->residuals, reader);
+    }
+    this->residuals.resize(components);
+    RiceCoder::decode(this->residuals.data(), components, reader);
+    TrajectoryCodec::applyResiduals(this->state, this->residuals, D, true, keyframe, this->positions);
+    RiceCoder::decode(this->residuals.data(), components, reader);
+    TrajectoryCodec::applyResiduals(this->state, this->residuals, D, false, keyframe, this->velocities);
+    this->state.particle_count = frame_header.particle_count;
+    this->state.push(this->positions, this->velocities, keyframe);
+    this->decoded_frame = frame;
+    return true;
+}
+
+/// @brief Loads the frame index from the end of the file.
+/// @return false if the file has no index, for example if the run was interrupted.
+template<unsigned int D>
+bool TrajectoryReader<D>::readIndex() {
+    TrajectoryFormat::Footer footer;
+    this->file.seekg(-(long)sizeof(footer), std::ios::end);
+    if(!this->file.read((char*)&footer, sizeof(footer)) || std::memcmp(footer.magic, TrajectoryFormat::END_MAGIC, 4) != 0) {
+        this->file.clear();
+        return false;
+    }
+    char magic[4];
+    uint64_t frame_count;
+    this->file.seekg(footer.index_offset);
+    if(!this->file.read(magic, 4) || std::memcmp(magic, TrajectoryFormat::INDEX_MAGIC, 4) != 0
+        || !this->file.read((char*)&frame_count, sizeof(frame_count))) {
+        this->file.clear();
+        return false;
+    }
+    this->index.resize(frame_count);
+    if(!this->file.read((char*)this->index.data(), frame_count * sizeof(TrajectoryFormat::IndexEntry))) {
+        this->index.clear();
+        this->file.clear();
+        return false;
+    }
+    return true;
+}
+
+/// @brief Rebuilds the frame index by walking through the frames, stopping at the first incomplete one.
+template<unsigned int D>
+void TrajectoryReader<D>::scanFrames() {
+    this->file.seekg(0, std::ios::end);
+    uint64_t size = this->file.tellg();
+    uint64_t offset = sizeof(this->header);
+    TrajectoryFormat::FrameHeader frame_header;
+    while(offset + sizeof(frame_header) <= size) {
+        this->file.seekg(offset);
+        if(!this->file.read((char*)&frame_header, sizeof(frame_header)) || std::memcmp(frame_header.magic, TrajectoryFormat::FRAME_MAGIC, 4) != 0) {
+            break;
+        }
+        uint64_t next = offset + sizeof(frame_header) + frame_header.payload_size;
+        if(next > size) {
+            break;
+        }
+        this->index.push_back({offset, frame_header.flags, frame_header.particle_count});
+        offset = next;
+    }
+    this->file.clear();
+}
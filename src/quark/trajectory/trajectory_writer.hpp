@@ -0,0 +1,154 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include "trajectory_format.hpp"
+#include "trajectory_codec.hpp"
+#include "../world/particle.hpp"
+
+/// @brief Streams the frames of a run into a single compressed trajectory file.
+///         See trajectory_format.hpp for the layout of the file.
+/// @tparam D The number of dimensions of the simulation.
+template<unsigned int D>
+class TrajectoryWriter {
+    private:
+    std::ofstream file;
+    TrajectoryFormat::FileHeader header;
+    TrajectoryCodecState state;
+    std::vector<TrajectoryFormat::IndexEntry> index;
+    unsigned int frames_since_keyframe = 0;
+    uint64_t offset = 0;
+    // buffers reused between frames
+    std::vector<int64_t> positions;
+    std::vector<int64_t> velocities;
+    std::vector<double> masses;
+    std::vector<int> ids;
+    std::vector<uint64_t> residuals;
+    std::vector<uint8_t> payload;
+
+    public:
+    /// @brief Creates the trajectory file.
+    /// @param file_name the path of the file.
+    /// @param position_precision the quantization step of the positions.
+    /// @param velocity_precision the quantization step of the velocities.
+    /// @param keyframe_interval the maximum number of frames between two keyframes. Seeking decodes up to this many frames.
+    TrajectoryWriter(std::string file_name, double position_precision = 1e-4, double velocity_precision = 1e-4, unsigned int keyframe_interval = 100) {
+        this->file.open(file_name, std::ios::binary | std::ios::trunc);
+        if(!this->file) {
+            std::cout << "ERROR : The file can not be open." << std::endl;
+            return;
+        }
+        std::memcpy(this->header.magic, TrajectoryFormat::FILE_MAGIC, 4);
+        this->header.version = TrajectoryFormat::VERSION;
+        this->header.dimension = D;
+        this->header.keyframe_interval = std::max(keyframe_interval, 1u);
+        this->header.position_precision = position_precision;
+        this->header.velocity_precision = velocity_precision;
+        this->writeRaw(&this->header, sizeof(this->header));
+    }
+
+    ~TrajectoryWriter() {
+        this->close();
+    }
+
+    public:
+    /// @brief Appends a frame to the trajectory.
+    /// @param particles the particles of the frame.
+    /// @param count the number of particles.
+    void writeFrame(const Particle<D>* particles, unsigned int count);
+
+    /// @brief Writes the frame index and closes the file. Called by the destructor.
+    void close();
+
+    /// @brief Number of bytes written so far.
+    uint64_t getSize() const {
+        return this->offset;
+    }
+
+    private:
+    void writeRaw(const void* data, size_t size) {
+        this->file.write((const char*)data, size);
+        this->offset += size;
+    }
+};
+
+template<unsigned int D>
+void TrajectoryWriter<D>::writeFrame(const Particle<D>* particles, unsigned int count) {
+    if(!this->file.is_open()) {
+        return;
+    }
+    // quantize the frame
+    this->positions.resize(count * D);
+    this->velocities.resize(count * D);
+    this->masses.resize(count);
+    this->ids.resize(count);
+    for(unsigned int i = 0; i < count; i++) {
+        const Vector<double, D>& pos = particles[i].getPosition();
+        const Vector<double, D>& vel = particles[i].getVelocity();
+        for(unsigned int dim = 0; dim < D; dim++) {
+            this->positions[i * D + dim] = TrajectoryCodec::quantize(pos[dim], this->header.position_precision);
+            this->velocities[i * D + dim] = TrajectoryCodec::quantize(vel[dim], this->header.velocity_precision);
+        }
+        this->masses[i] = particles[i].getMass();
+        this->ids[i] = particles[i].getId();
+    }
+
+    // predictions only hold if the particles are the same as in the last frame
+    bool keyframe = this->state.history == 0
+        || this->frames_since_keyframe + 1 >= this->header.keyframe_interval
+        || count != this->state.particle_count
+        || this->masses != this->state.masses
+        || this->ids != this->state.ids;
+
+    this->payload.clear();
+    BitWriter writer(this->payload);
+    if(keyframe) {
+        TrajectoryCodec::encodeMasses(this->masses, writer);
+        TrajectoryCodec::encodeIds(this->ids, this->residuals, writer);
+    }
+    TrajectoryCodec::computeResiduals(this->state, this->positions, D, true, keyframe, this->residuals);
+    RiceCoder::encode(this->residuals.data(), this->residuals.size(), writer);
+    TrajectoryCodec::computeResiduals(this->state, this->velocities, D, false, keyframe, this->residuals);
+    RiceCoder::encode(this->residuals.data(), this->residuals.size(), writer);
+    writer.flush();
+
+    TrajectoryFormat::FrameHeader frame_header;
+    std::memcpy(frame_header.magic, TrajectoryFormat::FRAME_MAGIC, 4);
+    frame_header.flags = keyframe ? TrajectoryFormat::KEYFRAME_FLAG : 0;
+    frame_header.particle_count = count;
+    frame_header.padding = 0;
+    frame_header.payload_size = this->payload.size();
+    this->index.push_back({this->offset, frame_header.flags, count});
+    this->writeRaw(&frame_header, sizeof(frame_header));
+    this->writeRaw(this->payload.data(), this->payload.size());
+
+    // update the state shared with the decoder
+    this->frames_since_keyframe = keyframe ? 0 : this->frames_since_keyframe + 1;
+    this->state.particle_count = count;
+    if(keyframe) {
+        std::swap(this->state.masses, this->masses);
+        std::swap(this->state.ids, this->ids);
+    }
+    this->state.push(this->positions, this->velocities, keyframe);
+}
+
+template<unsigned int D>
+void TrajectoryWriter<D>::close() {
+    if(!this->file.is_open()) {
+        return;
+    }
+    uint64_t index_offset = this->offset;
+    uint64_t frame_count = this->index.size();
+    this->writeRaw(TrajectoryFormat::INDEX_MAGIC, 4);
+    this->writeRaw(&frame_count, sizeof(frame_count));
+    this->writeRaw(this->index.data(), this->index.size() * sizeof(TrajectoryFormat::IndexEntry));
+    TrajectoryFormat::Footer footer;
+    footer.index_offset = index_offset;
+    std::memcpy(footer.magic, TrajectoryFormat::END_MAGIC, 4);
+    footer.padding = 0;
+    this->writeRaw(&footer, sizeof(footer));
+    this->file.close();
+}
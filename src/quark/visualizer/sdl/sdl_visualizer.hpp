@@ -2,13 +2,40 @@
 
 #include <iostream>
 #include <chrono>
+#include <cmath>
+#include <vector>
+#include <limits>
+#include <cstdint>
 #include "SDL2/SDL.h"
 #include "../visualizer.hpp"
 #include "../view_port.hpp"
+#include "../../parallel/parallel_for.hpp"
+
+/// @brief How the SDL visualizer sends the particles to the screen.
+enum class RENDER_MODE {
+    framebuffer, // default: rasterized in parallel on the cpu, uploaded as one texture
+    points, // one batched SDL_RenderDrawPoints call
+};
+
+/// @brief How the pixels of the framebuffer are coloured.
+enum class COLOR_MODE {
+    plain, // default: white where there is any particle
+    density, // number of particles in the pixel
+    velocity, // mean speed of the particles in the pixel
+};
 
 template<typename Universe>
 class SDLVisualizer : public Visualizer<Universe> {
     private:
+    constexpr static unsigned int D = ParticleDimension<UniverseParticle<Universe>>::value;
+
+    /// @brief A chunk drawn as a whole, from its particle count, as it is smaller than a pixel on the screen.
+    struct AggregatedChunk {
+        int x;
+        int y;
+        uint32_t count;
+    };
+
     SDL_Window* window;
     SDL_Event event;
     SDL_Renderer* renderer;
@@ -17,8 +44,34 @@ class SDLVisualizer : public Visualizer<Universe> {
     // view port
     ViewPort view;
     std::chrono::steady_clock::time_point last_draw_time;
-    
-    
+
+    // rendering options
+    RENDER_MODE render_mode = RENDER_MODE::framebuffer;
+    COLOR_MODE color_mode = COLOR_MODE::plain;
+    unsigned int thread_count = defaultThreadCount();
+    // particles per pixel at which the density colour saturates
+    double density_saturation = 16.0;
+    // speed at which the velocity colour saturates
+    double speed_scale = 1.0;
+
+    // framebuffer path: one accumulator per thread, summed into the pixels
+    SDL_Texture* texture = nullptr;
+    Vector<int, 2> texture_size;
+    std::vector<uint32_t> pixels;
+    std::vector<std::vector<uint32_t>> thread_counts;
+    std::vector<std::vector<float>> thread_speeds;
+    // points path
+    std::vector<SDL_Point> screen_points;
+
+    // culling: universes with a chunk grid only go through the chunks in the view port
+    // chunks narrower than this many pixels are aggregated, except for the velocity colour
+    double aggregation_pixels = 1.0;
+    // below this fraction of the universe in the view port, only the particles of the visible chunks are projected
+    double culling_fraction = 0.5;
+    std::vector<unsigned int> visible_particles;
+    std::vector<AggregatedChunk> aggregated_chunks;
+
+
     public:
     SDLVisualizer() {
         // init members
@@ -29,19 +82,31 @@ class SDLVisualizer : public Visualizer<Universe> {
 
         if(SDL_VideoInit(NULL) != 0) {
             // error while initializing the video system, destroy self
+            std::cout << "ERROR : Unable to initialize the SDL video: " << SDL_GetError() << std::endl;
             exit(1); // better error management ?
         }
         // create the window with title, x, y, width, height, flags.
         // here we set the flags so the window grab the focus on creation, and is resizable.
         this->window = SDL_CreateWindow("SDL universe visulizer", 100, 100, window_size[0], window_size[1], SDL_WINDOW_RESIZABLE);
         this->renderer = SDL_CreateRenderer(this->window, -1, 0);
+        if(this->renderer == nullptr) {
+            // no accelerated renderer, as with the dummy video driver: fall back to the software one
+            this->renderer = SDL_CreateRenderer(this->window, -1, SDL_RENDERER_SOFTWARE);
+        }
+        if(this->window == nullptr || this->renderer == nullptr) {
+            std::cout << "ERROR : Unable to create the SDL window: " << SDL_GetError() << std::endl;
+            exit(1);
+        }
 
         this->last_draw_time = std::chrono::steady_clock::now();
     }
 
     ~SDLVisualizer() {
-        SDL_DestroyWindow(this->window);
+        if(this->texture != nullptr) {
+            SDL_DestroyTexture(this->texture);
+        }
         SDL_DestroyRenderer(this->renderer);
+        SDL_DestroyWindow(this->window);
         SDL_Quit();
     }
 
@@ -58,6 +123,42 @@ class SDLVisualizer : public Visualizer<Universe> {
         this->view.dimensions = Vector<unsigned int, 2>(dim);
     }
 
+    void setRenderMode(RENDER_MODE render_mode) {
+        this->render_mode = render_mode;
+    }
+
+    /// @brief Sets the colouring of the pixels. Only used by the framebuffer render mode.
+    void setColorMode(COLOR_MODE color_mode) {
+        this->color_mode = color_mode;
+    }
+
+    /// @brief Sets the number of threads rasterizing the particles.
+    void setThreadCount(unsigned int thread_count) {
+        this->thread_count = std::max(thread_count, 1u);
+    }
+
+    /// @brief Sets the number of particles in a pixel that gives the brightest density colour.
+    void setDensitySaturation(double density_saturation) {
+        this->density_saturation = density_saturation;
+    }
+
+    /// @brief Sets the speed that gives the hottest velocity colour.
+    void setSpeedScale(double speed_scale) {
+        this->speed_scale = speed_scale;
+    }
+
+    /// @brief Sets the width in pixels under which the chunks of a universe are drawn as a whole, from their number of
+    ///         particles, instead of particle by particle. Defaults to 1. 0 always draws the particles.
+    void setAggregationPixels(double aggregation_pixels) {
+        this->aggregation_pixels = aggregation_pixels;
+    }
+
+    /// @brief Sets the fraction of the universe in the view port under which only the chunks in the view are gone through.
+    ///         Defaults to 0.5: above it, projecting every particle is cheaper than gathering them from their chunks.
+    void setCullingFraction(double culling_fraction) {
+        this->culling_fraction = culling_fraction;
+    }
+
     private:
     void handleEvents() {
         while (SDL_PollEvent(&this->event)) {
@@ -85,24 +186,227 @@ class SDLVisualizer : public Visualizer<Universe> {
         this->window_size = Vector<int, 2>(new_size);
     }
 
-    public: 
+    /// @brief Pixel of a particle, or false if it is out of the window.
+    inline bool toPixel(const Particle<D>& particle, int& x, int& y) const {
+        return this->toPixel(particle.getPosition()[view.dimensions[0]], particle.getPosition()[view.dimensions[1]], x, y);
+    }
+
+    /// @brief Pixel of a point of the view port plane, or false if it is out of the window.
+    inline bool toPixel(double u, double v, int& x, int& y) const {
+        double px = (u - view.corner[0]) * window_size[0] / view.size[0];
+        double py = (v - view.corner[1]) * window_size[1] / view.size[1];
+        if(!(px >= 0 && px < window_size[0] && py >= 0 && py < window_size[1])) {
+            return false;
+        }
+        x = (int)px;
+        y = (int)py;
+        return true;
+    }
+
+    /// @brief Maps t in [0, 1] to black, red, yellow then white.
+    static uint32_t heatColor(double t) {
+        t = std::max(0.0, std::min(1.0, t));
+        uint32_t r = (uint32_t)(255 * std::min(1.0, 3 * t));
+        uint32_t g = (uint32_t)(255 * std::max(0.0, std::min(1.0, 3 * t - 1)));
+        uint32_t b = (uint32_t)(255 * std::max(0.0, 3 * t - 2));
+        return 0xFF000000 | (r << 16) | (g << 8) | b;
+    }
+
+    /// @brief Maps t in [0, 1] from blue (slow) to red (fast).
+    static uint32_t speedColor(double t) {
+        t = std::max(0.0, std::min(1.0, t));
+        uint32_t r = (uint32_t)(255 * t);
+        uint32_t g = (uint32_t)(255 * (1 - std::abs(2 * t - 1)) * 0.6);
+        uint32_t b = (uint32_t)(255 * (1 - t));
+        return 0xFF000000 | (r << 16) | (g << 8) | b;
+    }
+
+    /// @brief Rasterizes the particles and the aggregated chunks in the cpu framebuffer, and uploads it in one texture.
+    /// @param count the number of particles to draw.
+    /// @param particleAt gives the k-th particle to draw.
+    template<typename ParticleAt>
+    void drawFramebuffer(unsigned int count, const ParticleAt& particleAt) {
+        int width = this->window_size[0];
+        int height = this->window_size[1];
+        unsigned int pixel_count = width * height;
+        if(this->texture == nullptr || this->texture_size[0] != width || this->texture_size[1] != height) {
+            if(this->texture != nullptr) {
+                SDL_DestroyTexture(this->texture);
+            }
+            this->texture = SDL_CreateTexture(this->renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, width, height);
+            int size[2] = {width, height};
+            this->texture_size = Vector<int, 2>(size);
+            this->pixels.resize(pixel_count);
+        }
+        bool speeds = this->color_mode == COLOR_MODE::velocity;
+        unsigned int threads = std::max(1u, std::min(this->thread_count, count));
+        this->thread_counts.resize(threads);
+        this->thread_speeds.resize(threads);
+
+        // each thread accumulates its share of the particles in its own buffers
+        parallelFor(threads, 0, count, [&](unsigned int begin, unsigned int end, unsigned int thread) {
+            std::vector<uint32_t>& counts = this->thread_counts[thread];
+            std::vector<float>& speed_sums = this->thread_speeds[thread];
+            counts.assign(pixel_count, 0);
+            if(speeds) {
+                speed_sums.assign(pixel_count, 0.0f);
+            }
+            for(unsigned int i = begin; i < end; i++) {
+                int x, y;
+                if(this->toPixel(particleAt(i), x, y)) {
+                    counts[y * width + x]++;
+                    if(speeds) {
+                        speed_sums[y * width + x] += sqrt(particleAt(i).getVelocity().sq_magnitude());
+                    }
+                }
+            }
+        });
+        // the aggregated chunks add their counts to the buffer of the first thread
+        if(!this->aggregated_chunks.empty()) {
+            if(count == 0) {
+                this->thread_counts[0].assign(pixel_count, 0);
+            }
+            for(const AggregatedChunk& chunk: this->aggregated_chunks) {
+                this->thread_counts[0][chunk.y * width + chunk.x] += chunk.count;
+            }
+        }
+        // then the pixels are split between the threads to sum the buffers and colour them
+        unsigned int used_threads = count == 0 ? (this->aggregated_chunks.empty() ? 0 : 1) : threads;
+        parallelFor(this->thread_count, 0, pixel_count, [&](unsigned int begin, unsigned int end, unsigned int thread) {
+            for(unsigned int pixel = begin; pixel < end; pixel++) {
+                uint32_t count = 0;
+                float speed_sum = 0.0f;
+                for(unsigned int t = 0; t < used_threads; t++) {
+                    count += this->thread_counts[t][pixel];
+                    if(speeds) {
+                        speed_sum += this->thread_speeds[t][pixel];
+                    }
+                }
+                if(count == 0) {
+                    this->pixels[pixel] = 0xFF000000;
+                    continue;
+                }
+                switch(this->color_mode) {
+                    case COLOR_MODE::plain:
+                        this->pixels[pixel] = 0xFFFFFFFF;
+                        break;
+                    case COLOR_MODE::density:
+                        this->pixels[pixel] = heatColor(log(1.0 + count) / log(1.0 + this->density_saturation));
+                        break;
+                    case COLOR_MODE::velocity:
+                        this->pixels[pixel] = speedColor(speed_sum / count / this->speed_scale);
+                        break;
+                }
+            }
+        });
+        SDL_UpdateTexture(this->texture, NULL, this->pixels.data(), width * sizeof(uint32_t));
+        SDL_RenderCopy(this->renderer, this->texture, NULL, NULL);
+    }
+
+    /// @brief Converts the particles to screen points in parallel, and draws them in one call, with a point per aggregated chunk.
+    /// @param count the number of particles to draw.
+    /// @param particleAt gives the k-th particle to draw.
+    template<typename ParticleAt>
+    void drawPoints(unsigned int count, const ParticleAt& particleAt) {
+        SDL_SetRenderDrawColor(this->renderer, 0, 0, 0, 255);
+        SDL_RenderClear(this->renderer);
+        SDL_SetRenderDrawColor(this->renderer, 255, 255, 255, 255);
+        this->screen_points.resize(count + this->aggregated_chunks.size());
+        for(unsigned int i = 0; i < this->aggregated_chunks.size(); i++) {
+            this->screen_points[count + i] = SDL_Point{this->aggregated_chunks[i].x, this->aggregated_chunks[i].y};
+        }
+        parallelFor(this->thread_count, 0, count, [&](unsigned int begin, unsigned int end, unsigned int thread) {
+            for(unsigned int i = begin; i < end; i++) {
+                int x, y;
+                if(!this->toPixel(particleAt(i), x, y)) {
+                    // off screen points are clipped by the renderer
+                    x = -1;
+                    y = -1;
+                }
+                this->screen_points[i] = SDL_Point{x, y};
+            }
+        });
+        SDL_RenderDrawPoints(this->renderer, this->screen_points.data(), this->screen_points.size());
+    }
+
+    /// @brief Gathers the particles of the chunks in the view port, or aggregates the chunks when they are smaller than
+    ///         a pixel, so the cost of a frame follows what is shown rather than the size of the universe.
+    /// @return false when most of the universe is in view, and every particle is projected instead.
+    template<typename ChunkedUniverse>
+    bool cullChunks(ChunkedUniverse* universe) {
+        double side = universe->getChunkSide();
+        double length = universe->getLength();
+        double chunk_pixels = std::min(side * this->window_size[0] / this->view.size[0], side * this->window_size[1] / this->view.size[1]);
+        // a chunk is only cheaper than its particles if it holds more than one on average
+        bool aggregate = chunk_pixels < this->aggregation_pixels && this->color_mode != COLOR_MODE::velocity
+            && universe->getChunkCount() < universe->getActiveCount();
+        double fraction = 1.0;
+        for(unsigned int dim = 0; dim < 2; dim++) {
+            double overlap = std::min(this->view.corner[dim] + this->view.size[dim], length) - std::max(this->view.corner[dim], 0.0);
+            fraction *= std::max(overlap, 0.0) / length;
+        }
+        if(!aggregate && fraction >= this->culling_fraction) {
+            return false;
+        }
+        // the view port only bounds the two dimensions it shows
+        Vector<double, D> low = Vector<double, D>([]() { return -std::numeric_limits<double>::infinity(); });
+        Vector<double, D> high = Vector<double, D>([]() { return std::numeric_limits<double>::infinity(); });
+        for(unsigned int dim = 0; dim < 2; dim++) {
+            low[this->view.dimensions[dim]] = this->view.corner[dim];
+            high[this->view.dimensions[dim]] = this->view.corner[dim] + this->view.size[dim];
+        }
+        this->visible_particles.clear();
+        universe->visitChunks(low, high, [&](auto& chunk) {
+            if(!aggregate) {
+                for(auto part = chunk.getParticleBegin(); part != chunk.getParticleEnd(); ++part) {
+                    this->visible_particles.push_back(*part);
+                }
+                return;
+            }
+            // the particles of the chunk all fall in a pixel or two, around its center
+            int x, y;
+            Vector<int, D> coordinates = chunk.getCoordinates();
+            double u = (coordinates[this->view.dimensions[0]] + 0.5) * side;
+            double v = (coordinates[this->view.dimensions[1]] + 0.5) * side;
+            if(chunk.getParticleNumber() > 0 && this->toPixel(u, v, x, y)) {
+                this->aggregated_chunks.push_back(AggregatedChunk{x, y, (uint32_t)chunk.getParticleNumber()});
+            }
+        });
+        return true;
+    }
+
+    template<typename ParticleAt>
+    void render(unsigned int count, const ParticleAt& particleAt) {
+        switch(this->render_mode) {
+            case RENDER_MODE::framebuffer:
+                this->drawFramebuffer(count, particleAt);
+                break;
+            case RENDER_MODE::points:
+                this->drawPoints(count, particleAt);
+                break;
+        }
+    }
+
+    public:
     void draw(Universe* universe) override {
         // get delta time to display
         this->last_draw_time = std::chrono::steady_clock::now();
 
-        SDL_SetRenderDrawColor(this->renderer, 0, 0, 0, 1);
-        SDL_RenderClear(this->renderer);
-        SDL_SetRenderDrawColor(this->renderer, 255, 255, 255, 255);
-        for(auto particle : universe->getParticles()){
-            SDL_RenderDrawPoint(
-                this->renderer,
-                (particle.getPosition()[view.dimensions[0]] - view.corner[0]) * window_size[0] / view.size[0],
-                (particle.getPosition()[view.dimensions[1]] - view.corner[1]) * window_size[1] / view.size[1]
-            );
+        const auto& particles = universe->getParticles();
+        this->aggregated_chunks.clear();
+        bool culled = false;
+        if constexpr(requires { universe->visitChunks(Vector<double, D>(), Vector<double, D>(), [](auto& chunk) {}); universe->getChunkSide(); universe->getChunkCount(); }) {
+            culled = this->cullChunks(universe);
+        }
+        if(culled) {
+            this->render(this->visible_particles.size(), [&](unsigned int i) -> const Particle<D>& { return particles[this->visible_particles[i]]; });
+        }
+        else {
+            this->render(particles.size(), [&](unsigned int i) -> const Particle<D>& { return particles[i]; });
         }
         SDL_RenderPresent(this->renderer);
 
         // events handling so the window is responding
         this->handleEvents();
     }
-};
\ No newline at end of file
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/// Layout of the shared memory segment a SharedFrameWriter publishes its frames in:
+///
+///     header : a RingHeader, padded to SLOT_ALIGNMENT bytes
+///     slots  : slot_count slots of slot_size bytes, each a SlotHeader then capacity ParticleRecords
+///
+/// Frames go to the slots in turn. Each slot is a sequence lock: its sequence is odd while the writer fills it,
+/// and even once the frame is complete. A reader copies the slot of the latest frame, and keeps the copy only if the
+/// sequence did not change in the meantime. The writer never waits for the readers, they drop the frames they miss.
+namespace SharedFrameFormat {
+    constexpr const char* MAGIC = "quark-frames";
+    constexpr uint32_t VERSION = 1;
+    constexpr uint64_t SLOT_ALIGNMENT = 64;
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "The frames are shared between processes through lock free atomics.");
+
+    struct RingHeader {
+        char magic[16];
+        uint32_t version;
+        uint32_t dimension;
+        uint32_t slot_count;
+        uint32_t capacity;
+        uint64_t slot_size;
+        // random for each writer, so a reader sees when the segment was created again under the same name
+        uint64_t session;
+        // number of the last complete frame, 0 before the first one
+        std::atomic<uint64_t> latest_frame;
+        // set when the writer is destroyed
+        std::atomic<uint64_t> closed;
+    };
+
+    struct SlotHeader {
+        std::atomic<uint64_t> sequence;
+        uint64_t frame;
+        double time;
+        uint32_t count;
+        uint32_t padding;
+    };
+
+    template<unsigned int D>
+    struct ParticleRecord {
+        int32_t id;
+        uint32_t padding;
+        double position[D];
+        double velocity[D];
+        double mass;
+    };
+
+    constexpr uint64_t align(uint64_t size) {
+        return (size + SLOT_ALIGNMENT - 1) / SLOT_ALIGNMENT * SLOT_ALIGNMENT;
+    }
+
+    template<unsigned int D>
+    constexpr uint64_t slotSize(uint32_t capacity) {
+        return align(sizeof(SlotHeader) + capacity * sizeof(ParticleRecord<D>));
+    }
+}
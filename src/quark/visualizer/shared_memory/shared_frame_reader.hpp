@@ -0,0 +1,221 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstddef>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "shared_frame_format.hpp"
+#include "../../world/particle.hpp"
+
+/// @brief Reads the frames a SharedFrameWriter publishes from another process.
+///         It exposes the particles of the last frame read like a universe does, so any Visualizer<SharedFrameReader<D>>
+///         can draw it. Frames published between two updates are dropped, and a frame the writer overwrites while it is
+///         copied is thrown away, so the writer never waits. The reader attaches whenever the segment appears, and
+///         attaches again when another writer creates it anew.
+/// @tparam D The number of dimensions of the simulation.
+template<unsigned int D>
+class SharedFrameReader {
+    private:
+    // attempts to copy the latest frame before giving up until the next update
+    constexpr static unsigned int MAX_ATTEMPTS = 4;
+    // time without frames after which the name of the segment is checked again
+    constexpr static double STALE_CHECK_PERIOD = 1.0;
+
+    std::string name;
+    void* memory = nullptr;
+    uint64_t size = 0;
+    const SharedFrameFormat::RingHeader* header = nullptr;
+    uint64_t session = 0;
+    std::vector<SharedFrameFormat::ParticleRecord<D>> records;
+    std::vector<Particle<D>> particles;
+    uint64_t frame = 0;
+    double time = 0.0;
+    uint64_t dropped_frames = 0;
+    std::chrono::steady_clock::time_point last_check;
+
+    public:
+    /// @param name the name of the segment given to the writer, like "/quark". It may not exist yet.
+    SharedFrameReader(std::string name) : name(name) {
+        this->last_check = std::chrono::steady_clock::now();
+        this->attach();
+    }
+
+    ~SharedFrameReader() {
+        this->detach();
+    }
+
+    SharedFrameReader(const SharedFrameReader&) = delete;
+    SharedFrameReader& operator=(const SharedFrameReader&) = delete;
+
+    /// @brief Maps the segment, if a writer created it.
+    /// @return whether the reader is attached.
+    bool attach() {
+        if(this->memory != nullptr) {
+            return true;
+        }
+        int descriptor = shm_open(this->name.c_str(), O_RDONLY, 0);
+        if(descriptor < 0) {
+            return false;
+        }
+        struct stat status;
+        if(fstat(descriptor, &status) != 0 || (uint64_t)status.st_size < sizeof(SharedFrameFormat::RingHeader)) {
+            // the writer is still sizing it
+            close(descriptor);
+            return false;
+        }
+        void* memory = mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, descriptor, 0);
+        close(descriptor);
+        if(memory == MAP_FAILED) {
+            return false;
+        }
+        const SharedFrameFormat::RingHeader* header = static_cast<const SharedFrameFormat::RingHeader*>(memory);
+        uint64_t expected_size = SharedFrameFormat::align(sizeof(SharedFrameFormat::RingHeader)) + (uint64_t)header->slot_count * header->slot_size;
+        if(std::strncmp(header->magic, SharedFrameFormat::MAGIC, sizeof(header->magic)) != 0 || header->version != SharedFrameFormat::VERSION
+            || header->slot_count == 0 || expected_size > (uint64_t)status.st_size) {
+            // not initialized yet, or not a segment of frames
+            munmap(memory, status.st_size);
+            return false;
+        }
+        if(header->dimension != D) {
+            std::cout << "ERROR : The shared memory " << this->name << " holds frames of dimension " << header->dimension << "." << std::endl;
+            munmap(memory, status.st_size);
+            return false;
+        }
+        this->memory = memory;
+        this->size = status.st_size;
+        this->header = header;
+        this->session = header->session;
+        this->frame = 0;
+        this->records.resize(header->capacity);
+        return true;
+    }
+
+    /// @brief Unmaps the segment. The last frame read stays available.
+    void detach() {
+        if(this->memory == nullptr) {
+            return;
+        }
+        munmap(this->memory, this->size);
+        this->memory = nullptr;
+        this->header = nullptr;
+    }
+
+    bool isAttached() const {
+        return this->memory != nullptr;
+    }
+
+    /// @brief Whether the writer of the attached segment was destroyed.
+    bool isWriterClosed() const {
+        return this->header != nullptr && this->header->closed.load(std::memory_order_acquire) != 0;
+    }
+
+    /// @brief Reads the latest frame if it is newer than the current one, attaching first if needed.
+    ///         Without new frames for a while, checks the segment was not removed or created again, and follows it.
+    /// @return whether a new frame was read.
+    bool update() {
+        if(!this->attach()) {
+            return false;
+        }
+        if(this->readLatest()) {
+            this->last_check = std::chrono::steady_clock::now();
+            return true;
+        }
+        if(this->isWriterClosed()) {
+            this->detach();
+            return false;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if(std::chrono::duration<double>(now - this->last_check).count() > STALE_CHECK_PERIOD) {
+            this->last_check = now;
+            if(this->isStale()) {
+                this->detach();
+            }
+        }
+        return false;
+    }
+
+    // getters, as for a universe
+    const std::vector<Particle<D>>& getParticles() const {
+        return this->particles;
+    }
+
+    /// @brief Number, given by the writer, of the current frame. 0 before the first one.
+    uint64_t getFrame() const {
+        return this->frame;
+    }
+
+    /// @brief Time of the simulation at the current frame.
+    double getTime() const {
+        return this->time;
+    }
+
+    /// @brief Number of frames published but never read, since the reader was created.
+    uint64_t getDroppedFrameCount() const {
+        return this->dropped_frames;
+    }
+
+    private:
+    const SharedFrameFormat::SlotHeader* getSlot(unsigned int slot) const {
+        const char* slots = static_cast<const char*>(this->memory) + SharedFrameFormat::align(sizeof(SharedFrameFormat::RingHeader));
+        return reinterpret_cast<const SharedFrameFormat::SlotHeader*>(slots + slot * this->header->slot_size);
+    }
+
+    /// @brief Copies the slot of the latest frame, and keeps the copy only if the writer did not touch the slot meanwhile.
+    bool readLatest() {
+        for(unsigned int attempt = 0; attempt < MAX_ATTEMPTS; attempt++) {
+            uint64_t latest = this->header->latest_frame.load(std::memory_order_acquire);
+            if(latest == 0 || latest == this->frame) {
+                return false;
+            }
+            const SharedFrameFormat::SlotHeader* slot = this->getSlot(latest % this->header->slot_count);
+            uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+            if(sequence % 2 != 0) {
+                continue;
+            }
+            uint64_t slot_frame = slot->frame;
+            double slot_time = slot->time;
+            uint32_t count = std::min(slot->count, this->header->capacity);
+            std::memcpy(this->records.data(), slot + 1, count * sizeof(SharedFrameFormat::ParticleRecord<D>));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(slot->sequence.load(std::memory_order_relaxed) != sequence || slot_frame != latest) {
+                // overwritten while copying
+                continue;
+            }
+            if(this->frame != 0 && latest > this->frame) {
+                this->dropped_frames += latest - this->frame - 1;
+            }
+            this->frame = latest;
+            this->time = slot_time;
+            this->particles.resize(count);
+            int max_id = -1;
+            for(unsigned int i = 0; i < count; i++) {
+                this->particles[i] = Particle<D>(this->records[i].id, Vector<double, D>(this->records[i].position), Vector<double, D>(this->records[i].velocity), this->records[i].mass);
+                max_id = std::max(max_id, (int)this->records[i].id);
+            }
+            // the particles keep the ids of the writer, new particles of this process must not reuse them
+            Particle<D>::reserveIdsUpTo(max_id);
+            return true;
+        }
+        return false;
+    }
+
+    /// @brief Whether the name of the segment now leads to another segment, or to none.
+    bool isStale() const {
+        int descriptor = shm_open(this->name.c_str(), O_RDONLY, 0);
+        if(descriptor < 0) {
+            return true;
+        }
+        uint64_t session;
+        bool stale = pread(descriptor, &session, sizeof(session), offsetof(SharedFrameFormat::RingHeader, session)) != sizeof(session) || session != this->session;
+        close(descriptor);
+        return stale;
+    }
+};
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <new>
+#include <atomic>
+#include <string>
+#include <random>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "shared_frame_format.hpp"
+#include "../../world/particle.hpp"
+
+/// @brief Publishes frames in a POSIX shared memory segment, for viewers in other processes.
+///         See shared_frame_format.hpp for the layout. Writing a frame never waits: the readers copy the frames
+///         they catch, and a reader that crashes or never comes does not change anything for the writer.
+///         The segment is removed when the writer is destroyed.
+/// @tparam D The number of dimensions of the simulation.
+template<unsigned int D>
+class SharedFrameWriter {
+    private:
+    std::string name;
+    void* memory = nullptr;
+    uint64_t size = 0;
+    SharedFrameFormat::RingHeader* header = nullptr;
+    uint64_t frame = 0;
+    bool warned_capacity = false;
+
+    public:
+    /// @brief Creates the shared memory segment, replacing any segment left with the same name.
+    /// @param name the name of the segment, starting with a slash, like "/quark".
+    /// @param capacity the largest number of particles of a frame. Frames with more particles are cut.
+    /// @param slot_count the number of frames kept. The writer fills the oldest one, so readers have time to copy the others.
+    SharedFrameWriter(std::string name, unsigned int capacity, unsigned int slot_count = 3) : name(name) {
+        slot_count = std::max(slot_count, 2u);
+        uint64_t slot_size = SharedFrameFormat::slotSize<D>(capacity);
+        this->size = SharedFrameFormat::align(sizeof(SharedFrameFormat::RingHeader)) + slot_count * slot_size;
+        // a segment left by a crashed run is dropped, its readers keep their mapping until they see the new session
+        shm_unlink(this->name.c_str());
+        int descriptor = shm_open(this->name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if(descriptor < 0) {
+            std::cout << "ERROR : The shared memory " << this->name << " can not be created." << std::endl;
+            return;
+        }
+        if(ftruncate(descriptor, this->size) != 0) {
+            std::cout << "ERROR : The shared memory " << this->name << " can not be sized." << std::endl;
+            close(descriptor);
+            shm_unlink(this->name.c_str());
+            return;
+        }
+        this->memory = mmap(nullptr, this->size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+        close(descriptor);
+        if(this->memory == MAP_FAILED) {
+            std::cout << "ERROR : The shared memory " << this->name << " can not be mapped." << std::endl;
+            this->memory = nullptr;
+            shm_unlink(this->name.c_str());
+            return;
+        }
+        // the segment starts zeroed: every slot sequence is even and no frame is published
+        this->header = new(this->memory) SharedFrameFormat::RingHeader();
+        std::strncpy(this->header->magic, SharedFrameFormat::MAGIC, sizeof(this->header->magic));
+        this->header->version = SharedFrameFormat::VERSION;
+        this->header->dimension = D;
+        this->header->slot_count = slot_count;
+        this->header->capacity = capacity;
+        this->header->slot_size = slot_size;
+        this->header->session = std::random_device()() | ((uint64_t)std::random_device()() << 32);
+        for(unsigned int slot = 0; slot < slot_count; slot++) {
+            new(this->getSlot(slot)) SharedFrameFormat::SlotHeader();
+        }
+        this->header->closed.store(0, std::memory_order_relaxed);
+        this->header->latest_frame.store(0, std::memory_order_release);
+    }
+
+    ~SharedFrameWriter() {
+        if(this->memory == nullptr) {
+            return;
+        }
+        this->header->closed.store(1, std::memory_order_release);
+        munmap(this->memory, this->size);
+        shm_unlink(this->name.c_str());
+    }
+
+    SharedFrameWriter(const SharedFrameWriter&) = delete;
+    SharedFrameWriter& operator=(const SharedFrameWriter&) = delete;
+
+    bool isOpen() const {
+        return this->memory != nullptr;
+    }
+
+    /// @brief Number of frames published so far.
+    uint64_t getFrameCount() const {
+        return this->frame;
+    }
+
+    /// @brief Publishes a frame. Never blocks.
+    /// @param particles the particles of the frame.
+    /// @param count the number of particles.
+    /// @param time the time of the simulation at this frame.
+    void writeFrame(const Particle<D>* particles, unsigned int count, double time = 0.0) {
+        if(this->memory == nullptr) {
+            return;
+        }
+        if(count > this->header->capacity) {
+            if(!this->warned_capacity) {
+                std::cout << "ERROR : Frames of " << count << " particles are cut to the " << this->header->capacity << " of the shared memory." << std::endl;
+                this->warned_capacity = true;
+            }
+            count = this->header->capacity;
+        }
+        this->frame++;
+        SharedFrameFormat::SlotHeader* slot = this->getSlot(this->frame % this->header->slot_count);
+        // odd sequence: the readers of this slot throw away what they copy from now on
+        uint64_t sequence = slot->sequence.load(std::memory_order_relaxed);
+        slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot->frame = this->frame;
+        slot->time = time;
+        slot->count = count;
+        SharedFrameFormat::ParticleRecord<D>* records = reinterpret_cast<SharedFrameFormat::ParticleRecord<D>*>(slot + 1);
+        for(unsigned int i = 0; i < count; i++) {
+            records[i].id = particles[i].getId();
+            records[i].padding = 0;
+            for(unsigned int dim = 0; dim < D; dim++) {
+                records[i].position[dim] = particles[i].getPosition()[dim];
+                records[i].velocity[dim] = particles[i].getVelocity()[dim];
+            }
+            records[i].mass = particles[i].getMass();
+        }
+        slot->sequence.store(sequence + 2, std::memory_order_release);
+        this->header->latest_frame.store(this->frame, std::memory_order_release);
+    }
+
+    private:
+    SharedFrameFormat::SlotHeader* getSlot(unsigned int slot) {
+        char* slots = static_cast<char*>(this->memory) + SharedFrameFormat::align(sizeof(SharedFrameFormat::RingHeader));
+        return reinterpret_cast<SharedFrameFormat::SlotHeader*>(slots + slot * this->header->slot_size);
+    }
+};
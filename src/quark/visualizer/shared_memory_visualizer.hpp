@@ -0,0 +1,54 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include "visualizer.hpp"
+#include "shared_memory/shared_frame_writer.hpp"
+
+/// @brief Publishes the drawn frames in POSIX shared memory, for a viewer running in its own process, like demo/shm_viewer.
+///         Unlike the SDLVisualizer, closing or crashing the viewer does not stop the run, and the run never waits for it.
+template<typename Universe>
+class SharedMemoryVisualizer : public Visualizer<Universe> {
+    private:
+    constexpr static unsigned int D = ParticleDimension<UniverseParticle<Universe>>::value;
+    SharedFrameWriter<D> writer;
+    // shortest time between two published frames, 0 to publish every draw
+    double frame_period = 1.0 / 60;
+    std::chrono::steady_clock::time_point last_frame_time;
+
+    public:
+    /// @brief Creates the shared memory segment.
+    /// @param name the name of the segment, starting with a slash, like "/quark".
+    /// @param capacity the largest number of particles of a frame, the capacity of the universe.
+    /// @param slot_count the number of frames kept in the segment.
+    SharedMemoryVisualizer(std::string name, unsigned int capacity, unsigned int slot_count = 3) : writer(name, capacity, slot_count) {}
+
+    /// @brief Publishes at most this many frames per second, so the copies do not slow a fast run down. Defaults to 60.
+    ///         0 publishes every drawn frame.
+    void setMaxFrameRate(double frame_rate) {
+        this->frame_period = frame_rate > 0 ? 1.0 / frame_rate : 0.0;
+    }
+
+    bool isOpen() const {
+        return this->writer.isOpen();
+    }
+
+    /// @brief Number of frames published so far.
+    uint64_t getFrameCount() const {
+        return this->writer.getFrameCount();
+    }
+
+    void draw(Universe* universe) override {
+        auto now = std::chrono::steady_clock::now();
+        if(this->writer.getFrameCount() > 0 && std::chrono::duration<double>(now - this->last_frame_time).count() < this->frame_period) {
+            return;
+        }
+        this->last_frame_time = now;
+        const auto& particles = universe->getParticles();
+        double time = 0.0;
+        if constexpr(requires { universe->getTime(); }) {
+            time = universe->getTime();
+        }
+        this->writer.writeFrame(particles.data(), particles.size(), time);
+    }
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include "visualizer.hpp"
+#include "../trajectory/trajectory_writer.hpp"
+
+/// @brief Records every drawn frame in a compressed trajectory file, that can be played back later.
+///         Much smaller than the .vtu files of the XMLVisualizer, and a single file per run.
+template<typename Universe>
+class TrajectoryVisualizer : public Visualizer<Universe> {
+    private:
+    constexpr static unsigned int D = ParticleDimension<UniverseParticle<Universe>>::value;
+    TrajectoryWriter<D> writer;
+
+    public:
+    /// @brief Creates the trajectory file.
+    /// @param file_name the path of the file.
+    /// @param position_precision the quantization step of the positions.
+    /// @param velocity_precision the quantization step of the velocities.
+    /// @param keyframe_interval the maximum number of frames between two keyframes.
+    TrajectoryVisualizer(std::string file_name, double position_precision = 1e-4, double velocity_precision = 1e-4, unsigned int keyframe_interval = 100) :
+        writer(file_name, position_precision, velocity_precision, keyframe_interval) {}
+
+    public:
+    void draw(Universe* universe) override {
+        auto particles = universe->getParticles();
+        this->writer.writeFrame(particles.data(), particles.size());
+    }
+
+    /// @brief Writes the frame index and closes the file. Done automatically when the visualizer is destroyed.
+    void close() {
+        this->writer.close();
+    }
+};
@@ -1,10 +1,25 @@
 #pragma once
 
-#include "../world/universe.hpp"
+#include <type_traits>
+#include "../world/particle.hpp"
+
+/// @brief Type of the particles of a universe, or of anything exposing getParticles() like one.
+template<typename Universe>
+using UniverseParticle = typename std::remove_cvref_t<decltype(std::declval<Universe&>().getParticles())>::value_type;
+
+/// @brief Dimension of a particle type.
+template<typename P>
+struct ParticleDimension;
+
+template<unsigned int D>
+struct ParticleDimension<Particle<D>> {
+    constexpr static unsigned int value = D;
+};
 
 template<typename Universe>
 class Visualizer {
     public:
+    virtual ~Visualizer() {}
     /// @brief Show all the particles on the screen.
     virtual void draw(Universe* universe) = 0;
 };
\ No newline at end of file
@@ -11,14 +11,13 @@ class XMLVisualizer : public Visualizer<Universe> {
 
     private:
     string fileName;
-    int nbPoints;
     int nbCells;
     int nbDimensions;
     int nbIteration = 0;
 
     public:
+    /// @param nbParticles unused: each file holds the particles of the universe at the time of the frame.
     XMLVisualizer(int nbParticles, int nbChunks, int nbDimensions, string globalFileName){
-        this->nbPoints = nbParticles;
         this->nbCells = nbChunks;
         this->nbDimensions = nbDimensions;
         this->fileName = globalFileName;
@@ -34,7 +33,7 @@ class XMLVisualizer : public Visualizer<Universe> {
 
             myFlow << "<VTKFile type=\"UnstructuredGrid\" version=\"0.1\" byte_order=\"BigEndian\">" << endl;
             myFlow << "<UnstructuredGrid>" << endl;
-            myFlow << "<Piece NumberOfPoints=\"" << this->nbPoints <<"\" NumberOfCells=\"" << this->nbCells <<"\">" << endl;
+            myFlow << "<Piece NumberOfPoints=\"" << universe->getParticles().size() <<"\" NumberOfCells=\"" << this->nbCells <<"\">" << endl;
             myFlow << "<Points>" << endl;
             myFlow << "<DataArray name=\"Position\" type=\"Float32\" NumberOfComponents=\"" << 3 << "\" format=\"ascii\">" << endl;
             for(auto particle : universe->getParticles()){
@@ -75,6 +74,13 @@ class XMLVisualizer : public Visualizer<Universe> {
             }
             myFlow << endl;
             myFlow << "</DataArray>" << endl;
+            myFlow << "<DataArray type=\"Int32\" Name=\"Id\" format=\"ascii\">" << endl;
+            for(auto particle : universe->getParticles()){
+                myFlow << particle.getId();
+                myFlow << " ";
+            }
+            myFlow << endl;
+            myFlow << "</DataArray>" << endl;
             myFlow << "</PointData>" << endl;
             myFlow << "<Cells>" << endl;
             myFlow << "<DataArray type=\"Int32\" Name=\"connectivity\" format=\"ascii\">" << endl;
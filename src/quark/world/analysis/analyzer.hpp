@@ -0,0 +1,46 @@
+#pragma once
+
+#include "../../maths/vector.hpp"
+#include "../particle.hpp"
+
+/// @brief Virtual class for statistics over pairs of particles, fed by the pairs the force pass already visits.
+///         Only the pairs found by the neighbour search are seen, so the range must not exceed the cut distance of the universe.
+/// @tparam D The number of dimensions of the simulation.
+template<unsigned int D>
+class PairAnalyzer {
+    public:
+    virtual ~PairAnalyzer() = default;
+
+    /// @brief Distance under which pairs are given to the analyzer.
+    virtual double getRange() = 0;
+
+    /// @brief Called before the pairs of a sampled force pass.
+    /// @param particles the particles of the universe, at the positions of the pass.
+    /// @param count the number of particles.
+    /// @param thread_count the number of threads that may report pairs, each with its own index.
+    virtual void beginSample(const Particle<D>* particles, unsigned int count, unsigned int thread_count) = 0;
+
+    /// @brief Called once for each pair closer than the range, from several threads at once.
+    /// @param i the index of the first particle.
+    /// @param j the index of the second particle.
+    /// @param distance_sq the squared distance between them.
+    /// @param thread the index of the calling thread, to accumulate without locks.
+    virtual void addPair(unsigned int i, unsigned int j, double distance_sq, unsigned int thread) = 0;
+
+    /// @brief Called after the pass, to merge the accumulators of the threads.
+    virtual void endSample() = 0;
+};
+
+/// @brief Virtual class for statistics over the particles themselves, computed after the sampled steps.
+/// @tparam D The number of dimensions of the simulation.
+template<unsigned int D>
+class StepAnalyzer {
+    public:
+    virtual ~StepAnalyzer() = default;
+
+    /// @brief Called after a sampled step.
+    /// @param particles the particles of the universe.
+    /// @param count the number of particles.
+    /// @param thread_count the number of threads the analyzer may use.
+    virtual void analyze(const Particle<D>* particles, unsigned int count, unsigned int thread_count) = 0;
+};
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <ostream>
+#include "analyzer.hpp"
+#include "../../parallel/parallel_for.hpp"
+
+/// @brief Splits the particles in clusters, two particles closer than the bond distance being in the same cluster.
+///         The pairs of the force pass are merged in a lock free union-find: each particle points to a parent of smaller index,
+///         threads link roots with a compare and swap and halve the paths they walk through.
+///         The universe does not wrap the pairs, so clusters are only meaningful in absorbent and reflexive universes.
+/// @tparam D The number of dimensions of the simulation.
+template<unsigned int D>
+class ClusterAnalyzer : public PairAnalyzer<D> {
+    public:
+    /// @brief A cluster at the last sample.
+    struct Cluster {
+        unsigned int size;
+        double mass;
+        Vector<double, D> center_of_mass;
+        Vector<double, D> momentum;
+    };
+
+    private:
+    double range;
+    unsigned int sample_count = 0;
+    const Particle<D>* particles = nullptr;
+    unsigned int thread_count = 1;
+    std::vector<std::atomic<unsigned int>> parents;
+    // cluster of each particle, and the clusters by index of their root
+    std::vector<unsigned int> labels;
+    std::vector<Cluster> clusters;
+    // number of clusters of each size, at the last sample
+    std::vector<unsigned int> size_distribution;
+
+    public:
+    /// @param range the bond distance, under which two particles are in the same cluster.
+    ClusterAnalyzer(double range) : range(range) {}
+
+    double getRange() override {
+        return this->range;
+    }
+
+    void beginSample(const Particle<D>* particles, unsigned int count, unsigned int thread_count) override {
+        this->particles = particles;
+        this->thread_count = thread_count;
+        if(this->parents.size() != count) {
+            this->parents = std::vector<std::atomic<unsigned int>>(count);
+        }
+        parallelFor(thread_count, 0, count, [&](unsigned int begin, unsigned int end, unsigned int thread) {
+            for(unsigned int i = begin; i < end; i++) {
+                this->parents[i].store(i, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    void addPair(unsigned int i, unsigned int j, double distance_sq, unsigned int thread) override {
+        while(true) {
+            i = this->find(i);
+            j = this->find(j);
+            if(i == j) {
+                return;
+            }
+            // the larger root points to the smaller one, so there is never a cycle
+            if(i < j) {
+                std::swap(i, j);
+            }
+            unsigned int expected = i;
+            if(this->parents[i].compare_exchange_weak(expected, j, std::memory_order_acq_rel)) {
+                return;
+            }
+            // another thread linked i in the meantime, start again from the new roots
+        }
+    }
+
+    void endSample() override {
+        unsigned int count = this->parents.size();
+        this->labels.resize(count);
+        // no more links: every particle can find its root in parallel
+        parallelFor(this->thread_count, 0, count, [&](unsigned int begin, unsigned int end, unsigned int thread) {
+            for(unsigned int i = begin; i < end; i++) {
+                this->labels[i] = this->find(i);
+            }
+        });
+        // roots are the particles of smallest index of their cluster, so they number the clusters in order
+        this->clusters.clear();
+        for(unsigned int i = 0; i < count; i++) {
+            if(this->labels[i] == i) {
+                this->labels[i] = this->clusters.size();
+                this->clusters.push_back(Cluster{0, 0.0, Vector<double, D>(), Vector<double, D>()});
+            }
+            else {
+                // the root has a smaller index, it is already numbered
+                this->labels[i] = this->labels[this->labels[i]];
+            }
+            Cluster& cluster = this->clusters[this->labels[i]];
+            double mass = this->particles[i].getMass();
+            cluster.size++;
+            cluster.mass += mass;
+            cluster.center_of_mass += this->particles[i].getPosition() * mass;
+            cluster.momentum += this->particles[i].getVelocity() * mass;
+        }
+        this->size_distribution.clear();
+        for(Cluster& cluster: this->clusters) {
+            cluster.center_of_mass = cluster.center_of_mass / cluster.mass;
+            if(cluster.size >= this->size_distribution.size()) {
+                this->size_distribution.resize(cluster.size + 1, 0);
+            }
+            this->size_distribution[cluster.size]++;
+        }
+        this->particles = nullptr;
+        this->sample_count++;
+    }
+
+    unsigned int getSampleCount() const {
+        return this->sample_count;
+    }
+
+    unsigned int getClusterCount() const {
+        return this->clusters.size();
+    }
+
+    /// @brief The clusters at the last sample, in the order of their first particle.
+    const std::vector<Cluster>& getClusters() const {
+        return this->clusters;
+    }
+
+    /// @brief Cluster of each particle at the last sample, an index in getClusters().
+    const std::vector<unsigned int>& getLabels() const {
+        return this->labels;
+    }
+
+    /// @brief Number of clusters of each size at the last sample.
+    const std::vector<unsigned int>& getSizeDistribution() const {
+        return this->size_distribution;
+    }
+
+    /// @brief Size of the largest cluster at the last sample.
+    unsigned int getLargestClusterSize() const {
+        return this->size_distribution.empty() ? 0 : this->size_distribution.size() - 1;
+    }
+
+    /// @brief Writes one line per cluster: its size, mass, center of mass and momentum.
+    void writeResults(std::ostream& stream) const {
+        for(const Cluster& cluster: this->clusters) {
+            stream << cluster.size << " " << cluster.mass;
+            for(unsigned int dim = 0; dim < D; dim++) {
+                stream << " " << cluster.center_of_mass[dim];
+            }
+            for(unsigned int dim = 0; dim < D; dim++) {
+                stream << " " << cluster.momentum[dim];
+            }
+            stream << std::endl;
+        }
+    }
+
+    private:
+    /// @brief Root of a particle, halving the path on the way. Safe while other threads link roots.
+    inline unsigned int find(unsigned int i) {
+        unsigned int parent = this->parents[i].load(std::memory_order_acquire);
+        while(parent != i) {
+            unsigned int grand_parent = this->parents[parent].load(std::memory_order_acquire);
+            if(grand_parent != parent) {
+                // losing this race is fine: someone else changed the parent, to a smaller index too
+                unsigned int expected = parent;
+                this->parents[i].compare_exchange_weak(expected, grand_parent, std::memory_order_acq_rel);
+            }
+            i = parent;
+            parent = grand_parent;
+        }
+        return i;
+    }
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <vector>
+#include <ostream>
+#include "analyzer.hpp"
+
+/// @brief Number of neighbours of each particle closer than a distance, usually the first minimum of g(r).
+///         Keeps the coordination of every particle for the last sample, and a histogram of the coordinations over all samples.
+/// @tparam D The number of dimensions of the simulation.
+template<unsigned int D>
+class CoordinationAnalyzer : public PairAnalyzer<D> {
+    private:
+    double range;
+    unsigned int sample_count = 0;
+    std::vector<unsigned int> coordinations;
+    std::vector<std::vector<unsigned int>> thread_coordinations;
+    // number of particles with each coordination, over all samples
+    std::vector<unsigned long> histogram;
+
+    public:
+    /// @param range the distance under which two particles are neighbours.
+    CoordinationAnalyzer(double range) : range(range) {}
+
+    double getRange() override {
+        return this->range;
+    }
+
+    void beginSample(const Particle<D>* particles, unsigned int count, unsigned int thread_count) override {
+        this->coordinations.assign(count, 0);
+        this->thread_coordinations.resize(thread_count);
+        for(std::vector<unsigned int>& thread_coordination: this->thread_coordinations) {
+            thread_coordination.assign(count, 0);
+        }
+    }
+
+    void addPair(unsigned int i, unsigned int j, double distance_sq, unsigned int thread) override {
+        this->thread_coordinations[thread][i]++;
+        this->thread_coordinations[thread][j]++;
+    }
+
+    void endSample() override {
+        for(unsigned int part = 0; part < this->coordinations.size(); part++) {
+            unsigned int coordination = 0;
+            for(const std::vector<unsigned int>& thread_coordination: this->thread_coordinations) {
+                coordination += thread_coordination[part];
+            }
+            this->coordinations[part] = coordination;
+            if(coordination >= this->histogram.size()) {
+                this->histogram.resize(coordination + 1, 0);
+            }
+            this->histogram[coordination]++;
+        }
+        this->sample_count++;
+    }
+
+    unsigned int getSampleCount() const {
+        return this->sample_count;
+    }
+
+    /// @brief Coordination of each particle at the last sample.
+    const std::vector<unsigned int>& getCoordinations() const {
+        return this->coordinations;
+    }
+
+    /// @brief Number of particles seen with each coordination, summed over the samples.
+    const std::vector<unsigned long>& getHistogram() const {
+        return this->histogram;
+    }
+
+    /// @brief Mean coordination over all particles and samples.
+    double getMeanCoordination() const {
+        unsigned long particles = 0;
+        unsigned long neighbours = 0;
+        for(unsigned int coordination = 0; coordination < this->histogram.size(); coordination++) {
+            particles += this->histogram[coordination];
+            neighbours += coordination * this->histogram[coordination];
+        }
+        return particles == 0 ? 0.0 : (double)neighbours / particles;
+    }
+
+    /// @brief Writes one line per coordination: the coordination, and the fraction of particles having it.
+    void writeResults(std::ostream& stream) const {
+        unsigned long particles = 0;
+        for(unsigned long count: this->histogram) {
+            particles += count;
+        }
+        for(unsigned int coordination = 0; coordination < this->histogram.size(); coordination++) {
+            stream << coordination << " " << (particles == 0 ? 0.0 : (double)this->histogram[coordination] / particles) << std::endl;
+        }
+    }
+};
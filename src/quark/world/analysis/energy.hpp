@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include <ostream>
+#include "analyzer.hpp"
+#include "../interactions/interactor.hpp"
+
+/// @brief Tracks the conserved quantities of a simulation: kinetic, potential and total energy, and momentum.
+///         The potential energy comes from the interactors over the pairs of the force pass, so it must be registered
+///         both as a pair analyzer and as a step analyzer. Pair energies are shifted to zero at the range, which makes them
+///         the exact potential of forces cut at that range: give the cut distance of the universe.
+///         External forces and walls have no potential, they show up as a drift.
+/// @tparam D The number of dimensions of the simulation.
+template<unsigned int D>
+class EnergyTracker : public PairAnalyzer<D>, public StepAnalyzer<D> {
+    private:
+    double range;
+    std::vector<Interactor<D>*> interactors;
+    const Particle<D>* particles = nullptr;
+    std::vector<double> thread_energies;
+    double pair_energy = 0.0;
+    // one value per sample, in order
+    std::vector<double> kinetic_energies;
+    std::vector<double> potential_energies;
+    std::vector<Vector<double, D>> momenta;
+    // sum of the norms of the momenta of the particles at the first sample, the scale of the momentum drift
+    double momentum_scale = 0.0;
+
+    public:
+    /// @param range the cut distance of the universe.
+    EnergyTracker(double range) : range(range) {}
+
+    /// @brief Adds an interactor to the potential energy. Give the ones registered in the universe.
+    void registerInteractor(Interactor<D>* interactor) {
+        this->interactors.push_back(interactor);
+    }
+
+    double getRange() override {
+        return this->range;
+    }
+
+    void beginSample(const Particle<D>* particles, unsigned int count, unsigned int thread_count) override {
+        this->particles = particles;
+        this->thread_energies.assign(thread_count, 0.0);
+    }
+
+    void addPair(unsigned int i, unsigned int j, double distance_sq, unsigned int thread) override {
+        const Particle<D>& first = this->particles[i];
+        const Particle<D>& second = this->particles[j];
+        // the same pair, moved apart to the range
+        Particle<D> far = second;
+        far.setPosition(first.getPosition() + (second.getPosition() - first.getPosition()) * (this->range / sqrt(distance_sq)));
+        for(Interactor<D>* interactor: this->interactors) {
+            this->thread_energies[thread] += interactor->computePotentialEnergy(first, second) - interactor->computePotentialEnergy(first, far);
+        }
+    }
+
+    void endSample() override {
+        this->pair_energy = 0.0;
+        for(double energy: this->thread_energies) {
+            this->pair_energy += energy;
+        }
+        this->particles = nullptr;
+    }
+
+    void analyze(const Particle<D>* particles, unsigned int count, unsigned int thread_count) override {
+        double kinetic_energy = 0.0;
+        double scale = 0.0;
+        Vector<double, D> momentum = Vector<double, D>();
+        for(unsigned int i = 0; i < count; i++) {
+            Vector<double, D> particle_momentum = particles[i].getVelocity() * particles[i].getMass();
+            kinetic_energy += 0.5 * particles[i].getMass() * particles[i].getVelocity().sq_magnitude();
+            momentum += particle_momentum;
+            scale += sqrt(particle_momentum.sq_magnitude());
+        }
+        if(this->kinetic_energies.empty()) {
+            this->momentum_scale = scale;
+        }
+        this->kinetic_energies.push_back(kinetic_energy);
+        this->potential_energies.push_back(this->pair_energy);
+        this->momenta.push_back(momentum);
+    }
+
+    unsigned int getSampleCount() const {
+        return this->kinetic_energies.size();
+    }
+
+    const std::vector<double>& getKineticEnergies() const {
+        return this->kinetic_energies;
+    }
+
+    const std::vector<double>& getPotentialEnergies() const {
+        return this->potential_energies;
+    }
+
+    /// @brief Total momentum of the particles at each sample.
+    const std::vector<Vector<double, D>>& getMomenta() const {
+        return this->momenta;
+    }
+
+    /// @brief Kinetic plus potential energy at a sample.
+    double getTotalEnergy(unsigned int sample) const {
+        return this->kinetic_energies[sample] + this->potential_energies[sample];
+    }
+
+    /// @brief Largest change of the total energy since the first sample, relative to the sum of the absolute kinetic and
+    ///         potential energies of the first sample, as the total energy is often close to zero.
+    double getEnergyDrift() const {
+        if(this->kinetic_energies.empty()) {
+            return 0.0;
+        }
+        double drift = 0.0;
+        for(unsigned int sample = 1; sample < this->getSampleCount(); sample++) {
+            drift = std::max(drift, std::abs(this->getTotalEnergy(sample) - this->getTotalEnergy(0)));
+        }
+        double scale = this->kinetic_energies[0] + std::abs(this->potential_energies[0]);
+        return scale == 0.0 ? 0.0 : drift / scale;
+    }
+
+    /// @brief Largest change of the total momentum since the first sample, relative to the sum of the norms of the momenta
+    ///         of the particles at the first sample, as the total momentum is often zero.
+    double getMomentumDrift() const {
+        double drift = 0.0;
+        for(unsigned int sample = 1; sample < this->getSampleCount(); sample++) {
+            drift = std::max(drift, (this->momenta[sample] - this->momenta[0]).sq_magnitude());
+        }
+        return this->momentum_scale == 0.0 ? 0.0 : sqrt(drift) / this->momentum_scale;
+    }
+
+    /// @brief Writes one line per sample: the kinetic, potential and total energy, and the momentum.
+    void writeResults(std::ostream& stream) const {
+        for(unsigned int sample = 0; sample < this->getSampleCount(); sample++) {
+            stream << this->kinetic_energies[sample] << " " << this->potential_energies[sample] << " " << this->getTotalEnergy(sample);
+            for(unsigned int dim = 0; dim < D; dim++) {
+                stream << " " << this->momenta[sample][dim];
+            }
+            stream << std::endl;
+        }
+    }
+};
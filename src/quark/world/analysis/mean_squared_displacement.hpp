@@ -0,0 +1,98 @@
+#pragma once
+
+#include <vector>
+#include <limits>
+#include <unordered_map>
+#include <ostream>
+#include "analyzer.hpp"
+#include "../../parallel/parallel_for.hpp"
+#include "../../parallel/reduce.hpp"
+
+/// @brief Mean squared displacement of the particles from their positions at the first sample, one value per sample.
+///         Particles are followed by id, as their indexes change when the universe compacts them. The mean is taken over
+///         the particles of the first sample still in the universe: particles injected later are left out, and the value
+///         is NaN once all of them are gone.
+///         In a periodic universe, a particle jumping more than half the box between two samples is taken as wrapped,
+///         so the samples must be close enough for no particle to really move that far.
+/// @tparam D The number of dimensions of the simulation.
+template<unsigned int D>
+class MeanSquaredDisplacement : public StepAnalyzer<D> {
+    private:
+    // size of the periodic box, or 0 when the universe does not wrap
+    double box_length;
+    bool started = false;
+    // slot of the origin and position of each followed particle, by id
+    std::unordered_map<int, unsigned int> slots;
+    std::vector<Vector<double, D>> origins;
+    // unwrapped positions at the last sample
+    std::vector<Vector<double, D>> positions;
+    // slot of each particle of the current sample, -1 if it is not followed
+    std::vector<int> sample_slots;
+    std::vector<double> values;
+
+    public:
+    /// @param box_length the size of the universe when its border is periodic, 0 otherwise.
+    MeanSquaredDisplacement(double box_length = 0.0) : box_length(box_length) {}
+
+    void analyze(const Particle<D>* particles, unsigned int count, unsigned int thread_count) override {
+        if(!this->started) {
+            // first sample: the origins
+            this->started = true;
+            for(unsigned int i = 0; i < count; i++) {
+                this->slots[particles[i].getId()] = this->origins.size();
+                this->origins.push_back(particles[i].getPosition());
+                this->positions.push_back(particles[i].getPosition());
+            }
+            this->values.push_back(0.0);
+            return;
+        }
+        this->sample_slots.resize(count);
+        unsigned int followed = 0;
+        for(unsigned int i = 0; i < count; i++) {
+            auto slot = this->slots.find(particles[i].getId());
+            this->sample_slots[i] = slot == this->slots.end() ? -1 : slot->second;
+            followed += slot != this->slots.end();
+        }
+        parallelFor(thread_count, 0, count, [&](unsigned int begin, unsigned int end, unsigned int thread) {
+            for(unsigned int i = begin; i < end; i++) {
+                int slot = this->sample_slots[i];
+                if(slot < 0) {
+                    continue;
+                }
+                Vector<double, D> step = particles[i].getPosition() - this->positions[slot];
+                if(this->box_length > 0) {
+                    for(unsigned int dim = 0; dim < D; dim++) {
+                        step[dim] -= this->box_length * round(step[dim] / this->box_length);
+                    }
+                }
+                this->positions[slot] += step;
+            }
+        });
+        double sum = deterministicSum<double>(thread_count, count, [&](unsigned int i) {
+            int slot = this->sample_slots[i];
+            return slot < 0 ? 0.0 : (this->positions[slot] - this->origins[slot]).sq_magnitude();
+        });
+        this->values.push_back(followed > 0 ? sum / followed : std::numeric_limits<double>::quiet_NaN());
+    }
+
+    /// @brief Starts over from the next sample.
+    void reset() {
+        this->started = false;
+        this->slots.clear();
+        this->origins.clear();
+        this->positions.clear();
+        this->values.clear();
+    }
+
+    /// @brief Mean squared displacement of each sample, the first one being 0.
+    const std::vector<double>& getValues() const {
+        return this->values;
+    }
+
+    /// @brief Writes one line per sample: the sample index, and the mean squared displacement.
+    void writeResults(std::ostream& stream) const {
+        for(unsigned int sample = 0; sample < this->values.size(); sample++) {
+            stream << sample << " " << this->values[sample] << std::endl;
+        }
+    }
+};
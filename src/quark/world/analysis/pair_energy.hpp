@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include <ostream>
+#include <functional>
+#include "analyzer.hpp"
+
+/// @brief Histogram of the energies of the pairs, and the total pair energy of each sample.
+///         The pair potential is given as a function of the squared distance, so it can match any interactor.
+/// @tparam D The number of dimensions of the simulation.
+template<unsigned int D>
+class PairEnergyHistogram : public PairAnalyzer<D> {
+    private:
+    double range;
+    double min_energy;
+    double bin_width;
+    std::function<double(double)> potential;
+    std::vector<unsigned long> histogram;
+    std::vector<std::vector<unsigned long>> thread_histograms;
+    std::vector<double> thread_energies;
+    // total pair energy of each sample
+    std::vector<double> energies;
+
+    public:
+    /// @param range the distance under which pairs count, at most the cut distance of the universe.
+    /// @param potential the energy of a pair from its squared distance.
+    /// @param min_energy the lowest energy of the histogram. Lower energies go to the first bin.
+    /// @param max_energy the highest energy of the histogram. Higher energies go to the last bin.
+    /// @param bin_count the number of bins of the histogram.
+    PairEnergyHistogram(double range, std::function<double(double)> potential, double min_energy, double max_energy, unsigned int bin_count)
+        : range(range), min_energy(min_energy), bin_width((max_energy - min_energy) / bin_count), potential(potential), histogram(bin_count, 0) {}
+
+    double getRange() override {
+        return this->range;
+    }
+
+    void beginSample(const Particle<D>* particles, unsigned int count, unsigned int thread_count) override {
+        this->thread_histograms.resize(thread_count);
+        for(std::vector<unsigned long>& thread_histogram: this->thread_histograms) {
+            thread_histogram.assign(this->histogram.size(), 0);
+        }
+        this->thread_energies.assign(thread_count, 0.0);
+    }
+
+    void addPair(unsigned int i, unsigned int j, double distance_sq, unsigned int thread) override {
+        double energy = this->potential(distance_sq);
+        int bin = (int)floor((energy - this->min_energy) / this->bin_width);
+        bin = std::max(0, std::min(bin, (int)this->histogram.size() - 1));
+        this->thread_histograms[thread][bin]++;
+        this->thread_energies[thread] += energy;
+    }
+
+    void endSample() override {
+        double energy = 0.0;
+        for(unsigned int thread = 0; thread < this->thread_histograms.size(); thread++) {
+            for(unsigned int bin = 0; bin < this->histogram.size(); bin++) {
+                this->histogram[bin] += this->thread_histograms[thread][bin];
+            }
+            energy += this->thread_energies[thread];
+        }
+        this->energies.push_back(energy);
+    }
+
+    /// @brief Energy at the middle of a bin.
+    double getEnergy(unsigned int bin) const {
+        return this->min_energy + (bin + 0.5) * this->bin_width;
+    }
+
+    /// @brief Number of pairs seen in each bin, summed over the samples.
+    const std::vector<unsigned long>& getHistogram() const {
+        return this->histogram;
+    }
+
+    /// @brief Total pair energy of each sample, in order.
+    const std::vector<double>& getTotalEnergies() const {
+        return this->energies;
+    }
+
+    /// @brief Writes one line per bin: the energy, and the number of pairs.
+    void writeResults(std::ostream& stream) const {
+        for(unsigned int bin = 0; bin < this->histogram.size(); bin++) {
+            stream << this->getEnergy(bin) << " " << this->histogram[bin] << std::endl;
+        }
+    }
+};
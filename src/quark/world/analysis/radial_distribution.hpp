@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include <ostream>
+#include "analyzer.hpp"
+
+/// @brief Radial distribution function g(r), accumulated over the sampled force passes.
+///         g(r) is the number of pairs at distance r, divided by what an ideal gas of the same density would give.
+///         There is no correction for the faces of a closed universe, so g(r) falls a bit below 1 at long range there.
+/// @tparam D The number of dimensions of the simulation.
+template<unsigned int D>
+class RadialDistribution : public PairAnalyzer<D> {
+    private:
+    double range;
+    double bin_width;
+    double volume;
+    unsigned int particle_count = 0;
+    unsigned int sample_count = 0;
+    std::vector<unsigned long> histogram;
+    std::vector<std::vector<unsigned long>> thread_histograms;
+
+    public:
+    /// @param range the largest distance of the histogram, at most the cut distance of the universe.
+    /// @param bin_count the number of bins of the histogram.
+    /// @param volume the volume of the universe, LD^D, giving the density of the ideal gas.
+    RadialDistribution(double range, unsigned int bin_count, double volume)
+        : range(range), bin_width(range / bin_count), volume(volume), histogram(bin_count, 0) {}
+
+    double getRange() override {
+        return this->range;
+    }
+
+    void beginSample(const Particle<D>* particles, unsigned int count, unsigned int thread_count) override {
+        this->particle_count = count;
+        this->thread_histograms.resize(thread_count);
+        for(std::vector<unsigned long>& thread_histogram: this->thread_histograms) {
+            thread_histogram.assign(this->histogram.size(), 0);
+        }
+    }
+
+    void addPair(unsigned int i, unsigned int j, double distance_sq, unsigned int thread) override {
+        unsigned int bin = (unsigned int)(sqrt(distance_sq) / this->bin_width);
+        if(bin < this->histogram.size()) {
+            this->thread_histograms[thread][bin]++;
+        }
+    }
+
+    void endSample() override {
+        for(const std::vector<unsigned long>& thread_histogram: this->thread_histograms) {
+            for(unsigned int bin = 0; bin < this->histogram.size(); bin++) {
+                this->histogram[bin] += thread_histogram[bin];
+            }
+        }
+        this->sample_count++;
+    }
+
+    /// @brief Drops the samples accumulated so far, to skip the equilibration for instance.
+    void reset() {
+        std::fill(this->histogram.begin(), this->histogram.end(), 0);
+        this->sample_count = 0;
+    }
+
+    unsigned int getSampleCount() const {
+        return this->sample_count;
+    }
+
+    /// @brief Distance at the middle of a bin.
+    double getRadius(unsigned int bin) const {
+        return (bin + 0.5) * this->bin_width;
+    }
+
+    /// @brief Value of g(r) over the samples, for each bin.
+    std::vector<double> getValues() const {
+        std::vector<double> values(this->histogram.size(), 0.0);
+        if(this->sample_count == 0 || this->particle_count < 2) {
+            return values;
+        }
+        // volume of the unit ball in D dimensions
+        double unit_ball = pow(M_PI, D / 2.0) / tgamma(D / 2.0 + 1);
+        double pair_count = 0.5 * this->particle_count * (this->particle_count - 1.0);
+        for(unsigned int bin = 0; bin < this->histogram.size(); bin++) {
+            double shell = unit_ball * (pow((bin + 1) * this->bin_width, D) - pow(bin * this->bin_width, D));
+            double ideal = this->sample_count * pair_count * shell / this->volume;
+            values[bin] = this->histogram[bin] / ideal;
+        }
+        return values;
+    }
+
+    /// @brief Writes one line per bin: the radius, and g(r).
+    void writeResults(std::ostream& stream) const {
+        std::vector<double> values = this->getValues();
+        for(unsigned int bin = 0; bin < values.size(); bin++) {
+            stream << this->getRadius(bin) << " " << values[bin] << std::endl;
+        }
+    }
+};
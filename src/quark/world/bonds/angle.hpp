@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cmath>
+#include <algorithm>
+#include "bond_potential.hpp"
+
+/// @brief Harmonic in the angle, U = k / 2 (theta - theta0)^2.
+///         The derivative by the cosine goes through 1 / sin(theta), which is bounded for angles close to 0 or pi.
+class HarmonicAngle : public AnglePotential {
+    private:
+    const double stiffness;
+    const double rest_angle;
+    constexpr static double MIN_SINE = 1e-6;
+
+    public:
+    /// @param stiffness the constant k.
+    /// @param rest_angle the angle theta0 of the energy minimum, in radians.
+    HarmonicAngle(double stiffness, double rest_angle) : stiffness(stiffness), rest_angle(rest_angle) {}
+
+    public:
+    double computeDerivative(double cosine) override {
+        double angle = acos(std::clamp(cosine, -1.0, 1.0));
+        double sine = std::max(sqrt(1 - std::min(cosine * cosine, 1.0)), MIN_SINE);
+        return -this->stiffness * (angle - this->rest_angle) / sine;
+    }
+
+    double computeEnergy(double cosine) override {
+        double stretch = acos(std::clamp(cosine, -1.0, 1.0)) - this->rest_angle;
+        return 0.5 * this->stiffness * stretch * stretch;
+    }
+};
+
+/// @brief Harmonic in the cosine of the angle, U = k / 2 (cos theta - cos theta0)^2.
+///         Close to HarmonicAngle around the rest angle, and smooth everywhere, which suits straight chains (theta0 = pi).
+class CosineAngle : public AnglePotential {
+    private:
+    const double stiffness;
+    const double rest_cosine;
+
+    public:
+    /// @param stiffness the constant k.
+    /// @param rest_angle the angle theta0 of the energy minimum, in radians.
+    CosineAngle(double stiffness, double rest_angle) : stiffness(stiffness), rest_cosine(cos(rest_angle)) {}
+
+    public:
+    double computeDerivative(double cosine) override {
+        return this->stiffness * (cosine - this->rest_cosine);
+    }
+
+    double computeEnergy(double cosine) override {
+        double stretch = cosine - this->rest_cosine;
+        return 0.5 * this->stiffness * stretch * stretch;
+    }
+};
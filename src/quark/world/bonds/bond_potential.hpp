@@ -0,0 +1,29 @@
+#pragma once
+
+/// @brief Virtual class for the potentials of the bonds between two particles.
+///         The force is returned as a factor of the vector between the particles, like the interactors,
+///         so the bonded pass never takes a square root.
+class BondPotential {
+    public:
+    virtual ~BondPotential() {}
+    /// @brief Force on the first particle of a bond, divided by the vector from the first particle to the second one.
+    /// @param distance_sq the squared length of the bond.
+    /// @return dU/dr / r: positive when the bond pulls the particles together.
+    virtual double computeForce(double distance_sq) = 0;
+    /// @brief Energy of a bond.
+    /// @param distance_sq the squared length of the bond.
+    virtual double computeEnergy(double distance_sq) = 0;
+};
+
+/// @brief Virtual class for the potentials of the angle between two bonds sharing a particle, the vertex.
+///         Potentials are written as functions of the cosine of the angle, which the pass gets without any trigonometry.
+class AnglePotential {
+    public:
+    virtual ~AnglePotential() {}
+    /// @brief Derivative of the energy by the cosine of the angle.
+    /// @param cosine the cosine of the angle, in [-1, 1].
+    virtual double computeDerivative(double cosine) = 0;
+    /// @brief Energy of an angle.
+    /// @param cosine the cosine of the angle, in [-1, 1].
+    virtual double computeEnergy(double cosine) = 0;
+};
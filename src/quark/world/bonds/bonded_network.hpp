@@ -0,0 +1,315 @@
+#pragma once
+
+#include <map>
+#include <array>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include "bond_potential.hpp"
+#include "../particle.hpp"
+#include "../../maths/vector.hpp"
+#include "../../parallel/parallel_for.hpp"
+#include "../../parallel/reduce.hpp"
+
+/// @brief Bonds and angles between given particles, for polymers and elastic networks.
+///         Terms are kept in lists by particle index, and gathered in compressed sparse rows: the terms of each particle
+///         are contiguous, each row sorted by partner. Each thread computes the whole force of its share of the particles
+///         and writes it in the particle storage, so the pass needs no buffer, and gives the same result for any thread count.
+///         Bonds are then computed twice, once from each end, which is cheap next to the pairs of the chunk grid.
+///         The universe calls reorderParticles when it moves particles, so the terms follow them.
+/// @tparam D The number of dimensions of the simulation.
+template<unsigned int D>
+class BondedNetwork {
+    public:
+    struct Bond {
+        unsigned int first;
+        unsigned int second;
+        unsigned int potential;
+    };
+
+    struct Angle {
+        unsigned int first;
+        unsigned int vertex;
+        unsigned int last;
+        unsigned int potential;
+    };
+
+    private:
+    // a bond seen from one of its ends
+    struct BondEntry {
+        unsigned int partner;
+        unsigned int potential;
+    };
+    // an angle seen from one of its particles: 0 for the first one, 1 for the vertex, 2 for the last one
+    struct AngleEntry {
+        unsigned int angle;
+        unsigned int role;
+    };
+
+    std::vector<BondPotential*> bond_potentials;
+    std::vector<AnglePotential*> angle_potentials;
+    std::vector<Bond> bonds;
+    std::vector<Angle> angles;
+
+    // rows, built for a number of particles, again when the terms or the particles change
+    bool rows_valid = false;
+    unsigned int row_count = 0;
+    std::vector<unsigned int> bond_offsets;
+    std::vector<BondEntry> bond_entries;
+    std::vector<unsigned int> angle_offsets;
+    std::vector<AngleEntry> angle_entries;
+
+    public:
+    BondedNetwork() = default;
+
+    /// @brief Bonds two particles.
+    /// @param first the index of the first particle.
+    /// @param second the index of the second particle.
+    /// @param potential the potential of the bond, which must outlive the network.
+    void addBond(unsigned int first, unsigned int second, BondPotential* potential) {
+        this->bonds.push_back(Bond{first, second, potentialIndex(this->bond_potentials, potential)});
+        this->rows_valid = false;
+    }
+
+    /// @brief Adds an angle between the bonds vertex-first and vertex-last. The bonds themselves are not added.
+    /// @param potential the potential of the angle, which must outlive the network.
+    void addAngle(unsigned int first, unsigned int vertex, unsigned int last, AnglePotential* potential) {
+        this->angles.push_back(Angle{first, vertex, last, potentialIndex(this->angle_potentials, potential)});
+        this->rows_valid = false;
+    }
+
+    /// @brief Bonds every pair of particles closer than a distance, to turn a lattice into an elastic solid.
+    /// @return the number of bonds added.
+    unsigned int addBondsWithin(const Particle<D>* particles, unsigned int count, double range, BondPotential* potential) {
+        // particles by cell of side range, so only the neighbouring cells are searched
+        std::map<std::array<long, D>, std::vector<unsigned int>> cells;
+        for(unsigned int i = 0; i < count; i++) {
+            cells[cellOf(particles[i].getPosition(), range)].push_back(i);
+        }
+        unsigned int neighbour_count = 1;
+        for(unsigned int dim = 0; dim < D; dim++) {
+            neighbour_count *= 3;
+        }
+        unsigned int added = 0;
+        for(unsigned int i = 0; i < count; i++) {
+            std::array<long, D> cell = cellOf(particles[i].getPosition(), range);
+            for(unsigned int offset = 0; offset < neighbour_count; offset++) {
+                std::array<long, D> neighbour = cell;
+                for(unsigned int dim = 0, rest = offset; dim < D; dim++, rest /= 3) {
+                    neighbour[dim] += (long)(rest % 3) - 1;
+                }
+                auto found = cells.find(neighbour);
+                if(found == cells.end()) {
+                    continue;
+                }
+                for(unsigned int j: found->second) {
+                    if(j > i && (particles[j].getPosition() - particles[i].getPosition()).sq_magnitude() < range * range) {
+                        this->addBond(i, j, potential);
+                        added++;
+                    }
+                }
+            }
+        }
+        return added;
+    }
+
+    unsigned int getBondCount() const {
+        return this->bonds.size();
+    }
+
+    unsigned int getAngleCount() const {
+        return this->angles.size();
+    }
+
+    const std::vector<Bond>& getBonds() const {
+        return this->bonds;
+    }
+
+    const std::vector<Angle>& getAngles() const {
+        return this->angles;
+    }
+
+    /// @brief Adds the bonded forces to the particles. Terms with a particle beyond count are left out.
+    /// @param box_length the size of a periodic universe, for the closest image of each partner, or 0.
+    void addForces(Particle<D>* particles, unsigned int count, unsigned int thread_count, double box_length) {
+        this->buildRows(count);
+        parallelFor(thread_count, 0, count, [&](unsigned int begin, unsigned int end, unsigned int thread) {
+            for(unsigned int i = begin; i < end; i++) {
+                Vector<double, D> force = Vector<double, D>();
+                for(unsigned int entry = this->bond_offsets[i]; entry < this->bond_offsets[i + 1]; entry++) {
+                    const BondEntry& bond = this->bond_entries[entry];
+                    Vector<double, D> separation = this->separation(particles, i, bond.partner, box_length);
+                    force += separation * this->bond_potentials[bond.potential]->computeForce(separation.sq_magnitude());
+                }
+                for(unsigned int entry = this->angle_offsets[i]; entry < this->angle_offsets[i + 1]; entry++) {
+                    force += this->angleForce(particles, this->angle_entries[entry], box_length);
+                }
+                particles[i].addForce(force);
+            }
+        });
+    }
+
+    /// @brief Total energy of the terms between the first count particles, summed in a fixed order.
+    double computeEnergy(const Particle<D>* particles, unsigned int count, unsigned int thread_count, double box_length) {
+        double bond_energy = deterministicSum<double>(thread_count, this->bonds.size(), [&](unsigned int b) {
+            const Bond& bond = this->bonds[b];
+            if(bond.first >= count || bond.second >= count) {
+                return 0.0;
+            }
+            double distance_sq = this->separation(particles, bond.first, bond.second, box_length).sq_magnitude();
+            return this->bond_potentials[bond.potential]->computeEnergy(distance_sq);
+        });
+        double angle_energy = deterministicSum<double>(thread_count, this->angles.size(), [&](unsigned int a) {
+            const Angle& angle = this->angles[a];
+            if(angle.first >= count || angle.vertex >= count || angle.last >= count) {
+                return 0.0;
+            }
+            Vector<double, D> before = this->separation(particles, angle.vertex, angle.first, box_length);
+            Vector<double, D> after = this->separation(particles, angle.vertex, angle.last, box_length);
+            double cosine = dot(before, after) / sqrt(before.sq_magnitude() * after.sq_magnitude());
+            return this->angle_potentials[angle.potential]->computeEnergy(cosine);
+        });
+        return bond_energy + angle_energy;
+    }
+
+    /// @brief Follows particles moved by the universe.
+    /// @param new_indexes the new index of each particle, or -1 for removed particles, whose terms are dropped.
+    ///         Particles beyond its size keep their index.
+    void reorderParticles(const std::vector<int>& new_indexes) {
+        auto remap = [&](unsigned int index) {
+            return index < new_indexes.size() ? new_indexes[index] : (int)index;
+        };
+        unsigned int kept = 0;
+        for(const Bond& bond: this->bonds) {
+            int first = remap(bond.first);
+            int second = remap(bond.second);
+            if(first >= 0 && second >= 0) {
+                this->bonds[kept++] = Bond{(unsigned int)first, (unsigned int)second, bond.potential};
+            }
+        }
+        this->bonds.resize(kept);
+        kept = 0;
+        for(const Angle& angle: this->angles) {
+            int first = remap(angle.first);
+            int vertex = remap(angle.vertex);
+            int last = remap(angle.last);
+            if(first >= 0 && vertex >= 0 && last >= 0) {
+                this->angles[kept++] = Angle{(unsigned int)first, (unsigned int)vertex, (unsigned int)last, angle.potential};
+            }
+        }
+        this->angles.resize(kept);
+        this->rows_valid = false;
+    }
+
+    private:
+    template<typename Potential>
+    static unsigned int potentialIndex(std::vector<Potential*>& potentials, Potential* potential) {
+        auto found = std::find(potentials.begin(), potentials.end(), potential);
+        if(found != potentials.end()) {
+            return found - potentials.begin();
+        }
+        potentials.push_back(potential);
+        return potentials.size() - 1;
+    }
+
+    static std::array<long, D> cellOf(const Vector<double, D>& position, double range) {
+        std::array<long, D> cell;
+        for(unsigned int dim = 0; dim < D; dim++) {
+            cell[dim] = (long)floor(position[dim] / range);
+        }
+        return cell;
+    }
+
+    static double dot(const Vector<double, D>& a, const Vector<double, D>& b) {
+        double result = 0.0;
+        for(unsigned int dim = 0; dim < D; dim++) {
+            result += a[dim] * b[dim];
+        }
+        return result;
+    }
+
+    /// @brief Vector from a particle to another one, to the closest image in a periodic universe.
+    static inline Vector<double, D> separation(const Particle<D>* particles, unsigned int from, unsigned int to, double box_length) {
+        Vector<double, D> separation = particles[to].getPosition() - particles[from].getPosition();
+        if(box_length > 0) {
+            for(unsigned int dim = 0; dim < D; dim++) {
+                separation[dim] -= box_length * round(separation[dim] / box_length);
+            }
+        }
+        return separation;
+    }
+
+    /// @brief Force of an angle on one of its particles, from the derivative of the potential by the cosine.
+    inline Vector<double, D> angleForce(const Particle<D>* particles, const AngleEntry& entry, double box_length) {
+        const Angle& angle = this->angles[entry.angle];
+        Vector<double, D> before = this->separation(particles, angle.vertex, angle.first, box_length);
+        Vector<double, D> after = this->separation(particles, angle.vertex, angle.last, box_length);
+        double before_sq = before.sq_magnitude();
+        double after_sq = after.sq_magnitude();
+        double inverse_lengths = 1.0 / sqrt(before_sq * after_sq);
+        double cosine = dot(before, after) * inverse_lengths;
+        double derivative = this->angle_potentials[angle.potential]->computeDerivative(cosine);
+        // F = -dU/dcos * dcos/dr, for the first and the last particles. The vertex gets the opposite of their sum.
+        Vector<double, D> first_force = (after * inverse_lengths - before * (cosine / before_sq)) * -derivative;
+        Vector<double, D> last_force = (before * inverse_lengths - after * (cosine / after_sq)) * -derivative;
+        switch(entry.role) {
+            case 0:
+                return first_force;
+            case 2:
+                return last_force;
+            default:
+                return -(first_force + last_force);
+        }
+    }
+
+    /// @brief Gathers the terms of each particle in rows, with a counting sort over the particles.
+    void buildRows(unsigned int count) {
+        if(this->rows_valid && this->row_count == count) {
+            return;
+        }
+        this->bond_offsets.assign(count + 1, 0);
+        this->angle_offsets.assign(count + 1, 0);
+        for(const Bond& bond: this->bonds) {
+            if(bond.first < count && bond.second < count) {
+                this->bond_offsets[bond.first + 1]++;
+                this->bond_offsets[bond.second + 1]++;
+            }
+        }
+        for(const Angle& angle: this->angles) {
+            if(angle.first < count && angle.vertex < count && angle.last < count) {
+                this->angle_offsets[angle.first + 1]++;
+                this->angle_offsets[angle.vertex + 1]++;
+                this->angle_offsets[angle.last + 1]++;
+            }
+        }
+        for(unsigned int i = 0; i < count; i++) {
+            this->bond_offsets[i + 1] += this->bond_offsets[i];
+            this->angle_offsets[i + 1] += this->angle_offsets[i];
+        }
+        this->bond_entries.resize(this->bond_offsets[count]);
+        this->angle_entries.resize(this->angle_offsets[count]);
+        std::vector<unsigned int> bond_fill(this->bond_offsets.begin(), this->bond_offsets.end() - 1);
+        std::vector<unsigned int> angle_fill(this->angle_offsets.begin(), this->angle_offsets.end() - 1);
+        for(const Bond& bond: this->bonds) {
+            if(bond.first < count && bond.second < count) {
+                this->bond_entries[bond_fill[bond.first]++] = BondEntry{bond.second, bond.potential};
+                this->bond_entries[bond_fill[bond.second]++] = BondEntry{bond.first, bond.potential};
+            }
+        }
+        for(unsigned int a = 0; a < this->angles.size(); a++) {
+            const Angle& angle = this->angles[a];
+            if(angle.first < count && angle.vertex < count && angle.last < count) {
+                this->angle_entries[angle_fill[angle.first]++] = AngleEntry{a, 0};
+                this->angle_entries[angle_fill[angle.vertex]++] = AngleEntry{a, 1};
+                this->angle_entries[angle_fill[angle.last]++] = AngleEntry{a, 2};
+            }
+        }
+        // partners in increasing order, so each row reads the particles forward
+        for(unsigned int i = 0; i < count; i++) {
+            std::sort(this->bond_entries.begin() + this->bond_offsets[i], this->bond_entries.begin() + this->bond_offsets[i + 1],
+                [](const BondEntry& a, const BondEntry& b) { return a.partner < b.partner; });
+        }
+        this->row_count = count;
+        this->rows_valid = true;
+    }
+};
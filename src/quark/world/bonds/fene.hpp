@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cmath>
+#include <algorithm>
+#include "bond_potential.hpp"
+
+/// @brief Finitely extensible nonlinear elastic bond, U = -k R0^2 / 2 ln(1 - (r / R0)^2), the bond of the Kremer-Grest polymer model.
+///         The force grows without bound as the bond length reaches R0. A bond stretched that far means the time step is too large:
+///         the stretch is clamped just below R0 so the simulation goes on, with a very stiff bond.
+class FENEBond : public BondPotential {
+    private:
+    const double stiffness;
+    const double max_length_sq;
+    // largest (r / R0)^2 used in the force
+    constexpr static double MAX_STRETCH_SQ = 0.99;
+
+    public:
+    /// @param stiffness the constant k, 30 epsilon / sigma^2 in the Kremer-Grest model.
+    /// @param max_length the length R0 the bond can never reach, 1.5 sigma in the Kremer-Grest model.
+    FENEBond(double stiffness = 30.0, double max_length = 1.5) : stiffness(stiffness), max_length_sq(max_length * max_length) {}
+
+    public:
+    double computeForce(double distance_sq) override {
+        double stretch_sq = std::min(distance_sq / this->max_length_sq, MAX_STRETCH_SQ);
+        return this->stiffness / (1 - stretch_sq);
+    }
+
+    double computeEnergy(double distance_sq) override {
+        double stretch_sq = std::min(distance_sq / this->max_length_sq, MAX_STRETCH_SQ);
+        return -0.5 * this->stiffness * this->max_length_sq * log(1 - stretch_sq);
+    }
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cmath>
+#include "bond_potential.hpp"
+
+/// @brief Spring with a rest length, U = k / 2 (r - r0)^2. Used for elastic networks.
+class HarmonicBond : public BondPotential {
+    private:
+    const double stiffness;
+    const double rest_length;
+
+    public:
+    HarmonicBond(double stiffness, double rest_length) : stiffness(stiffness), rest_length(rest_length) {}
+
+    public:
+    double computeForce(double distance_sq) override {
+        double distance = sqrt(distance_sq);
+        return this->stiffness * (distance - this->rest_length) / distance;
+    }
+
+    double computeEnergy(double distance_sq) override {
+        double stretch = sqrt(distance_sq) - this->rest_length;
+        return 0.5 * this->stiffness * stretch * stretch;
+    }
+};
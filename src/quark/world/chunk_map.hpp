@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+/// @brief Open addressing hash table from chunk keys to chunk indexes, used by the sparse grid of the universe.
+///         Keys are the linear index of the chunk coordinates, so any 64 bits value but the empty marker is a valid key.
+///         Slots are probed linearly from a Fibonacci hash of the key, and the table doubles before being half full.
+///         There is no removal: the universe rebuilds the whole table when too many chunks got empty.
+class ChunkMap {
+    private:
+    constexpr static uint64_t EMPTY = UINT64_MAX;
+    constexpr static unsigned int MIN_CAPACITY = 16;
+
+    std::vector<uint64_t> keys;
+    std::vector<unsigned int> values;
+    unsigned int count = 0;
+    // log2 of the capacity, so the hash keeps its high bits
+    unsigned int bits = 0;
+
+    public:
+    ChunkMap() {
+        this->resize(MIN_CAPACITY);
+    }
+
+    /// @brief Value of a key, or -1 if the key is not in the map.
+    inline int find(uint64_t key) const {
+        for(uint64_t slot = this->hash(key);; slot = (slot + 1) & (this->keys.size() - 1)) {
+            if(this->keys[slot] == key) {
+                return this->values[slot];
+            }
+            if(this->keys[slot] == EMPTY) {
+                return -1;
+            }
+        }
+    }
+
+    /// @brief Adds a key that is not in the map yet.
+    void insert(uint64_t key, unsigned int value) {
+        if(2 * (this->count + 1) > this->keys.size()) {
+            this->resize(2 * this->keys.size());
+        }
+        this->place(key, value);
+        this->count++;
+    }
+
+    void clear() {
+        this->count = 0;
+        this->keys.clear();
+        this->resize(MIN_CAPACITY);
+    }
+
+    unsigned int size() const {
+        return this->count;
+    }
+
+    private:
+    inline uint64_t hash(uint64_t key) const {
+        return (key * 0x9E3779B97F4A7C15ull) >> (64 - this->bits);
+    }
+
+    void place(uint64_t key, unsigned int value) {
+        uint64_t slot = this->hash(key);
+        while(this->keys[slot] != EMPTY) {
+            slot = (slot + 1) & (this->keys.size() - 1);
+        }
+        this->keys[slot] = key;
+        this->values[slot] = value;
+    }
+
+    void resize(unsigned int capacity) {
+        std::vector<uint64_t> old_keys = std::move(this->keys);
+        std::vector<unsigned int> old_values = std::move(this->values);
+        this->keys.assign(capacity, EMPTY);
+        this->values.assign(capacity, 0);
+        this->bits = 0;
+        while((1u << this->bits) < capacity) {
+            this->bits++;
+        }
+        for(unsigned int slot = 0; slot < old_keys.size(); slot++) {
+            if(old_keys[slot] != EMPTY) {
+                this->place(old_keys[slot], old_values[slot]);
+            }
+        }
+    }
+};
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <mutex>
+#include <memory>
+#include <iostream>
+#include <vector>
+#include <ostream>
+#include <functional>
+#include <condition_variable>
+#include "../parallel/thread_pool.hpp"
+
+/// @brief Runs many independent universes concurrently on a shared thread pool, and collects one result per member.
+///         Each member is built by the factory, stepped until its step count is reached or its stop condition holds,
+///         handed to the collector, then destroyed, so only the members being run live in memory at once.
+///         Members run as separate pool tasks : workers that run out of members steal from the others,
+///         which keeps all the cores busy even when the members have very different lengths.
+///         Anything shared between members (interactors, forces...) must be safe to use from several threads at once,
+///         the stateful ones (long range solvers, visualizers) should be created per member.
+/// @tparam Universe the type of universe each member runs.
+/// @tparam Result the result collected from each member.
+template<typename Universe, typename Result>
+class Ensemble {
+    public:
+    /// @brief Builds the universe of a member. The ensemble takes ownership of it.
+    typedef std::function<Universe*(unsigned int member)> Factory;
+    /// @brief Extracts the result of a member once it stopped.
+    typedef std::function<Result(unsigned int member, Universe& universe, unsigned int steps)> Collector;
+    /// @brief Returns true once a member should stop, checked after each step.
+    typedef std::function<bool(unsigned int member, Universe& universe, unsigned int step)> StopCondition;
+
+    private:
+    unsigned int member_count;
+    Factory factory;
+    Collector collector;
+    StopCondition stop_condition = nullptr;
+    std::function<double(unsigned int)> delta_time = [](unsigned int) { return 0.001; };
+    std::function<unsigned int(unsigned int)> max_steps = [](unsigned int) { return 1000u; };
+
+    ThreadPool* pool;
+    std::unique_ptr<ThreadPool> owned_pool;
+
+    /// @brief What a member leaves behind, in its own object: the members never write to the same word,
+    ///         even for results packed in bits like std::vector<bool>.
+    struct MemberOutcome {
+        Result result = Result();
+        unsigned int steps = 0;
+    };
+    std::vector<MemberOutcome> outcomes;
+    std::vector<Result> results;
+    std::vector<unsigned int> step_counts;
+
+    public:
+    /// @brief Creates an ensemble running on its own pool.
+    /// @param member_count number of universes to run.
+    /// @param factory builds the universe of each member.
+    /// @param collector extracts the result of each member.
+    /// @param thread_count number of threads of the pool.
+    Ensemble(unsigned int member_count, Factory factory, Collector collector, unsigned int thread_count = defaultThreadCount())
+    : member_count(member_count), factory(factory), collector(collector), owned_pool(new ThreadPool(thread_count)) {
+        this->pool = this->owned_pool.get();
+    }
+    /// @brief Creates an ensemble running on a pool shared with other work.
+    Ensemble(unsigned int member_count, Factory factory, Collector collector, ThreadPool* pool)
+    : member_count(member_count), factory(factory), collector(collector), pool(pool) {}
+
+    /// @brief Sets the time step used by every member.
+    void setTimeStep(double delta_time) {
+        this->delta_time = [delta_time](unsigned int) { return delta_time; };
+    }
+    /// @brief Sets the time step of each member.
+    void setTimeStep(std::function<double(unsigned int)> delta_time) {
+        this->delta_time = delta_time;
+    }
+    /// @brief Sets the maximum number of steps of every member.
+    void setMaxSteps(unsigned int max_steps) {
+        this->max_steps = [max_steps](unsigned int) { return max_steps; };
+    }
+    /// @brief Sets the maximum number of steps of each member.
+    void setMaxSteps(std::function<unsigned int(unsigned int)> max_steps) {
+        this->max_steps = max_steps;
+    }
+    /// @brief Sets a condition to stop a member before its maximum number of steps.
+    void setStopCondition(StopCondition stop_condition) {
+        this->stop_condition = stop_condition;
+    }
+
+    /// @brief Runs all the members, and blocks until they are done. Only waits for its own members, so other work
+    ///         on a shared pool is not waited for. Called from a task of the pool, the worker runs queued tasks meanwhile.
+    /// @return the results, in member order.
+    const std::vector<Result>& run() {
+        this->outcomes = std::vector<MemberOutcome>(this->member_count);
+        // members of this run not done yet
+        std::mutex mutex;
+        std::condition_variable done;
+        unsigned int remaining = this->member_count;
+        for(unsigned int member = 0; member < this->member_count; member++) {
+            this->pool->submit([this, member, &mutex, &done, &remaining]() {
+                this->runMember(member);
+                std::lock_guard<std::mutex> lock(mutex);
+                if(--remaining == 0) {
+                    done.notify_all();
+                }
+            });
+        }
+        if(this->pool->isWorkerThread()) {
+            // help until every member was taken by a worker, then wait for the ones still running
+            while(this->pool->runPendingTask()) {}
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&remaining]() { return remaining == 0; });
+        this->results.clear();
+        this->step_counts.clear();
+        for(const MemberOutcome& outcome: this->outcomes) {
+            this->results.push_back(outcome.result);
+            this->step_counts.push_back(outcome.steps);
+        }
+        return this->results;
+    }
+
+    const std::vector<Result>& getResults() const {
+        return this->results;
+    }
+
+    /// @brief Number of steps each member ran for in the last run.
+    const std::vector<unsigned int>& getStepCounts() const {
+        return this->step_counts;
+    }
+
+    /// @brief Writes one line per member : its index, its step count and its result.
+    void writeResults(std::ostream& stream) const {
+        for(unsigned int member = 0; member < this->results.size(); member++) {
+            stream << member << " " << this->step_counts[member] << " " << this->results[member] << std::endl;
+        }
+    }
+
+    private:
+    void runMember(unsigned int member) {
+        std::unique_ptr<Universe> universe(this->factory(member));
+        if(!universe) {
+            std::cout << "ERROR : Ensemble factory returned no universe for member " << member << std::endl;
+            return;
+        }
+        double delta_time = this->delta_time(member);
+        unsigned int max_steps = this->max_steps(member);
+        unsigned int step = 0;
+        while(step < max_steps) {
+            universe->step(delta_time);
+            step++;
+            if(this->stop_condition && this->stop_condition(member, *universe, step)) {
+                break;
+            }
+        }
+        // each member writes its own outcome, no lock needed
+        this->outcomes[member].steps = step;
+        this->outcomes[member].result = this->collector(member, *universe, step);
+    }
+};
@@ -7,6 +7,7 @@
 template<unsigned int D>
 class Force {
     public:
+    virtual ~Force() {}
     /// @brief Apply a force to a particle.
     /// @param part The particle to apply forces to.
     /// @return the applied force.
@@ -0,0 +1,355 @@
+#pragma once
+
+#include <array>
+#include <list>
+#include <queue>
+#include <cmath>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include "particle.hpp"
+#include "../maths/vector.hpp"
+#include "../maths/const_pow.hpp"
+#include "../visualizer/visualizer.hpp"
+
+/// @brief Event driven universe of hard spheres (disks in 2D), bouncing on each other and on the faces of the box.
+///         Particles fly straight between collisions, so instead of stepping the time, the universe predicts when
+///         the next collision happens and jumps to it. Pending events sit in a priority queue. An event is not removed
+///         when a collision changes one of its particles: each particle counts its collisions, and an event whose
+///         counters do not match any more is dropped when it comes out of the queue.
+///         Collisions are only predicted with the particles of the neighbour cells, and crossing a cell is an event too.
+///         Each particle also keeps the time of its last update, and is only moved when one of its events is processed.
+///         The particle storage and the visualizer hooks are the same as the Universe ones.
+/// @tparam D the number of dimensions of the universe.
+/// @tparam N the number of particles in the universe.
+/// @tparam LD the size of the universe cube.
+template<unsigned int D, unsigned int N, double LD>
+class HardSphereUniverse {
+    private:
+    constexpr static unsigned int NEIGHBOUR_CELLS = const_pow(3, D);
+
+    enum EVENT_TYPE {
+        collision, // two particles touch
+        cell_crossing, // a particle goes to the next cell
+        wall, // a particle touches a face of the box
+    };
+
+    struct Event {
+        double time;
+        EVENT_TYPE type;
+        unsigned int i;
+        // other particle of a collision, or dimension of a cell crossing or wall
+        unsigned int j;
+        // collision counters of the particles when the event was predicted
+        unsigned long count_i;
+        unsigned long count_j;
+
+        bool operator>(const Event& other) const {
+            return this->time > other.time;
+        }
+    };
+
+    std::array<Particle<D>, N> particles;
+    std::list<Visualizer<HardSphereUniverse<D, N, LD>>*> registered_visulizer;
+
+    double diameter;
+    double restitution = 1.0;
+    double time = 0.0;
+    unsigned long collision_total = 0;
+    unsigned long event_total = 0;
+
+    // time at which each particle position is up to date, and its collision counter
+    std::array<double, N> particle_times;
+    std::array<unsigned long, N> collision_counts;
+
+    // cell grid, at least one diameter wide so collisions only happen between neighbour cells
+    unsigned int cells_per_dim;
+    double cell_length;
+    std::vector<std::vector<unsigned int>> cells;
+    std::array<Vector<int, D>, N> particle_cells;
+
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+
+    public:
+    /// @brief Creates a universe with the given particles. They must be in the box, and must not overlap.
+    /// @param particles the particles to populate the universe with.
+    /// @param diameter the diameter of the spheres.
+    HardSphereUniverse(Particle<D> particles[N], double diameter) : diameter(diameter) {
+        std::copy(particles, particles + N, this->particles.begin());
+        this->cells_per_dim = std::max(1, (int)floor(LD / diameter));
+        this->cell_length = LD / this->cells_per_dim;
+        this->cells.resize(const_pow(this->cells_per_dim, D));
+        for(unsigned int i = 0; i < N; i++) {
+            this->particle_times[i] = 0.0;
+            this->collision_counts[i] = 0;
+            for(unsigned int dim = 0; dim < D; dim++) {
+                int cell = (int)floor(this->particles[i].getPosition()[dim] / this->cell_length);
+                this->particle_cells[i][dim] = std::max(0, std::min(cell, (int)this->cells_per_dim - 1));
+            }
+            this->cells[this->cellIndex(this->particle_cells[i])].push_back(i);
+        }
+        this->predictAll();
+    }
+
+    // getters and setters
+    public:
+    const std::array<Particle<D>, N>& getParticles() const {
+        return this->particles;
+    }
+
+    double getTime() const {
+        return this->time;
+    }
+
+    /// @brief Number of collisions between particles since the creation of the universe.
+    unsigned long getCollisionCount() const {
+        return this->collision_total;
+    }
+
+    /// @brief Number of events processed, collisions with the walls and cell crossings included.
+    unsigned long getEventCount() const {
+        return this->event_total;
+    }
+
+    /// @brief Sets the ratio of the normal relative speed after and before a collision. 1 is elastic, less dissipates energy.
+    void setRestitution(double restitution) {
+        this->restitution = restitution;
+    }
+
+    void registerVisualizer(Visualizer<HardSphereUniverse<D, N, LD>> *visualizer) {
+        this->registered_visulizer.push_back(visualizer);
+    }
+
+    /// @brief Processes all the events until deltaTime later, brings every particle to that time, and calls the visualizers.
+    void step(double deltaTime) {
+        double target = this->time + deltaTime;
+        while(!this->events.empty() && this->events.top().time <= target) {
+            Event event = this->events.top();
+            this->events.pop();
+            if(!this->isValid(event)) {
+                continue;
+            }
+            this->time = event.time;
+            this->processEvent(event);
+        }
+        this->time = target;
+        for(unsigned int i = 0; i < N; i++) {
+            this->advance(i);
+        }
+        // invalid events pile up in the queue: start over from the synchronised state when there are too many
+        if(this->events.size() > 32 * N + 1024) {
+            this->events = std::priority_queue<Event, std::vector<Event>, std::greater<Event>>();
+            this->predictAll();
+        }
+        for(Visualizer<HardSphereUniverse<D, N, LD>> *visulizer: this->registered_visulizer) {
+            visulizer->draw(this);
+        }
+    }
+
+    private:
+    unsigned int cellIndex(const Vector<int, D>& cell) const {
+        unsigned int index = 0;
+        for(unsigned int dim = 0; dim < D; dim++) {
+            index = index * this->cells_per_dim + cell[dim];
+        }
+        return index;
+    }
+
+    /// @brief Moves a particle along its straight path to the current time.
+    void advance(unsigned int i) {
+        double elapsed = this->time - this->particle_times[i];
+        if(elapsed != 0.0) {
+            this->particles[i].updatePosition(this->particles[i].getVelocity() * elapsed);
+            this->particle_times[i] = this->time;
+        }
+    }
+
+    bool isValid(const Event& event) const {
+        if(this->collision_counts[event.i] != event.count_i) {
+            return false;
+        }
+        return event.type != EVENT_TYPE::collision || this->collision_counts[event.j] == event.count_j;
+    }
+
+    void schedule(double delay, EVENT_TYPE type, unsigned int i, unsigned int j) {
+        Event event;
+        event.time = this->time + delay;
+        event.type = type;
+        event.i = i;
+        event.j = j;
+        event.count_i = this->collision_counts[i];
+        event.count_j = type == EVENT_TYPE::collision ? this->collision_counts[j] : 0;
+        this->events.push(event);
+    }
+
+    /// @brief Time until i and j touch, or infinity if they never do. Both particles are at the current time.
+    double collisionDelay(unsigned int i, unsigned int j) const {
+        Vector<double, D> r = this->particles[i].getPosition() - this->particles[j].getPosition();
+        Vector<double, D> v = this->particles[i].getVelocity() - this->particles[j].getVelocity();
+        double b = 0;
+        for(unsigned int dim = 0; dim < D; dim++) {
+            b += r[dim] * v[dim];
+        }
+        if(b >= 0) {
+            // moving apart
+            return std::numeric_limits<double>::infinity();
+        }
+        double v2 = v.sq_magnitude();
+        double gap = r.sq_magnitude() - this->diameter * this->diameter;
+        if(gap <= 0) {
+            // already touching and getting closer, from rounding errors
+            return 0.0;
+        }
+        double discriminant = b * b - v2 * gap;
+        if(discriminant < 0) {
+            return std::numeric_limits<double>::infinity();
+        }
+        // the smallest root, written to avoid cancellation
+        return gap / (-b + sqrt(discriminant));
+    }
+
+    /// @brief Predicts the next collisions of a particle with its neighbours, its next cell crossing and its next wall.
+    void predict(unsigned int i) {
+        this->advance(i);
+        this->predictCollisions(i);
+        this->predictBoundaries(i, true);
+    }
+
+    /// @brief Predicts the collisions of a particle with the particles of its neighbour cells.
+    /// @param layer_dim if set, only the neighbour cells at layer_side along this dimension are visited.
+    /// @param layer_side -1 or 1, the side of the layer of cells to visit.
+    void predictCollisions(unsigned int i, int layer_dim = -1, int layer_side = 0) {
+        for(unsigned int neighbour = 0; neighbour < NEIGHBOUR_CELLS; neighbour++) {
+            Vector<int, D> cell = this->particle_cells[i];
+            unsigned int rest = neighbour;
+            bool inside = true;
+            for(unsigned int dim = 0; dim < D; dim++) {
+                int offset = (int)(rest % 3) - 1;
+                cell[dim] += offset;
+                rest /= 3;
+                inside = inside && cell[dim] >= 0 && cell[dim] < (int)this->cells_per_dim;
+                inside = inside && ((int)dim != layer_dim || offset == layer_side);
+            }
+            if(!inside) {
+                continue;
+            }
+            for(unsigned int j: this->cells[this->cellIndex(cell)]) {
+                if(j == i) {
+                    continue;
+                }
+                this->advance(j);
+                double delay = this->collisionDelay(i, j);
+                if(delay != std::numeric_limits<double>::infinity()) {
+                    this->schedule(delay, EVENT_TYPE::collision, i, j);
+                }
+            }
+        }
+    }
+
+    /// @brief Predicts the next cell boundary a particle crosses, and the next face of the box it touches.
+    /// @param wall whether to schedule the wall event too.
+    void predictBoundaries(unsigned int i, bool wall) {
+        double cell_delay = std::numeric_limits<double>::infinity();
+        unsigned int cell_dim = 0;
+        double wall_delay = std::numeric_limits<double>::infinity();
+        unsigned int wall_dim = 0;
+        double radius = this->diameter * 0.5;
+        for(unsigned int dim = 0; dim < D; dim++) {
+            double position = this->particles[i].getPosition()[dim];
+            double velocity = this->particles[i].getVelocity()[dim];
+            int cell = this->particle_cells[i][dim];
+            if(velocity > 0) {
+                if(cell + 1 < (int)this->cells_per_dim) {
+                    double delay = std::max(0.0, ((cell + 1) * this->cell_length - position) / velocity);
+                    if(delay < cell_delay) {
+                        cell_delay = delay;
+                        cell_dim = dim;
+                    }
+                }
+                double delay = std::max(0.0, (LD - radius - position) / velocity);
+                if(delay < wall_delay) {
+                    wall_delay = delay;
+                    wall_dim = dim;
+                }
+            }
+            else if(velocity < 0) {
+                if(cell > 0) {
+                    double delay = std::max(0.0, (cell * this->cell_length - position) / velocity);
+                    if(delay < cell_delay) {
+                        cell_delay = delay;
+                        cell_dim = dim;
+                    }
+                }
+                double delay = std::max(0.0, (radius - position) / velocity);
+                if(delay < wall_delay) {
+                    wall_delay = delay;
+                    wall_dim = dim;
+                }
+            }
+        }
+        if(cell_delay != std::numeric_limits<double>::infinity()) {
+            this->schedule(cell_delay, EVENT_TYPE::cell_crossing, i, cell_dim);
+        }
+        if(wall && wall_delay != std::numeric_limits<double>::infinity()) {
+            this->schedule(wall_delay, EVENT_TYPE::wall, i, wall_dim);
+        }
+    }
+
+    void predictAll() {
+        for(unsigned int i = 0; i < N; i++) {
+            this->predict(i);
+        }
+    }
+
+    void processEvent(const Event& event) {
+        this->event_total++;
+        unsigned int i = event.i;
+        this->advance(i);
+        switch(event.type) {
+            case EVENT_TYPE::collision: {
+                unsigned int j = event.j;
+                this->advance(j);
+                // impulse along the line of centers
+                Vector<double, D> r = this->particles[i].getPosition() - this->particles[j].getPosition();
+                Vector<double, D> v = this->particles[i].getVelocity() - this->particles[j].getVelocity();
+                double b = 0;
+                for(unsigned int dim = 0; dim < D; dim++) {
+                    b += r[dim] * v[dim];
+                }
+                double mass_i = this->particles[i].getMass();
+                double mass_j = this->particles[j].getMass();
+                Vector<double, D> impulse = r * ((1 + this->restitution) * mass_i * mass_j / (mass_i + mass_j) * b / r.sq_magnitude());
+                this->particles[i].updateVelocity(impulse * (-1.0 / mass_i));
+                this->particles[j].updateVelocity(impulse * (1.0 / mass_j));
+                this->collision_counts[i]++;
+                this->collision_counts[j]++;
+                this->collision_total++;
+                this->predict(i);
+                this->predict(j);
+                break;
+            }
+            case EVENT_TYPE::cell_crossing: {
+                unsigned int dim = event.j;
+                std::vector<unsigned int>& old_cell = this->cells[this->cellIndex(this->particle_cells[i])];
+                old_cell.erase(std::find(old_cell.begin(), old_cell.end(), i));
+                int side = this->particles[i].getVelocity()[dim] > 0 ? 1 : -1;
+                this->particle_cells[i][dim] += side;
+                this->cells[this->cellIndex(this->particle_cells[i])].push_back(i);
+                // the pending collisions and wall of the particle stay valid: only the layer of cells it now
+                // neighbours is added, with its next crossing
+                this->predictCollisions(i, dim, side);
+                this->predictBoundaries(i, false);
+                break;
+            }
+            case EVENT_TYPE::wall: {
+                unsigned int dim = event.j;
+                Vector<double, D> bounce = Vector<double, D>();
+                bounce[dim] = -2 * this->particles[i].getVelocity()[dim];
+                this->particles[i].updateVelocity(bounce);
+                this->collision_counts[i]++;
+                this->predict(i);
+                break;
+            }
+        }
+    }
+};
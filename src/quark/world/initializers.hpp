@@ -0,0 +1,212 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <vector>
+#include <cstdint>
+#include "particle.hpp"
+#include "../maths/vector.hpp"
+#include "../maths/philox.hpp"
+#include "../parallel/parallel_for.hpp"
+#include "../parallel/reduce.hpp"
+
+/// @brief Bulk initializers, filling an array of particles in parallel.
+///         Random numbers come from a counter based generator keyed by the particle index,
+///         so a given seed gives the same particles for any thread count.
+///         Particles get consecutive ids, reserved at once.
+namespace Initializers {
+
+    // streams of the random generator, so positions and velocities of a particle are independent
+    const uint32_t POSITION_STREAM = 0;
+    const uint32_t VELOCITY_STREAM = 1;
+
+    /// @brief Places count particles uniformly at random in a box, at rest.
+    /// @param particles the particles to fill.
+    /// @param count the number of particles.
+    /// @param corner the lowest corner of the box.
+    /// @param size the size of the box in each dimension.
+    /// @param seed the seed of the random generator.
+    /// @param mass the mass of the particles.
+    /// @param thread_count the number of threads to fill the particles with.
+    template<unsigned int D>
+    void uniform(
+        Particle<D>* particles, unsigned int count, const Vector<double, D>& corner, const Vector<double, D>& size,
+        uint64_t seed, double mass = 1.0, unsigned int thread_count = defaultThreadCount()
+    ) {
+        Philox rng(seed);
+        int first_id = Particle<D>::reserveIds(count);
+        parallelFor(thread_count, 0, count, [&](unsigned int begin, unsigned int end, unsigned int thread) {
+            for(unsigned int i = begin; i < end; i++) {
+                Vector<double, D> position;
+                for(unsigned int dim = 0; dim < D; dim += 2) {
+                    std::array<double, 2> u = rng.uniform(i, POSITION_STREAM, dim / 2);
+                    position[dim] = corner[dim] + size[dim] * u[0];
+                    if(dim + 1 < D) {
+                        position[dim + 1] = corner[dim + 1] + size[dim + 1] * u[1];
+                    }
+                }
+                particles[i] = Particle<D>(first_id + i, position, Vector<double, D>(), mass);
+            }
+        });
+    }
+
+    /// @brief Fills a lattice made of cells, with a basis of sites in each cell.
+    ///         The first dimension is the most significant one in the particle order, like the universe chunks.
+    /// @param site function giving the position of a site from its cell coordinates and its index in the basis.
+    /// @return the number of particles written.
+    template<unsigned int D, typename Site>
+    unsigned int lattice(
+        Particle<D>* particles, const Vector<unsigned int, D>& cells, unsigned int basis_size,
+        double mass, unsigned int thread_count, Site site
+    ) {
+        unsigned int count = basis_size;
+        for(unsigned int dim = 0; dim < D; dim++) {
+            count *= cells[dim];
+        }
+        int first_id = Particle<D>::reserveIds(count);
+        parallelFor(thread_count, 0, count, [&](unsigned int begin, unsigned int end, unsigned int thread) {
+            for(unsigned int i = begin; i < end; i++) {
+                unsigned int rest = i / basis_size;
+                Vector<unsigned int, D> cell;
+                for(int dim = D - 1; dim >= 0; dim--) {
+                    cell[dim] = rest % cells[dim];
+                    rest /= cells[dim];
+                }
+                particles[i] = Particle<D>(first_id + i, site(cell, i % basis_size), Vector<double, D>(), mass);
+            }
+        });
+        return count;
+    }
+
+    /// @brief Fills a simple cubic lattice, one particle per cell, like the blocks of the collision demo.
+    /// @param corner position of the first particle.
+    /// @param cells the number of particles along each dimension.
+    /// @param spacing the distance between neighbours.
+    /// @return the number of particles written, the product of the cells.
+    template<unsigned int D>
+    unsigned int cubic(
+        Particle<D>* particles, const Vector<double, D>& corner, const Vector<unsigned int, D>& cells,
+        double spacing, double mass = 1.0, unsigned int thread_count = defaultThreadCount()
+    ) {
+        return lattice<D>(particles, cells, 1, mass, thread_count, [&](const Vector<unsigned int, D>& cell, unsigned int site) {
+            Vector<double, D> position;
+            for(unsigned int dim = 0; dim < D; dim++) {
+                position[dim] = corner[dim] + cell[dim] * spacing;
+            }
+            return position;
+        });
+    }
+
+    /// @brief Number of sites in a face centered cubic cell: the corner, and the center of each face.
+    template<unsigned int D>
+    constexpr unsigned int fccBasisSize() {
+        return 1 + D * (D - 1) / 2;
+    }
+
+    /// @brief Fills a face centered cubic lattice, the densest packing of Lennard-Jones crystals in 3D.
+    ///         In 2D, this is a centered square lattice.
+    /// @param corner lowest corner of the first cell.
+    /// @param cells the number of cells along each dimension.
+    /// @param cell_length the side of a cell. Nearest neighbours are at cell_length / sqrt(2).
+    /// @return the number of particles written, fccBasisSize<D>() times the product of the cells.
+    template<unsigned int D>
+    unsigned int fcc(
+        Particle<D>* particles, const Vector<double, D>& corner, const Vector<unsigned int, D>& cells,
+        double cell_length, double mass = 1.0, unsigned int thread_count = defaultThreadCount()
+    ) {
+        // the basis: the corner, then the face centers, offset by half a cell in two dimensions
+        std::vector<std::array<unsigned int, 2>> faces;
+        for(unsigned int a = 0; a < D; a++) {
+            for(unsigned int b = a + 1; b < D; b++) {
+                faces.push_back({a, b});
+            }
+        }
+        return lattice<D>(particles, cells, fccBasisSize<D>(), mass, thread_count, [&](const Vector<unsigned int, D>& cell, unsigned int site) {
+            Vector<double, D> position;
+            for(unsigned int dim = 0; dim < D; dim++) {
+                position[dim] = corner[dim] + cell[dim] * cell_length;
+            }
+            if(site > 0) {
+                position[faces[site - 1][0]] += cell_length * 0.5;
+                position[faces[site - 1][1]] += cell_length * 0.5;
+            }
+            return position;
+        });
+    }
+
+    /// @brief Fills a hexagonal lattice: the triangular lattice in 2D, hexagonal close packing in 3D.
+    ///         Every particle is at spacing of its nearest neighbours.
+    /// @param corner position of the first particle.
+    /// @param cells the number of particles along each dimension: per row, rows, and layers in 3D.
+    /// @param spacing the distance between neighbours.
+    /// @return the number of particles written, the product of the cells.
+    template<unsigned int D>
+    unsigned int hexagonal(
+        Particle<D>* particles, const Vector<double, D>& corner, const Vector<unsigned int, D>& cells,
+        double spacing, double mass = 1.0, unsigned int thread_count = defaultThreadCount()
+    ) {
+        static_assert(D == 2 || D == 3, "Hexagonal lattices are only defined in 2D and 3D.");
+        return lattice<D>(particles, cells, 1, mass, thread_count, [&](const Vector<unsigned int, D>& cell, unsigned int site) {
+            Vector<double, D> position = corner;
+            // odd rows are shifted by half a spacing
+            position[0] += (cell[0] + 0.5 * (cell[1] % 2)) * spacing;
+            position[1] += cell[1] * spacing * sqrt(3.0) / 2;
+            if constexpr(D == 3) {
+                // odd layers sit over the holes of the even ones
+                if(cell[2] % 2 == 1) {
+                    position[0] += spacing * 0.5;
+                    position[1] += spacing * sqrt(3.0) / 6;
+                }
+                position[2] += cell[2] * spacing * sqrt(2.0 / 3.0);
+            }
+            return position;
+        });
+    }
+
+    /// @brief Draws the velocities of the particles from the Maxwell-Boltzmann distribution, with the Boltzmann constant at 1.
+    ///         Each velocity component is normal, with a variance of temperature / mass.
+    /// @param particles the particles, already placed.
+    /// @param count the number of particles.
+    /// @param temperature the temperature of the distribution.
+    /// @param seed the seed of the random generator.
+    /// @param remove_drift whether to remove the velocity of the center of mass, so the system does not move as a whole.
+    /// @param thread_count the number of threads to fill the particles with.
+    template<unsigned int D>
+    void maxwellBoltzmann(
+        Particle<D>* particles, unsigned int count, double temperature, uint64_t seed,
+        bool remove_drift = true, unsigned int thread_count = defaultThreadCount()
+    ) {
+        Philox rng(seed);
+        parallelFor(thread_count, 0, count, [&](unsigned int begin, unsigned int end, unsigned int thread) {
+            for(unsigned int i = begin; i < end; i++) {
+                double sigma = sqrt(temperature / particles[i].getMass());
+                Vector<double, D> velocity;
+                for(unsigned int dim = 0; dim < D; dim += 2) {
+                    std::array<double, 2> n = rng.normal(i, VELOCITY_STREAM, dim / 2);
+                    velocity[dim] = sigma * n[0];
+                    if(dim + 1 < D) {
+                        velocity[dim + 1] = sigma * n[1];
+                    }
+                }
+                particles[i].setVelocity(velocity);
+            }
+        });
+        if(!remove_drift || count == 0) {
+            return;
+        }
+        // sums in a fixed order, so the drift is the same for any thread count
+        Vector<double, D> momentum = deterministicSum<Vector<double, D>>(thread_count, count, [&](unsigned int i) {
+            return Vector<double, D>(particles[i].getVelocity() * particles[i].getMass());
+        });
+        double total_mass = deterministicSum<double>(thread_count, count, [&](unsigned int i) {
+            return particles[i].getMass();
+        });
+        Vector<double, D> drift = momentum / total_mass;
+        parallelFor(thread_count, 0, count, [&](unsigned int begin, unsigned int end, unsigned int thread) {
+            for(unsigned int i = begin; i < end; i++) {
+                particles[i].updateVelocity(-drift);
+            }
+        });
+    }
+
+}
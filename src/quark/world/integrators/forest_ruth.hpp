@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cmath>
+#include "integrator.hpp"
+
+/// @brief Forest-Ruth (or Yoshida) fourth order symplectic integrator, three Störmer-Verlet steps of tuned lengths.
+///         Three force evaluations per step, but the error falls with dt^4,
+///         so smooth problems like orbits can run with much larger time steps for the same energy error.
+template<unsigned int D>
+class ForestRuthIntegrator : public Integrator<D> {
+    private:
+    // 1 / (2 - 2^(1/3)): the outer sub steps, the middle one goes backward in time
+    const double theta = 1.0 / (2.0 - cbrt(2.0));
+
+    public:
+    ForestRuthIntegrator() = default;
+
+    void step(Particle<D>* particles, unsigned int count, double delta_time, unsigned int thread_count, const std::function<void()>& computeForces) {
+        this->kick(particles, count, 0.5 * this->theta * delta_time, thread_count);
+        this->drift(particles, count, this->theta * delta_time, thread_count);
+        computeForces();
+        this->kick(particles, count, 0.5 * (1 - this->theta) * delta_time, thread_count);
+        this->drift(particles, count, (1 - 2 * this->theta) * delta_time, thread_count);
+        computeForces();
+        this->kick(particles, count, 0.5 * (1 - this->theta) * delta_time, thread_count);
+        this->drift(particles, count, this->theta * delta_time, thread_count);
+        computeForces();
+        this->kick(particles, count, 0.5 * this->theta * delta_time, thread_count);
+    }
+};
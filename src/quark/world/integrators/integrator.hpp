@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+#include <functional>
+#include "../particle.hpp"
+#include "../../parallel/parallel_for.hpp"
+
+/// @brief Virtual class for the time integration schemes of a universe.
+///         The forces held by the particles are up to date with their positions when step is called,
+///         and must be left up to date at the end of the step, so each step starts from the forces of the previous one.
+///         Integrators evaluating the forces elsewhere in the step say so with leavesForcesUpToDate: they get no forces
+///         at the start, and leave stale ones.
+///         Integrators may keep buffers between steps, so an integrator should only be used by one universe.
+/// @tparam D The number of dimensions of the simulation.
+template<unsigned int D>
+class Integrator {
+    public:
+    virtual ~Integrator() {}
+    /// @brief Advances the particles by one time step.
+    /// @param particles the particles to move.
+    /// @param count the number of particles.
+    /// @param delta_time the time step.
+    /// @param thread_count the number of threads the particle updates can be split over.
+    /// @param computeForces recomputes the forces of all the particles from their current positions.
+    virtual void step(Particle<D>* particles, unsigned int count, double delta_time, unsigned int thread_count, const std::function<void()>& computeForces) = 0;
+
+    /// @brief Whether the forces held by the particles match their positions at the end of a step.
+    ///         When false, the universe does not compute the forces before a step, and computes them again after
+    ///         the steps it analyzes, so the analyzers see the forces of the final positions.
+    virtual bool leavesForcesUpToDate() const {
+        return true;
+    }
+
+    /// @brief Called when the universe moves particles around, for integrators that keep indexes of particles.
+    /// @param new_indexes the new index of each particle, -1 for the removed ones.
+    virtual void reorderParticles(const std::vector<int>& new_indexes) {}
+
+    protected:
+    /// @brief v += coefficient * dt * F / m, for all the particles.
+    static void kick(Particle<D>* particles, unsigned int count, double coefficient, unsigned int thread_count) {
+        parallelFor(thread_count, 0, count, [&](unsigned int begin, unsigned int end, unsigned int thread) {
+            for(unsigned int i = begin; i < end; i++) {
+                particles[i].updateVelocity(particles[i].getForce() * (coefficient / particles[i].getMass()));
+            }
+        });
+    }
+
+    /// @brief x += coefficient * dt * v, for all the particles.
+    static void drift(Particle<D>* particles, unsigned int count, double coefficient, unsigned int thread_count) {
+        parallelFor(thread_count, 0, count, [&](unsigned int begin, unsigned int end, unsigned int thread) {
+            for(unsigned int i = begin; i < end; i++) {
+                particles[i].updatePosition(particles[i].getVelocity() * coefficient);
+            }
+        });
+    }
+};
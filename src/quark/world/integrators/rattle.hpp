@@ -0,0 +1,381 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include "integrator.hpp"
+
+/// @brief Störmer-Verlet with constraints: fixed distances between particles, solved with SHAKE on the positions
+///         and RATTLE on the velocities, and rigid bodies, moved as a whole.
+///         Removing the stiff vibrations of bonds and solids lets the time step follow the slower motions.
+///
+///         Distance constraints are iterated one after the other until they all hold within the tolerance.
+///         A rigid body keeps the shape of its particles at creation: its center of mass and angular momentum follow the
+///         total force and torque on its particles, and the particles are placed back from its position and orientation.
+///         Rotations are computed in 3D, a 2D body turning around the z axis. A particle can not be in a rigid body and
+///         in a distance constraint. Specular walls and periodic borders move single particles, use soft walls with bodies.
+/// @tparam D The number of dimensions of the simulation, 2 or 3.
+template<unsigned int D>
+class RattleIntegrator : public Integrator<D> {
+    static_assert(D == 2 || D == 3, "Constraints are only implemented in 2D and 3D.");
+
+    public:
+    typedef std::array<double, 3> Vector3;
+    typedef std::array<double, 9> Matrix3;
+
+    struct DistanceConstraint {
+        unsigned int first;
+        unsigned int second;
+        double length_sq;
+    };
+
+    struct RigidBody {
+        std::vector<unsigned int> members;
+        // positions of the members from the center of mass, in the frame of the body
+        std::vector<Vector3> offsets;
+        double mass;
+        Vector3 center;
+        Vector3 momentum;
+        Vector3 angular_momentum;
+        // unit quaternion, w first, from the frame of the body to the universe
+        std::array<double, 4> orientation;
+        Matrix3 inverse_inertia;
+    };
+
+    private:
+    std::vector<DistanceConstraint> constraints;
+    std::vector<RigidBody> bodies;
+    double tolerance = 1e-10;
+    unsigned int max_iterations = 500;
+    // vector between the particles of each constraint at the start of the step, the direction of the SHAKE corrections
+    std::vector<Vector<double, D>> start_separations;
+    unsigned int last_iterations = 0;
+    bool converged = true;
+
+    public:
+    RattleIntegrator() = default;
+
+    /// @brief Keeps two particles at a fixed distance.
+    void addDistanceConstraint(unsigned int first, unsigned int second, double length) {
+        this->constraints.push_back(DistanceConstraint{first, second, length * length});
+    }
+
+    /// @brief Makes a rigid body of particles, with their current positions and velocities.
+    ///         The velocities are projected on the rigid motions of the body.
+    /// @return the index of the body.
+    unsigned int addRigidBody(Particle<D>* particles, const std::vector<unsigned int>& members) {
+        RigidBody body;
+        body.members = members;
+        body.mass = 0;
+        body.center = {0, 0, 0};
+        body.momentum = {0, 0, 0};
+        body.angular_momentum = {0, 0, 0};
+        body.orientation = {1, 0, 0, 0};
+        for(unsigned int member: members) {
+            double mass = particles[member].getMass();
+            Vector3 position = toSpace(particles[member].getPosition());
+            Vector3 velocity = toSpace(particles[member].getVelocity());
+            body.mass += mass;
+            for(unsigned int dim = 0; dim < 3; dim++) {
+                body.center[dim] += mass * position[dim];
+                body.momentum[dim] += mass * velocity[dim];
+            }
+        }
+        Matrix3 inertia = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+        for(unsigned int dim = 0; dim < 3; dim++) {
+            body.center[dim] /= body.mass;
+        }
+        for(unsigned int member: members) {
+            double mass = particles[member].getMass();
+            Vector3 offset = difference(toSpace(particles[member].getPosition()), body.center);
+            Vector3 velocity = toSpace(particles[member].getVelocity());
+            body.offsets.push_back(offset);
+            Vector3 moment = cross(offset, velocity);
+            double offset_sq = offset[0] * offset[0] + offset[1] * offset[1] + offset[2] * offset[2];
+            for(unsigned int a = 0; a < 3; a++) {
+                body.angular_momentum[a] += mass * moment[a];
+                for(unsigned int b = 0; b < 3; b++) {
+                    inertia[3 * a + b] += mass * ((a == b ? offset_sq : 0.0) - offset[a] * offset[b]);
+                }
+            }
+        }
+        body.inverse_inertia = inverse(inertia);
+        this->bodies.push_back(body);
+        this->placeBody(particles, this->bodies.back());
+        return this->bodies.size() - 1;
+    }
+
+    /// @brief Sets the largest relative error on the constrained distances. Defaults to 1e-10.
+    void setTolerance(double tolerance) {
+        this->tolerance = tolerance;
+    }
+
+    /// @brief Sets the number of sweeps over the constraints after which SHAKE and RATTLE give up. Defaults to 500.
+    void setMaxIterations(unsigned int max_iterations) {
+        this->max_iterations = std::max(max_iterations, 1u);
+    }
+
+    const std::vector<DistanceConstraint>& getConstraints() const {
+        return this->constraints;
+    }
+
+    const std::vector<RigidBody>& getRigidBodies() const {
+        return this->bodies;
+    }
+
+    /// @brief Number of SHAKE sweeps of the last step.
+    unsigned int getLastIterations() const {
+        return this->last_iterations;
+    }
+
+    /// @brief Whether the constraints held within the tolerance at the end of the last step.
+    bool hasConverged() const {
+        return this->converged;
+    }
+
+    void step(Particle<D>* particles, unsigned int count, double delta_time, unsigned int thread_count, const std::function<void()>& computeForces) {
+        this->start_separations.resize(this->constraints.size());
+        for(unsigned int c = 0; c < this->constraints.size(); c++) {
+            this->start_separations[c] = particles[this->constraints[c].first].getPosition() - particles[this->constraints[c].second].getPosition();
+        }
+        // the torques are taken before the particles move
+        for(RigidBody& body: this->bodies) {
+            this->kickBody(particles, body, 0.5 * delta_time);
+        }
+        // the free particles follow Störmer-Verlet, the particles of the bodies are placed back over it
+        this->kick(particles, count, 0.5 * delta_time, thread_count);
+        this->drift(particles, count, delta_time, thread_count);
+        for(RigidBody& body: this->bodies) {
+            this->driftBody(body, delta_time);
+            this->placeBody(particles, body);
+        }
+        this->shake(particles, delta_time);
+        computeForces();
+        this->kick(particles, count, 0.5 * delta_time, thread_count);
+        for(RigidBody& body: this->bodies) {
+            this->kickBody(particles, body, 0.5 * delta_time);
+            this->placeBody(particles, body);
+        }
+        this->rattle(particles, delta_time);
+    }
+
+    /// @brief Follows the particles moved by the universe. Constraints on removed particles are dropped,
+    ///         and bodies that lost a particle are dissolved, their other particles going on freely.
+    void reorderParticles(const std::vector<int>& new_indexes) override {
+        auto remap = [&](unsigned int index) {
+            return index < new_indexes.size() ? new_indexes[index] : (int)index;
+        };
+        unsigned int kept = 0;
+        for(const DistanceConstraint& constraint: this->constraints) {
+            int first = remap(constraint.first);
+            int second = remap(constraint.second);
+            if(first >= 0 && second >= 0) {
+                this->constraints[kept++] = DistanceConstraint{(unsigned int)first, (unsigned int)second, constraint.length_sq};
+            }
+        }
+        this->constraints.resize(kept);
+        kept = 0;
+        for(RigidBody& body: this->bodies) {
+            bool complete = true;
+            for(unsigned int& member: body.members) {
+                int index = remap(member);
+                complete = complete && index >= 0;
+                member = index;
+            }
+            if(complete) {
+                this->bodies[kept++] = body;
+            }
+        }
+        this->bodies.resize(kept);
+    }
+
+    private:
+    static Vector3 toSpace(const Vector<double, D>& vector) {
+        return {vector[0], vector[1], D == 3 ? vector[D - 1] : 0.0};
+    }
+
+    static Vector<double, D> fromSpace(const Vector3& vector) {
+        Vector<double, D> result;
+        for(unsigned int dim = 0; dim < D; dim++) {
+            result[dim] = vector[dim];
+        }
+        return result;
+    }
+
+    static Vector3 difference(const Vector3& a, const Vector3& b) {
+        return {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+    }
+
+    static Vector3 cross(const Vector3& a, const Vector3& b) {
+        return {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+    }
+
+    static double dot(const Vector<double, D>& a, const Vector<double, D>& b) {
+        double result = 0.0;
+        for(unsigned int dim = 0; dim < D; dim++) {
+            result += a[dim] * b[dim];
+        }
+        return result;
+    }
+
+    static Vector3 multiply(const Matrix3& matrix, const Vector3& vector) {
+        Vector3 result;
+        for(unsigned int a = 0; a < 3; a++) {
+            result[a] = matrix[3 * a] * vector[0] + matrix[3 * a + 1] * vector[1] + matrix[3 * a + 2] * vector[2];
+        }
+        return result;
+    }
+
+    /// @brief Inverse of a symmetric inertia tensor. The tensor of particles on a line is singular along the line,
+    ///         where no particle moves when turning: a tiny regularisation keeps the inverse finite.
+    static Matrix3 inverse(Matrix3 m) {
+        double regularisation = 1e-12 * (m[0] + m[4] + m[8]);
+        for(unsigned int a = 0; a < 3; a++) {
+            m[4 * a] += regularisation;
+        }
+        Matrix3 cofactors = {
+            m[4] * m[8] - m[5] * m[7], m[2] * m[7] - m[1] * m[8], m[1] * m[5] - m[2] * m[4],
+            m[5] * m[6] - m[3] * m[8], m[0] * m[8] - m[2] * m[6], m[2] * m[3] - m[0] * m[5],
+            m[3] * m[7] - m[4] * m[6], m[1] * m[6] - m[0] * m[7], m[0] * m[4] - m[1] * m[3],
+        };
+        double determinant = m[0] * cofactors[0] + m[1] * cofactors[3] + m[2] * cofactors[6];
+        for(double& value: cofactors) {
+            value = determinant == 0 ? 0.0 : value / determinant;
+        }
+        return cofactors;
+    }
+
+    static Matrix3 rotationMatrix(const std::array<double, 4>& q) {
+        double w = q[0], x = q[1], y = q[2], z = q[3];
+        return {
+            1 - 2 * (y * y + z * z), 2 * (x * y - w * z), 2 * (x * z + w * y),
+            2 * (x * y + w * z), 1 - 2 * (x * x + z * z), 2 * (y * z - w * x),
+            2 * (x * z - w * y), 2 * (y * z + w * x), 1 - 2 * (x * x + y * y),
+        };
+    }
+
+    /// @brief Angular velocity of a body with a given orientation: R I^-1 R^T L.
+    static Vector3 angularVelocity(const RigidBody& body, const std::array<double, 4>& orientation) {
+        Matrix3 rotation = rotationMatrix(orientation);
+        Matrix3 transposed = {rotation[0], rotation[3], rotation[6], rotation[1], rotation[4], rotation[7], rotation[2], rotation[5], rotation[8]};
+        return multiply(rotation, multiply(body.inverse_inertia, multiply(transposed, body.angular_momentum)));
+    }
+
+    /// @brief Turns an orientation by an angular velocity during a time.
+    static std::array<double, 4> rotate(const std::array<double, 4>& q, const Vector3& angular_velocity, double time) {
+        double speed = sqrt(angular_velocity[0] * angular_velocity[0] + angular_velocity[1] * angular_velocity[1] + angular_velocity[2] * angular_velocity[2]);
+        if(speed == 0) {
+            return q;
+        }
+        double half_angle = 0.5 * speed * time;
+        double s = sin(half_angle) / speed;
+        std::array<double, 4> r = {cos(half_angle), s * angular_velocity[0], s * angular_velocity[1], s * angular_velocity[2]};
+        std::array<double, 4> result = {
+            r[0] * q[0] - r[1] * q[1] - r[2] * q[2] - r[3] * q[3],
+            r[0] * q[1] + r[1] * q[0] + r[2] * q[3] - r[3] * q[2],
+            r[0] * q[2] - r[1] * q[3] + r[2] * q[0] + r[3] * q[1],
+            r[0] * q[3] + r[1] * q[2] - r[2] * q[1] + r[3] * q[0],
+        };
+        double norm = sqrt(result[0] * result[0] + result[1] * result[1] + result[2] * result[2] + result[3] * result[3]);
+        for(double& value: result) {
+            value /= norm;
+        }
+        return result;
+    }
+
+    /// @brief Momentum and angular momentum of a body += time * the force and torque on its particles.
+    void kickBody(const Particle<D>* particles, RigidBody& body, double time) {
+        for(unsigned int m = 0; m < body.members.size(); m++) {
+            Vector3 force = toSpace(particles[body.members[m]].getForce());
+            Vector3 torque = cross(difference(toSpace(particles[body.members[m]].getPosition()), body.center), force);
+            for(unsigned int dim = 0; dim < 3; dim++) {
+                body.momentum[dim] += time * force[dim];
+                body.angular_momentum[dim] += time * torque[dim];
+            }
+        }
+    }
+
+    /// @brief Moves the center of mass, and turns the body with its angular velocity at the middle of the rotation.
+    void driftBody(RigidBody& body, double time) {
+        for(unsigned int dim = 0; dim < 3; dim++) {
+            body.center[dim] += time * body.momentum[dim] / body.mass;
+        }
+        std::array<double, 4> middle = rotate(body.orientation, angularVelocity(body, body.orientation), 0.5 * time);
+        body.orientation = rotate(body.orientation, angularVelocity(body, middle), time);
+    }
+
+    /// @brief Places the particles of a body from its position, orientation and motion.
+    void placeBody(Particle<D>* particles, const RigidBody& body) {
+        Matrix3 rotation = rotationMatrix(body.orientation);
+        Vector3 angular_velocity = angularVelocity(body, body.orientation);
+        for(unsigned int m = 0; m < body.members.size(); m++) {
+            Vector3 offset = multiply(rotation, body.offsets[m]);
+            Vector3 spin = cross(angular_velocity, offset);
+            Vector3 position, velocity;
+            for(unsigned int dim = 0; dim < 3; dim++) {
+                position[dim] = body.center[dim] + offset[dim];
+                velocity[dim] = body.momentum[dim] / body.mass + spin[dim];
+            }
+            particles[body.members[m]].setPosition(fromSpace(position));
+            particles[body.members[m]].setVelocity(fromSpace(velocity));
+        }
+    }
+
+    /// @brief Moves the constrained particles along their separation at the start of the step, until the distances hold.
+    ///         The velocities get the same correction, divided by the time step.
+    void shake(Particle<D>* particles, double delta_time) {
+        this->converged = true;
+        for(this->last_iterations = 0; this->last_iterations < this->max_iterations && !this->constraints.empty(); this->last_iterations++) {
+            bool done = true;
+            for(unsigned int c = 0; c < this->constraints.size(); c++) {
+                const DistanceConstraint& constraint = this->constraints[c];
+                Particle<D>& first = particles[constraint.first];
+                Particle<D>& second = particles[constraint.second];
+                Vector<double, D> separation = first.getPosition() - second.getPosition();
+                double error = constraint.length_sq - separation.sq_magnitude();
+                if(std::abs(error) <= 2 * this->tolerance * constraint.length_sq) {
+                    continue;
+                }
+                done = false;
+                double first_inverse_mass = 1.0 / first.getMass();
+                double second_inverse_mass = 1.0 / second.getMass();
+                double g = error / (2 * dot(separation, this->start_separations[c]) * (first_inverse_mass + second_inverse_mass));
+                first.updatePosition(this->start_separations[c] * (g * first_inverse_mass));
+                second.updatePosition(this->start_separations[c] * (-g * second_inverse_mass));
+                first.updateVelocity(this->start_separations[c] * (g * first_inverse_mass / delta_time));
+                second.updateVelocity(this->start_separations[c] * (-g * second_inverse_mass / delta_time));
+            }
+            if(done) {
+                return;
+            }
+        }
+        this->converged = this->constraints.empty();
+    }
+
+    /// @brief Removes the velocity along each constraint, so the distances stay fixed.
+    void rattle(Particle<D>* particles, double delta_time) {
+        for(unsigned int iteration = 0; iteration < this->max_iterations && !this->constraints.empty(); iteration++) {
+            bool done = true;
+            for(const DistanceConstraint& constraint: this->constraints) {
+                Particle<D>& first = particles[constraint.first];
+                Particle<D>& second = particles[constraint.second];
+                Vector<double, D> separation = first.getPosition() - second.getPosition();
+                double rate = dot(separation, first.getVelocity() - second.getVelocity());
+                if(std::abs(rate) <= this->tolerance * constraint.length_sq / delta_time) {
+                    continue;
+                }
+                done = false;
+                double first_inverse_mass = 1.0 / first.getMass();
+                double second_inverse_mass = 1.0 / second.getMass();
+                double k = rate / (constraint.length_sq * (first_inverse_mass + second_inverse_mass));
+                first.updateVelocity(separation * (-k * first_inverse_mass));
+                second.updateVelocity(separation * (k * second_inverse_mass));
+            }
+            if(done) {
+                return;
+            }
+        }
+        this->converged = false;
+    }
+};
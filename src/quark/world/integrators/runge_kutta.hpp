@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+#include "integrator.hpp"
+
+/// @brief Classical fourth order Runge-Kutta. Accurate on short runs, but not symplectic: the energy drifts over long ones.
+///         Four force evaluations per step, and it keeps a copy of the state, so it is meant for small systems.
+template<unsigned int D>
+class RungeKuttaIntegrator : public Integrator<D> {
+    private:
+    std::vector<Vector<double, D>> start_positions;
+    std::vector<Vector<double, D>> start_velocities;
+    // sums of the slopes of the stages, weighted 1 2 2 1
+    std::vector<Vector<double, D>> position_slopes;
+    std::vector<Vector<double, D>> velocity_slopes;
+    // velocity of the current stage
+    std::vector<Vector<double, D>> stage_velocities;
+
+    public:
+    RungeKuttaIntegrator() = default;
+
+    void step(Particle<D>* particles, unsigned int count, double delta_time, unsigned int thread_count, const std::function<void()>& computeForces) {
+        this->start_positions.resize(count);
+        this->start_velocities.resize(count);
+        this->position_slopes.resize(count);
+        this->velocity_slopes.resize(count);
+        this->stage_velocities.resize(count);
+        // first stage, from the current forces
+        parallelFor(thread_count, 0, count, [&](unsigned int begin, unsigned int end, unsigned int thread) {
+            for(unsigned int i = begin; i < end; i++) {
+                this->start_positions[i] = particles[i].getPosition();
+                this->start_velocities[i] = particles[i].getVelocity();
+                this->stage_velocities[i] = particles[i].getVelocity();
+                this->position_slopes[i] = particles[i].getVelocity();
+                this->velocity_slopes[i] = particles[i].getForce() / particles[i].getMass();
+            }
+        });
+        // the three next stages start from the slope of the previous one, at half a step, half a step and a full step
+        const double offsets[3] = {0.5, 0.5, 1.0};
+        const double weights[3] = {2.0, 2.0, 1.0};
+        for(unsigned int stage = 0; stage < 3; stage++) {
+            double offset = offsets[stage] * delta_time;
+            parallelFor(thread_count, 0, count, [&](unsigned int begin, unsigned int end, unsigned int thread) {
+                for(unsigned int i = begin; i < end; i++) {
+                    particles[i].setPosition(this->start_positions[i] + this->stage_velocities[i] * offset);
+                    this->stage_velocities[i] = this->start_velocities[i] + particles[i].getForce() * (offset / particles[i].getMass());
+                }
+            });
+            computeForces();
+            double weight = weights[stage];
+            parallelFor(thread_count, 0, count, [&](unsigned int begin, unsigned int end, unsigned int thread) {
+                for(unsigned int i = begin; i < end; i++) {
+                    this->position_slopes[i] += this->stage_velocities[i] * weight;
+                    this->velocity_slopes[i] += particles[i].getForce() * (weight / particles[i].getMass());
+                }
+            });
+        }
+        // combine the stages, then bring the forces up to date for the next step
+        parallelFor(thread_count, 0, count, [&](unsigned int begin, unsigned int end, unsigned int thread) {
+            for(unsigned int i = begin; i < end; i++) {
+                particles[i].setPosition(this->start_positions[i] + this->position_slopes[i] * (delta_time / 6));
+                particles[i].setVelocity(this->start_velocities[i] + this->velocity_slopes[i] * (delta_time / 6));
+            }
+        });
+        computeForces();
+    }
+};
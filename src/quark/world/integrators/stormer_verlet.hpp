@@ -0,0 +1,39 @@
+#pragma once
+
+#include "integrator.hpp"
+
+/// @brief Störmer-Verlet in its velocity form, second order and symplectic. One force evaluation per step.
+///         This is the default integrator of a universe.
+template<unsigned int D>
+class StormerVerletIntegrator : public Integrator<D> {
+    public:
+    StormerVerletIntegrator() = default;
+
+    void step(Particle<D>* particles, unsigned int count, double delta_time, unsigned int thread_count, const std::function<void()>& computeForces) {
+        // half kick with the old forces, drift, then half kick with the new ones
+        this->kick(particles, count, 0.5 * delta_time, thread_count);
+        this->drift(particles, count, delta_time, thread_count);
+        computeForces();
+        this->kick(particles, count, 0.5 * delta_time, thread_count);
+    }
+};
+
+/// @brief Störmer-Verlet in its position form: half drift, kick, half drift. Second order and symplectic.
+///         The forces are evaluated at the middle of the step, so the ones held by the particles lag half a step behind:
+///         they are left stale rather than paying a second force evaluation per step.
+template<unsigned int D>
+class PositionVerletIntegrator : public Integrator<D> {
+    public:
+    PositionVerletIntegrator() = default;
+
+    bool leavesForcesUpToDate() const override {
+        return false;
+    }
+
+    void step(Particle<D>* particles, unsigned int count, double delta_time, unsigned int thread_count, const std::function<void()>& computeForces) {
+        this->drift(particles, count, 0.5 * delta_time, thread_count);
+        computeForces();
+        this->kick(particles, count, delta_time, thread_count);
+        this->drift(particles, count, 0.5 * delta_time, thread_count);
+    }
+};
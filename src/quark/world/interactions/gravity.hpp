@@ -6,15 +6,21 @@
 template<unsigned int D>
 class GravityInteractor : public Interactor<D> {
     private:
-    constexpr static const double G = 0.0000000000667430;
+    const double G;
     public:
-    GravityInteractor() = default;
+    /// @param G the gravitational constant, in the units of the simulation. Defaults to its SI value.
+    GravityInteractor(double G = 0.0000000000667430) : G(G) {}
     public:
     Vector<double, D> computeInteractionForce(const Particle<D>& part1, const Particle<D>& part2) {
         // gravity interaction is : 
         // F = m1 m2 * r12 / || r12 ||^3
-        double distance_cubed = pow((part2.getPosition() - part1.getPosition()).sq_magnitude(), 3/2);
+        double distance_cubed = pow((part2.getPosition() - part1.getPosition()).sq_magnitude(), 1.5);
         double F = this->G * part1.getMass() * part2.getMass() / distance_cubed;
         return (part2.getPosition() - part1.getPosition()) * F;
     }
+
+    /// @brief Compute the gravitational energy of a pair, -G m1 m2 / r.
+    double computePotentialEnergy(const Particle<D>& part1, const Particle<D>& part2) {
+        return -this->G * part1.getMass() * part2.getMass() / sqrt((part2.getPosition() - part1.getPosition()).sq_magnitude());
+    }
 };
\ No newline at end of file
@@ -8,10 +8,20 @@
 template<unsigned int D>
 class Interactor {
     public:
+    virtual ~Interactor() {}
     /// @brief Compute the forces that part2 exerce on part1.
     ///         This should be the opposite of computeInteractionForce(part2, part1).
     /// @param part1  The particle on which forces are exerced.
     /// @param part2  The particle exercing the force.
     /// @return the force that part2 exerce on part1.
     virtual Vector<double, D> computeInteractionForce(const Particle<D>& part1, const Particle<D>& part2) = 0;
+
+    /// @brief Compute the potential energy of a pair, whose gradient along part1 is minus the force on part1.
+    ///         Interactors without a potential count for nothing in the energy.
+    /// @param part1 The first particle of the pair.
+    /// @param part2 The second particle of the pair.
+    /// @return the energy of the pair.
+    virtual double computePotentialEnergy(const Particle<D>& part1, const Particle<D>& part2) {
+        return 0.0;
+    }
 };
\ No newline at end of file
@@ -11,6 +11,10 @@ class LennardJonesInteractor : public Interactor<D> {
     const double sigma_sixth = sigma * sigma * sigma * sigma * sigma * sigma;
     const double epsilon_24 = epsilon * 24;
 
+    public:
+    LennardJonesInteractor(double sigma = 1.0, double epsilon = 1.0) : sigma(sigma), epsilon(epsilon) {}
+
+    private:
     /// @brief Compute the force that part2 exerce on part1, from the Lennard-Jones potential.
     /// @param part1 The particle on which the force is applied.
     /// @param part2 The particle applying the force.
@@ -22,4 +26,11 @@ class LennardJonesInteractor : public Interactor<D> {
         return rij * (epsilon_24 / distance_sq * sigma_over_distance_sixth * (1 - 2 * sigma_over_distance_sixth));
     }
 
+    /// @brief Compute the Lennard-Jones energy of a pair, 4 epsilon ((sigma / r)^12 - (sigma / r)^6).
+    double computePotentialEnergy(const Particle<D>& part1, const Particle<D>& part2) {
+        double distance_sq = (part2.getPosition() - part1.getPosition()).sq_magnitude();
+        double sigma_over_distance_sixth = sigma_sixth / (distance_sq * distance_sq * distance_sq);
+        return 4 * epsilon * sigma_over_distance_sixth * (sigma_over_distance_sixth - 1);
+    }
+
 };
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "long_range_solver.hpp"
+#include "kernel.hpp"
+
+/// @brief Reference long range solver, summing the interactions of all pairs of particles. O(N^2).
+///         Only the particles themselves are summed: the images of a periodic universe are left out.
+/// @tparam D The number of dimensions of the simulation.
+template<unsigned int D>
+class DirectSummationSolver : public LongRangeSolver<D> {
+    private:
+    const double coupling;
+    const double softening_sq;
+    double potential_energy = 0;
+
+    public:
+    /// @brief Creates a direct summation solver.
+    /// @param coupling the strength of the interaction. G for gravity, -k for Coulomb forces.
+    /// @param softening distance added to every pair, to avoid singular forces at close encounters.
+    DirectSummationSolver(double coupling, double softening = 0.0) : coupling(coupling), softening_sq(softening * softening) {}
+
+    public:
+    void addForces(Particle<D>* particles, unsigned int count, double box_length) override {
+        this->potential_energy = 0;
+        for(unsigned int i = 0; i < count; i++) {
+            Vector<double, D> pos_i = particles[i].getPosition();
+            for(unsigned int j = 0; j < i; j++) {
+                Vector<double, D> rij = pos_i - particles[j].getPosition();
+                double distance_sq = rij.sq_magnitude() + this->softening_sq;
+                double strength = this->coupling * particles[i].getMass() * particles[j].getMass();
+                Vector<double, D> force = rij * (strength * LaplaceKernel<D>::gradientFactor(distance_sq));
+                particles[i].addForce(force);
+                particles[j].addForce(-force);
+                this->potential_energy -= strength * LaplaceKernel<D>::potential(distance_sq);
+            }
+        }
+    }
+
+    /// @brief Potential energy of the particles, computed by the last call to addForces.
+    double getPotentialEnergy() const {
+        return this->potential_energy;
+    }
+};
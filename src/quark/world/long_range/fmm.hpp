@@ -0,0 +1,563 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include "long_range_solver.hpp"
+#include "kernel.hpp"
+
+/// @brief Fast multipole solver for the laplace kernel, in 2 or 3 dimensions.
+///         The particles are sorted in a uniform tree built on their bounding cube. Each cell stores a cartesian
+///         multipole expansion of its particles, truncated at the given order, which is turned into local expansions
+///         of the well separated cells of the same level (M2L) and passed down to the leaves.
+///         Adjacent leaves interact directly, so the cost is O(N) for a given order, and the error decreases
+///         geometrically with the order.
+///         The tree only holds the particles, not their periodic images: the solver refuses periodic universes.
+/// @tparam D The number of dimensions of the simulation.
+template<unsigned int D>
+class FastMultipoleSolver : public LongRangeSolver<D> {
+    static_assert(D == 2 || D == 3, "the fast multipole solver only supports 2 and 3 dimensions");
+
+    private:
+    /// @brief One term of a translation operator: target[target] += coefficient * source[source] * table[table].
+    struct Term {
+        unsigned int target;
+        unsigned int source;
+        unsigned int table;
+        double coefficient;
+    };
+
+    private:
+    const double coupling;
+    const double softening_sq;
+    const int order;
+    const unsigned int leaf_size;
+    double potential_energy = 0;
+    bool periodic_refused = false;
+
+    // multi index tables, sorted by degree. built once.
+    unsigned int coefficient_count = 0;
+    std::vector<Vector<int, D>> multi_indices;
+    std::vector<int> lower_index[D]; // position of n - e_d, -1 if n_d == 0
+    std::vector<int> upper_index[D]; // position of n + e_d, -1 if |n| == order
+    std::vector<double> inverse_factorials;
+    std::vector<Term> m2m_terms;
+    std::vector<Term> m2l_terms;
+    std::vector<Term> l2l_terms;
+
+    // tree, rebuilt at each call
+    unsigned int leaf_level = 0;
+    Vector<double, D> origin;
+    double size = 1.0;
+    std::vector<std::vector<unsigned int>> cell_counts;
+    std::vector<std::vector<double>> multipoles;
+    std::vector<std::vector<double>> locals;
+    // particles sorted by leaf
+    std::vector<unsigned int> leaf_start;
+    std::vector<unsigned int> sorted_particles;
+    std::vector<Vector<double, D>> sorted_positions;
+    std::vector<double> sorted_strengths;
+
+    public:
+    /// @brief Creates a fast multipole solver.
+    /// @param coupling the strength of the interaction. G for gravity, -k for Coulomb forces.
+    /// @param order the order of the expansions. Higher orders are more precise and more expensive.
+    /// @param leaf_size the average number of particles in the leaves of the tree.
+    /// @param softening distance added to the close pairs, to avoid singular forces at close encounters.
+    FastMultipoleSolver(double coupling, unsigned int order = 4, unsigned int leaf_size = 32, double softening = 0.0) :
+        coupling(coupling),
+        softening_sq(softening * softening),
+        order(order),
+        leaf_size(std::max(leaf_size, 1u)) {
+        this->generateMultiIndices();
+        this->generateTerms();
+    }
+
+    public:
+    void addForces(Particle<D>* particles, unsigned int count, double box_length) override;
+
+    /// @brief Potential energy of the particles, computed by the last call to addForces.
+    double getPotentialEnergy() const {
+        return this->potential_energy;
+    }
+
+    private:
+    void generateMultiIndices();
+    void generateTerms();
+    void buildTree(Particle<D>* particles, unsigned int count);
+    void upwardPass();
+    void downwardPass();
+    void evaluateLeaves(Particle<D>* particles);
+
+    private:
+    // utility
+    int findMultiIndex(Vector<int, D> n) const;
+    void computeMonomials(const Vector<double, D>& h, double* monomials) const;
+    void computeDerivatives(const Vector<double, D>& x, double* derivatives) const;
+    Vector<int, D> cellCoordinates(unsigned int cell, unsigned int level) const;
+    unsigned int cellIndex(const Vector<int, D>& coordinates, unsigned int level) const;
+    Vector<double, D> cellCenter(const Vector<int, D>& coordinates, unsigned int level) const;
+};
+
+/// @brief Lists all the multi indices n with |n| <= order, sorted by degree, and the links between them.
+template<unsigned int D>
+void FastMultipoleSolver<D>::generateMultiIndices() {
+    for(int degree = 0; degree <= this->order; degree++) {
+        // enumerate the (order + 1)^D candidates, keep the ones of the current degree
+        int candidates = (int)std::pow(this->order + 1, D);
+        for(int candidate = candidates - 1; candidate >= 0; candidate--) {
+            Vector<int, D> n;
+            int current = candidate;
+            int total = 0;
+            for(int dim = D - 1; dim >= 0; dim--) {
+                n[dim] = current % (this->order + 1);
+                current /= this->order + 1;
+                total += n[dim];
+            }
+            if(total == degree) {
+                this->multi_indices.push_back(n);
+            }
+        }
+    }
+    this->coefficient_count = this->multi_indices.size();
+
+    for(unsigned int pos = 0; pos < this->coefficient_count; pos++) {
+        Vector<int, D> n = this->multi_indices[pos];
+        double factorial = 1;
+        for(unsigned int dim = 0; dim < D; dim++) {
+            for(int k = 2; k <= n[dim]; k++) {
+                factorial *= k;
+            }
+            Vector<int, D> lower = n;
+            lower[dim]--;
+            this->lower_index[dim].push_back(n[dim] > 0 ? this->findMultiIndex(lower) : -1);
+            Vector<int, D> upper = n;
+            upper[dim]++;
+            this->upper_index[dim].push_back(this->findMultiIndex(upper));
+        }
+        this->inverse_factorials.push_back(1.0 / factorial);
+    }
+}
+
+/// @brief Precomputes the terms of the M2M, M2L and L2L operators, so the passes are flat loops.
+template<unsigned int D>
+void FastMultipoleSolver<D>::generateTerms() {
+    for(unsigned int n = 0; n < this->coefficient_count; n++) {
+        for(unsigned int k = 0; k < this->coefficient_count; k++) {
+            Vector<int, D> sum = this->multi_indices[n] + this->multi_indices[k];
+            Vector<int, D> difference = this->multi_indices[n] - this->multi_indices[k];
+            int degree = 0;
+            bool k_below_n = true;
+            for(unsigned int dim = 0; dim < D; dim++) {
+                degree += sum[dim];
+                k_below_n = k_below_n && difference[dim] >= 0;
+            }
+            // M2M: M_n += M_k * b^(n-k) / (n-k)!
+            if(k_below_n) {
+                unsigned int table = this->findMultiIndex(difference);
+                this->m2m_terms.push_back({n, k, table, this->inverse_factorials[table]});
+            }
+            if(degree <= this->order) {
+                unsigned int table = this->findMultiIndex(sum);
+                int degree_k = 0;
+                for(unsigned int dim = 0; dim < D; dim++) {
+                    degree_k += this->multi_indices[k][dim];
+                }
+                // M2L: L_n += (-1)^|k| M_k * d^(n+k) phi
+                this->m2l_terms.push_back({n, k, table, degree_k % 2 == 0 ? 1.0 : -1.0});
+                // L2L: L_n += L_(n+k) * s^k / k!
+                this->l2l_terms.push_back({n, table, k, this->inverse_factorials[k]});
+            }
+        }
+    }
+}
+
+template<unsigned int D>
+void FastMultipoleSolver<D>::addForces(Particle<D>* particles, unsigned int count, double box_length) {
+    this->potential_energy = 0;
+    if(box_length > 0) {
+        if(!this->periodic_refused) {
+            std::cout << "ERROR : The fast multipole solver does not handle periodic borders, it adds no forces." << std::endl;
+            this->periodic_refused = true;
+        }
+        return;
+    }
+    if(count == 0) {
+        return;
+    }
+    this->buildTree(particles, count);
+    this->upwardPass();
+    this->downwardPass();
+    this->evaluateLeaves(particles);
+}
+
+/// @brief Builds the uniform tree over the bounding cube of the particles, and sorts the particles by leaf.
+template<unsigned int D>
+void FastMultipoleSolver<D>::buildTree(Particle<D>* particles, unsigned int count) {
+    // bounding cube
+    Vector<double, D> min_corner = particles[0].getPosition();
+    Vector<double, D> max_corner = particles[0].getPosition();
+    for(unsigned int i = 1; i < count; i++) {
+        Vector<double, D> pos = particles[i].getPosition();
+        for(unsigned int dim = 0; dim < D; dim++) {
+            min_corner[dim] = std::min(min_corner[dim], pos[dim]);
+            max_corner[dim] = std::max(max_corner[dim], pos[dim]);
+        }
+    }
+    this->size = 0;
+    for(unsigned int dim = 0; dim < D; dim++) {
+        this->size = std::max(this->size, max_corner[dim] - min_corner[dim]);
+    }
+    this->size = this->size > 0 ? this->size * 1.000001 : 1.0;
+    this->origin = min_corner;
+
+    // deepest level such that the leaves hold about leaf_size particles. capped to keep the memory reasonable.
+    const unsigned int max_level = D == 2 ? 10 : 6;
+    this->leaf_level = 0;
+    while(this->leaf_level < max_level && count > this->leaf_size * (1u << (D * this->leaf_level))) {
+        this->leaf_level++;
+    }
+
+    // allocate the levels
+    this->cell_counts.resize(this->leaf_level + 1);
+    this->multipoles.resize(this->leaf_level + 1);
+    this->locals.resize(this->leaf_level + 1);
+    for(unsigned int level = 0; level <= this->leaf_level; level++) {
+        unsigned int cells = 1u << (D * level);
+        this->cell_counts[level].assign(cells, 0);
+        this->multipoles[level].assign(cells * this->coefficient_count, 0.0);
+        this->locals[level].assign(cells * this->coefficient_count, 0.0);
+    }
+
+    // counting sort of the particles by leaf
+    unsigned int leaves = 1u << (D * this->leaf_level);
+    int side = 1 << this->leaf_level;
+    std::vector<unsigned int> particle_leaf(count);
+    for(unsigned int i = 0; i < count; i++) {
+        Vector<double, D> pos = particles[i].getPosition();
+        Vector<int, D> coordinates;
+        for(unsigned int dim = 0; dim < D; dim++) {
+            coordinates[dim] = std::min((int)((pos[dim] - this->origin[dim]) / this->size * side), side - 1);
+        }
+        particle_leaf[i] = this->cellIndex(coordinates, this->leaf_level);
+        this->cell_counts[this->leaf_level][particle_leaf[i]]++;
+    }
+    this->leaf_start.assign(leaves + 1, 0);
+    for(unsigned int leaf = 0; leaf < leaves; leaf++) {
+        this->leaf_start[leaf + 1] = this->leaf_start[leaf] + this->cell_counts[this->leaf_level][leaf];
+    }
+    std::vector<unsigned int> next(this->leaf_start.begin(), this->leaf_start.end() - 1);
+    this->sorted_particles.resize(count);
+    this->sorted_positions.resize(count);
+    this->sorted_strengths.resize(count);
+    for(unsigned int i = 0; i < count; i++) {
+        unsigned int slot = next[particle_leaf[i]]++;
+        this->sorted_particles[slot] = i;
+        this->sorted_positions[slot] = particles[i].getPosition();
+        this->sorted_strengths[slot] = particles[i].getMass();
+    }
+
+    // count the particles of the upper levels
+    for(int level = this->leaf_level - 1; level >= 0; level--) {
+        for(unsigned int child = 0; child < this->cell_counts[level + 1].size(); child++) {
+            Vector<int, D> coordinates = this->cellCoordinates(child, level + 1);
+            for(unsigned int dim = 0; dim < D; dim++) {
+                coordinates[dim] /= 2;
+            }
+            this->cell_counts[level][this->cellIndex(coordinates, level)] += this->cell_counts[level + 1][child];
+        }
+    }
+}
+
+/// @brief Computes the multipoles of the leaves (P2M), and accumulates them up to the root (M2M).
+template<unsigned int D>
+void FastMultipoleSolver<D>::upwardPass() {
+    std::vector<double> monomials(this->coefficient_count);
+    const unsigned int n_coef = this->coefficient_count;
+
+    // P2M: M_k = sum_j s_j (x_j - center)^k / k!
+    std::vector<double>& leaf_multipoles = this->multipoles[this->leaf_level];
+    for(unsigned int leaf = 0; leaf + 1 < this->leaf_start.size(); leaf++) {
+        Vector<double, D> center = this->cellCenter(this->cellCoordinates(leaf, this->leaf_level), this->leaf_level);
+        for(unsigned int slot = this->leaf_start[leaf]; slot < this->leaf_start[leaf + 1]; slot++) {
+            this->computeMonomials(this->sorted_positions[slot] - center, monomials.data());
+            for(unsigned int k = 0; k < n_coef; k++) {
+                leaf_multipoles[leaf * n_coef + k] += this->sorted_strengths[slot] * monomials[k] * this->inverse_factorials[k];
+            }
+        }
+    }
+
+    // M2M, from the leaves to the root
+    for(int level = this->leaf_level - 1; level >= 0; level--) {
+        for(unsigned int child = 0; child < this->cell_counts[level + 1].size(); child++) {
+            if(this->cell_counts[level + 1][child] == 0) {
+                continue;
+            }
+            Vector<int, D> child_coordinates = this->cellCoordinates(child, level + 1);
+            Vector<int, D> parent_coordinates = child_coordinates;
+            for(unsigned int dim = 0; dim < D; dim++) {
+                parent_coordinates[dim] /= 2;
+            }
+            unsigned int parent = this->cellIndex(parent_coordinates, level);
+            this->computeMonomials(
+                this->cellCenter(child_coordinates, level + 1) - this->cellCenter(parent_coordinates, level),
+                monomials.data()
+            );
+            const double* source = &this->multipoles[level + 1][child * n_coef];
+            double* target = &this->multipoles[level][parent * n_coef];
+            for(const Term& term: this->m2m_terms) {
+                target[term.target] += term.coefficient * source[term.source] * monomials[term.table];
+            }
+        }
+    }
+}
+
+/// @brief Converts the multipoles of the well separated cells into local expansions (M2L), and passes them down (L2L).
+///         Well separated cells are the children of the neighbors of the parent that are not neighbors themselves.
+template<unsigned int D>
+void FastMultipoleSolver<D>::downwardPass() {
+    std::vector<double> table(this->coefficient_count);
+    const unsigned int n_coef = this->coefficient_count;
+    const unsigned int neighbor_count = (unsigned int)std::pow(3, D);
+    const unsigned int children_count = 1u << D;
+
+    for(unsigned int level = 2; level <= this->leaf_level; level++) {
+        int side = 1 << level;
+        // M2L
+        for(unsigned int cell = 0; cell < this->cell_counts[level].size(); cell++) {
+            if(this->cell_counts[level][cell] == 0) {
+                continue; // no particle will use that local expansion
+            }
+            Vector<int, D> coordinates = this->cellCoordinates(cell, level);
+            Vector<double, D> center = this->cellCenter(coordinates, level);
+            double* target = &this->locals[level][cell * n_coef];
+            for(unsigned int neighbor = 0; neighbor < neighbor_count; neighbor++) {
+                for(unsigned int child = 0; child < children_count; child++) {
+                    // child of the neighbor of the parent
+                    Vector<int, D> source_coordinates;
+                    bool inside = true;
+                    bool adjacent = true;
+                    unsigned int neighbor_it = neighbor;
+                    for(int dim = D - 1; dim >= 0; dim--) {
+                        int offset = (int)(neighbor_it % 3) - 1;
+                        neighbor_it /= 3;
+                        source_coordinates[dim] = 2 * (coordinates[dim] / 2 + offset) + (int)((child >> dim) & 1);
+                        inside = inside && 0 <= source_coordinates[dim] && source_coordinates[dim] < side;
+                        adjacent = adjacent && std::abs(source_coordinates[dim] - coordinates[dim]) <= 1;
+                    }
+                    if(!inside || adjacent) {
+                        continue;
+                    }
+                    unsigned int source_cell = this->cellIndex(source_coordinates, level);
+                    if(this->cell_counts[level][source_cell] == 0) {
+                        continue;
+                    }
+                    this->computeDerivatives(center - this->cellCenter(source_coordinates, level), table.data());
+                    const double* source = &this->multipoles[level][source_cell * n_coef];
+                    for(const Term& term: this->m2l_terms) {
+                        target[term.target] += term.coefficient * source[term.source] * table[term.table];
+                    }
+                }
+            }
+        }
+        // L2L to the next level
+        if(level == this->leaf_level) {
+            break;
+        }
+        for(unsigned int child = 0; child < this->cell_counts[level + 1].size(); child++) {
+            if(this->cell_counts[level + 1][child] == 0) {
+                continue;
+            }
+            Vector<int, D> child_coordinates = this->cellCoordinates(child, level + 1);
+            Vector<int, D> parent_coordinates = child_coordinates;
+            for(unsigned int dim = 0; dim < D; dim++) {
+                parent_coordinates[dim] /= 2;
+            }
+            unsigned int parent = this->cellIndex(parent_coordinates, level);
+            this->computeMonomials(
+                this->cellCenter(child_coordinates, level + 1) - this->cellCenter(parent_coordinates, level),
+                table.data()
+            );
+            const double* source = &this->locals[level][parent * n_coef];
+            double* target = &this->locals[level + 1][child * n_coef];
+            for(const Term& term: this->l2l_terms) {
+                target[term.target] += term.coefficient * source[term.source] * table[term.table];
+            }
+        }
+    }
+}
+
+/// @brief Evaluates the local expansions on the particles of each leaf (L2P), and adds the direct interactions
+///         with the particles of the adjacent leaves (P2P).
+template<unsigned int D>
+void FastMultipoleSolver<D>::evaluateLeaves(Particle<D>* particles) {
+    std::vector<double> monomials(this->coefficient_count);
+    const unsigned int n_coef = this->coefficient_count;
+    const unsigned int neighbor_count = (unsigned int)std::pow(3, D);
+    int side = 1 << this->leaf_level;
+
+    for(unsigned int leaf = 0; leaf + 1 < this->leaf_start.size(); leaf++) {
+        if(this->leaf_start[leaf] == this->leaf_start[leaf + 1]) {
+            continue;
+        }
+        Vector<int, D> coordinates = this->cellCoordinates(leaf, this->leaf_level);
+        Vector<double, D> center = this->cellCenter(coordinates, this->leaf_level);
+        const double* local = &this->locals[this->leaf_level][leaf * n_coef];
+
+        for(unsigned int slot = this->leaf_start[leaf]; slot < this->leaf_start[leaf + 1]; slot++) {
+            Vector<double, D> pos = this->sorted_positions[slot];
+            // L2P: phi(center + h) = sum_n L_n h^n / n!
+            this->computeMonomials(pos - center, monomials.data());
+            double potential = 0;
+            Vector<double, D> gradient = Vector<double, D>();
+            for(unsigned int n = 0; n < n_coef; n++) {
+                double weight = monomials[n] * this->inverse_factorials[n];
+                potential += local[n] * weight;
+                for(unsigned int dim = 0; dim < D; dim++) {
+                    if(this->upper_index[dim][n] >= 0) {
+                        gradient[dim] += local[this->upper_index[dim][n]] * weight;
+                    }
+                }
+            }
+            // P2P with all the adjacent leaves, including this one
+            for(unsigned int neighbor = 0; neighbor < neighbor_count; neighbor++) {
+                Vector<int, D> neighbor_coordinates;
+                bool inside = true;
+                unsigned int neighbor_it = neighbor;
+                for(int dim = D - 1; dim >= 0; dim--) {
+                    neighbor_coordinates[dim] = coordinates[dim] + (int)(neighbor_it % 3) - 1;
+                    neighbor_it /= 3;
+                    inside = inside && 0 <= neighbor_coordinates[dim] && neighbor_coordinates[dim] < side;
+                }
+                if(!inside) {
+                    continue;
+                }
+                unsigned int neighbor_leaf = this->cellIndex(neighbor_coordinates, this->leaf_level);
+                for(unsigned int other = this->leaf_start[neighbor_leaf]; other < this->leaf_start[neighbor_leaf + 1]; other++) {
+                    if(other == slot) {
+                        continue;
+                    }
+                    Vector<double, D> rij = pos - this->sorted_positions[other];
+                    double distance_sq = rij.sq_magnitude() + this->softening_sq;
+                    potential += this->sorted_strengths[other] * LaplaceKernel<D>::potential(distance_sq);
+                    gradient += rij * (this->sorted_strengths[other] * LaplaceKernel<D>::gradientFactor(distance_sq));
+                }
+            }
+            double strength = this->coupling * this->sorted_strengths[slot];
+            particles[this->sorted_particles[slot]].addForce(gradient * strength);
+            this->potential_energy -= 0.5 * strength * potential;
+        }
+    }
+}
+
+template<unsigned int D>
+int FastMultipoleSolver<D>::findMultiIndex(Vector<int, D> n) const {
+    int degree = 0;
+    for(unsigned int dim = 0; dim < D; dim++) {
+        if(n[dim] < 0) {
+            return -1;
+        }
+        degree += n[dim];
+    }
+    if(degree > this->order) {
+        return -1;
+    }
+    for(unsigned int pos = 0; pos < this->multi_indices.size(); pos++) {
+        if(this->multi_indices[pos] == n) {
+            return pos;
+        }
+    }
+    return -1;
+}
+
+/// @brief Computes h^n for all the multi indices n, each one from a lower one.
+template<unsigned int D>
+void FastMultipoleSolver<D>::computeMonomials(const Vector<double, D>& h, double* monomials) const {
+    monomials[0] = 1.0;
+    for(unsigned int pos = 1; pos < this->coefficient_count; pos++) {
+        unsigned int dim = 0;
+        while(this->lower_index[dim][pos] < 0) {
+            dim++;
+        }
+        monomials[pos] = monomials[this->lower_index[dim][pos]] * h[dim];
+    }
+}
+
+/// @brief Computes all the derivatives d^n phi(x) of the kernel, with the recurrence obtained by differentiating
+///         |x|^2 d_i phi = -x_i phi (3D) or |x|^2 d_i phi = -x_i (2D) with the Leibniz rule.
+template<unsigned int D>
+void FastMultipoleSolver<D>::computeDerivatives(const Vector<double, D>& x, double* derivatives) const {
+    double distance_sq = 0;
+    for(unsigned int dim = 0; dim < D; dim++) {
+        distance_sq += x[dim] * x[dim];
+    }
+    derivatives[0] = LaplaceKernel<D>::potential(distance_sq);
+    for(unsigned int pos = 1; pos < this->coefficient_count; pos++) {
+        const Vector<int, D>& n = this->multi_indices[pos];
+        // differentiate along the first non zero dimension: n = m + e_i
+        unsigned int i = 0;
+        while(n[i] == 0) {
+            i++;
+        }
+        double value = 0;
+        for(unsigned int j = 0; j < D; j++) {
+            int m_j = n[j] - (j == i ? 1 : 0);
+            if(m_j > 0) {
+                value -= 2 * m_j * x[j] * derivatives[this->lower_index[j][pos]];
+            }
+            if(m_j > 1) {
+                value -= m_j * (m_j - 1) * derivatives[this->lower_index[j][this->lower_index[j][pos]]];
+            }
+        }
+        int m_i = n[i] - 1;
+        if constexpr (D == 3) {
+            value -= x[i] * derivatives[this->lower_index[i][pos]];
+            if(m_i > 0) {
+                value -= m_i * derivatives[this->lower_index[i][this->lower_index[i][pos]]];
+            }
+        }
+        else {
+            int degree = 0;
+            for(unsigned int j = 0; j < D; j++) {
+                degree += n[j];
+            }
+            if(degree == 1) {
+                value -= x[i];
+            }
+            else if(degree == 2 && m_i == 1) {
+                value -= 1;
+            }
+        }
+        derivatives[pos] = value / distance_sq;
+    }
+}
+
+template<unsigned int D>
+Vector<int, D> FastMultipoleSolver<D>::cellCoordinates(unsigned int cell, unsigned int level) const {
+    Vector<int, D> result;
+    for(int dim = D - 1; dim >= 0; dim--) {
+        result[dim] = cell & ((1u << level) - 1);
+        cell >>= level;
+    }
+    return result;
+}
+
+template<unsigned int D>
+unsigned int FastMultipoleSolver<D>::cellIndex(const Vector<int, D>& coordinates, unsigned int level) const {
+    unsigned int result = 0;
+    for(unsigned int dim = 0; dim < D; dim++) {
+        result = (result << level) + coordinates[dim];
+    }
+    return result;
+}
+
+template<unsigned int D>
+Vector<double, D> FastMultipoleSolver<D>::cellCenter(const Vector<int, D>& coordinates, unsigned int level) const {
+    double cell_size = this->size / (1 << level);
+    Vector<double, D> result;
+    for(unsigned int dim = 0; dim < D; dim++) {
+        result[dim] = this->origin[dim] + (coordinates[dim] + 0.5) * cell_size;
+    }
+    return result;
+}
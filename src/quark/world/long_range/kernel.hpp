@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cmath>
+
+/// @brief Green function of the Laplace equation used by the long range solvers:
+///         phi(r) = 1 / r in 3 dimensions, and phi(r) = -log(r) in 2 dimensions.
+///         The potential is phi = sum_j s_j phi(x - x_j), and the force on particle i is coupling * s_i * grad(phi)(x_i),
+///         so a positive coupling (G) gives gravity, and a negative one (-k) gives Coulomb forces.
+/// @tparam D The number of dimensions of the simulation.
+template<unsigned int D>
+struct LaplaceKernel {
+    static_assert(D == 2 || D == 3, "the laplace kernel is only defined in 2 and 3 dimensions");
+
+    /// @brief Value of the kernel.
+    /// @param distance_sq squared distance between the two points.
+    static inline double potential(double distance_sq) {
+        if constexpr (D == 3) {
+            return 1.0 / std::sqrt(distance_sq);
+        }
+        else {
+            return -0.5 * std::log(distance_sq);
+        }
+    }
+
+    /// @brief The gradient of the kernel at x is x * gradientFactor(|x|^2).
+    /// @param distance_sq squared distance between the two points.
+    static inline double gradientFactor(double distance_sq) {
+        if constexpr (D == 3) {
+            return -1.0 / (distance_sq * std::sqrt(distance_sq));
+        }
+        else {
+            return -1.0 / distance_sq;
+        }
+    }
+};
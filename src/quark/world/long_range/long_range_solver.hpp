@@ -0,0 +1,16 @@
+#pragma once
+
+#include "../particle.hpp"
+
+/// @brief Virtual class for solvers computing interactions between all pairs of particles, without cut off distance.
+///         They are registered in the universe next to the interactors, which only handle the short range part.
+/// @tparam D The number of dimensions of the simulation.
+template<unsigned int D>
+class LongRangeSolver {
+    public:
+    /// @brief Add the long range forces to all the given particles.
+    /// @param particles the particles to compute forces for.
+    /// @param count the number of particles.
+    /// @param box_length the size of the universe cube when its border is periodic, 0 otherwise.
+    virtual void addForces(Particle<D>* particles, unsigned int count, double box_length) = 0;
+};
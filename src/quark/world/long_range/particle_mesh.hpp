@@ -0,0 +1,403 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include <complex>
+#include <algorithm>
+#include <iostream>
+#include "long_range_solver.hpp"
+#include "../../maths/fft.hpp"
+#include "../../parallel/parallel_for.hpp"
+
+/// @brief How the particles are spread on the grid, and how the forces are read back.
+enum ASSIGNMENT_SCHEME {
+    cic, // cloud in cell, 2 cells per dimension
+    tsc, // triangular shaped cloud, 3 cells per dimension
+};
+
+/// @brief Particle mesh solver for the laplace kernel in a periodic universe, in 2 or 3 dimensions.
+///         The masses are assigned on a grid of M^D cells covering the universe, the Poisson equation is solved
+///         with fourier transforms, and the gradient of the potential is interpolated back on the particles.
+///         The cost is O(N + M^D log M), which is much cheaper than pairwise methods for dense and roughly uniform systems,
+///         but forces are smoothed under a few cells: pair it with a short range interactor for close encounters.
+///         The grid is split in slabs along the first dimension, each thread owning a range of slabs.
+/// @tparam D The number of dimensions of the simulation.
+template<unsigned int D>
+class ParticleMeshSolver : public LongRangeSolver<D> {
+    static_assert(D == 2 || D == 3, "the particle mesh solver only supports 2 and 3 dimensions");
+
+    private:
+    const double coupling;
+    const unsigned int grid_size;
+    const ASSIGNMENT_SCHEME scheme;
+    const unsigned int thread_count;
+    unsigned int cell_count;
+    unsigned int slab_size;
+    double potential_energy = 0;
+    bool open_refused = false;
+
+    FFT fft;
+    // poisson solution in fourier space, and in real space, where it gives the potential of a unit cell on the other cells.
+    // Both depend on the box length given last.
+    double green_box_length = 0;
+    std::vector<double> green_modes;
+    std::vector<double> green;
+    std::vector<std::complex<double>> density;
+    std::vector<std::complex<double>> field;
+    // particles sorted by slab, so each thread only looks at the particles touching its slabs
+    std::vector<unsigned int> slab_start;
+    std::vector<unsigned int> sorted_particles;
+    // positions of the particles, wrapped in the universe
+    std::vector<Vector<double, D>> wrapped_positions;
+
+    public:
+    /// @brief Creates a particle mesh solver.
+    /// @param coupling the strength of the interaction. G for gravity, -k for Coulomb forces.
+    /// @param grid_size the number of cells in each dimension, must be a power of two. Other sizes leave the solver invalid.
+    /// @param scheme the assignment scheme.
+    /// @param thread_count the number of threads used by the solver.
+    ParticleMeshSolver(double coupling, unsigned int grid_size, ASSIGNMENT_SCHEME scheme = ASSIGNMENT_SCHEME::cic, unsigned int thread_count = defaultThreadCount()) :
+        coupling(coupling),
+        grid_size(isPowerOfTwo(grid_size) ? grid_size : 0),
+        scheme(scheme),
+        thread_count(thread_count),
+        fft(this->grid_size) {
+        if(this->grid_size == 0) {
+            std::cout << "ERROR : The particle mesh grid size " << grid_size << " is not a power of two." << std::endl;
+        }
+        this->slab_size = (unsigned int)std::pow(this->grid_size, D - 1);
+        this->cell_count = this->slab_size * grid_size;
+        this->density.resize(this->cell_count);
+        this->field.resize(this->cell_count);
+    }
+
+    public:
+    void addForces(Particle<D>* particles, unsigned int count, double box_length) override;
+
+    /// @brief Whether the grid size was valid. An invalid solver adds no forces.
+    bool isValid() const {
+        return this->grid_size != 0;
+    }
+
+    /// @brief Potential energy of the pairs of particles, computed by the last call to addForces.
+    ///         The energy of each particle with its own cloud on the grid is left out.
+    double getPotentialEnergy() const {
+        return this->potential_energy;
+    }
+
+    private:
+    void sortParticles(Particle<D>* particles, unsigned int count, double box_length);
+    void assignMasses(Particle<D>* particles, double box_length);
+    void computeGreenFunction(double box_length);
+    void transform(std::vector<std::complex<double>>& grid, bool inverse);
+    void interpolate(Particle<D>* particles, unsigned int count, double box_length, int dim);
+    double selfPotential(double mass, const double (*weights)[3], double cell_length) const;
+
+    private:
+    // utility
+    unsigned int stencilWidth() const;
+    int stencil(double position, double cell_length, double* weights) const;
+    unsigned int wrap(int index) const;
+    static bool isPowerOfTwo(unsigned int size) {
+        return size != 0 && (size & (size - 1)) == 0;
+    }
+};
+
+template<unsigned int D>
+void ParticleMeshSolver<D>::addForces(Particle<D>* particles, unsigned int count, double box_length) {
+    this->potential_energy = 0;
+    if(count == 0 || !this->isValid()) {
+        return;
+    }
+    // the grid is periodic, it can not leave out the images of the particles
+    if(box_length <= 0) {
+        if(!this->open_refused) {
+            std::cout << "ERROR : The particle mesh solver needs a periodic universe, it adds no forces." << std::endl;
+            this->open_refused = true;
+        }
+        return;
+    }
+    this->sortParticles(particles, count, box_length);
+    this->assignMasses(particles, box_length);
+    this->transform(this->density, false);
+
+    // solve the poisson equation in fourier space: laplacian(phi) = -c rho, so phi_k = c rho_k / k^2,
+    // with c = 4 pi in 3D and 2 pi in 2D
+    if(box_length != this->green_box_length) {
+        this->computeGreenFunction(box_length);
+    }
+    const unsigned int M = this->grid_size;
+    parallelFor(this->thread_count, 0, M, [&](unsigned int slab_begin, unsigned int slab_end, unsigned int thread) {
+        for(unsigned int cell = slab_begin * this->slab_size; cell < slab_end * this->slab_size; cell++) {
+            this->density[cell] *= this->green_modes[cell];
+        }
+    });
+
+    // the potential itself, for the energy
+    std::copy(this->density.begin(), this->density.end(), this->field.begin());
+    this->transform(this->field, true);
+    this->interpolate(particles, count, box_length, -1);
+
+    // one component of the gradient at a time, with the centered difference on the grid: g_k = i sin(k h) / h phi_k.
+    // It matches the assignment better than the exact derivative i k, which overshoots at the short wavelengths.
+    const double cell_length = box_length / M;
+    for(unsigned int dim = 0; dim < D; dim++) {
+        parallelFor(this->thread_count, 0, M, [&](unsigned int slab_begin, unsigned int slab_end, unsigned int thread) {
+            unsigned int stride = (unsigned int)std::pow(M, D - 1 - dim);
+            for(unsigned int cell = slab_begin * this->slab_size; cell < slab_end * this->slab_size; cell++) {
+                int n = (cell / stride) % M;
+                double k = 2 * M_PI * n / box_length;
+                this->field[cell] = this->density[cell] * std::complex<double>(0, sin(k * cell_length) / cell_length);
+            }
+        });
+        this->transform(this->field, true);
+        this->interpolate(particles, count, box_length, dim);
+    }
+}
+
+/// @brief Computes the poisson solution for a box length: c / k^2 for each mode, with c = 4 pi in 3D and 2 pi in 2D,
+///         and its inverse transform. The mean density does not create forces in a periodic universe, its mode is zero.
+template<unsigned int D>
+void ParticleMeshSolver<D>::computeGreenFunction(double box_length) {
+    const double c = D == 3 ? 4 * M_PI : 2 * M_PI;
+    const unsigned int M = this->grid_size;
+    this->green_modes.resize(this->cell_count);
+    for(unsigned int cell = 0; cell < this->cell_count; cell++) {
+        double k_sq = 0;
+        unsigned int index = cell;
+        for(unsigned int dim = 0; dim < D; dim++) {
+            int n = index % M;
+            index /= M;
+            n = n < (int)M / 2 ? n : n - (int)M;
+            double k = 2 * M_PI * n / box_length;
+            k_sq += k * k;
+        }
+        this->green_modes[cell] = k_sq == 0 ? 0.0 : c / k_sq;
+    }
+    std::copy(this->green_modes.begin(), this->green_modes.end(), this->field.begin());
+    this->transform(this->field, true);
+    this->green.resize(this->cell_count);
+    for(unsigned int cell = 0; cell < this->cell_count; cell++) {
+        this->green[cell] = this->field[cell].real();
+    }
+    this->green_box_length = box_length;
+}
+
+/// @brief Wraps the particles in the universe and sorts them by slab of the first dimension.
+template<unsigned int D>
+void ParticleMeshSolver<D>::sortParticles(Particle<D>* particles, unsigned int count, double box_length) {
+    const double cell_length = box_length / this->grid_size;
+    std::vector<unsigned int> particle_slab(count);
+    this->slab_start.assign(this->grid_size + 1, 0);
+    this->wrapped_positions.resize(count);
+    this->sorted_particles.resize(count);
+    for(unsigned int i = 0; i < count; i++) {
+        Vector<double, D> pos = particles[i].getPosition();
+        for(unsigned int dim = 0; dim < D; dim++) {
+            pos[dim] -= box_length * floor(pos[dim] / box_length);
+        }
+        this->wrapped_positions[i] = pos;
+        particle_slab[i] = std::min((unsigned int)(pos[0] / cell_length), this->grid_size - 1);
+        this->slab_start[particle_slab[i] + 1]++;
+    }
+    for(unsigned int slab = 0; slab < this->grid_size; slab++) {
+        this->slab_start[slab + 1] += this->slab_start[slab];
+    }
+    std::vector<unsigned int> next(this->slab_start.begin(), this->slab_start.end() - 1);
+    for(unsigned int i = 0; i < count; i++) {
+        this->sorted_particles[next[particle_slab[i]]++] = i;
+    }
+}
+
+/// @brief Spreads the masses on the density grid. Each thread owns a range of slabs, and only writes in it:
+///         it visits the particles of its slabs and of the neighboring ones, and clips their stencil to its slabs.
+template<unsigned int D>
+void ParticleMeshSolver<D>::assignMasses(Particle<D>* particles, double box_length) {
+    const double cell_length = box_length / this->grid_size;
+    const double cell_volume = std::pow(cell_length, D);
+    const unsigned int width = this->stencilWidth();
+    const int M = this->grid_size;
+    parallelFor(this->thread_count, 0, M, [&](unsigned int slab_begin, unsigned int slab_end, unsigned int thread) {
+        std::fill(this->density.begin() + slab_begin * this->slab_size, this->density.begin() + slab_end * this->slab_size, 0.0);
+        // stencils reach at most 2 cells away from the particle slab. each slab must be visited only once.
+        int visited = std::min((int)(slab_end - slab_begin) + 4, M);
+        for(int slab = (int)slab_begin - 2; slab < (int)slab_begin - 2 + visited; slab++) {
+            unsigned int source_slab = this->wrap(slab);
+            for(unsigned int sorted = this->slab_start[source_slab]; sorted < this->slab_start[source_slab + 1]; sorted++) {
+                const Vector<double, D>& pos = this->wrapped_positions[this->sorted_particles[sorted]];
+                double mass = particles[this->sorted_particles[sorted]].getMass() / cell_volume;
+                double weights[D][3];
+                int first[D];
+                for(unsigned int dim = 0; dim < D; dim++) {
+                    first[dim] = this->stencil(pos[dim], cell_length, weights[dim]);
+                }
+                // the first dimension of the stencil, clipped to our slabs
+                for(unsigned int a = 0; a < width; a++) {
+                    unsigned int x = this->wrap(first[0] + a);
+                    if(x < slab_begin || x >= slab_end) {
+                        continue;
+                    }
+                    if constexpr (D == 2) {
+                        for(unsigned int b = 0; b < width; b++) {
+                            this->density[x * M + this->wrap(first[1] + b)] += mass * weights[0][a] * weights[1][b];
+                        }
+                    }
+                    else {
+                        for(unsigned int b = 0; b < width; b++) {
+                            unsigned int y = this->wrap(first[1] + b);
+                            for(unsigned int c = 0; c < width; c++) {
+                                this->density[(x * M + y) * M + this->wrap(first[2] + c)] += mass * weights[0][a] * weights[1][b] * weights[2][c];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    });
+}
+
+/// @brief Fourier transform of the whole grid, one dimension at a time. The lines of each dimension are split between the threads.
+///         The inverse transform is normalized.
+template<unsigned int D>
+void ParticleMeshSolver<D>::transform(std::vector<std::complex<double>>& grid, bool inverse) {
+    const unsigned int M = this->grid_size;
+    for(unsigned int dim = 0; dim < D; dim++) {
+        unsigned int stride = (unsigned int)std::pow(M, D - 1 - dim);
+        // lines are indexed by (index before dim, index after dim)
+        parallelFor(this->thread_count, 0, this->slab_size, [&](unsigned int line_begin, unsigned int line_end, unsigned int thread) {
+            std::vector<std::complex<double>> line(M);
+            for(unsigned int l = line_begin; l < line_end; l++) {
+                unsigned int start = (l / stride) * stride * M + l % stride;
+                // gather the line so the transform runs on contiguous memory
+                for(unsigned int i = 0; i < M; i++) {
+                    line[i] = grid[start + i * stride];
+                }
+                this->fft.transform(line.data(), 1, inverse);
+                for(unsigned int i = 0; i < M; i++) {
+                    grid[start + i * stride] = line[i];
+                }
+            }
+        });
+    }
+    if(inverse) {
+        double normalization = 1.0 / this->cell_count;
+        for(std::complex<double>& value: grid) {
+            value *= normalization;
+        }
+    }
+}
+
+/// @brief Reads the field grid back on the particles, with the same stencil as the assignment.
+/// @param dim the component of the gradient stored in the field, or -1 if it holds the potential.
+template<unsigned int D>
+void ParticleMeshSolver<D>::interpolate(Particle<D>* particles, unsigned int count, double box_length, int dim) {
+    const double cell_length = box_length / this->grid_size;
+    const unsigned int width = this->stencilWidth();
+    const unsigned int M = this->grid_size;
+    std::vector<double> energies(this->thread_count, 0.0);
+    parallelFor(this->thread_count, 0, count, [&](unsigned int begin, unsigned int end, unsigned int thread) {
+        for(unsigned int i = begin; i < end; i++) {
+            const Vector<double, D>& pos = this->wrapped_positions[i];
+            double weights[D][3];
+            int first[D];
+            for(unsigned int d = 0; d < D; d++) {
+                first[d] = this->stencil(pos[d], cell_length, weights[d]);
+            }
+            double value = 0;
+            for(unsigned int a = 0; a < width; a++) {
+                unsigned int x = this->wrap(first[0] + a);
+                for(unsigned int b = 0; b < width; b++) {
+                    unsigned int y = this->wrap(first[1] + b);
+                    if constexpr (D == 2) {
+                        value += this->field[x * M + y].real() * weights[0][a] * weights[1][b];
+                    }
+                    else {
+                        for(unsigned int c = 0; c < width; c++) {
+                            unsigned int z = this->wrap(first[2] + c);
+                            value += this->field[(x * M + y) * M + z].real() * weights[0][a] * weights[1][b] * weights[2][c];
+                        }
+                    }
+                }
+            }
+            double strength = this->coupling * particles[i].getMass();
+            if(dim < 0) {
+                energies[thread] -= 0.5 * strength * (value - this->selfPotential(particles[i].getMass(), weights, cell_length));
+            }
+            else {
+                Vector<double, D> force = Vector<double, D>();
+                force[dim] = strength * value;
+                particles[i].addForce(force);
+            }
+        }
+    });
+    for(double energy: energies) {
+        this->potential_energy += energy;
+    }
+}
+
+/// @brief Potential a particle creates on itself through the grid, from its stencil weights.
+///         The stencil cells a and b of the particle interact through green[a - b], so the weight products are first
+///         summed by offset along each dimension.
+template<unsigned int D>
+double ParticleMeshSolver<D>::selfPotential(double mass, const double (*weights)[3], double cell_length) const {
+    const int width = this->stencilWidth();
+    const int offsets = 2 * width - 1;
+    const unsigned int M = this->grid_size;
+    // offset_weights[d][o + width - 1]: sum of weights[d][a] * weights[d][b] with a - b = o
+    double offset_weights[D][5] = {};
+    for(unsigned int d = 0; d < D; d++) {
+        for(int a = 0; a < width; a++) {
+            for(int b = 0; b < width; b++) {
+                offset_weights[d][a - b + width - 1] += weights[d][a] * weights[d][b];
+            }
+        }
+    }
+    double value = 0;
+    for(int a = 0; a < offsets; a++) {
+        for(int b = 0; b < offsets; b++) {
+            unsigned int xy = this->wrap(a - width + 1) * M + this->wrap(b - width + 1);
+            if constexpr (D == 2) {
+                value += this->green[xy] * offset_weights[0][a] * offset_weights[1][b];
+            }
+            else {
+                for(int c = 0; c < offsets; c++) {
+                    value += this->green[xy * M + this->wrap(c - width + 1)] * offset_weights[0][a] * offset_weights[1][b] * offset_weights[2][c];
+                }
+            }
+        }
+    }
+    return value * mass / std::pow(cell_length, D);
+}
+
+template<unsigned int D>
+unsigned int ParticleMeshSolver<D>::stencilWidth() const {
+    return this->scheme == ASSIGNMENT_SCHEME::cic ? 2 : 3;
+}
+
+/// @brief Computes the weights of the cells around a position, along one dimension.
+/// @return the index of the first cell of the stencil, not wrapped.
+template<unsigned int D>
+int ParticleMeshSolver<D>::stencil(double position, double cell_length, double* weights) const {
+    double x = position / cell_length;
+    if(this->scheme == ASSIGNMENT_SCHEME::cic) {
+        int first = (int)floor(x - 0.5);
+        double f = x - 0.5 - first;
+        weights[0] = 1 - f;
+        weights[1] = f;
+        return first;
+    }
+    else {
+        int center = (int)floor(x);
+        double d = x - center - 0.5;
+        weights[0] = 0.5 * (0.5 - d) * (0.5 - d);
+        weights[1] = 0.75 - d * d;
+        weights[2] = 0.5 * (0.5 + d) * (0.5 + d);
+        return center - 1;
+    }
+}
+
+template<unsigned int D>
+unsigned int ParticleMeshSolver<D>::wrap(int index) const {
+    int M = this->grid_size;
+    return ((index % M) + M) % M;
+}
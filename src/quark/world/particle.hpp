@@ -1,6 +1,7 @@
 #pragma once
 
 
+#include <atomic>
 #include <functional>
 #include <random>
 #include "../maths/vector.hpp"
@@ -10,8 +11,8 @@
 template<unsigned int D>
 class Particle {
     private:
-    /// @brief  last used id of the particles.
-    static int last_id;
+    /// @brief  last used id of the particles. Atomic, as universes may be built from several threads at once.
+    static std::atomic<int> last_id;
 
     private:
     int id; // id for this particle
@@ -26,7 +27,9 @@ class Particle {
     /// @brief Create a particle with all params to default.
     Particle() = default;
     /// @brief Creates a particle from the given position generator function.
-    Particle(std::function<Vector<double, D>()> positionGenerator) {
+    template<typename Generator>
+    requires std::is_invocable_r_v<Vector<double, D>, Generator&>
+    Particle(Generator positionGenerator) {
         this->id = Particle::last_id++;
         this->position = positionGenerator();
         this->velocity = Vector<double, D>();
@@ -41,18 +44,42 @@ class Particle {
         this->force = force;
         this->mass = mass;
     }
+    /// @brief Creates a particle with a given id, taken from reserveIds. Used to create particles in bulk.
+    Particle(int id, const Vector<double, D>& pos, const Vector<double, D>& vel, double mass) {
+        this->id = id;
+        this->position = pos;
+        this->velocity = vel;
+        this->force = Vector<double, D>();
+        this->mass = mass;
+    }
+
+    /// @brief Reserves count consecutive particle ids.
+    /// @return the first reserved id.
+    static int reserveIds(unsigned int count) {
+        return Particle::last_id.fetch_add(count);
+    }
+
+    /// @brief Makes sure the ids up to id, included, are never given to new particles. Used for particles read back with their ids.
+    static void reserveIdsUpTo(int id) {
+        int last = Particle::last_id.load();
+        while(last <= id && !Particle::last_id.compare_exchange_weak(last, id + 1)) {}
+    }
 
     // getters
     public:
-    Vector<double, D> getPosition() const {
+    int getId() const {
+        return this->id;
+    }
+
+    const Vector<double, D>& getPosition() const {
         return this->position;
     }
 
-    Vector<double, D> getVelocity() const {
+    const Vector<double, D>& getVelocity() const {
         return this->velocity;
     }
 
-    Vector<double, D> getForce() const {
+    const Vector<double, D>& getForce() const {
         return this->force;
     }
 
@@ -61,24 +88,42 @@ class Particle {
     }
 
     // updating methods
-    void updateVelocity(Vector<double, D> ammount) {
+    // they take any vector expression, so the update is evaluated in place without a temporary vector
+    template<typename E>
+    void updateVelocity(const VectorExpression<E, double, D>& ammount) {
         this->velocity += ammount;
     }
 
-    void updatePosition(Vector<double, D> ammount) {
+    template<typename E>
+    void updatePosition(const VectorExpression<E, double, D>& ammount) {
         this->position += ammount;
     }
 
+    template<typename E>
+    void setPosition(const VectorExpression<E, double, D>& position) {
+        this->position = position;
+    }
+
+    template<typename E>
+    void setVelocity(const VectorExpression<E, double, D>& velocity) {
+        this->velocity = velocity;
+    }
+
+    void setMass(double mass) {
+        this->mass = mass;
+    }
+
     void resetForce() {
         this->force.reset();
     }
 
-    void addForce(Vector<double, D> force) {
+    template<typename E>
+    void addForce(const VectorExpression<E, double, D>& force) {
         this->force += force;
     }
 
 };
 
 // static definition and initialization of last particle id
-template<unsigned int D> int Particle<D>::last_id = 0; 
+template<unsigned int D> std::atomic<int> Particle<D>::last_id = 0;
 
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+#include "particle.hpp"
+
+/// @brief Copy of the particles of a universe at a given step, published to the consumers of a StepPipeline.
+///         It exposes the particles like a universe does, so any Visualizer<Snapshot<D>> can draw it.
+///         A snapshot is only filled by the pipeline before it is published, and does not change while consumers read it.
+/// @tparam D The number of dimensions of the simulation.
+template<unsigned int D>
+class Snapshot {
+    private:
+    std::vector<Particle<D>> particles;
+    unsigned long step = 0;
+    double time = 0.0;
+
+    public:
+    Snapshot() = default;
+
+    const std::vector<Particle<D>>& getParticles() const {
+        return this->particles;
+    }
+
+    /// @brief Number of steps the universe ran when the snapshot was taken.
+    unsigned long getStep() const {
+        return this->step;
+    }
+
+    /// @brief Simulated time when the snapshot was taken.
+    double getTime() const {
+        return this->time;
+    }
+
+    /// @brief Fills the snapshot, reusing its storage.
+    template<typename Iterator>
+    void capture(Iterator begin, Iterator end, unsigned long step, double time) {
+        this->particles.assign(begin, end);
+        this->step = step;
+        this->time = time;
+    }
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include "source.hpp"
+#include "../initializers.hpp"
+#include "../../maths/philox.hpp"
+
+/// @brief Source creating particles uniformly in a box at a constant rate, like an inlet.
+///         Random numbers are keyed by the number of particles emitted so far, so a seed always gives the same flow.
+/// @tparam D the dimension of the particles.
+template<unsigned int D>
+class BoxSource : public ParticleSource<D> {
+    private:
+    Vector<double, D> corner;
+    Vector<double, D> size;
+    Vector<double, D> velocity;
+    double rate;
+    Philox rng;
+    double mass;
+    double temperature;
+    // particles owed by the past steps, the rate is rarely a whole number of particles per step
+    double pending = 0.0;
+    uint64_t emitted = 0;
+
+    public:
+    /// @param corner the lowest corner of the box.
+    /// @param size the size of the box in each dimension.
+    /// @param velocity the mean velocity of the new particles.
+    /// @param rate the number of particles created per unit of time.
+    /// @param seed the seed of the random generator.
+    /// @param mass the mass of the new particles.
+    /// @param temperature the temperature of the Maxwell-Boltzmann spread around the mean velocity.
+    BoxSource(
+        const Vector<double, D>& corner, const Vector<double, D>& size, const Vector<double, D>& velocity,
+        double rate, uint64_t seed, double mass = 1.0, double temperature = 0.0
+    ) : corner(corner), size(size), velocity(velocity), rate(rate), rng(seed), mass(mass), temperature(temperature) {}
+
+    unsigned int emit(double time, double delta_time, Particle<D>* particles, unsigned int capacity) override {
+        this->pending += this->rate * delta_time;
+        unsigned int count = std::min((unsigned int)this->pending, capacity);
+        // particles that did not fit are lost, the source does not pile up a burst for later
+        this->pending -= std::floor(this->pending);
+        int first_id = Particle<D>::reserveIds(count);
+        double sigma = sqrt(this->temperature / this->mass);
+        for(unsigned int i = 0; i < count; i++) {
+            uint64_t index = this->emitted + i;
+            Vector<double, D> position;
+            Vector<double, D> particle_velocity = this->velocity;
+            for(unsigned int dim = 0; dim < D; dim += 2) {
+                std::array<double, 2> u = this->rng.uniform(index, Initializers::POSITION_STREAM, dim / 2);
+                std::array<double, 2> n = this->rng.normal(index, Initializers::VELOCITY_STREAM, dim / 2);
+                position[dim] = this->corner[dim] + this->size[dim] * u[0];
+                particle_velocity[dim] += sigma * n[0];
+                if(dim + 1 < D) {
+                    position[dim + 1] = this->corner[dim + 1] + this->size[dim + 1] * u[1];
+                    particle_velocity[dim + 1] += sigma * n[1];
+                }
+            }
+            particles[i] = Particle<D>(first_id + i, position, particle_velocity, this->mass);
+        }
+        this->emitted += count;
+        return count;
+    }
+
+    uint64_t getEmittedCount() const {
+        return this->emitted;
+    }
+};
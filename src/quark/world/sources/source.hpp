@@ -0,0 +1,20 @@
+#pragma once
+
+#include "../particle.hpp"
+
+/// @brief Virtual class for the sources of a universe, creating particles during the simulation.
+///         The universe asks each source for particles at the end of every step, and places them in its free slots.
+/// @tparam D the dimension of the particles.
+template<unsigned int D>
+class ParticleSource {
+    public:
+    virtual ~ParticleSource() = default;
+
+    /// @brief Creates the particles appearing during a step.
+    /// @param time the time of the universe at the end of the step.
+    /// @param delta_time the duration of the step.
+    /// @param particles output, the new particles.
+    /// @param capacity the number of free slots in the universe, the source must not write more particles.
+    /// @return the number of particles written.
+    virtual unsigned int emit(double time, double delta_time, Particle<D>* particles, unsigned int capacity) = 0;
+};
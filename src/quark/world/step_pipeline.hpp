@@ -0,0 +1,213 @@
+#pragma once
+
+#include <list>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+#include "snapshot.hpp"
+#include "../visualizer/visualizer.hpp"
+
+/// @brief Steps a universe while its consumers (visualizers, writers, analysis) work on earlier steps, each on its own thread.
+///         After a step, the particles are copied in an immutable snapshot that is queued to every consumer,
+///         and the next step starts right away. When a consumer has queue_depth snapshots waiting,
+///         publishing blocks until it catches up, so a slow consumer slows the simulation down instead of filling the memory.
+///         Snapshot buffers are recycled once every consumer is done with them.
+///         Consumers registered here run outside of the universe step: they should not be registered on the universe too.
+/// @tparam Universe the type of universe to step.
+template<typename Universe>
+class StepPipeline {
+    private:
+    constexpr static unsigned int D = ParticleDimension<UniverseParticle<Universe>>::value;
+
+    /// @brief A snapshot in flight, shared by the queues of all the consumers.
+    struct Publication {
+        std::unique_ptr<Snapshot<D>> snapshot;
+        std::promise<void> done;
+        std::atomic<unsigned int> remaining;
+    };
+
+    /// @brief A consumer, its queue of publications, and its thread.
+    struct Consumer {
+        Visualizer<Snapshot<D>>* visualizer;
+        std::deque<std::shared_ptr<Publication>> queue;
+        std::thread thread;
+    };
+
+    Universe* universe;
+    unsigned int queue_depth;
+    unsigned int publish_interval = 1;
+    std::list<Consumer> consumers;
+
+    // protects the queues and the recycled snapshots
+    std::mutex mutex;
+    std::condition_variable queued;
+    std::condition_variable consumed;
+    bool stopping = false;
+    std::vector<std::unique_ptr<Snapshot<D>>> free_snapshots;
+
+    unsigned long step_count = 0;
+    double time = 0.0;
+    // time spent waiting for the consumers to catch up, and number of publications that had to wait
+    double stall_time = 0.0;
+    std::atomic<unsigned long> stall_count = 0;
+
+    public:
+    /// @brief Creates a pipeline around a universe.
+    /// @param universe the universe to step.
+    /// @param queue_depth the number of snapshots a consumer can have waiting before publishing blocks.
+    StepPipeline(Universe* universe, unsigned int queue_depth = 2) : universe(universe), queue_depth(std::max(queue_depth, 1u)) {}
+
+    StepPipeline(const StepPipeline&) = delete;
+    StepPipeline& operator=(const StepPipeline&) = delete;
+
+    /// @brief Waits for the consumers to process every published snapshot, then stops their threads.
+    ~StepPipeline() {
+        this->flush();
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->stopping = true;
+        }
+        this->queued.notify_all();
+        for(Consumer& consumer: this->consumers) {
+            consumer.thread.join();
+        }
+    }
+
+    /// @brief Adds a consumer, which gets its own thread. Register the consumers before stepping.
+    void registerConsumer(Visualizer<Snapshot<D>>* visualizer) {
+        this->consumers.emplace_back();
+        Consumer& consumer = this->consumers.back();
+        consumer.visualizer = visualizer;
+        consumer.thread = std::thread(&StepPipeline::consume, this, &consumer);
+    }
+
+    /// @brief Publishes a snapshot every interval steps. Defaults to every step.
+    void setPublishInterval(unsigned int interval) {
+        this->publish_interval = std::max(interval, 1u);
+    }
+
+    /// @brief Steps the universe, and publishes a snapshot if the interval is reached.
+    void step(double delta_time) {
+        this->universe->step(delta_time);
+        this->step_count++;
+        this->time += delta_time;
+        if(this->step_count % this->publish_interval == 0) {
+            this->publish();
+        }
+    }
+
+    /// @brief Copies the particles of the universe in a snapshot and queues it to every consumer.
+    ///         Blocks while a consumer queue is full.
+    /// @return a future, ready once every consumer has processed the snapshot.
+    std::shared_future<void> publish() {
+        std::shared_ptr<Publication> publication = std::make_shared<Publication>();
+        std::shared_future<void> done = publication->done.get_future().share();
+        publication->remaining = this->consumers.size();
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            // backpressure: wait for room in every queue
+            auto stall_begin = std::chrono::steady_clock::now();
+            auto has_room = [this]() {
+                for(const Consumer& consumer: this->consumers) {
+                    if(consumer.queue.size() >= this->queue_depth) {
+                        return false;
+                    }
+                }
+                return true;
+            };
+            if(!has_room()) {
+                this->stall_count++;
+                this->consumed.wait(lock, has_room);
+            }
+            this->stall_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - stall_begin).count();
+            if(!this->free_snapshots.empty()) {
+                publication->snapshot = std::move(this->free_snapshots.back());
+                this->free_snapshots.pop_back();
+            }
+        }
+        if(!publication->snapshot) {
+            publication->snapshot.reset(new Snapshot<D>());
+        }
+        const auto& particles = this->universe->getParticles();
+        publication->snapshot->capture(particles.begin(), particles.end(), this->step_count, this->time);
+        if(this->consumers.empty()) {
+            publication->done.set_value();
+            return done;
+        }
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            for(Consumer& consumer: this->consumers) {
+                consumer.queue.push_back(publication);
+            }
+        }
+        this->queued.notify_all();
+        return done;
+    }
+
+    /// @brief Blocks until every published snapshot has been processed.
+    void flush() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->consumed.wait(lock, [this]() {
+            for(const Consumer& consumer: this->consumers) {
+                if(!consumer.queue.empty()) {
+                    return false;
+                }
+            }
+            return true;
+        });
+    }
+
+    unsigned long getStepCount() const {
+        return this->step_count;
+    }
+
+    double getTime() const {
+        return this->time;
+    }
+
+    /// @brief Total time the simulation waited for slow consumers, in seconds.
+    double getStallTime() const {
+        return this->stall_time;
+    }
+
+    /// @brief Number of publications that waited for a slow consumer. Can be read from any thread.
+    unsigned long getStallCount() const {
+        return this->stall_count;
+    }
+
+    private:
+    /// @brief Thread of a consumer: processes its queue in order.
+    void consume(Consumer* consumer) {
+        while(true) {
+            std::shared_ptr<Publication> publication;
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->queued.wait(lock, [&]() { return this->stopping || !consumer->queue.empty(); });
+                if(consumer->queue.empty()) {
+                    return;
+                }
+                publication = consumer->queue.front();
+            }
+            consumer->visualizer->draw(publication->snapshot.get());
+            bool last = --publication->remaining == 0;
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                // the snapshot stays queued while it is drawn, so it counts for the backpressure
+                consumer->queue.pop_front();
+                if(last) {
+                    this->free_snapshots.push_back(std::move(publication->snapshot));
+                }
+            }
+            if(last) {
+                publication->done.set_value();
+            }
+            this->consumed.notify_all();
+        }
+    }
+};
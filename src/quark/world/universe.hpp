@@ -1,18 +1,37 @@
 #pragma once
 
+#include <span>
 #include <array>
+#include <deque>
+#include <vector>
 #include <list>
+#include <cstdint>
 #include <random>
 #include <algorithm>
+#include <functional>
 #include <unordered_map>
+#include <chrono>
 #include "../maths/vector.hpp"
 #include "../maths/const_pow.hpp"
 #include "../maths/const_div.hpp"
 #include "particle.hpp"
+#include "initializers.hpp"
 #include "universe_chunk.hpp"
+#include "chunk_map.hpp"
 #include "interactions/interactor.hpp"
 #include "forces/forces.hpp"
+#include "walls/wall.hpp"
+#include "walls/lennard_jones.hpp"
+#include "long_range/long_range_solver.hpp"
+#include "integrators/integrator.hpp"
+#include "integrators/stormer_verlet.hpp"
+#include "analysis/analyzer.hpp"
+#include "bonds/bonded_network.hpp"
+#include "sources/source.hpp"
 #include "../visualizer/visualizer.hpp"
+#include "../parallel/parallel_for.hpp"
+#include "../parallel/reduce.hpp"
+#include "../parallel/numa.hpp"
 
 enum BORDER_TYPE {
     absorbent, // default
@@ -20,6 +39,12 @@ enum BORDER_TYPE {
     periodic,
 }; 
 
+/// @brief How the chunks of the universe are stored.
+enum class GRID_TYPE {
+    dense, // every chunk exists, found by its index
+    sparse, // only the occupied chunks exist, found through a hash of their coordinates
+};
+
 /// @brief Universe class.
 /// @tparam D the number of dimensions of the universe.
 /// @tparam N the number of particles in the universe.
@@ -28,20 +53,85 @@ enum BORDER_TYPE {
 template<unsigned int D, unsigned int N, double LD, double RCUT>
 class Universe {
     private:
-    constexpr static unsigned int C = const_div(LD, RCUT);
-    constexpr static unsigned int CHUNK_LENGTH = const_pow(C, D);
-    constexpr static unsigned int CHUNK_IT_LENGTH = const_pow(3, D);
+    // the dense grid is used by default while it has at most that many chunks per particle
+    constexpr static uint64_t DENSE_CHUNKS_PER_PARTICLE = 8;
     // interactors and visulizers
     std::list<Interactor<D>*> registered_interactors;
     std::list<Force<D>*> registered_forces;
+    std::list<LongRangeSolver<D>*> registered_long_range_solvers;
+    std::list<BondedNetwork<D>*> registered_bonded_networks;
     std::list<Visualizer<Universe<D, N, LD, RCUT>>*> registered_visulizer;
     BORDER_TYPE border = BORDER_TYPE::absorbent;
+    // walls used by the reflexive border
+    LennardJonesMirrorWall default_wall;
+    Wall* wall = &default_wall;
+    // time integration scheme
+    StormerVerletIntegrator<D> default_integrator;
+    Integrator<D>* integrator = &default_integrator;
+    // whether the forces held by the particles match their positions, computed lazily before the first step
+    bool forces_up_to_date = false;
 
+    // the particles still in the universe come first, absorbed ones are swapped past active_count
     std::array<Particle<D>, N> particles;
-    UniverseChunk<D> chunks[CHUNK_LENGTH];
+    unsigned int active_count = N;
+    std::vector<unsigned int> absorbed_particles;
+    std::list<ParticleSource<D>*> registered_sources;
+    std::vector<Particle<D>> source_buffer;
+    double time = 0.0;
+    // chunks are RCUT / cell_division wide
+    unsigned int cell_division = 1;
+    unsigned int chunks_per_dim;
+    double chunk_side;
+    uint64_t chunk_length;
+    // in a deque, so the chunks do not move when the sparse grid creates new ones
+    std::deque<UniverseChunk<D>> chunks;
+    // chosen from the number of chunks, until setGridType is called
+    GRID_TYPE grid_type = GRID_TYPE::dense;
+    bool grid_type_set = false;
+
+    // offsets of the chunks that can hold particles closer than RCUT, created once for optimisation
+    std::vector<Vector<int, D>> stencil;
+    // the same offsets as index offsets in the dense grid
+    std::vector<int64_t> chunk_proxy_it;
+
+    // sparse grid: index of each chunk from its key, and the stencil of each chunk, -1 where chunks do not exist
+    ChunkMap chunk_map;
+    std::vector<int> chunk_neighbours;
+    bool chunk_neighbours_valid = false;
+
+    // auto-tuning of the cell division: time spent stepping with each candidate
+    std::vector<unsigned int> tuning_divisions;
+    std::vector<double> tuning_times;
+    unsigned int tuning_index = 0;
+    unsigned int tuning_step = 0;
+    unsigned int tuning_steps_per_division = 0;
 
-    // created once for optimisation, allows to iterate over nearby chunks
-    int chunk_proxy_it[CHUNK_IT_LENGTH];
+    // chunks touching each face, for each dimension, lower face first. Built from the wall range.
+    std::vector<unsigned int> boundary_chunks[2 * D];
+    double boundary_range = -1.0;
+    // buffers to gather the particles near a face, so the wall kernels run on contiguous memory
+    std::vector<unsigned int> wall_particles;
+    std::vector<double> wall_distances;
+    std::vector<double> wall_forces;
+
+    // threads used by the force pass and the particle updates
+    unsigned int thread_count = 1;
+    // when set, the results do not depend on the thread count
+    bool reproducible = false;
+    // per thread force accumulators of the parallel force pass
+    std::vector<std::vector<Vector<double, D>>> thread_forces;
+
+    // in-situ analysis, fed every analysis_interval steps by the pairs of the force pass
+    std::list<PairAnalyzer<D>*> registered_pair_analyzers;
+    std::list<StepAnalyzer<D>*> registered_step_analyzers;
+    unsigned int analysis_interval = 1;
+    unsigned long step_count = 0;
+    // squared range of each pair analyzer during a sampled pass, and the largest one
+    std::vector<double> analysis_ranges_sq;
+    double analysis_range_sq = 0.0;
+    // force passes of the integrator in a step, so the pair analyzers see the last one, at the end of the step
+    unsigned int force_passes = 1;
+    unsigned int force_pass = 0;
 
     // target cinetic energy 
     bool restrain_cinetic_energy = false;
@@ -50,28 +140,150 @@ class Universe {
 
     // getters and setters
     public:
-    std::array<Particle<D>, N> getParticles(){
-        return this->particles;
+    /// @brief The particles still in the universe. Their order changes when particles are absorbed.
+    std::span<const Particle<D>> getParticles() const {
+        return std::span<const Particle<D>>(this->particles.data(), this->active_count);
+    }
+
+    /// @brief Number of particles still in the universe, at most N.
+    unsigned int getActiveCount() const {
+        return this->active_count;
+    }
+
+    double getTime() const {
+        return this->time;
     }
 
     public:
     void step(double deltaTime);
     void registerInteractor(Interactor<D> *interactor);
     void registerForce(Force<D> *force);
+    void registerLongRangeSolver(LongRangeSolver<D> *solver);
+    /// @brief Registers bonds and angles between given particles. The network follows the particles when they are compacted.
+    void registerBondedNetwork(BondedNetwork<D> *network);
     void registerVisualizer(Visualizer<Universe<D, N, LD, RCUT>> *visualizer);
+    /// @brief Registers a source, asked for new particles at the end of each step.
+    void registerSource(ParticleSource<D> *source);
+    /// @brief Adds a particle in a free slot, after the active ones.
+    ///         Up to date forces only get the pairs of the new particle added. With a long range solver, every particle
+    ///         feels the new one: the forces are all computed again before the next step.
+    /// @return false if the universe is full, or if the particle is out of an absorbent universe.
+    bool injectParticle(const Particle<D>& particle);
+    /// @brief Registers an analyzer fed by the pairs of the force pass, on the sampled steps.
+    void registerPairAnalyzer(PairAnalyzer<D> *analyzer);
+    /// @brief Registers an analyzer called with the particles after the sampled steps.
+    void registerStepAnalyzer(StepAnalyzer<D> *analyzer);
+    /// @brief Runs the analyzers every analysis_interval steps, starting with the first one. Defaults to 1.
+    void setAnalysisInterval(unsigned int analysis_interval) {
+        this->analysis_interval = std::max(analysis_interval, 1u);
+    }
     void restrainCineticEnergy(double target_energy) {
         restrain_cinetic_energy = true;
         Ecd = target_energy;
     }
     void set_border_type(BORDER_TYPE border) {
         this->border = border;
+        this->forces_up_to_date = false;
+    }
+    /// @brief Sets the wall used when the border type is reflexive. Defaults to a Lennard-Jones mirror wall.
+    void setWall(Wall* wall) {
+        this->wall = wall;
+        this->forces_up_to_date = false;
+    }
+    /// @brief Sets the time integration scheme. Defaults to Störmer-Verlet.
+    void setIntegrator(Integrator<D>* integrator) {
+        this->integrator = integrator;
+    }
+    /// @brief Sets the number of threads used to step the universe. Defaults to 1.
+    ///         Interactors are then called from several threads at once.
+    void setThreadCount(unsigned int thread_count) {
+        this->thread_count = std::max(thread_count, 1u);
+    }
+    /// @brief In reproducible mode, every sum runs in a fixed order, so the trajectory is bitwise identical for any thread count.
+    ///         Each pair force is then computed twice, once for each particle, instead of using the third law of Newton.
+    void setReproducible(bool reproducible) {
+        this->reproducible = reproducible;
+    }
+    /// @brief Total cinetic energy of the particles, summed in a fixed order.
+    double getCineticEnergy();
+    /// @brief Moves the memory of each thread's share of the particles, chunks and force buffers to the NUMA node
+    ///         of the cpu that thread is pinned to, see setThreadAffinity. Does nothing when the threads are not pinned.
+    ///         Call it again after changing the thread count or the grid.
+    void placeMemory();
+    /// @brief Where the memory of the particles, chunks and force buffers is, compared to the nodes of the threads using it.
+    NumaReport getNumaReport();
+    /// @brief Chooses between the dense and the sparse grid of chunks, and places the particles again.
+    ///         Defaults to dense, unless the grid would have more than 8 chunks per particle.
+    ///         The sparse grid only creates the occupied chunks, for dilute universes much larger than the cut distance.
+    void setGridType(GRID_TYPE grid_type) {
+        this->grid_type = grid_type;
+        this->grid_type_set = true;
+        this->generateChunks();
+        this->populateChunks();
+    }
+    GRID_TYPE getGridType() const {
+        return this->grid_type;
+    }
+    /// @brief Number of chunks in memory. All of them for the dense grid, the occupied ones for the sparse grid.
+    unsigned int getChunkCount() const {
+        return this->chunks.size();
+    }
+    /// @brief Width of the chunks, RCUT / cell_division.
+    double getChunkSide() const {
+        return this->chunk_side;
+    }
+    double getLength() const {
+        return LD;
+    }
+    /// @brief Calls visit(chunk) for each chunk in memory that overlaps the box [low, high], so the visualizers only go
+    ///         through the part of the universe they show. The chunks of the faces also hold the particles beyond the faces.
+    template<typename Visit>
+    void visitChunks(const Vector<double, D>& low, const Vector<double, D>& high, Visit visit);
+    /// @brief Splits the chunks in cell_division along each dimension, so they are RCUT / cell_division wide. Defaults to 1.
+    ///         Pairs are then searched in the (2 cell_division + 1)^D chunks around, minus the ones further than RCUT.
+    ///         Smaller chunks cover less volume outside of the cut sphere, for more chunks to go through.
+    ///         The pair passes skip the pairs further than RCUT, so the forces do not depend on the cell division.
+    void setCellDivision(unsigned int cell_division) {
+        this->cell_division = std::max(cell_division, 1u);
+        this->generateChunkProxyIt();
+        this->generateChunks();
+        this->populateChunks();
+        // the chunks were rebuilt
+        this->forces_up_to_date = false;
+    }
+    unsigned int getCellDivision() const {
+        return this->cell_division;
+    }
+    /// @brief Steps with each cell division in turn, timing steps_per_division steps with each, then keeps the fastest one.
+    void autoTuneCellDivision(std::vector<unsigned int> divisions = {1, 2, 3}, unsigned int steps_per_division = 4) {
+        if(divisions.empty()) {
+            return;
+        }
+        this->tuning_divisions = divisions;
+        this->tuning_times.assign(divisions.size(), 0.0);
+        this->tuning_index = 0;
+        this->tuning_step = 0;
+        this->tuning_steps_per_division = std::max(steps_per_division, 1u);
+        this->setCellDivision(divisions[0]);
+    }
+    /// @brief Whether the cell division auto-tuning is still running.
+    bool isTuning() const {
+        return !this->tuning_divisions.empty();
     }
 
     private:
-    void updateParticleForces();
-    void stromerVerletUpdate(double deltaTime);
+    void updateParticleForces(bool analyze = false);
+    template<bool ANALYZE> void updatePairForces();
+    template<bool ANALYZE> void updatePairForcesBuffered();
+    template<bool ANALYZE> void updatePairForcesOrdered();
+    inline void analyzePair(unsigned int i, unsigned int j, double distance_sq, unsigned int thread);
+    void addParticleForces(unsigned int index);
     void verifyParticlesChunks();
     void targetCineticEnergy();
+    void generateBoundaryChunks();
+    void updateWallForces();
+    void reflectParticles();
+    void recordTuningStep(double duration);
 
     public:
     /// @brief Creates a universe with random particles in the [0x1]^D hyper cube.
@@ -81,39 +293,47 @@ class Universe {
     Universe() {
         this->particles = std::array<Particle<D>, N>();
 
-        // generate the chunks
+        // generate the chunk nearby iterator, and the chunks
+        this->generateChunkProxyIt();
         this->generateChunks();
 
-        // create one random generator for all the particles, that the closure will capture.
-        // this allow to avoid creating a random object for each particle
-        std::default_random_engine rnd{std::random_device{}()};
-        std::uniform_real_distribution<double> dist(0.0, 1.0);
-        // fill the particle vec with new particles, generated from a random position
-        std::generate(this->particles.begin(), this->particles.end(), [&]() {
-            return Particle<D>([&]() {
-                return Vector<double, D>([&]() {
-                    return dist(rnd);
-                });
-            });
-        });
+        // fill the particles with random positions, in parallel
+        Vector<double, D> corner = Vector<double, D>();
+        Vector<double, D> size = Vector<double, D>([]() { return 1.0; });
+        uint64_t seed = ((uint64_t)std::random_device{}() << 32) | std::random_device{}();
+        Initializers::uniform<D>(this->particles.data(), N, corner, size, seed);
 
         // put all the particles in the corresponding chunks
         this->populateChunks();
-        // generate the chunk nearby iterator
-        this->generateChunkProxyIt();
     }
     /// @brief Creates a universe with given particles. 
     /// @param interactor the interactor for this universe.
     /// @param ld caracteristic length
     /// @param rcut max intercation distance
     /// @param particles the particles to populate the universe with
-    Universe(Particle<D> particles[N]) {
+    Universe(Particle<D> particles[N]) : Universe(particles, N) {}
+    /// @brief Creates a universe with fewer particles than it can hold, leaving room for sources.
+    /// @param particles the particles to populate the universe with.
+    /// @param count the number of particles, at most N.
+    Universe(const Particle<D>* particles, unsigned int count) {
+        this->active_count = std::min(count, N);
         // from https://cplusplus.com/forum/beginner/200574/
-        std::copy(particles, particles + N, this->particles.begin());
+        std::copy(particles, particles + this->active_count, this->particles.begin());
 
+        this->generateChunkProxyIt();
         this->generateChunks();
         this->populateChunks();
+    }
+    /// @brief Creates a universe whose particles are written in place, without going through a copy.
+    /// @param fill function given the storage of the N particles, writing the particles and returning their number.
+    template<typename Fill>
+    requires std::is_invocable_r_v<unsigned int, Fill&, Particle<D>*>
+    Universe(Fill fill) {
+        this->active_count = std::min(fill(this->particles.data()), N);
+
         this->generateChunkProxyIt();
+        this->generateChunks();
+        this->populateChunks();
     }
 
     private:
@@ -121,13 +341,20 @@ class Universe {
     void generateChunks();
     void populateChunks();
     void placeParticle(unsigned int particle_index, unsigned  int chunk_index);
+    void compactParticles();
+    unsigned int flushChunks();
+    std::vector<void*> chunkPages(unsigned int begin, unsigned int end);
+    void wrapParticle(unsigned int particle_index);
     void generateChunkProxyIt();
 
     private:
     // utility
-    int vecCoordToInt(Vector<int, D> vec);
-    Vector<int, D> intCoordToVec(int coord);
-    unsigned int getParticleChunk(unsigned int part);
+    int64_t vecCoordToInt(Vector<int, D> vec);
+    Vector<int, D> intCoordToVec(uint64_t coord);
+    int getParticleChunk(unsigned int part);
+    int createChunk(const Vector<int, D>& coordinates);
+    void generateChunkNeighbours();
+    const int* getNeighbourChunks(unsigned int chunk, int* buffer);
 };
 
 /// @brief Generates the chunks for our universe.
@@ -136,15 +363,40 @@ class Universe {
 /// @tparam C The number of chunks in all dimensions of the universe.
 template<unsigned int D, unsigned int N, double LD, double RCUT>
 void Universe<D, N, LD, RCUT>::generateChunks() {
+    this->chunks.clear();
+    this->chunk_map.clear();
+    this->chunk_neighbours_valid = false;
+    this->boundary_range = -1.0;
+    if(!this->grid_type_set) {
+        uint64_t dense_limit = std::max<uint64_t>(DENSE_CHUNKS_PER_PARTICLE * N, this->stencil.size());
+        this->grid_type = this->chunk_length <= dense_limit ? GRID_TYPE::dense : GRID_TYPE::sparse;
+    }
+    if(this->grid_type == GRID_TYPE::sparse) {
+        // chunks are created when a particle enters them
+        return;
+    }
     // generate every chunk
-    for(unsigned int chunk_index = 0; chunk_index < this->CHUNK_LENGTH; chunk_index++) {
+    for(uint64_t chunk_index = 0; chunk_index < this->chunk_length; chunk_index++) {
         // create the vector from that index
         Vector<int, D> coordinates = this->intCoordToVec(chunk_index);
         // create a chunk at that coordinates
-        this->chunks[chunk_index] = UniverseChunk<D>(coordinates);
+        this->chunks.push_back(UniverseChunk<D>(coordinates));
     }
 }
 
+/// @brief Creates a chunk of the sparse grid.
+/// @return the index of the new chunk.
+template<unsigned int D, unsigned int N, double LD, double RCUT>
+int Universe<D, N, LD, RCUT>::createChunk(const Vector<int, D>& coordinates) {
+    int chunk_index = this->chunks.size();
+    this->chunks.push_back(UniverseChunk<D>(coordinates));
+    this->chunk_map.insert(this->vecCoordToInt(coordinates), chunk_index);
+    // the neighbour lists and the boundary chunks now miss this one
+    this->chunk_neighbours_valid = false;
+    this->boundary_range = -1.0;
+    return chunk_index;
+}
+
 /// @brief Places all the particle in their respective chunks.
 /// @tparam D The number of dimensions of the Universe.
 /// @tparam N The number of particles in the universe.
@@ -152,7 +404,7 @@ void Universe<D, N, LD, RCUT>::generateChunks() {
 template<unsigned int D, unsigned int N, double LD, double RCUT>
 void Universe<D, N, LD, RCUT>::populateChunks() {
     // fill our chunks with the particles
-    for(unsigned int i = 0; i < N; i++) {
+    for(unsigned int i = 0; i < this->active_count; i++) {
         // get the chunk of i particle, put it in it
         int part_chunk = this->getParticleChunk(i);
         if(part_chunk < 0) {
@@ -160,10 +412,28 @@ void Universe<D, N, LD, RCUT>::populateChunks() {
         }
         this->placeParticle(i, part_chunk);
     }
-    // flush all chunks
-    for(unsigned int chunk = 0; chunk < this->CHUNK_LENGTH; chunk++) {
-        this->chunks[chunk].flush();
+    this->flushChunks();
+}
+
+/// @brief Flushes the chunks in parallel, with the same split as the pair passes,
+///         so the particle sets of a chunk are allocated by the thread that reads them.
+/// @return the number of empty chunks.
+template<unsigned int D, unsigned int N, double LD, double RCUT>
+unsigned int Universe<D, N, LD, RCUT>::flushChunks() {
+    std::vector<unsigned int> empty_chunks(this->thread_count, 0);
+    parallelFor(this->thread_count, 0, this->chunks.size(), [&](unsigned int begin, unsigned int end, unsigned int thread) {
+        for(unsigned int chunk = begin; chunk < end; chunk++) {
+            this->chunks[chunk].flush();
+            if(this->chunks[chunk].getParticleNumber() == 0) {
+                empty_chunks[thread]++;
+            }
+        }
+    });
+    unsigned int total = 0;
+    for(unsigned int count: empty_chunks) {
+        total += count;
     }
+    return total;
 }
 
 template<unsigned int D, unsigned int N, double LD, double RCUT>
@@ -171,11 +441,67 @@ void Universe<D, N, LD, RCUT>::placeParticle(unsigned int particle_index, unsign
     this->chunks[chunk_index].addParticle(particle_index);
 }
 
+/// @brief Removes the absorbed particles from the active set, so the passes only loop over live particles.
+///         Each hole is filled with the last active particle, going through the holes from the end
+///         so the particle moved into a hole is always a live one.
 template<unsigned int D, unsigned int N, double LD, double RCUT>
-unsigned int Universe<D, N, LD, RCUT>::getParticleChunk(unsigned int part) {
+void Universe<D, N, LD, RCUT>::compactParticles() {
+    if(this->absorbed_particles.empty()) {
+        return;
+    }
+    std::sort(this->absorbed_particles.begin(), this->absorbed_particles.end(), std::greater<unsigned int>());
+    // new index of each particle, for the integrator and the bonded networks
+    std::vector<int> new_indexes(this->active_count);
+    for(unsigned int i = 0; i < this->active_count; i++) {
+        new_indexes[i] = i;
+    }
+    for(unsigned int hole: this->absorbed_particles) {
+        unsigned int last = --this->active_count;
+        new_indexes[hole] = -1;
+        if(hole == last) {
+            continue;
+        }
+        new_indexes[last] = hole;
+        int chunk = this->getParticleChunk(last);
+        this->particles[hole] = this->particles[last];
+        // particles created outside of the universe are in no chunk
+        if(chunk >= 0) {
+            this->chunks[chunk].removeParticle(last);
+            this->chunks[chunk].addParticle(hole);
+            this->chunks[chunk].flush();
+        }
+    }
+    this->absorbed_particles.clear();
+    this->integrator->reorderParticles(new_indexes);
+    for(BondedNetwork<D> *network: this->registered_bonded_networks) {
+        network->reorderParticles(new_indexes);
+    }
+}
+
+/// @brief Moves a particle that went out of a periodic universe back into the [0, LD[^D cube.
+template<unsigned int D, unsigned int N, double LD, double RCUT>
+void Universe<D, N, LD, RCUT>::wrapParticle(unsigned int particle_index) {
+    Vector<double, D> pos = this->particles[particle_index].getPosition();
+    Vector<double, D> offset = Vector<double, D>();
+    bool outside = false;
+    for(unsigned int i = 0; i < D; i++) {
+        if(pos[i] < 0 || pos[i] >= LD) {
+            offset[i] = -LD * floor(pos[i] / LD);
+            outside = true;
+        }
+    }
+    if(outside) {
+        this->particles[particle_index].updatePosition(offset);
+    }
+}
+
+/// @brief Index of the chunk a particle belongs to, or -1 if it left an absorbent universe.
+///         The sparse grid creates the chunk if it does not exist yet.
+template<unsigned int D, unsigned int N, double LD, double RCUT>
+int Universe<D, N, LD, RCUT>::getParticleChunk(unsigned int part) {
     // get the chunk of i particle
     Vector<double, D> pos = this->particles[part].getPosition();
-    int result = 0;
+    Vector<int, D> coordinates;
     for(unsigned int i = 0; i < D; i++) {
         switch(this->border) {
             case BORDER_TYPE::absorbent:
@@ -204,67 +530,175 @@ unsigned int Universe<D, N, LD, RCUT>::getParticleChunk(unsigned int part) {
                 }
                 break;
         }
-        result *= this->C;
-        result += std::max(0, std::min((int)floor(pos[i] / RCUT), (int)this->C - 1));
+        coordinates[i] = std::max(0, std::min((int)floor(pos[i] / this->chunk_side), (int)this->chunks_per_dim - 1));
     }
-    return result;
+    int64_t key = this->vecCoordToInt(coordinates);
+    if(this->grid_type == GRID_TYPE::dense) {
+        return key;
+    }
+    int chunk = this->chunk_map.find(key);
+    return chunk >= 0 ? chunk : this->createChunk(coordinates);
 }
 
-/// @brief Generate an array of index offset. These offset represent the nearby chunks.
-///         This allow quick iteration over chunks.
+/// @brief Sizes the chunks from the cell division, and generates the stencil: the offsets of the chunks that can hold
+///         a particle closer than RCUT to a particle of the center chunk. This allows quick iteration over chunks.
+///         The stencil still holds pairs further than RCUT, the pair passes skip them.
 /// @tparam D dimension of the universe
 /// @tparam N Number of particles 
 /// @tparam LD size of the universe
 /// @tparam RCUT max distance interaction
 template<unsigned int D, unsigned int N, double LD, double RCUT>
 void Universe<D, N, LD, RCUT>::generateChunkProxyIt() {
-    // ? opti : this could be optimized ? as we are computing index to vec to index ? maybe faster way ?
-    // not too worried about optimizing this, as it runs once at the creation of the universe
-    // create the proxy chunk iterator
-    for(unsigned int chunk_index = 0; chunk_index < this->CHUNK_IT_LENGTH; chunk_index++) {
-        // create the vector from that index. Basically same code than for all chunks 
+    this->chunk_side = RCUT / this->cell_division;
+    this->chunks_per_dim = const_div(LD, this->chunk_side);
+    this->chunk_length = const_pow((uint64_t)this->chunks_per_dim, D);
+    this->stencil.clear();
+    this->chunk_proxy_it.clear();
+    // not too worried about optimizing this, as it runs once per grid
+    int reach = this->cell_division;
+    unsigned int width = 2 * reach + 1;
+    unsigned int candidates = const_pow(width, D);
+    for(unsigned int chunk_index = 0; chunk_index < candidates; chunk_index++) {
         unsigned int current_index = chunk_index;
         Vector<int, D> coordinates;
+        // closest distance between the two chunks, squared, in chunk sides
+        int gap = 0;
         for(unsigned int dim = 0; dim < D; dim++) {
             // get current dimension index
-            coordinates[dim] = current_index % 3 - 1;
+            coordinates[dim] = (int)(current_index % width) - reach;
             // "squash" that dimension down to get next one
-            current_index = (current_index - coordinates[dim]) / 3;
+            current_index /= width;
+            int far = std::max(std::abs(coordinates[dim]) - 1, 0);
+            gap += far * far;
+        }
+        // the cut distance is cell_division chunk sides
+        if(gap < reach * reach) {
+            this->stencil.push_back(coordinates);
+            this->chunk_proxy_it.push_back(this->vecCoordToInt(coordinates));
         }
-        // create a chunk at that coordinates
-        this->chunk_proxy_it[chunk_index] = this->vecCoordToInt(coordinates);
     }
 }
 
 template<unsigned int D, unsigned int N, double LD, double RCUT>
-int Universe<D, N, LD, RCUT>::vecCoordToInt(Vector<int, D> vec) {
-    int result = vec[0];
+int64_t Universe<D, N, LD, RCUT>::vecCoordToInt(Vector<int, D> vec) {
+    int64_t result = vec[0];
     for(unsigned int i = 1; i < D; i++) {
-        result *= C;
+        result *= this->chunks_per_dim;
         result += vec[i];
     }
     return result;
 }
 
 template<unsigned int D, unsigned int N, double LD, double RCUT>
-Vector<int, D> Universe<D, N, LD, RCUT>::intCoordToVec(int coord) {
+Vector<int, D> Universe<D, N, LD, RCUT>::intCoordToVec(uint64_t coord) {
     Vector<int, D> result;
-    for(unsigned int dim = 0; dim < D; dim++) {
+    // the first dimension is the most significant one, as in vecCoordToInt
+    for(int dim = D - 1; dim >= 0; dim--) {
         // get current dimension index
-        result[dim] = coord % C;
+        result[dim] = coord % this->chunks_per_dim;
         // "squash" that dimension down to get next one
-        coord = (coord - result[dim]) / C;
+        coord = (coord - result[dim]) / this->chunks_per_dim;
     }
     return result;
 }
 
+/// @brief Resolves the stencil of every chunk of the sparse grid through the hash map.
+template<unsigned int D, unsigned int N, double LD, double RCUT>
+void Universe<D, N, LD, RCUT>::generateChunkNeighbours() {
+    unsigned int stencil_size = this->stencil.size();
+    this->chunk_neighbours.resize(this->chunks.size() * stencil_size);
+    for(unsigned int chunk = 0; chunk < this->chunks.size(); chunk++) {
+        Vector<int, D> coordinates = this->chunks[chunk].getCoordinates();
+        for(unsigned int i = 0; i < stencil_size; i++) {
+            Vector<int, D> neighbour;
+            bool inside = true;
+            for(unsigned int dim = 0; dim < D; dim++) {
+                neighbour[dim] = coordinates[dim] + this->stencil[i][dim];
+                inside = inside && neighbour[dim] >= 0 && neighbour[dim] < (int)this->chunks_per_dim;
+            }
+            this->chunk_neighbours[chunk * stencil_size + i] = inside ? this->chunk_map.find(this->vecCoordToInt(neighbour)) : -1;
+        }
+    }
+    this->chunk_neighbours_valid = true;
+}
+
+/// @brief Indexes of the stencil chunks around a chunk, itself included, with -1 for the ones that do not exist.
+/// @param buffer room for the stencil, filled for the dense grid.
+/// @return the indexes, either in the buffer or in the table of the sparse grid.
+template<unsigned int D, unsigned int N, double LD, double RCUT>
+inline const int* Universe<D, N, LD, RCUT>::getNeighbourChunks(unsigned int chunk, int* buffer) {
+    unsigned int stencil_size = this->stencil.size();
+    if(this->grid_type == GRID_TYPE::sparse) {
+        return this->chunk_neighbours.data() + chunk * stencil_size;
+    }
+    Vector<int, D> coordinates = this->chunks[chunk].getCoordinates();
+    for(unsigned int i = 0; i < stencil_size; i++) {
+        // offsets going through a face would wrap to the other side of the grid
+        bool inside = true;
+        for(unsigned int dim = 0; dim < D; dim++) {
+            int neighbour = coordinates[dim] + this->stencil[i][dim];
+            inside = inside && neighbour >= 0 && neighbour < (int)this->chunks_per_dim;
+        }
+        buffer[i] = inside ? chunk + this->chunk_proxy_it[i] : -1;
+    }
+    return buffer;
+}
+
 template<unsigned int D, unsigned int N, double LD, double RCUT>
 void Universe<D, N, LD, RCUT>::step(double deltaTime) {
-    // compute the forces on all particles
-    this->stromerVerletUpdate(deltaTime);
+    // the integrators start from the forces of the current positions
+    bool end_forces = this->integrator->leavesForcesUpToDate();
+    if(end_forces && !this->forces_up_to_date) {
+        this->updateParticleForces();
+        this->forces_up_to_date = true;
+    }
+    auto step_start = std::chrono::steady_clock::now();
+    bool sampled = this->step_count % this->analysis_interval == 0;
+    this->step_count++;
+    // move the particles, computing the forces on the way. The last force pass of the step is analyzed.
+    this->force_pass = 0;
+    this->integrator->step(this->particles.data(), this->active_count, deltaTime, this->thread_count, [this, sampled, end_forces]() {
+        this->force_pass++;
+        this->updateParticleForces(sampled && end_forces && this->force_pass == this->force_passes);
+    });
+    this->force_passes = std::max(this->force_pass, 1u);
+    if(!end_forces) {
+        this->forces_up_to_date = false;
+    }
+
+    // hard walls mirror back the particles that went through a face
+    if(this->border == BORDER_TYPE::reflexive && this->wall->isSpecular()) {
+        this->reflectParticles();
+    }
 
     // replace each particle in its chunk
     this->verifyParticlesChunks();
+    this->time += deltaTime;
+
+    // the sources fill the free slots, they never see more room than there is
+    for(ParticleSource<D> *source: this->registered_sources) {
+        this->source_buffer.resize(N - this->active_count);
+        unsigned int emitted = source->emit(this->time, deltaTime, this->source_buffer.data(), this->source_buffer.size());
+        for(unsigned int i = 0; i < emitted; i++) {
+            this->injectParticle(this->source_buffer[i]);
+        }
+    }
+
+    if(this->isTuning()) {
+        this->recordTuningStep(std::chrono::duration<double>(std::chrono::steady_clock::now() - step_start).count());
+    }
+
+    if(sampled) {
+        // the forces of an integrator evaluating them mid step are not the ones of the positions analyzed
+        bool analyzed = !this->registered_pair_analyzers.empty() || !this->registered_step_analyzers.empty();
+        if(analyzed && !this->forces_up_to_date && !end_forces) {
+            this->updateParticleForces(true);
+            this->forces_up_to_date = true;
+        }
+        for(StepAnalyzer<D> *analyzer: this->registered_step_analyzers) {
+            analyzer->analyze(this->particles.data(), this->active_count, this->thread_count);
+        }
+    }
 
     // call each visulizer
     for(Visualizer<Universe<D, N, LD, RCUT>> *visulizer: this->registered_visulizer) {
@@ -281,32 +715,193 @@ void Universe<D, N, LD, RCUT>::step(double deltaTime) {
     }
 }
 
+/// @brief Adds the duration of a step to the current cell division candidate, and moves to the next one when it has enough steps.
+///         After the last candidate, the fastest cell division is kept.
+template<unsigned int D, unsigned int N, double LD, double RCUT>
+void Universe<D, N, LD, RCUT>::recordTuningStep(double duration) {
+    this->tuning_times[this->tuning_index] += duration;
+    this->tuning_step++;
+    if(this->tuning_step < this->tuning_steps_per_division) {
+        return;
+    }
+    this->tuning_step = 0;
+    this->tuning_index++;
+    if(this->tuning_index < this->tuning_divisions.size()) {
+        this->setCellDivision(this->tuning_divisions[this->tuning_index]);
+        return;
+    }
+    unsigned int fastest = std::min_element(this->tuning_times.begin(), this->tuning_times.end()) - this->tuning_times.begin();
+    unsigned int division = this->tuning_divisions[fastest];
+    this->tuning_divisions.clear();
+    if(division != this->cell_division) {
+        this->setCellDivision(division);
+    }
+}
+
+/// @brief Computes the forces on all the particles.
+/// @param analyze whether the pair analyzers sample the pairs of this pass.
 template<unsigned int D, unsigned int N, double LD, double RCUT>
-void Universe<D, N, LD, RCUT>::updateParticleForces() {
+void Universe<D, N, LD, RCUT>::updateParticleForces(bool analyze) {
     // reset all the forces to zero
-    for(unsigned int i = 0; i < N; i++) {
+    for(unsigned int i = 0; i < this->active_count; i++) {
         this->particles[i].resetForce();
     }
-    
+
+    // new chunks of the sparse grid need their neighbours
+    if(this->grid_type == GRID_TYPE::sparse && !this->chunk_neighbours_valid) {
+        this->generateChunkNeighbours();
+    }
+
+    // the analyzers ride along the pair loops, compiled in separately so the plain passes do not pay for them
+    analyze = analyze && !this->registered_pair_analyzers.empty();
+    if(analyze) {
+        unsigned int threads = this->reproducible || this->thread_count > 1 ? this->thread_count : 1;
+        this->analysis_ranges_sq.clear();
+        this->analysis_range_sq = 0.0;
+        for(PairAnalyzer<D> *analyzer: this->registered_pair_analyzers) {
+            double range = analyzer->getRange();
+            this->analysis_ranges_sq.push_back(range * range);
+            this->analysis_range_sq = std::max(this->analysis_range_sq, range * range);
+            analyzer->beginSample(this->particles.data(), this->active_count, threads);
+        }
+    }
+
+    // short range forces between the particles of nearby chunks
+    if(this->reproducible) {
+        analyze ? this->updatePairForcesOrdered<true>() : this->updatePairForcesOrdered<false>();
+    }
+    else if(this->thread_count > 1) {
+        analyze ? this->updatePairForcesBuffered<true>() : this->updatePairForcesBuffered<false>();
+    }
+    else {
+        analyze ? this->updatePairForces<true>() : this->updatePairForces<false>();
+    }
+
+    if(analyze) {
+        for(PairAnalyzer<D> *analyzer: this->registered_pair_analyzers) {
+            analyzer->endSample();
+        }
+    }
+
+    // long range interactions are computed over all the particles, regardless of the chunks
+    for(LongRangeSolver<D> *solver: this->registered_long_range_solvers) {
+        solver->addForces(this->particles.data(), this->active_count, this->border == BORDER_TYPE::periodic ? LD : 0.0);
+    }
+
+    // bonded terms, with the closest image of the partners in a periodic universe
+    for(BondedNetwork<D> *network: this->registered_bonded_networks) {
+        network->addForces(this->particles.data(), this->active_count, this->thread_count, this->border == BORDER_TYPE::periodic ? LD : 0.0);
+    }
+
+    // also iterate over all unique forces
+    for(unsigned int chunk = 0; chunk < this->chunks.size(); chunk++) {
+        for(auto part_i = this->chunks[chunk].getParticleBegin(); part_i != this->chunks[chunk].getParticleEnd(); ++part_i) {
+            // update particle at index part_i
+            // iterate over every nearby chunk
+            for(Force<D> *force: this->registered_forces) {
+                Vector<double, D> f = force->computeForce(this->particles[*part_i]);
+                this->particles[*part_i].addForce(f);
+            }
+        }
+    }
+
+    // if the border type is set to relfexive, apply the wall force to the particles near the faces
+    if(this->border == BORDER_TYPE::reflexive) {
+        this->updateWallForces();
+    }
+}
+
+/// @brief Adds the forces of a new particle to up to date forces: its pairs, the external forces and the walls.
+///         Bonds are left out, the new particle is in no network.
+template<unsigned int D, unsigned int N, double LD, double RCUT>
+void Universe<D, N, LD, RCUT>::addParticleForces(unsigned int index) {
+    Particle<D>& particle = this->particles[index];
+    particle.resetForce();
+    if(this->grid_type == GRID_TYPE::sparse && !this->chunk_neighbours_valid) {
+        this->generateChunkNeighbours();
+    }
+    std::vector<int> buffer(this->stencil.size());
+    const int* neighbours = this->getNeighbourChunks(this->getParticleChunk(index), buffer.data());
+    for(unsigned int i = 0; i < this->stencil.size(); i++) {
+        if(neighbours[i] < 0) {
+            continue;
+        }
+        for(auto part_j = this->chunks[neighbours[i]].getParticleBegin(); part_j != this->chunks[neighbours[i]].getParticleEnd(); ++part_j) {
+            if(*part_j == index || (particle.getPosition() - this->particles[*part_j].getPosition()).sq_magnitude() >= RCUT * RCUT) {
+                continue;
+            }
+            Vector<double, D> force = Vector<double, D>();
+            for(Interactor<D> *interactor: this->registered_interactors) {
+                force += interactor->computeInteractionForce(particle, this->particles[*part_j]);
+            }
+            particle.addForce(force);
+            this->particles[*part_j].addForce(-force);
+        }
+    }
+    for(Force<D> *force: this->registered_forces) {
+        particle.addForce(force->computeForce(particle));
+    }
+    if(this->border == BORDER_TYPE::reflexive) {
+        for(unsigned int face = 0; face < 2 * D; face++) {
+            unsigned int dim = face / 2;
+            bool lower = face % 2 == 0;
+            double distance = lower ? particle.getPosition()[dim] : LD - particle.getPosition()[dim];
+            double wall_force;
+            this->wall->computeWallForces(&distance, &wall_force, 1);
+            Vector<double, D> border_force = Vector<double, D>();
+            border_force[dim] = lower ? wall_force : -wall_force;
+            particle.addForce(border_force);
+        }
+    }
+}
+
+/// @brief Gives a pair to the analyzers it is in range of.
+template<unsigned int D, unsigned int N, double LD, double RCUT>
+inline void Universe<D, N, LD, RCUT>::analyzePair(unsigned int i, unsigned int j, double distance_sq, unsigned int thread) {
+    if(distance_sq >= this->analysis_range_sq) {
+        return;
+    }
+    unsigned int analyzer_index = 0;
+    for(PairAnalyzer<D> *analyzer: this->registered_pair_analyzers) {
+        if(distance_sq < this->analysis_ranges_sq[analyzer_index]) {
+            analyzer->addPair(i, j, distance_sq, thread);
+        }
+        analyzer_index++;
+    }
+}
+
+/// @brief Sequential pair force pass: each pair is computed once, and its force applied to both particles.
+/// @tparam ANALYZE whether the pairs are also given to the pair analyzers.
+template<unsigned int D, unsigned int N, double LD, double RCUT>
+template<bool ANALYZE>
+void Universe<D, N, LD, RCUT>::updatePairForces() {
     // update particles force, taking into account the chunks
     // loop over every chunk, update every particle in that chunk
-    for(unsigned int chunk = 0; chunk < this->CHUNK_LENGTH; chunk++) {
+    unsigned int stencil_size = this->stencil.size();
+    std::vector<int> buffer(stencil_size);
+    for(unsigned int chunk = 0; chunk < this->chunks.size(); chunk++) {
+        const int* neighbours = this->getNeighbourChunks(chunk, buffer.data());
         for(auto part_i = this->chunks[chunk].getParticleBegin(); part_i != this->chunks[chunk].getParticleEnd(); ++part_i) {
             // update particle at index part_i
             // iterate over every nearby chunk
-            for(unsigned int i = 0; i < this->CHUNK_IT_LENGTH; i++) {
+            for(unsigned int i = 0; i < stencil_size; i++) {
                 // chunk at chunk + offset may not exist
-                if(0 <= chunk + chunk_proxy_it[i] && chunk + chunk_proxy_it[i] < (int)this->CHUNK_LENGTH) {
+                if(neighbours[i] >= 0) {
                     // loop over every particle of the chunk to compute force with
                     for(
-                        auto part_j = this->chunks[chunk + chunk_proxy_it[i]].getParticleBegin();
-                        part_j != this->chunks[chunk + chunk_proxy_it[i]].getParticleEnd();
+                        auto part_j = this->chunks[neighbours[i]].getParticleBegin();
+                        part_j != this->chunks[neighbours[i]].getParticleEnd();
                         ++part_j
                     ) {
                         // only compute forces if j < i: this allows to divide calcs per 2, and don't compute with ourselves
                         if(*part_i <= *part_j) {
                             continue;
                         }
+                        // the stencil reaches further than the cut distance, the pairs beyond it do not interact
+                        double distance_sq = (this->particles[*part_i].getPosition() - this->particles[*part_j].getPosition()).sq_magnitude();
+                        if(distance_sq >= RCUT * RCUT) {
+                            continue;
+                        }
                         // compute force that part j apply on part i
                         Vector<double, D> force = Vector<double, D>();
                         for(Interactor<D> *interactor: this->registered_interactors) {
@@ -314,111 +909,369 @@ void Universe<D, N, LD, RCUT>::updateParticleForces() {
                         }
                         this->particles[*part_i].addForce(force);
                         this->particles[*part_j].addForce(-force);
+                        if constexpr(ANALYZE) {
+                            this->analyzePair(*part_i, *part_j, distance_sq, 0);
+                        }
                     }
                 }
             }
         }
     }
+}
 
-    // also iterate over all unique forces
-    for(unsigned int chunk = 0; chunk < this->CHUNK_LENGTH; chunk++) {
-        for(auto part_i = this->chunks[chunk].getParticleBegin(); part_i != this->chunks[chunk].getParticleEnd(); ++part_i) {
-            // update particle at index part_i
-            // iterate over every nearby chunk
-            for(Force<D> *force: this->registered_forces) {
-                Vector<double, D> f = force->computeForce(this->particles[*part_i]);
-                this->particles[*part_i].addForce(f);
+/// @brief Parallel pair force pass: chunks are split between the threads, each pair is computed once,
+///         and both forces go to the thread's own accumulator. The accumulators are summed at the end.
+///         Fast, but the summation order depends on the thread count.
+template<unsigned int D, unsigned int N, double LD, double RCUT>
+template<bool ANALYZE>
+void Universe<D, N, LD, RCUT>::updatePairForcesBuffered() {
+    this->thread_forces.resize(this->thread_count);
+    unsigned int chunk_count = this->chunks.size();
+    unsigned int stencil_size = this->stencil.size();
+    parallelFor(this->thread_count, 0, chunk_count, [&](unsigned int begin, unsigned int end, unsigned int thread) {
+        std::vector<Vector<double, D>>& forces = this->thread_forces[thread];
+        forces.assign(N, Vector<double, D>());
+        std::vector<int> buffer(stencil_size);
+        for(unsigned int chunk = begin; chunk < end; chunk++) {
+            const int* neighbours = this->getNeighbourChunks(chunk, buffer.data());
+            for(auto part_i = this->chunks[chunk].getParticleBegin(); part_i != this->chunks[chunk].getParticleEnd(); ++part_i) {
+                for(unsigned int i = 0; i < stencil_size; i++) {
+                    if(neighbours[i] >= 0) {
+                        for(
+                            auto part_j = this->chunks[neighbours[i]].getParticleBegin();
+                            part_j != this->chunks[neighbours[i]].getParticleEnd();
+                            ++part_j
+                        ) {
+                            if(*part_i <= *part_j) {
+                                continue;
+                            }
+                            double distance_sq = (this->particles[*part_i].getPosition() - this->particles[*part_j].getPosition()).sq_magnitude();
+                            if(distance_sq >= RCUT * RCUT) {
+                                continue;
+                            }
+                            Vector<double, D> force = Vector<double, D>();
+                            for(Interactor<D> *interactor: this->registered_interactors) {
+                                force += interactor->computeInteractionForce(this->particles[*part_i], this->particles[*part_j]);
+                            }
+                            forces[*part_i] += force;
+                            forces[*part_j] -= force;
+                            if constexpr(ANALYZE) {
+                                this->analyzePair(*part_i, *part_j, distance_sq, thread);
+                            }
+                        }
+                    }
+                }
             }
         }
-    }
+    });
+    // only the threads that got chunks wrote their accumulator
+    unsigned int used_threads = std::min(this->thread_count, chunk_count);
+    parallelFor(this->thread_count, 0, this->active_count, [&](unsigned int begin, unsigned int end, unsigned int thread) {
+        for(unsigned int part = begin; part < end; part++) {
+            Vector<double, D> force = Vector<double, D>();
+            for(unsigned int t = 0; t < used_threads; t++) {
+                force += this->thread_forces[t][part];
+            }
+            this->particles[part].addForce(force);
+        }
+    });
+}
 
-    // if the border type is set to relfexive, apply force to simulate this
-    if(this->border == BORDER_TYPE::reflexive) {
-        
-        for(unsigned int chunk = 0; chunk < this->CHUNK_LENGTH; chunk++) {
+/// @brief Reproducible pair force pass: every particle sums the forces of all its neighbours itself,
+///         in the order of the neighbour chunks. Each particle is only written by the thread owning its chunk,
+///         and the order of the sum only depends on the chunks, so the result is the same for any thread count.
+template<unsigned int D, unsigned int N, double LD, double RCUT>
+template<bool ANALYZE>
+void Universe<D, N, LD, RCUT>::updatePairForcesOrdered() {
+    unsigned int stencil_size = this->stencil.size();
+    parallelFor(this->thread_count, 0, this->chunks.size(), [&](unsigned int begin, unsigned int end, unsigned int thread) {
+        std::vector<int> buffer(stencil_size);
+        for(unsigned int chunk = begin; chunk < end; chunk++) {
+            const int* neighbours = this->getNeighbourChunks(chunk, buffer.data());
             for(auto part_i = this->chunks[chunk].getParticleBegin(); part_i != this->chunks[chunk].getParticleEnd(); ++part_i) {
-                // update particle at index part_i
-                // iterate over every nearby chunk
-                Vector<double, D> border_force = Vector<double, D>();
-                Vector<double, D> pos = this->particles[*part_i].getPosition();
-                for(unsigned int i = 0; i < D; i++) {
-                    if(pos[i] < 1.1224) { // rcut is 2^(1/6)
-                        double r = pos[i];
-                        // here, eps = 1; sigma = 1.
-                        // maybe add a nice way to do this in the future, but all examples have those values
-                        // and we need to sync them with the different values of the different interactors... ugggh
-                        double r_two_sixth = pow(2 * r, 6); // sounds like a star wars droid name
-                        border_force [i]= 24 / (2 * r) / r_two_sixth * (1 - 2 / r_two_sixth);
-                    }
-                    else if(pos[i] >= LD - 1.1224) { // rcut is 2^(1/6)
-                        double r = LD - pos[i];
-                        // here, eps = 1; sigma = 1.
-                        // maybe a nice way to do this in the future, but all examples have those values
-                        // and we need to sync them with the different values of the different interactors... ugggh
-                        double r_two_sixth = pow(2 * r, 6); // sounds like a star wars droid name
-                        border_force[i] = -24 / (2 * r) / r_two_sixth * (1 - 2 / r_two_sixth);
+                Vector<double, D> total_force = Vector<double, D>();
+                for(unsigned int i = 0; i < stencil_size; i++) {
+                    if(neighbours[i] >= 0) {
+                        for(
+                            auto part_j = this->chunks[neighbours[i]].getParticleBegin();
+                            part_j != this->chunks[neighbours[i]].getParticleEnd();
+                            ++part_j
+                        ) {
+                            if(*part_i == *part_j) {
+                                continue;
+                            }
+                            double distance_sq = (this->particles[*part_i].getPosition() - this->particles[*part_j].getPosition()).sq_magnitude();
+                            if(distance_sq >= RCUT * RCUT) {
+                                continue;
+                            }
+                            for(Interactor<D> *interactor: this->registered_interactors) {
+                                total_force += interactor->computeInteractionForce(this->particles[*part_i], this->particles[*part_j]);
+                            }
+                            // each pair is visited from both sides, the analyzers only see it once
+                            if constexpr(ANALYZE) {
+                                if(*part_i > *part_j) {
+                                    this->analyzePair(*part_i, *part_j, distance_sq, thread);
+                                }
+                            }
+                        }
                     }
                 }
-                this->particles[*part_i].addForce(border_force);
+                this->particles[*part_i].addForce(total_force);
+            }
+        }
+    });
+}
+
+/// @brief Lists the chunks that can hold particles in range of each face of the universe.
+///         Only those chunks are visited by the walls, so the cost scales with the surface of the universe.
+template<unsigned int D, unsigned int N, double LD, double RCUT>
+void Universe<D, N, LD, RCUT>::generateBoundaryChunks() {
+    double range = this->wall->getRange();
+    // particles out of the universe are clamped in the border chunks, so we always keep at least one layer
+    int lower_end = std::min((int)floor(range / this->chunk_side) + 1, (int)this->chunks_per_dim);
+    int upper_begin = std::max(std::min((int)floor((LD - range) / this->chunk_side), (int)this->chunks_per_dim - 1), 0);
+    for(unsigned int face = 0; face < 2 * D; face++) {
+        this->boundary_chunks[face].clear();
+    }
+    for(unsigned int chunk = 0; chunk < this->chunks.size(); chunk++) {
+        Vector<int, D> coordinates = this->chunks[chunk].getCoordinates();
+        for(unsigned int dim = 0; dim < D; dim++) {
+            if(coordinates[dim] < lower_end) {
+                this->boundary_chunks[2 * dim].push_back(chunk);
+            }
+            if(coordinates[dim] >= upper_begin) {
+                this->boundary_chunks[2 * dim + 1].push_back(chunk);
+            }
+        }
+    }
+    this->boundary_range = range;
+}
+
+template<unsigned int D, unsigned int N, double LD, double RCUT>
+void Universe<D, N, LD, RCUT>::updateWallForces() {
+    if(this->boundary_range != this->wall->getRange()) {
+        this->generateBoundaryChunks();
+    }
+    for(unsigned int face = 0; face < 2 * D; face++) {
+        unsigned int dim = face / 2;
+        bool lower = face % 2 == 0;
+        // gather the distance to the face of every particle in the boundary chunks
+        this->wall_particles.clear();
+        this->wall_distances.clear();
+        for(unsigned int chunk: this->boundary_chunks[face]) {
+            for(auto part = this->chunks[chunk].getParticleBegin(); part != this->chunks[chunk].getParticleEnd(); ++part) {
+                double pos = this->particles[*part].getPosition()[dim];
+                this->wall_particles.push_back(*part);
+                this->wall_distances.push_back(lower ? pos : LD - pos);
+            }
+        }
+        // run the wall kernel on the whole batch
+        unsigned int count = this->wall_particles.size();
+        this->wall_forces.resize(count);
+        this->wall->computeWallForces(this->wall_distances.data(), this->wall_forces.data(), count);
+        // scatter the forces back, pointing inside the universe
+        for(unsigned int i = 0; i < count; i++) {
+            if(this->wall_forces[i] != 0.0) {
+                Vector<double, D> border_force = Vector<double, D>();
+                border_force[dim] = lower ? this->wall_forces[i] : -this->wall_forces[i];
+                this->particles[this->wall_particles[i]].addForce(border_force);
             }
         }
     }
 }
 
+/// @brief Mirrors back the particles that went through a face, and flips their normal velocity.
+///         Particles have not been moved to their new chunk yet, so the ones that crossed a face are still in a boundary chunk.
 template<unsigned int D, unsigned int N, double LD, double RCUT>
-void Universe<D, N, LD, RCUT>::stromerVerletUpdate(double deltaTime) {
-    // one step of the stromer verlet algorithm
-    // update all particles, and store previous forces
-    // is it ok to create this size array on the stack every frame ?
-    Vector<double, D> f_old[N];
-    // first update of stromer verlet
-    for(unsigned int i = 0; i < N; i++) {
-        this->particles[i].updatePosition(
-            (this->particles[i].getVelocity() + this->particles[i].getForce() * 0.5 * deltaTime / (this->particles[i].getMass())) * deltaTime
-        );
-        f_old[i] = this->particles[i].getForce();
+void Universe<D, N, LD, RCUT>::reflectParticles() {
+    if(this->boundary_range != this->wall->getRange()) {
+        this->generateBoundaryChunks();
     }
-    // compute new forces
-    this->updateParticleForces();
-    // second update of Stromer Verlet
-    for(unsigned int i = 0; i < N; i++) {
-        this->particles[i].updateVelocity(
-            (this->particles[i].getForce() + f_old[i] * 0.5 / (this->particles[i].getMass())) * deltaTime
-        );
+    for(unsigned int face = 0; face < 2 * D; face++) {
+        unsigned int dim = face / 2;
+        bool lower = face % 2 == 0;
+        for(unsigned int chunk: this->boundary_chunks[face]) {
+            for(auto part = this->chunks[chunk].getParticleBegin(); part != this->chunks[chunk].getParticleEnd(); ++part) {
+                double pos = this->particles[*part].getPosition()[dim];
+                // how far the particle went through the face
+                double overshoot = lower ? -pos : pos - LD;
+                if(overshoot > 0) {
+                    Vector<double, D> position_update = Vector<double, D>();
+                    position_update[dim] = lower ? 2 * overshoot : -2 * overshoot;
+                    this->particles[*part].updatePosition(position_update);
+                    Vector<double, D> velocity_update = Vector<double, D>();
+                    velocity_update[dim] = -2 * this->particles[*part].getVelocity()[dim];
+                    this->particles[*part].updateVelocity(velocity_update);
+                }
+            }
+        }
     }
 }
 
 template<unsigned int D, unsigned int N, double LD, double RCUT>
 void Universe<D, N, LD, RCUT>::targetCineticEnergy() {
+    double energy = this->getCineticEnergy();
+    if(energy <= 0) {
+        return;
+    }
     // compute beta
-    double beta = 0;
-    for(unsigned i = 0; i < N; i++) {
-        beta += this->particles[i].getMass() * this->particles[i].getVelocity().sq_magnitude();
+    double beta = sqrt(this->Ecd / energy);
+    // rescale the velocities to reach the target energy
+    parallelFor(this->thread_count, 0, this->active_count, [&](unsigned int begin, unsigned int end, unsigned int thread) {
+        for(unsigned int i = begin; i < end; i++) {
+            this->particles[i].updateVelocity(this->particles[i].getVelocity() * (beta - 1));
+        }
+    });
+}
+
+template<unsigned int D, unsigned int N, double LD, double RCUT>
+double Universe<D, N, LD, RCUT>::getCineticEnergy() {
+    return 0.5 * deterministicSum<double>(this->thread_count, this->active_count, [&](unsigned int i) {
+        return this->particles[i].getMass() * this->particles[i].getVelocity().sq_magnitude();
+    });
+}
+
+/// @brief Pages of the chunks of a block, with the same split as the pair passes.
+template<unsigned int D, unsigned int N, double LD, double RCUT>
+std::vector<void*> Universe<D, N, LD, RCUT>::chunkPages(unsigned int begin, unsigned int end) {
+    std::vector<void*> pages;
+    for(unsigned int chunk = begin; chunk < end; chunk++) {
+        for(void* page: pagesOf(&this->chunks[chunk], sizeof(UniverseChunk<D>))) {
+            if(pages.empty() || pages.back() != page) {
+                pages.push_back(page);
+            }
+        }
+    }
+    return pages;
+}
+
+template<unsigned int D, unsigned int N, double LD, double RCUT>
+void Universe<D, N, LD, RCUT>::placeMemory() {
+    if(threadCpus().empty()) {
+        return;
+    }
+    // particles are split like in the integrators, chunks like in the pair passes
+    parallelFor(this->thread_count, 0, this->active_count, [&](unsigned int begin, unsigned int end, unsigned int thread) {
+        movePages(pagesOf(&this->particles[begin], (end - begin) * sizeof(Particle<D>)), threadNode(thread));
+    });
+    parallelFor(this->thread_count, 0, this->chunks.size(), [&](unsigned int begin, unsigned int end, unsigned int thread) {
+        movePages(this->chunkPages(begin, end), threadNode(thread));
+    });
+    for(unsigned int thread = 0; thread < this->thread_forces.size(); thread++) {
+        std::vector<Vector<double, D>>& forces = this->thread_forces[thread];
+        movePages(pagesOf(forces.data(), forces.size() * sizeof(Vector<double, D>)), threadNode(thread));
+    }
+}
+
+template<unsigned int D, unsigned int N, double LD, double RCUT>
+NumaReport Universe<D, N, LD, RCUT>::getNumaReport() {
+    NumaReport report;
+    report.node_count = NumaTopology::get().getNodeCount();
+    report.thread_count = this->thread_count;
+    report.pinned = !threadCpus().empty();
+    report.regions.resize(3);
+    report.regions[0].name = "particles";
+    report.regions[1].name = "chunks";
+    report.regions[2].name = "force buffers";
+    // the same blocks as parallelFor
+    unsigned int particle_threads = std::max(1u, std::min(this->thread_count, this->active_count));
+    for(unsigned int thread = 0; thread < particle_threads; thread++) {
+        unsigned int begin = (unsigned long long)this->active_count * thread / particle_threads;
+        unsigned int end = (unsigned long long)this->active_count * (thread + 1) / particle_threads;
+        report.addPages(0, pagesOf(&this->particles[begin], (end - begin) * sizeof(Particle<D>)), threadNode(thread));
+    }
+    unsigned int chunk_threads = std::max(1u, std::min(this->thread_count, (unsigned int)this->chunks.size()));
+    for(unsigned int thread = 0; thread < chunk_threads; thread++) {
+        unsigned int begin = (unsigned long long)this->chunks.size() * thread / chunk_threads;
+        unsigned int end = (unsigned long long)this->chunks.size() * (thread + 1) / chunk_threads;
+        report.addPages(1, this->chunkPages(begin, end), threadNode(thread));
+    }
+    for(unsigned int thread = 0; thread < this->thread_forces.size(); thread++) {
+        std::vector<Vector<double, D>>& forces = this->thread_forces[thread];
+        report.addPages(2, pagesOf(forces.data(), forces.size() * sizeof(Vector<double, D>)), threadNode(thread));
+    }
+    return report;
+}
+
+template<unsigned int D, unsigned int N, double LD, double RCUT>
+template<typename Visit>
+void Universe<D, N, LD, RCUT>::visitChunks(const Vector<double, D>& low, const Vector<double, D>& high, Visit visit) {
+    Vector<int, D> first;
+    Vector<int, D> last;
+    uint64_t box_chunks = 1;
+    for(unsigned int dim = 0; dim < D; dim++) {
+        if(!(low[dim] <= high[dim])) {
+            return;
+        }
+        // clamped as the particles are, so the chunks of the faces are kept for boxes beyond them
+        double max_chunk = this->chunks_per_dim - 1;
+        first[dim] = (int)std::max(0.0, std::min(floor(low[dim] / this->chunk_side), max_chunk));
+        last[dim] = (int)std::max(0.0, std::min(floor(high[dim] / this->chunk_side), max_chunk));
+        box_chunks *= last[dim] - first[dim] + 1;
+    }
+    // the sparse grid goes through its chunks when the box has more chunks than it
+    if(this->grid_type == GRID_TYPE::sparse && box_chunks > this->chunks.size()) {
+        for(UniverseChunk<D>& chunk: this->chunks) {
+            Vector<int, D> coordinates = chunk.getCoordinates();
+            bool inside = true;
+            for(unsigned int dim = 0; dim < D; dim++) {
+                inside = inside && coordinates[dim] >= first[dim] && coordinates[dim] <= last[dim];
+            }
+            if(inside) {
+                visit(chunk);
+            }
+        }
+        return;
+    }
+    Vector<int, D> coordinates = first;
+    for(uint64_t i = 0; i < box_chunks; i++) {
+        int64_t key = this->vecCoordToInt(coordinates);
+        int chunk = this->grid_type == GRID_TYPE::dense ? key : this->chunk_map.find(key);
+        if(chunk >= 0) {
+            visit(this->chunks[chunk]);
+        }
+        // next coordinates in the box, the last dimension moving fastest
+        for(int dim = D - 1; dim >= 0; dim--) {
+            if(++coordinates[dim] <= last[dim]) {
+                break;
+            }
+            coordinates[dim] = first[dim];
+        }
     }
-    beta = sqrt(this->Ecd / (beta * 0.5));
-    // compute 
 }
 
 template<unsigned int D, unsigned int N, double LD, double RCUT>
 void Universe<D, N, LD, RCUT>::verifyParticlesChunks() {
     // loop through all chunks, all particles, check they are in the right chunk.
-    for(unsigned int chunk = 0; chunk < this->CHUNK_LENGTH; chunk++) {
+    // the sparse grid may append chunks on the way, they only have incoming particles until the flush
+    for(unsigned int chunk = 0; chunk < this->chunks.size(); chunk++) {
         for(auto part = this->chunks[chunk].getParticleBegin(); part != this->chunks[chunk].getParticleEnd(); ++part) {
+            // particles leaving a periodic universe come back from the other side
+            if(this->border == BORDER_TYPE::periodic) {
+                this->wrapParticle(*part);
+            }
             // check the particle is placed in the write spot in all dimensions
-            unsigned int part_chunk = this->getParticleChunk(*part);
-            if(chunk != part_chunk) {
-                // -1 means do not replace the particle
+            int part_chunk = this->getParticleChunk(*part);
+            if((int)chunk != part_chunk) {
+                // -1 means the particle left an absorbent universe, it is compacted out after the flush
                 if(part_chunk >= 0) {
                     this->placeParticle(*part, part_chunk);
                 }
+                else {
+                    this->absorbed_particles.push_back(*part);
+                }
+                // removal is deferred to the flush, so we can keep iterating over the chunk
                 this->chunks[chunk].removeParticle(*part);
-                break;
             }
         }
     }
     // flush all chunks
-    for(unsigned int chunk = 0; chunk < this->CHUNK_LENGTH; chunk++) {
-        this->chunks[chunk].flush();
+    unsigned int empty_chunks = this->flushChunks();
+    this->compactParticles();
+    // the sparse grid cannot remove chunks from its map: start over when most of them are empty
+    if(this->grid_type == GRID_TYPE::sparse && empty_chunks > this->chunks.size() / 2 + this->stencil.size()) {
+        this->generateChunks();
+        this->populateChunks();
     }
 }
 
@@ -426,14 +1279,69 @@ void Universe<D, N, LD, RCUT>::verifyParticlesChunks() {
 template<unsigned int D, unsigned int N, double LD, double RCUT>
 void Universe<D, N, LD, RCUT>::registerInteractor(Interactor<D> *interactor) {
     this->registered_interactors.push_back(interactor);
+    this->forces_up_to_date = false;
 }
 
 template<unsigned int D, unsigned int N, double LD, double RCUT>
 void Universe<D, N, LD, RCUT>::registerForce(Force<D> *force) {
     this->registered_forces.push_back(force);
+    this->forces_up_to_date = false;
+}
+
+template<unsigned int D, unsigned int N, double LD, double RCUT>
+void Universe<D, N, LD, RCUT>::registerLongRangeSolver(LongRangeSolver<D> *solver) {
+    this->registered_long_range_solvers.push_back(solver);
+    this->forces_up_to_date = false;
 }
 
 template<unsigned int D, unsigned int N, double LD, double RCUT>
 void Universe<D, N, LD, RCUT>::registerVisualizer(Visualizer<Universe<D, N, LD, RCUT>> *visualizer) {
     this->registered_visulizer.push_back(visualizer);
+}
+
+template<unsigned int D, unsigned int N, double LD, double RCUT>
+void Universe<D, N, LD, RCUT>::registerBondedNetwork(BondedNetwork<D> *network) {
+    this->registered_bonded_networks.push_back(network);
+    this->forces_up_to_date = false;
+}
+
+template<unsigned int D, unsigned int N, double LD, double RCUT>
+void Universe<D, N, LD, RCUT>::registerSource(ParticleSource<D> *source) {
+    this->registered_sources.push_back(source);
+}
+
+template<unsigned int D, unsigned int N, double LD, double RCUT>
+bool Universe<D, N, LD, RCUT>::injectParticle(const Particle<D>& particle) {
+    if(this->active_count == N) {
+        return false;
+    }
+    unsigned int index = this->active_count;
+    this->particles[index] = particle;
+    if(this->border == BORDER_TYPE::periodic) {
+        this->wrapParticle(index);
+    }
+    int chunk = this->getParticleChunk(index);
+    if(chunk < 0) {
+        return false;
+    }
+    this->active_count++;
+    this->placeParticle(index, chunk);
+    this->chunks[chunk].flush();
+    if(this->forces_up_to_date && this->registered_long_range_solvers.empty()) {
+        this->addParticleForces(index);
+    }
+    else {
+        this->forces_up_to_date = false;
+    }
+    return true;
+}
+
+template<unsigned int D, unsigned int N, double LD, double RCUT>
+void Universe<D, N, LD, RCUT>::registerPairAnalyzer(PairAnalyzer<D> *analyzer) {
+    this->registered_pair_analyzers.push_back(analyzer);
+}
+
+template<unsigned int D, unsigned int N, double LD, double RCUT>
+void Universe<D, N, LD, RCUT>::registerStepAnalyzer(StepAnalyzer<D> *analyzer) {
+    this->registered_step_analyzers.push_back(analyzer);
 }
\ No newline at end of file
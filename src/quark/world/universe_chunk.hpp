@@ -58,7 +58,7 @@ class UniverseChunk {
     /// @brief Clean the chunk collections.
     ///         The multiple collections allow deletion and insertion while iteration.
     void flush() {
-        for(auto part = this->invalid_particles.begin(); part != this->particles_index.end(); ++part) {
+        for(auto part = this->invalid_particles.begin(); part != this->invalid_particles.end(); ++part) {
             this->particles_index.erase(*part);
         }
         // for some reason next line does not work ? so we have to iterate manually
@@ -70,7 +70,7 @@ class UniverseChunk {
 
     public:
     // getters
-    Vector<int, D> getCoordinates() {
+    Vector<int, D> getCoordinates() const {
         return this->coordinates;
     } 
 
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "wall.hpp"
+
+/// @brief Soft wall pushing particles back with a spring, F = k * (range - distance).
+///         The force keeps growing for particles that went through the face.
+class HarmonicWall : public Wall {
+    private:
+    const double stiffness;
+    const double range;
+
+    public:
+    HarmonicWall(double stiffness, double range) : stiffness(stiffness), range(range) {}
+
+    public:
+    double getRange() const override {
+        return this->range;
+    }
+
+    void computeWallForces(const double* distances, double* forces, unsigned int count) override {
+        for(unsigned int i = 0; i < count; i++) {
+            double force = this->stiffness * (this->range - distances[i]);
+            forces[i] = distances[i] < this->range ? force : 0.0;
+        }
+    }
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cmath>
+#include <algorithm>
+#include "wall.hpp"
+
+/// @brief Wall repelling particles with their mirror image through the face, with the Lennard-Jones potential.
+///         The potential is cut at its minimum (2^(1/6) sigma between the particle and its image), so it is purely repulsive.
+class LennardJonesMirrorWall : public Wall {
+    private:
+    const double sigma;
+    const double epsilon;
+    const double sigma_sixth;
+    const double range;
+
+    public:
+    LennardJonesMirrorWall(double sigma = 1.0, double epsilon = 1.0) :
+        sigma(sigma),
+        epsilon(epsilon),
+        sigma_sixth(sigma * sigma * sigma * sigma * sigma * sigma),
+        range(0.5 * std::pow(2.0, 1.0 / 6.0) * sigma) {}
+
+    public:
+    double getRange() const override {
+        return this->range;
+    }
+
+    void computeWallForces(const double* distances, double* forces, unsigned int count) override {
+        // particles that went through the face would get an infinite force, keep them at a small distance instead
+        const double min_distance = 0.01 * this->sigma;
+        for(unsigned int i = 0; i < count; i++) {
+            // distance between the particle and its image
+            double r = 2 * std::max(distances[i], min_distance);
+            double r_sq = r * r;
+            double sigma_over_r_sixth = this->sigma_sixth / (r_sq * r_sq * r_sq);
+            double force = 24 * this->epsilon / r * sigma_over_r_sixth * (2 * sigma_over_r_sixth - 1);
+            forces[i] = distances[i] < this->range ? force : 0.0;
+        }
+    }
+};
+
+/// @brief Wall made of a continuous half space of Lennard-Jones particles, giving the 9-3 potential:
+///         U(z) = epsilon * (2/15 (sigma/z)^9 - (sigma/z)^3).
+///         By default the potential is cut at its minimum, (2/5)^(1/6) sigma, so it is purely repulsive.
+class LennardJones93Wall : public Wall {
+    private:
+    const double sigma;
+    const double epsilon;
+    const double sigma_cube;
+    const double sigma_ninth;
+    const double range;
+
+    public:
+    LennardJones93Wall(double sigma = 1.0, double epsilon = 1.0) :
+        LennardJones93Wall(sigma, epsilon, std::pow(0.4, 1.0 / 6.0) * sigma) {}
+    LennardJones93Wall(double sigma, double epsilon, double cutoff) :
+        sigma(sigma),
+        epsilon(epsilon),
+        sigma_cube(sigma * sigma * sigma),
+        sigma_ninth(sigma * sigma * sigma * sigma * sigma * sigma * sigma * sigma * sigma),
+        range(cutoff) {}
+
+    public:
+    double getRange() const override {
+        return this->range;
+    }
+
+    void computeWallForces(const double* distances, double* forces, unsigned int count) override {
+        const double min_distance = 0.01 * this->sigma;
+        for(unsigned int i = 0; i < count; i++) {
+            // F(z) = -dU/dz = epsilon * (6/5 sigma^9 / z^10 - 3 sigma^3 / z^4)
+            double z = std::max(distances[i], min_distance);
+            double z_sq = z * z;
+            double z_fourth = z_sq * z_sq;
+            double z_tenth = z_fourth * z_fourth * z_sq;
+            double force = this->epsilon * (1.2 * this->sigma_ninth / z_tenth - 3 * this->sigma_cube / z_fourth);
+            forces[i] = distances[i] < this->range ? force : 0.0;
+        }
+    }
+};
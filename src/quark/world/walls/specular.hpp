@@ -0,0 +1,25 @@
+#pragma once
+
+#include "wall.hpp"
+
+/// @brief Hard wall: applies no force, but particles that went through a face are mirrored back
+///         and the normal component of their velocity is flipped.
+class SpecularWall : public Wall {
+    public:
+    SpecularWall() = default;
+
+    public:
+    double getRange() const override {
+        return 0.0;
+    }
+
+    void computeWallForces(const double* distances, double* forces, unsigned int count) override {
+        for(unsigned int i = 0; i < count; i++) {
+            forces[i] = 0.0;
+        }
+    }
+
+    bool isSpecular() const override {
+        return true;
+    }
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+/// @brief Virtual class for the walls of a reflexive universe.
+///         Walls only act on particles close to the faces of the universe, so the universe gathers
+///         the distance to a face of those particles and hands them over in contiguous batches.
+///         This keeps the kernels free of branches on the particle storage, so they can be vectorized.
+class Wall {
+    public:
+    virtual ~Wall() {}
+    /// @brief Distance to a face under which the wall acts on a particle.
+    /// @return the range of the wall.
+    virtual double getRange() const = 0;
+    /// @brief Compute the wall force for a batch of particles.
+    /// @param distances distance of each particle to the face. Can be negative if the particle went through.
+    /// @param forces output, norm of the force applied on each particle, positive toward the inside of the universe.
+    /// @param count number of particles in the batch.
+    virtual void computeWallForces(const double* distances, double* forces, unsigned int count) = 0;
+    /// @brief Whether particles that went through a face should be mirrored back into the universe.
+    /// @return true if the wall reflects particles.
+    virtual bool isSpecular() const {
+        return false;
+    }
+};
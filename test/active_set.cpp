@@ -0,0 +1,177 @@
+/// Unit tests for the active set of the universe: absorbed particles are compacted out, and sources fill the free slots.
+#include <cassert>
+#include <cmath>
+#include <vector>
+#include "quark/world/universe.hpp"
+#include "quark/world/initializers.hpp"
+#include "quark/world/interactions/lennard_jones.hpp"
+#include "quark/world/sources/box_source.hpp"
+#include "quark/world/forces/gravity.hpp"
+#include "quark/world/walls/harmonic.hpp"
+
+typedef Universe<2, 400, 40.0, 2.5> TestUniverse;
+
+LennardJonesInteractor<2> lj_interactor = LennardJonesInteractor<2>();
+
+Vector<double, 2> vec2(double x, double y) {
+    double values[2] = {x, y};
+    return Vector<double, 2>(values);
+}
+
+/// a square crystal, the particles of the outer rows flying away from the center
+void fillParticles(Particle<2>* particles) {
+    for(unsigned int i = 0; i < 400; i++) {
+        double pos[2] = {8.8 + (i % 20) * 1.12, 8.8 + (i / 20) * 1.12};
+        double vel[2] = {0, 0};
+        if(i % 20 < 2 || i % 20 > 17) {
+            vel[0] = i % 20 < 2 ? -40.0 : 40.0;
+        }
+        particles[i] = Particle<2>(i, Vector<double, 2>(pos), Vector<double, 2>(vel), 1.0);
+    }
+}
+
+/// particles leaving an absorbent universe are gone, and the remaining ones keep evolving
+void testAbsorption() {
+    Particle<2> particles[400];
+    fillParticles(particles);
+    TestUniverse* universe = new TestUniverse(particles);
+    universe->registerInteractor(&lj_interactor);
+    for(unsigned int step = 0; step < 400; step++) {
+        universe->step(0.001);
+    }
+    assert(universe->getActiveCount() == 320);
+    assert(universe->getParticles().size() == 320);
+    for(const Particle<2>& particle: universe->getParticles()) {
+        for(unsigned int dim = 0; dim < 2; dim++) {
+            assert(particle.getPosition()[dim] >= 0 && particle.getPosition()[dim] < 40.0);
+        }
+    }
+
+    // a fresh universe made of the survivors follows the same trajectory
+    std::vector<Particle<2>> survivors(universe->getParticles().begin(), universe->getParticles().end());
+    TestUniverse* fresh = new TestUniverse(survivors.data(), survivors.size());
+    fresh->registerInteractor(&lj_interactor);
+    assert(fresh->getActiveCount() == 320);
+    for(unsigned int step = 0; step < 100; step++) {
+        universe->step(0.001);
+        fresh->step(0.001);
+    }
+    for(unsigned int i = 0; i < universe->getActiveCount(); i++) {
+        Vector<double, 2> difference = universe->getParticles()[i].getPosition() - fresh->getParticles()[i].getPosition();
+        assert(difference.sq_magnitude() < 1e-12);
+    }
+    delete universe;
+    delete fresh;
+}
+
+/// a particle left outside of the universe at its creation is in no chunk, and still moves into the holes
+void testParticleOutside() {
+    Particle<2> particles[3] = {
+        Particle<2>(0, vec2(39.5, 20.0), vec2(40.0, 0.0), 1.0),
+        Particle<2>(1, vec2(20.0, 20.0), Vector<double, 2>(), 1.0),
+        Particle<2>(2, vec2(-5.0, 20.0), Vector<double, 2>(), 1.0)
+    };
+    TestUniverse* universe = new TestUniverse(particles, 3);
+    for(unsigned int step = 0; step < 100; step++) {
+        universe->step(0.001);
+    }
+    assert(universe->getActiveCount() == 2);
+    assert(universe->getParticles()[0].getPosition() == vec2(-5.0, 20.0));
+    assert(universe->getParticles()[1].getPosition() == vec2(20.0, 20.0));
+    delete universe;
+}
+
+/// gravity counting the particles it is applied to
+class CountingGravity : public GravityForce<2> {
+    public:
+    unsigned int calls = 0;
+
+    CountingGravity() : GravityForce<2>(1.0) {}
+
+    Vector<double, 2> computeForce(const Particle<2>& part) override {
+        this->calls++;
+        return GravityForce<2>::computeForce(part);
+    }
+};
+
+/// an injected particle only adds its own pairs to the forces, and the run goes on as if they were all computed again
+void testInjectionForces() {
+    Particle<2> particles[100];
+    for(unsigned int i = 0; i < 100; i++) {
+        particles[i] = Particle<2>(i, vec2(1.0 + (i % 10) * 1.12, 1.0 + (i / 10) * 1.12), Vector<double, 2>(), 1.0);
+    }
+    CountingGravity gravity;
+    HarmonicWall wall(10.0, 1.0);
+    auto createUniverse = [&](Particle<2>* particles, unsigned int count) {
+        TestUniverse* universe = new TestUniverse(particles, count);
+        universe->registerInteractor(&lj_interactor);
+        universe->registerForce(&gravity);
+        universe->set_border_type(BORDER_TYPE::reflexive);
+        universe->setWall(&wall);
+        return universe;
+    };
+    TestUniverse* universe = createUniverse(particles, 100);
+    universe->step(0.001);
+    // next to the crystal, and within the range of the wall
+    gravity.calls = 0;
+    assert(universe->injectParticle(Particle<2>(100, vec2(12.2, 0.8), Vector<double, 2>(), 1.0)));
+    assert(gravity.calls == 1);
+    std::vector<Particle<2>> copy(universe->getParticles().begin(), universe->getParticles().end());
+    TestUniverse* fresh = createUniverse(copy.data(), copy.size());
+    universe->step(0.001);
+    // the pass of the step only
+    assert(gravity.calls == 1 + 101);
+    fresh->step(0.001);
+    for(unsigned int step = 0; step < 50; step++) {
+        universe->step(0.001);
+        fresh->step(0.001);
+    }
+    for(unsigned int i = 0; i < 101; i++) {
+        Vector<double, 2> difference = universe->getParticles()[i].getPosition() - fresh->getParticles()[i].getPosition();
+        assert(difference.sq_magnitude() < 1e-20);
+    }
+    delete universe;
+    delete fresh;
+}
+
+/// a source fills an empty universe up to its capacity, and particles outside are refused
+void testSource() {
+    Particle<2> particles[1];
+    TestUniverse* universe = new TestUniverse(particles, 0);
+    assert(universe->getActiveCount() == 0);
+    assert(!universe->injectParticle(Particle<2>(0, vec2(-1.0, 5.0), Vector<double, 2>(), 1.0)));
+    assert(universe->getActiveCount() == 0);
+
+    // particles at rest, no interactor: random overlaps would blow them out of the universe
+    BoxSource<2> source(vec2(5.0, 5.0), vec2(30.0, 30.0), Vector<double, 2>(), 2500.0, 7);
+    universe->registerSource(&source);
+    universe->step(0.001);
+    // 2.5 particles per step
+    assert(universe->getActiveCount() == 2);
+    for(unsigned int step = 0; step < 199; step++) {
+        universe->step(0.001);
+    }
+    assert(universe->getActiveCount() == 400);
+    assert(source.getEmittedCount() == 400);
+    assert(std::abs(universe->getTime() - 0.2) < 1e-9);
+    delete universe;
+
+    // same seed, same particles
+    BoxSource<2> first(vec2(5.0, 5.0), vec2(30.0, 30.0), vec2(1.0, 0.0), 1000.0, 7, 1.0, 0.5);
+    BoxSource<2> second(vec2(5.0, 5.0), vec2(30.0, 30.0), vec2(1.0, 0.0), 1000.0, 7, 1.0, 0.5);
+    Particle<2> a[10], b[10];
+    assert(first.emit(0.01, 0.01, a, 10) == 10);
+    assert(second.emit(0.01, 0.01, b, 10) == 10);
+    for(unsigned int i = 0; i < 10; i++) {
+        assert(a[i].getPosition() == b[i].getPosition());
+        assert(a[i].getVelocity() == b[i].getVelocity());
+    }
+}
+
+int main() {
+    testAbsorption();
+    testParticleOutside();
+    testInjectionForces();
+    testSource();
+    return 0;
+}
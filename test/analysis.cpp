@@ -0,0 +1,192 @@
+/// Unit tests for the in-situ analysis: the pairs seen by the analyzers match a brute force search, for every force pass.
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include "quark/world/universe.hpp"
+#include "quark/world/integrators/stormer_verlet.hpp"
+#include "quark/world/initializers.hpp"
+#include "quark/world/analysis/radial_distribution.hpp"
+#include "quark/world/analysis/coordination.hpp"
+#include "quark/world/analysis/pair_energy.hpp"
+#include "quark/world/analysis/mean_squared_displacement.hpp"
+#include "quark/world/analysis/energy.hpp"
+#include "quark/world/interactions/lennard_jones.hpp"
+
+const unsigned int COUNT = 2000;
+typedef Universe<2, COUNT, 40.0, 2.5> TestUniverse;
+
+double lennardJones(double distance_sq) {
+    double inverse_sixth = 1.0 / (distance_sq * distance_sq * distance_sq);
+    return 4 * (inverse_sixth * inverse_sixth - inverse_sixth);
+}
+
+/// particles at rest uniformly in the universe, without interactions so they stay in place
+TestUniverse* createUniverse() {
+    Particle<2>* particles = new Particle<2>[COUNT];
+    double corner[2] = {0.0, 0.0};
+    double size[2] = {40.0, 40.0};
+    Initializers::uniform<2>(particles, COUNT, Vector<double, 2>(corner), Vector<double, 2>(size), 17);
+    TestUniverse* universe = new TestUniverse(particles);
+    delete[] particles;
+    return universe;
+}
+
+/// every pass gives each pair once to the analyzers
+void testPasses() {
+    TestUniverse* reference = createUniverse();
+    auto particles = reference->getParticles();
+    std::vector<unsigned int> expected(COUNT, 0);
+    double expected_energy = 0;
+    for(unsigned int i = 0; i < COUNT; i++) {
+        for(unsigned int j = i + 1; j < COUNT; j++) {
+            double distance_sq = (particles[i].getPosition() - particles[j].getPosition()).sq_magnitude();
+            if(distance_sq < 1.5 * 1.5) {
+                expected[i]++;
+                expected[j]++;
+            }
+            if(distance_sq < 2.5 * 2.5) {
+                expected_energy += lennardJones(distance_sq);
+            }
+        }
+    }
+    delete reference;
+    for(unsigned int mode = 0; mode < 3; mode++) {
+        TestUniverse* universe = createUniverse();
+        universe->setThreadCount(mode == 0 ? 1 : 3);
+        universe->setReproducible(mode == 2);
+        CoordinationAnalyzer<2> coordination(1.5);
+        PairEnergyHistogram<2> energies(2.5, lennardJones, -1.0, 1.0, 20);
+        universe->registerPairAnalyzer(&coordination);
+        universe->registerPairAnalyzer(&energies);
+        universe->setAnalysisInterval(5);
+        for(unsigned int step = 0; step < 20; step++) {
+            universe->step(0.01);
+        }
+        assert(coordination.getSampleCount() == 4);
+        assert(coordination.getCoordinations() == expected);
+        assert(energies.getTotalEnergies().size() == 4);
+        assert(std::abs(energies.getTotalEnergies()[3] - expected_energy) < 1e-6 * std::abs(expected_energy));
+        delete universe;
+    }
+}
+
+/// an ideal gas has g(r) close to 1, a little less at long range from the faces of the universe
+void testIdealGas() {
+    TestUniverse* universe = createUniverse();
+    RadialDistribution<2> rdf(2.5, 10, 40.0 * 40.0);
+    universe->registerPairAnalyzer(&rdf);
+    universe->step(0.01);
+    std::vector<double> values = rdf.getValues();
+    for(unsigned int bin = 2; bin < values.size(); bin++) {
+        assert(values[bin] > 0.85 && values[bin] < 1.1);
+    }
+    delete universe;
+}
+
+/// particles flying straight have a squared displacement of (v t)^2, even through a periodic border
+void testDisplacement() {
+    Particle<2>* particles = new Particle<2>[COUNT];
+    double corner[2] = {0.0, 0.0};
+    double size[2] = {40.0, 40.0};
+    Initializers::uniform<2>(particles, COUNT, Vector<double, 2>(corner), Vector<double, 2>(size), 23);
+    double velocity[2] = {3.0, 4.0};
+    for(unsigned int i = 0; i < COUNT; i++) {
+        particles[i].setVelocity(Vector<double, 2>(velocity));
+    }
+    TestUniverse universe(particles);
+    delete[] particles;
+    universe.set_border_type(BORDER_TYPE::periodic);
+    MeanSquaredDisplacement<2> msd(40.0);
+    universe.registerStepAnalyzer(&msd);
+    for(unsigned int step = 0; step < 100; step++) {
+        universe.step(0.1);
+    }
+    // the first sample is the origin, after the first step
+    assert(msd.getValues().size() == 100);
+    double time = 99 * 0.1;
+    assert(std::abs(msd.getValues()[99] - 25 * time * time) < 1e-6 * 25 * time * time);
+}
+
+/// particles are followed by id through the compaction of the universe, and the injected ones are left out
+void testDisplacementCompacted() {
+    Particle<2> particles[10];
+    for(unsigned int i = 0; i < 10; i++) {
+        double position[2] = {10.0 + 2.0 * i, 20.0};
+        double velocity[2] = {0.3, 0.4};
+        particles[i] = Particle<2>(i, Vector<double, 2>(position), Vector<double, 2>(velocity), 1.0);
+    }
+    // the first particle leaves the universe after a few steps, the last one takes its index
+    double backward[2] = {-50.0, 0.0};
+    particles[0].setVelocity(Vector<double, 2>(backward));
+    Universe<2, 20, 40.0, 2.5> universe(particles, 10);
+    MeanSquaredDisplacement<2> msd;
+    universe.registerStepAnalyzer(&msd);
+    for(unsigned int step = 0; step < 100; step++) {
+        universe.step(0.1);
+        if(step == 50) {
+            double position[2] = {5.0, 5.0};
+            double velocity[2] = {3.0, 0.0};
+            assert(universe.injectParticle(Particle<2>(10, Vector<double, 2>(position), Vector<double, 2>(velocity), 1.0)));
+        }
+    }
+    assert(universe.getActiveCount() == 10);
+    assert(msd.getValues().size() == 100);
+    double time = 99 * 0.1;
+    assert(std::abs(msd.getValues()[99] - 0.25 * time * time) < 1e-9);
+    msd.reset();
+    universe.step(0.1);
+    universe.step(0.1);
+    assert(msd.getValues().size() == 2);
+    assert(std::abs(msd.getValues()[1] - (0.25 * 0.01 * 9 + 9.0 * 0.01) / 10) < 1e-9);
+}
+
+/// a warm Lennard-Jones crystal conserves its energy and momentum, and the tracked potential is the shifted pair sum
+void testEnergy(Integrator<2>* integrator) {
+    typedef Universe<2, 100, 40.0, 2.5> CrystalUniverse;
+    Particle<2> particles[100];
+    double spacing = 1.12246204831;
+    double corner[2] = {15.0, 15.0};
+    unsigned int cells[2] = {10, 10};
+    Initializers::cubic<2>(particles, Vector<double, 2>(corner), Vector<unsigned int, 2>(cells), spacing);
+    Initializers::maxwellBoltzmann<2>(particles, 100, 0.1, 5);
+    CrystalUniverse universe(particles, 100);
+    universe.setIntegrator(integrator);
+    LennardJonesInteractor<2> interactor;
+    universe.registerInteractor(&interactor);
+    EnergyTracker<2> tracker(2.5);
+    tracker.registerInteractor(&interactor);
+    universe.registerPairAnalyzer(&tracker);
+    universe.registerStepAnalyzer(&tracker);
+    universe.setAnalysisInterval(10);
+    universe.step(0.001);
+    double expected_energy = 0;
+    auto current = universe.getParticles();
+    for(unsigned int i = 0; i < 100; i++) {
+        for(unsigned int j = i + 1; j < 100; j++) {
+            double distance_sq = (current[i].getPosition() - current[j].getPosition()).sq_magnitude();
+            if(distance_sq < 2.5 * 2.5) {
+                expected_energy += lennardJones(distance_sq) - lennardJones(2.5 * 2.5);
+            }
+        }
+    }
+    assert(std::abs(tracker.getPotentialEnergies()[0] - expected_energy) < 1e-9 * std::abs(expected_energy));
+    assert(std::abs(tracker.getKineticEnergies()[0] - universe.getCineticEnergy()) < 1e-12);
+    for(unsigned int step = 1; step < 1000; step++) {
+        universe.step(0.001);
+    }
+    assert(tracker.getSampleCount() == 100);
+    assert(tracker.getEnergyDrift() < 2e-3);
+    assert(tracker.getMomentumDrift() < 1e-10);
+}
+
+int main() {
+    testPasses();
+    testIdealGas();
+    testDisplacement();
+    testDisplacementCompacted();
+    // the position verlet evaluates the forces mid step, the energy must still be the one of the final positions
+    StormerVerletIntegrator<2> stormer_verlet;
+    PositionVerletIntegrator<2> position_verlet;
+    testEnergy(&stormer_verlet);
+    testEnergy(&position_verlet);
+}
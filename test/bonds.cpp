@@ -0,0 +1,167 @@
+/// Unit tests for the bonded terms: forces are the gradient of the energy, the pass does not depend on the thread count,
+/// bonded universes conserve energy, and the terms follow the particles when the universe compacts them.
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "quark/world/universe.hpp"
+#include "quark/world/bonds/bonded_network.hpp"
+#include "quark/world/bonds/harmonic.hpp"
+#include "quark/world/bonds/fene.hpp"
+#include "quark/world/bonds/angle.hpp"
+
+Vector<double, 3> vec3(double x, double y, double z) {
+    double values[3] = {x, y, z};
+    return Vector<double, 3>(values);
+}
+
+/// the forces match central differences of the energy, for every kind of term
+void testGradient() {
+    HarmonicBond harmonic(50.0, 1.0);
+    FENEBond fene(30.0, 1.5);
+    HarmonicAngle bending(5.0, 2.0);
+    CosineAngle straight(5.0, M_PI);
+    std::vector<Particle<3>> particles;
+    std::default_random_engine rnd{11};
+    std::uniform_real_distribution<double> jitter(-0.2, 0.2);
+    for(unsigned int i = 0; i < 5; i++) {
+        particles.push_back(Particle<3>(i, vec3(i + jitter(rnd), jitter(rnd), jitter(rnd)), Vector<double, 3>(), 1.0));
+    }
+    BondedNetwork<3> network;
+    network.addBond(0, 1, &harmonic);
+    network.addBond(1, 2, &fene);
+    network.addBond(2, 3, &harmonic);
+    network.addBond(3, 4, &fene);
+    network.addAngle(0, 1, 2, &bending);
+    network.addAngle(1, 2, 3, &straight);
+    network.addAngle(2, 3, 4, &bending);
+    for(Particle<3>& particle: particles) {
+        particle.resetForce();
+    }
+    network.addForces(particles.data(), 5, 1, 0.0);
+    const double h = 1e-6;
+    for(unsigned int i = 0; i < 5; i++) {
+        for(unsigned int dim = 0; dim < 3; dim++) {
+            Vector<double, 3> position = particles[i].getPosition();
+            Vector<double, 3> shifted = position;
+            shifted[dim] += h;
+            particles[i].setPosition(shifted);
+            double energy_plus = network.computeEnergy(particles.data(), 5, 1, 0.0);
+            shifted[dim] -= 2 * h;
+            particles[i].setPosition(shifted);
+            double energy_minus = network.computeEnergy(particles.data(), 5, 1, 0.0);
+            particles[i].setPosition(position);
+            double expected = -(energy_plus - energy_minus) / (2 * h);
+            assert(std::abs(particles[i].getForce()[dim] - expected) < 1e-5 * std::max(1.0, std::abs(expected)));
+        }
+    }
+}
+
+/// an elastic block, bonded to its neighbours, vibrates without losing energy, and every thread count gives the same forces
+void testElasticSolid() {
+    typedef Universe<2, 400, 60.0, 2.5> SolidUniverse;
+    Particle<2> particles[400];
+    std::default_random_engine rnd{5};
+    std::normal_distribution<double> noise(0.0, 0.3);
+    for(unsigned int i = 0; i < 400; i++) {
+        double pos[2] = {20 + (i % 20) * 1.0, 20 + (i / 20) * 1.0};
+        double vel[2] = {noise(rnd), noise(rnd)};
+        particles[i] = Particle<2>(i, Vector<double, 2>(pos), Vector<double, 2>(vel), 1.0);
+    }
+    HarmonicBond spring(100.0, 1.0);
+    HarmonicBond diagonal(100.0, sqrt(2.0));
+    BondedNetwork<2> network;
+    // nearest neighbours at rest length 1, diagonals at sqrt(2)
+    assert(network.addBondsWithin(particles, 400, 1.1, &spring) == 2 * 19 * 20);
+    for(unsigned int i = 0; i < 400; i++) {
+        if(i % 20 < 19 && i / 20 < 19) {
+            network.addBond(i, i + 21, &diagonal);
+            network.addBond(i + 1, i + 20, &diagonal);
+        }
+    }
+
+    std::vector<Vector<double, 2>> forces;
+    for(unsigned int threads: {1u, 3u}) {
+        SolidUniverse universe(particles);
+        universe.setThreadCount(threads);
+        universe.registerBondedNetwork(&network);
+        auto energy = [&]() {
+            return universe.getCineticEnergy() + network.computeEnergy(universe.getParticles().data(), universe.getActiveCount(), 1, 0.0);
+        };
+        universe.step(0.001);
+        double start_energy = energy();
+        for(unsigned int step = 0; step < 1000; step++) {
+            universe.step(0.001);
+        }
+        assert(std::abs(energy() - start_energy) < 1e-3 * start_energy);
+        if(threads == 1) {
+            for(const Particle<2>& particle: universe.getParticles()) {
+                forces.push_back(particle.getForce());
+            }
+        }
+        else {
+            for(unsigned int i = 0; i < 400; i++) {
+                assert(universe.getParticles()[i].getForce() == forces[i]);
+            }
+        }
+    }
+}
+
+/// particles flying out of the universe are compacted away, and the chain keeps bonding the same particles
+void testReorder() {
+    typedef Universe<2, 30, 40.0, 2.5> ChainUniverse;
+    Particle<2> particles[30];
+    BondedNetwork<2> network;
+    FENEBond fene;
+    CosineAngle stiffness(2.0, M_PI);
+    std::vector<unsigned int> chain;
+    for(unsigned int i = 0; i < 30; i++) {
+        if(i % 3 == 0) {
+            // a free particle, soon absorbed
+            double pos[2] = {20.0, 5.0 + i};
+            double vel[2] = {80, 0};
+            particles[i] = Particle<2>(i, Vector<double, 2>(pos), Vector<double, 2>(vel), 1.0);
+        }
+        else {
+            double pos[2] = {5 + chain.size() * 0.97, 20};
+            double vel[2] = {0, 0};
+            particles[i] = Particle<2>(i, Vector<double, 2>(pos), Vector<double, 2>(vel), 1.0);
+            chain.push_back(i);
+        }
+    }
+    for(unsigned int link = 0; link + 1 < chain.size(); link++) {
+        network.addBond(chain[link], chain[link + 1], &fene);
+        if(link + 2 < chain.size()) {
+            network.addAngle(chain[link], chain[link + 1], chain[link + 2], &stiffness);
+        }
+    }
+    ChainUniverse universe(particles);
+    universe.registerBondedNetwork(&network);
+    for(unsigned int step = 0; step < 300; step++) {
+        universe.step(0.001);
+    }
+    assert(universe.getActiveCount() == 20);
+    assert(network.getBondCount() == 19);
+    assert(network.getAngleCount() == 18);
+    // ids of the chain go 1, 2, 4, 5, 7, ...
+    auto next = [](int id) { return id % 3 == 2 ? id + 2 : id + 1; };
+    for(const BondedNetwork<2>::Bond& bond: network.getBonds()) {
+        int first = universe.getParticles()[bond.first].getId();
+        int second = universe.getParticles()[bond.second].getId();
+        assert(next(first) == second);
+        double length_sq = (universe.getParticles()[bond.first].getPosition() - universe.getParticles()[bond.second].getPosition()).sq_magnitude();
+        assert(length_sq < 1.5 * 1.5);
+    }
+    for(const BondedNetwork<2>::Angle& angle: network.getAngles()) {
+        int first = universe.getParticles()[angle.first].getId();
+        assert(universe.getParticles()[angle.vertex].getId() == next(first));
+        assert(universe.getParticles()[angle.last].getId() == next(next(first)));
+    }
+}
+
+int main() {
+    testGradient();
+    testElasticSolid();
+    testReorder();
+    return 0;
+}
@@ -0,0 +1,69 @@
+/// Unit tests for the sub-cell grids: the same pairs are found for any cell division, and the auto-tuner settles on one.
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include "quark/world/universe.hpp"
+#include "quark/world/interactions/lennard_jones.hpp"
+
+constexpr double CUT = 2.5;
+typedef Universe<3, 1000, 16.0, CUT> TestUniverse;
+
+// the universe skips the pairs further than the cut, so every cell division sees the same ones
+LennardJonesInteractor<3> lj_interactor;
+
+/// a warm liquid filling the universe
+TestUniverse* createUniverse() {
+    Particle<3>* particles = new Particle<3>[1000];
+    std::default_random_engine rnd{11};
+    std::normal_distribution<double> noise(0.0, 0.5);
+    for(unsigned int i = 0; i < 1000; i++) {
+        double pos[3] = {1.5 + (i % 10) * 1.3, 1.5 + (i / 10 % 10) * 1.3, 1.5 + (i / 100) * 1.3};
+        double vel[3] = {noise(rnd), noise(rnd), noise(rnd)};
+        particles[i] = Particle<3>(Vector<double, 3>(pos), Vector<double, 3>(vel), Vector<double, 3>(), 1.0);
+    }
+    TestUniverse* universe = new TestUniverse(particles);
+    delete[] particles;
+    universe->set_border_type(BORDER_TYPE::reflexive);
+    universe->registerInteractor(&lj_interactor);
+    return universe;
+}
+
+int main() {
+    // every cell division finds the same pairs, on both grids
+    TestUniverse* reference = createUniverse();
+    for(unsigned int step = 0; step < 50; step++) {
+        reference->step(0.001);
+    }
+    for(GRID_TYPE grid_type: {GRID_TYPE::dense, GRID_TYPE::sparse}) {
+        for(unsigned int division: {2, 3}) {
+            TestUniverse* universe = createUniverse();
+            universe->setGridType(grid_type);
+            universe->setCellDivision(division);
+            assert(universe->getCellDivision() == division);
+            for(unsigned int step = 0; step < 50; step++) {
+                universe->step(0.001);
+            }
+            for(unsigned int i = 0; i < 1000; i++) {
+                Vector<double, 3> difference = universe->getParticles()[i].getPosition() - reference->getParticles()[i].getPosition();
+                assert(difference.sq_magnitude() < 1e-18);
+            }
+            delete universe;
+        }
+    }
+    delete reference;
+
+    // the auto-tuner tries each candidate, then keeps one
+    TestUniverse* universe = createUniverse();
+    universe->autoTuneCellDivision({1, 2, 3}, 3);
+    for(unsigned int step = 0; step < 9; step++) {
+        assert(universe->isTuning());
+        assert(universe->getCellDivision() == 1 + step / 3);
+        universe->step(0.001);
+    }
+    assert(!universe->isTuning());
+    unsigned int division = universe->getCellDivision();
+    assert(division >= 1 && division <= 3);
+    printf("tuned cell division: %u\n", division);
+    delete universe;
+}
@@ -0,0 +1,101 @@
+/// Unit tests for the cluster analysis: the parallel union-find finds the same clusters as a sequential search.
+#include <cassert>
+#include <cmath>
+#include <vector>
+#include "quark/world/universe.hpp"
+#include "quark/world/initializers.hpp"
+#include "quark/world/analysis/clusters.hpp"
+
+const unsigned int COUNT = 3000;
+typedef Universe<2, COUNT, 60.0, 2.5> TestUniverse;
+
+/// sequential union-find over all pairs
+std::vector<unsigned int> bruteForceLabels(std::span<const Particle<2>> particles, double range) {
+    std::vector<unsigned int> parents(particles.size());
+    for(unsigned int i = 0; i < parents.size(); i++) {
+        parents[i] = i;
+    }
+    auto find = [&](unsigned int i) {
+        while(parents[i] != i) {
+            i = parents[i];
+        }
+        return i;
+    };
+    for(unsigned int i = 0; i < particles.size(); i++) {
+        for(unsigned int j = i + 1; j < particles.size(); j++) {
+            if((particles[i].getPosition() - particles[j].getPosition()).sq_magnitude() < range * range) {
+                unsigned int a = find(i);
+                unsigned int b = find(j);
+                parents[std::max(a, b)] = std::min(a, b);
+            }
+        }
+    }
+    // number the clusters in the order of their first particle, like the analyzer
+    std::vector<unsigned int> labels(particles.size());
+    unsigned int clusters = 0;
+    for(unsigned int i = 0; i < particles.size(); i++) {
+        unsigned int root = find(i);
+        labels[i] = root == i ? clusters++ : labels[root];
+    }
+    return labels;
+}
+
+/// a gas close to the percolation threshold gives clusters of all sizes, the same for any thread count
+void testGas() {
+    Particle<2>* particles = new Particle<2>[COUNT];
+    double corner[2] = {0.0, 0.0};
+    double size[2] = {60.0, 60.0};
+    Initializers::uniform<2>(particles, COUNT, Vector<double, 2>(corner), Vector<double, 2>(size), 5);
+    for(unsigned int threads: {1u, 4u}) {
+        TestUniverse* universe = new TestUniverse(particles);
+        universe->setThreadCount(threads);
+        ClusterAnalyzer<2> clusters(1.2);
+        universe->registerPairAnalyzer(&clusters);
+        universe->step(0.001);
+        assert(clusters.getSampleCount() == 1);
+        std::vector<unsigned int> expected = bruteForceLabels(universe->getParticles(), 1.2);
+        assert(clusters.getLabels() == expected);
+        unsigned int total = 0;
+        unsigned int cluster_count = 0;
+        const std::vector<unsigned int>& distribution = clusters.getSizeDistribution();
+        for(unsigned int size = 1; size < distribution.size(); size++) {
+            total += size * distribution[size];
+            cluster_count += distribution[size];
+        }
+        assert(total == COUNT);
+        assert(cluster_count == clusters.getClusterCount());
+        assert(clusters.getLargestClusterSize() > 20);
+        delete universe;
+    }
+    delete[] particles;
+}
+
+/// two blocks flying apart: two clusters, with the mass, center and momentum of each block
+void testBlocks() {
+    Particle<2> particles[200];
+    for(unsigned int i = 0; i < 200; i++) {
+        unsigned int block = i / 100;
+        double pos[2] = {10.0 + block * 30.0 + (i % 10), 20.0 + (i / 10 % 10)};
+        double vel[2] = {block == 0 ? -1.0 : 2.0, 0.0};
+        particles[i] = Particle<2>(i, Vector<double, 2>(pos), Vector<double, 2>(vel), block == 0 ? 1.0 : 3.0);
+    }
+    Universe<2, 200, 60.0, 2.5> universe(particles);
+    ClusterAnalyzer<2> clusters(1.1);
+    universe.registerPairAnalyzer(&clusters);
+    universe.step(0.001);
+    assert(clusters.getClusterCount() == 2);
+    for(unsigned int block = 0; block < 2; block++) {
+        const ClusterAnalyzer<2>::Cluster& cluster = clusters.getClusters()[block];
+        assert(cluster.size == 100);
+        assert(std::abs(cluster.mass - (block == 0 ? 100.0 : 300.0)) < 1e-9);
+        assert(std::abs(cluster.center_of_mass[0] - (14.5 + block * 30.0 + (block == 0 ? -0.001 : 0.002))) < 1e-9);
+        assert(std::abs(cluster.center_of_mass[1] - 24.5) < 1e-9);
+        assert(std::abs(cluster.momentum[0] - (block == 0 ? -100.0 : 600.0)) < 1e-9);
+    }
+}
+
+int main() {
+    testGas();
+    testBlocks();
+    return 0;
+}
@@ -0,0 +1,157 @@
+/// Unit tests for the constrained integrator: distance constraints with SHAKE and RATTLE, and rigid bodies.
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "quark/world/universe.hpp"
+#include "quark/world/integrators/rattle.hpp"
+#include "quark/world/interactions/lennard_jones.hpp"
+#include "quark/world/forces/gravity.hpp"
+
+/// a chain of rods in a spring field keeps its lengths, moves along them and conserves energy
+void testDistanceConstraints() {
+    const unsigned int COUNT = 5;
+    Particle<2> particles[COUNT];
+    std::default_random_engine rnd{3};
+    std::normal_distribution<double> noise(0.0, 1.0);
+    RattleIntegrator<2> integrator;
+    for(unsigned int i = 0; i < COUNT; i++) {
+        double pos[2] = {1.0 + i * 0.8, 0.5};
+        double vel[2] = {noise(rnd), noise(rnd)};
+        particles[i] = Particle<2>(i, Vector<double, 2>(pos), Vector<double, 2>(vel), 1.0 + i);
+        if(i > 0) {
+            integrator.addDistanceConstraint(i - 1, i, 0.8);
+        }
+    }
+    auto springForces = [&]() {
+        for(Particle<2>& particle: particles) {
+            particle.resetForce();
+            particle.addForce(-particle.getPosition());
+        }
+    };
+    auto energy = [&]() {
+        double result = 0;
+        for(const Particle<2>& particle: particles) {
+            result += 0.5 * particle.getMass() * particle.getVelocity().sq_magnitude() + 0.5 * particle.getPosition().sq_magnitude();
+        }
+        return result;
+    };
+    springForces();
+    integrator.step(particles, COUNT, 0.01, 1, springForces);
+    double start_energy = energy();
+    for(unsigned int step = 0; step < 10000; step++) {
+        integrator.step(particles, COUNT, 0.01, 1, springForces);
+        assert(integrator.hasConverged());
+    }
+    for(const RattleIntegrator<2>::DistanceConstraint& constraint: integrator.getConstraints()) {
+        Vector<double, 2> separation = particles[constraint.first].getPosition() - particles[constraint.second].getPosition();
+        Vector<double, 2> relative = particles[constraint.first].getVelocity() - particles[constraint.second].getVelocity();
+        assert(std::abs(separation.sq_magnitude() - 0.64) < 1e-8);
+        assert(std::abs(separation[0] * relative[0] + separation[1] * relative[1]) < 1e-6);
+    }
+    assert(std::abs(energy() - start_energy) < 1e-2 * start_energy);
+}
+
+/// a free asymmetric body tumbles keeping its shape, its angular momentum and its energy
+void testFreeRigidBody() {
+    const unsigned int COUNT = 4;
+    double positions[COUNT][3] = {{0, 0, 0}, {2, 0, 0}, {0, 1, 0}, {0, 0, 0.5}};
+    double velocities[COUNT][3] = {{0, 0, 0}, {0, 1, 0.3}, {-0.5, 0, 1}, {0.2, -1, 0}};
+    Particle<3> particles[COUNT];
+    for(unsigned int i = 0; i < COUNT; i++) {
+        particles[i] = Particle<3>(i, Vector<double, 3>(positions[i]), Vector<double, 3>(velocities[i]), 1.0 + 0.5 * i);
+    }
+    RattleIntegrator<3> integrator;
+    integrator.addRigidBody(particles, {0, 1, 2, 3});
+    auto noForces = [&]() {
+        for(Particle<3>& particle: particles) {
+            particle.resetForce();
+        }
+    };
+    auto energy = [&]() {
+        double result = 0;
+        for(const Particle<3>& particle: particles) {
+            result += 0.5 * particle.getMass() * particle.getVelocity().sq_magnitude();
+        }
+        return result;
+    };
+    std::vector<double> distances;
+    for(unsigned int i = 0; i < COUNT; i++) {
+        for(unsigned int j = 0; j < i; j++) {
+            distances.push_back((particles[i].getPosition() - particles[j].getPosition()).sq_magnitude());
+        }
+    }
+    noForces();
+    double start_energy = energy();
+    RattleIntegrator<3>::Vector3 start_angular_momentum = integrator.getRigidBodies()[0].angular_momentum;
+    double max_energy_error = 0;
+    for(unsigned int step = 0; step < 5000; step++) {
+        integrator.step(particles, COUNT, 0.01, 1, noForces);
+        max_energy_error = std::max(max_energy_error, std::abs(energy() - start_energy));
+    }
+    assert(max_energy_error < 1e-3 * start_energy);
+    for(unsigned int dim = 0; dim < 3; dim++) {
+        assert(std::abs(integrator.getRigidBodies()[0].angular_momentum[dim] - start_angular_momentum[dim]) < 1e-12);
+    }
+    unsigned int pair = 0;
+    for(unsigned int i = 0; i < COUNT; i++) {
+        for(unsigned int j = 0; j < i; j++) {
+            assert(std::abs((particles[i].getPosition() - particles[j].getPosition()).sq_magnitude() - distances[pair++]) < 1e-9);
+        }
+    }
+}
+
+/// a spinning Lennard-Jones block falls as one piece with a time step ten times the one of a free block,
+/// and keeps its particles when other particles are absorbed
+void testRigidBlockInUniverse() {
+    typedef Universe<2, 200, 40.0, 2.5> BlockUniverse;
+    const unsigned int SIDE = 8;
+    Particle<2> particles[SIDE * SIDE + 4];
+    std::vector<unsigned int> members;
+    for(unsigned int i = 0; i < SIDE * SIDE; i++) {
+        double pos[2] = {16 + (i % SIDE) * 1.0, 20 + (i / SIDE) * 1.0};
+        // spinning around the center of the block
+        double vel[2] = {-(pos[1] - 23.5) * 0.5, (pos[0] - 19.5) * 0.5};
+        particles[i] = Particle<2>(i, Vector<double, 2>(pos), Vector<double, 2>(vel), 1.0);
+        members.push_back(i);
+    }
+    for(unsigned int i = SIDE * SIDE; i < SIDE * SIDE + 4; i++) {
+        // fast particles, soon absorbed
+        double pos[2] = {4.0, 4.0 + i - SIDE * SIDE};
+        double vel[2] = {-100, 0};
+        particles[i] = Particle<2>(i, Vector<double, 2>(pos), Vector<double, 2>(vel), 1.0);
+    }
+    RattleIntegrator<2> integrator;
+    integrator.addRigidBody(particles, members);
+    LennardJonesInteractor<2> interactor;
+    GravityForce<2> gravity(1.0);
+    BlockUniverse universe(particles, SIDE * SIDE + 4);
+    universe.setIntegrator(&integrator);
+    universe.registerInteractor(&interactor);
+    universe.registerForce(&gravity);
+    double start_height = integrator.getRigidBodies()[0].center[1];
+    double start_angular_momentum = integrator.getRigidBodies()[0].angular_momentum[2];
+    double start_distance = (particles[0].getPosition() - particles[SIDE * SIDE - 1].getPosition()).sq_magnitude();
+    const double DELTA_TIME = 0.01;
+    const unsigned int STEPS = 200;
+    for(unsigned int step = 0; step < STEPS; step++) {
+        universe.step(DELTA_TIME);
+    }
+    assert(universe.getActiveCount() == SIDE * SIDE);
+    const RattleIntegrator<2>::RigidBody& body = integrator.getRigidBodies().at(0);
+    double time = STEPS * DELTA_TIME;
+    assert(std::abs(body.center[1] - (start_height - 0.5 * time * time)) < 1e-6);
+    assert(std::abs(body.angular_momentum[2] - start_angular_momentum) < 1e-9);
+    for(unsigned int m = 0; m < SIDE * SIDE; m++) {
+        assert(universe.getParticles()[body.members[m]].getId() == (int)m);
+    }
+    double distance = (universe.getParticles()[body.members[0]].getPosition() - universe.getParticles()[body.members.back()].getPosition()).sq_magnitude();
+    assert(std::abs(distance - start_distance) < 1e-9);
+}
+
+int main() {
+    testDistanceConstraints();
+    testFreeRigidBody();
+    testRigidBlockInUniverse();
+    return 0;
+}
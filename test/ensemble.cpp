@@ -0,0 +1,141 @@
+/// Unit tests for the thread pool and the ensemble runner: every task runs once, nested tasks and nested ensembles
+/// complete, and ensembles give their results in member order.
+#include <cassert>
+#include <cmath>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "quark/parallel/thread_pool.hpp"
+#include "quark/world/ensemble.hpp"
+#include "quark/world/universe.hpp"
+
+/// stand in for a universe, with a clock as its state
+struct Clock {
+    double time = 0;
+    unsigned int steps = 0;
+
+    void step(double delta_time) {
+        this->time += delta_time;
+        this->steps++;
+    }
+};
+
+/// each task runs exactly once, including the tasks submitted by tasks
+void testThreadPool() {
+    ThreadPool pool(4);
+    assert(pool.getThreadCount() == 4);
+    assert(!pool.isWorkerThread());
+    std::vector<std::atomic<int>> runs(1000);
+    for(unsigned int i = 0; i < 100; i++) {
+        pool.submit([&, i]() {
+            assert(pool.isWorkerThread());
+            runs[i]++;
+            for(unsigned int j = 1; j < 10; j++) {
+                pool.submit([&, i, j]() { runs[100 * j + i]++; });
+            }
+        });
+    }
+    pool.wait();
+    for(std::atomic<int>& count: runs) {
+        assert(count == 1);
+    }
+    // a busy worker does not hold back the others: its queued tasks are stolen
+    std::atomic<bool> release = false;
+    std::atomic<int> finished = 0;
+    pool.submit([&]() {
+        for(unsigned int i = 0; i < 20; i++) {
+            pool.submit([&]() { finished++; });
+        }
+        while(!release) {
+            std::this_thread::yield();
+        }
+    });
+    while(finished < 20) {
+        std::this_thread::yield();
+    }
+    release = true;
+    pool.wait();
+}
+
+/// results come back in member order, members stop at their condition, and a second run starts over
+void testEnsemble() {
+    Ensemble<Clock, double> ensemble(16, [](unsigned int member) { return new Clock(); },
+        [](unsigned int member, Clock& clock, unsigned int steps) { return clock.time; }, 3);
+    ensemble.setTimeStep([](unsigned int member) { return 0.5 * (member + 1); });
+    ensemble.setMaxSteps([](unsigned int member) { return 10 + member; });
+    ensemble.setStopCondition([](unsigned int member, Clock& clock, unsigned int step) { return member % 4 == 0 && step == 3; });
+    for(unsigned int run = 0; run < 2; run++) {
+        const std::vector<double>& results = ensemble.run();
+        assert(results.size() == 16);
+        for(unsigned int member = 0; member < 16; member++) {
+            unsigned int steps = member % 4 == 0 ? 3 : 10 + member;
+            assert(ensemble.getStepCounts()[member] == steps);
+            assert(std::abs(results[member] - steps * 0.5 * (member + 1)) < 1e-12);
+        }
+    }
+}
+
+/// boolean results of neighbouring members, packed in the same word of a std::vector<bool>, are all kept
+void testBoolResults() {
+    Ensemble<Clock, bool> ensemble(200, [](unsigned int member) { return new Clock(); },
+        [](unsigned int member, Clock& clock, unsigned int steps) { return member % 3 == 0; }, 8);
+    ensemble.setMaxSteps(1);
+    for(unsigned int run = 0; run < 20; run++) {
+        const std::vector<bool>& results = ensemble.run();
+        for(unsigned int member = 0; member < 200; member++) {
+            assert(results[member] == (member % 3 == 0));
+        }
+    }
+}
+
+/// ensembles run from the tasks of their own pool, even with a single worker, and only wait for their own members
+void testNestedEnsembles() {
+    for(unsigned int thread_count: {1u, 4u}) {
+        ThreadPool pool(thread_count);
+        std::vector<double> totals(6, 0.0);
+        Ensemble<Clock, double>::Factory factory = [](unsigned int member) { return new Clock(); };
+        Ensemble<Clock, double>::Collector collector = [](unsigned int member, Clock& clock, unsigned int steps) { return clock.time; };
+        for(unsigned int outer = 0; outer < 6; outer++) {
+            pool.submit([&, outer]() {
+                Ensemble<Clock, double> ensemble(5, factory, collector, &pool);
+                ensemble.setTimeStep(1.0);
+                ensemble.setMaxSteps(outer + 1);
+                for(double result: ensemble.run()) {
+                    totals[outer] += result;
+                }
+            });
+        }
+        pool.wait();
+        for(unsigned int outer = 0; outer < 6; outer++) {
+            assert(totals[outer] == 5.0 * (outer + 1));
+        }
+    }
+}
+
+/// real universes as members: free particles moving at constant speed
+void testUniverseMembers() {
+    typedef Universe<2, 1, 10.0, 2.5> FreeUniverse;
+    Ensemble<FreeUniverse, double> ensemble(8, [](unsigned int member) {
+            double pos[2] = {1.0, 5.0};
+            double vel[2] = {0.1 * member, 0.0};
+            Particle<2> particles[1] = {Particle<2>(Vector<double, 2>(pos), Vector<double, 2>(vel), Vector<double, 2>(), 1.0)};
+            return new FreeUniverse(particles);
+        },
+        [](unsigned int member, FreeUniverse& universe, unsigned int steps) { return universe.getParticles()[0].getPosition()[0]; }, 2);
+    ensemble.setTimeStep(0.01);
+    ensemble.setMaxSteps(100);
+    const std::vector<double>& results = ensemble.run();
+    for(unsigned int member = 0; member < 8; member++) {
+        assert(std::abs(results[member] - (1.0 + 0.1 * member)) < 1e-9);
+    }
+}
+
+int main() {
+    testThreadPool();
+    testEnsemble();
+    testBoolResults();
+    testNestedEnsembles();
+    testUniverseMembers();
+    return 0;
+}
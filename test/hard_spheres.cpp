@@ -0,0 +1,94 @@
+/// Unit tests for the event driven hard sphere universe: energy and momentum of the collisions, no overlap, particles kept in the box.
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include "quark/world/hard_sphere_universe.hpp"
+#include "quark/world/initializers.hpp"
+
+const unsigned int COUNT = 400;
+const double DIAMETER = 1.0;
+typedef HardSphereUniverse<2, COUNT, 40.0> TestUniverse;
+
+double kineticEnergy(const TestUniverse& universe) {
+    double energy = 0;
+    for(const Particle<2>& particle: universe.getParticles()) {
+        energy += 0.5 * particle.getMass() * particle.getVelocity().sq_magnitude();
+    }
+    return energy;
+}
+
+/// smallest distance between two particles, divided by the diameter
+double closestPair(const TestUniverse& universe) {
+    const std::array<Particle<2>, COUNT>& particles = universe.getParticles();
+    double closest = INFINITY;
+    for(unsigned int i = 0; i < COUNT; i++) {
+        for(unsigned int j = i + 1; j < COUNT; j++) {
+            closest = std::min(closest, (particles[i].getPosition() - particles[j].getPosition()).sq_magnitude());
+        }
+    }
+    return sqrt(closest) / DIAMETER;
+}
+
+void fill(Particle<2>* particles) {
+    // a 20 x 20 lattice with spacing 2 in a box of 40
+    double corner[2] = {1.0, 1.0};
+    unsigned int cells[2] = {20, 20};
+    Initializers::cubic<2>(particles, Vector<double, 2>(corner), Vector<unsigned int, 2>(cells), 2.0);
+    Initializers::maxwellBoltzmann<2>(particles, COUNT, 1.0, 7);
+}
+
+/// elastic collisions keep the energy, and nothing overlaps or leaves the box
+void testElastic() {
+    Particle<2> particles[COUNT];
+    fill(particles);
+    TestUniverse universe(particles, DIAMETER);
+    double energy = kineticEnergy(universe);
+    for(unsigned int step = 0; step < 50; step++) {
+        universe.step(0.2);
+        assert(std::abs(kineticEnergy(universe) - energy) < 1e-9 * energy);
+        assert(closestPair(universe) > 1.0 - 1e-9);
+        for(const Particle<2>& particle: universe.getParticles()) {
+            for(unsigned int dim = 0; dim < 2; dim++) {
+                assert(particle.getPosition()[dim] >= 0.5 - 1e-9 && particle.getPosition()[dim] <= 39.5 + 1e-9);
+            }
+        }
+    }
+    assert(std::abs(universe.getTime() - 10.0) < 1e-9);
+    assert(universe.getCollisionCount() > 1000);
+    printf("%lu collisions, %lu events\n", universe.getCollisionCount(), universe.getEventCount());
+}
+
+/// a head on collision of two different masses, far from the walls, keeps the momentum
+void testMomentum() {
+    Particle<2> particles[2];
+    double pos_a[2] = {10.0, 20.0};
+    double vel_a[2] = {1.0, 0.2};
+    double pos_b[2] = {14.0, 20.5};
+    double vel_b[2] = {-1.0, 0.0};
+    particles[0] = Particle<2>(0, Vector<double, 2>(pos_a), Vector<double, 2>(vel_a), 1.0);
+    particles[1] = Particle<2>(1, Vector<double, 2>(pos_b), Vector<double, 2>(vel_b), 3.0);
+    HardSphereUniverse<2, 2, 40.0> universe(particles, DIAMETER);
+    universe.step(3.0);
+    assert(universe.getCollisionCount() == 1);
+    Vector<double, 2> momentum = universe.getParticles()[0].getVelocity() * 1.0 + universe.getParticles()[1].getVelocity() * 3.0;
+    assert(std::abs(momentum[0] - (1.0 - 3.0)) < 1e-12);
+    assert(std::abs(momentum[1] - 0.2) < 1e-12);
+}
+
+/// inelastic collisions dissipate energy
+void testInelastic() {
+    Particle<2> particles[COUNT];
+    fill(particles);
+    TestUniverse universe(particles, DIAMETER);
+    universe.setRestitution(0.8);
+    double energy = kineticEnergy(universe);
+    universe.step(5.0);
+    assert(kineticEnergy(universe) < 0.9 * energy);
+    assert(closestPair(universe) > 1.0 - 1e-9);
+}
+
+int main() {
+    testElastic();
+    testMomentum();
+    testInelastic();
+}
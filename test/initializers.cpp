@@ -0,0 +1,65 @@
+/// Unit tests for the bulk initializers: counter based generator, lattices and velocity distribution.
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include "quark/world/initializers.hpp"
+
+int main() {
+    // known answers of Philox 4x32-10, from the Random123 test vectors
+    std::array<uint32_t, 4> zero = Philox(0).generate({0, 0, 0, 0});
+    assert(zero[0] == 0x6627e8d5 && zero[1] == 0xe169c58d && zero[2] == 0xbc57ac4c && zero[3] == 0x9b00dbd8);
+    std::array<uint32_t, 4> ones = Philox(0xffffffffffffffff).generate({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff});
+    assert(ones[0] == 0x408f276d && ones[1] == 0x41c83b0e && ones[2] == 0xa20bc7c6 && ones[3] == 0x6d5451fd);
+
+    // random particles do not depend on the thread count
+    const unsigned int COUNT = 100000;
+    std::vector<Particle<3>> single(COUNT);
+    std::vector<Particle<3>> several(COUNT);
+    Vector<double, 3> corner = Vector<double, 3>();
+    Vector<double, 3> size = Vector<double, 3>([]() { return 10.0; });
+    Initializers::uniform<3>(single.data(), COUNT, corner, size, 1234, 1.0, 1);
+    Initializers::uniform<3>(several.data(), COUNT, corner, size, 1234, 1.0, 7);
+    Initializers::maxwellBoltzmann<3>(single.data(), COUNT, 2.0, 99, true, 1);
+    Initializers::maxwellBoltzmann<3>(several.data(), COUNT, 2.0, 99, true, 7);
+    Vector<double, 3> mean = Vector<double, 3>();
+    double energy = 0;
+    for(unsigned int i = 0; i < COUNT; i++) {
+        assert(std::memcmp(&single[i].getPosition(), &several[i].getPosition(), sizeof(Vector<double, 3>)) == 0);
+        assert(std::memcmp(&single[i].getVelocity(), &several[i].getVelocity(), sizeof(Vector<double, 3>)) == 0);
+        for(unsigned int dim = 0; dim < 3; dim++) {
+            assert(0 <= single[i].getPosition()[dim] && single[i].getPosition()[dim] < 10);
+        }
+        mean += single[i].getPosition();
+        energy += 0.5 * single[i].getVelocity().sq_magnitude();
+    }
+    // uniform positions are centered on the box, velocities follow the equipartition: 3/2 kT per particle
+    for(unsigned int dim = 0; dim < 3; dim++) {
+        assert(std::abs(mean[dim] / COUNT - 5) < 0.05);
+    }
+    assert(std::abs(energy / COUNT - 1.5 * 2.0) < 0.05);
+
+    // lattices
+    std::vector<Particle<3>> crystal(4 * 27);
+    unsigned int cells[3] = {3, 3, 3};
+    assert(Initializers::fcc<3>(crystal.data(), corner, Vector<unsigned int, 3>(cells), 2.0) == 4 * 27);
+    // every site of the fcc lattice has 12 nearest neighbours at cell_length / sqrt(2), inside the lattice
+    unsigned int center = 4 * 13;
+    unsigned int neighbours = 0;
+    for(unsigned int i = 0; i < crystal.size(); i++) {
+        if(std::abs((crystal[i].getPosition() - crystal[center].getPosition()).sq_magnitude() - 2.0) < 1e-9) {
+            neighbours++;
+        }
+    }
+    assert(neighbours == 12);
+
+    std::vector<Particle<2>> sheet(6 * 6);
+    unsigned int sheet_cells[2] = {6, 6};
+    Initializers::hexagonal<2>(sheet.data(), Vector<double, 2>(), Vector<unsigned int, 2>(sheet_cells), 1.5);
+    neighbours = 0;
+    for(unsigned int i = 0; i < sheet.size(); i++) {
+        if(std::abs((sheet[i].getPosition() - sheet[3 * 6 + 3].getPosition()).sq_magnitude() - 2.25) < 1e-9) {
+            neighbours++;
+        }
+    }
+    assert(neighbours == 6);
+}
@@ -0,0 +1,69 @@
+/// Unit tests for the integrators: convergence order on a harmonic oscillator, and long run energy behaviour.
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include "quark/world/integrators/stormer_verlet.hpp"
+#include "quark/world/integrators/forest_ruth.hpp"
+#include "quark/world/integrators/runge_kutta.hpp"
+
+/// particles on springs of stiffness 1 towards the origin
+void springForces(Particle<2>* particles, unsigned int count) {
+    for(unsigned int i = 0; i < count; i++) {
+        particles[i].resetForce();
+        particles[i].addForce(-particles[i].getPosition());
+    }
+}
+
+/// integrates x'' = -x / m from x = (1, 0), v = 0, and returns the position error at the end, and the largest energy error on the way
+std::pair<double, double> oscillate(Integrator<2>& integrator, double delta_time, double duration) {
+    const unsigned int COUNT = 3;
+    Particle<2> particles[COUNT];
+    double masses[COUNT] = {1.0, 2.0, 0.5};
+    for(unsigned int i = 0; i < COUNT; i++) {
+        double pos[2] = {1.0, 0.0};
+        particles[i] = Particle<2>(Vector<double, 2>(pos), Vector<double, 2>(), Vector<double, 2>(), masses[i]);
+    }
+    springForces(particles, COUNT);
+    unsigned int steps = (unsigned int)round(duration / delta_time);
+    double energy_error = 0;
+    for(unsigned int step = 0; step < steps; step++) {
+        integrator.step(particles, COUNT, delta_time, 2, [&]() { springForces(particles, COUNT); });
+        for(unsigned int i = 0; i < COUNT; i++) {
+            double energy = 0.5 * masses[i] * particles[i].getVelocity().sq_magnitude() + 0.5 * particles[i].getPosition().sq_magnitude();
+            energy_error = std::max(energy_error, std::abs(energy - 0.5));
+        }
+    }
+    double position_error = 0;
+    for(unsigned int i = 0; i < COUNT; i++) {
+        double omega = sqrt(1.0 / masses[i]);
+        position_error = std::max(position_error, std::abs(particles[i].getPosition()[0] - cos(omega * steps * delta_time)));
+    }
+    return {position_error, energy_error};
+}
+
+/// checks the error falls like dt^order when halving the time step
+void checkOrder(Integrator<2>& integrator, double order) {
+    double coarse = oscillate(integrator, 0.02, 5.0).first;
+    double fine = oscillate(integrator, 0.01, 5.0).first;
+    double measured = log2(coarse / fine);
+    assert(std::abs(measured - order) < 0.3);
+}
+
+int main() {
+    StormerVerletIntegrator<2> stormer_verlet;
+    PositionVerletIntegrator<2> position_verlet;
+    ForestRuthIntegrator<2> forest_ruth;
+    RungeKuttaIntegrator<2> runge_kutta;
+    checkOrder(stormer_verlet, 2);
+    checkOrder(position_verlet, 2);
+    checkOrder(forest_ruth, 4);
+    checkOrder(runge_kutta, 4);
+
+    // symplectic schemes keep the energy bounded over long runs, with an error set by the time step
+    double verlet_energy = oscillate(stormer_verlet, 0.05, 2000.0).second;
+    double forest_ruth_energy = oscillate(forest_ruth, 0.05, 2000.0).second;
+    assert(verlet_energy < 1e-2);
+    assert(forest_ruth_energy < verlet_energy / 100);
+    // better than Verlet with a four times larger time step
+    assert(oscillate(forest_ruth, 0.2, 2000.0).second < verlet_energy);
+}
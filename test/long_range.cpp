@@ -0,0 +1,132 @@
+/// Unit tests for the long range solvers: the fast multipole solver against direct summation, and the particle mesh
+/// solver on one pair, wherever it sits in the box.
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "quark/world/long_range/fmm.hpp"
+#include "quark/world/long_range/particle_mesh.hpp"
+#include "quark/world/long_range/direct_summation.hpp"
+
+/// particles of random masses, spread in the unit cube
+template<unsigned int D>
+std::vector<Particle<D>> generateParticles(unsigned int count) {
+    std::default_random_engine rnd{17};
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+    std::vector<Particle<D>> particles(count);
+    for(unsigned int i = 0; i < count; i++) {
+        Vector<double, D> pos = Vector<double, D>([&]() { return dist(rnd); });
+        particles[i] = Particle<D>(pos, Vector<double, D>(), Vector<double, D>(), 0.5 + dist(rnd));
+    }
+    return particles;
+}
+
+/// relative RMS difference of the forces of the solver with the ones of the direct summation
+template<unsigned int D>
+double forceError(LongRangeSolver<D>& solver, const std::vector<Particle<D>>& reference) {
+    std::vector<Particle<D>> particles = generateParticles<D>(reference.size());
+    solver.addForces(particles.data(), particles.size(), 0.0);
+    double error_sq = 0;
+    double norm_sq = 0;
+    for(unsigned int i = 0; i < reference.size(); i++) {
+        error_sq += (particles[i].getForce() - reference[i].getForce()).sq_magnitude();
+        norm_sq += reference[i].getForce().sq_magnitude();
+    }
+    return std::sqrt(error_sq / norm_sq);
+}
+
+/// the multipole forces and energy converge to the direct ones as the order grows
+template<unsigned int D>
+void testMultipole(double tolerance) {
+    std::vector<Particle<D>> reference = generateParticles<D>(3000);
+    DirectSummationSolver<D> direct(1.0);
+    direct.addForces(reference.data(), reference.size(), 0.0);
+    double previous_error = INFINITY;
+    for(unsigned int order: {2u, 4u, 6u}) {
+        FastMultipoleSolver<D> fmm(1.0, order);
+        double error = forceError<D>(fmm, reference);
+        assert(error < previous_error);
+        previous_error = error;
+        if(order == 6) {
+            assert(error < tolerance);
+            assert(std::abs(fmm.getPotentialEnergy() / direct.getPotentialEnergy() - 1) < tolerance);
+        }
+    }
+}
+
+/// the tree does not hold the periodic images: a periodic box is refused, without any force
+void testPeriodicRefused() {
+    std::vector<Particle<3>> particles = generateParticles<3>(100);
+    FastMultipoleSolver<3> fmm(1.0);
+    fmm.addForces(particles.data(), particles.size(), 1.0);
+    for(const Particle<3>& particle: particles) {
+        assert(particle.getForce()[0] == 0.0 && particle.getForce()[1] == 0.0 && particle.getForce()[2] == 0.0);
+    }
+    assert(fmm.getPotentialEnergy() == 0.0);
+}
+
+/// Potential of the periodic images of a unit mass on a neutralizing background, near the mass, in a unit box:
+/// 1 / r + MADELUNG + 2 pi / 3 r^2, up to terms in r^4.
+const double MADELUNG = -2.837297;
+
+/// a pair in a unit box gets the direct summation force, corrected by the periodic images, at every position on the grid
+void testPair() {
+    const double distance = 0.2;
+    for(ASSIGNMENT_SCHEME scheme: {ASSIGNMENT_SCHEME::cic, ASSIGNMENT_SCHEME::tsc}) {
+        ParticleMeshSolver<3> mesh(1.0, 64, scheme, 2);
+        assert(mesh.isValid());
+        for(double offset: {0.1, 0.33, 0.4771, 0.6, 0.91}) {
+            double first[3] = {offset, 0.5, 0.25 + offset / 2};
+            double second[3] = {offset + distance, 0.5, 0.25 + offset / 2};
+            Particle<3> particles[2] = {
+                Particle<3>(Vector<double, 3>(first), Vector<double, 3>(), Vector<double, 3>(), 1.0),
+                Particle<3>(Vector<double, 3>(second), Vector<double, 3>(), Vector<double, 3>(), 1.0)
+            };
+            Particle<3> direct_particles[2] = {particles[0], particles[1]};
+            DirectSummationSolver<3> direct(1.0);
+            direct.addForces(direct_particles, 2, 0.0);
+            mesh.addForces(particles, 2, 1.0);
+            // the images pull the other way, with the gradient of 2 pi / 3 r^2
+            double expected = direct_particles[0].getForce()[0] - 4 * M_PI / 3 * distance;
+            assert(std::abs(particles[0].getForce()[0] - expected) < 0.01 * expected);
+            assert(std::abs(particles[0].getForce()[0] + particles[1].getForce()[0]) < 1e-9 * expected);
+            assert(std::abs(particles[0].getForce()[1]) < 1e-3 * expected);
+            assert(std::abs(particles[0].getForce()[2]) < 1e-3 * expected);
+            // without the self energy of the particles, only the pair is left
+            double expected_energy = direct.getPotentialEnergy() - MADELUNG - 2 * M_PI / 3 * distance * distance;
+            assert(std::abs(mesh.getPotentialEnergy() - expected_energy) < 0.01 * std::abs(expected_energy));
+        }
+    }
+}
+
+/// the transform only handles powers of two
+void testInvalidGridSize() {
+    ParticleMeshSolver<3> mesh(1.0, 100);
+    assert(!mesh.isValid());
+    double position[3] = {0.5, 0.5, 0.5};
+    Particle<3> particles[1] = {Particle<3>(Vector<double, 3>(position), Vector<double, 3>(), Vector<double, 3>(), 1.0)};
+    mesh.addForces(particles, 1, 1.0);
+    assert(particles[0].getForce().sq_magnitude() == 0.0);
+    assert(mesh.getPotentialEnergy() == 0.0);
+}
+
+/// the grid only solves periodic boxes: an open universe is refused, without any force
+void testOpenRefused() {
+    std::vector<Particle<3>> particles = generateParticles<3>(100);
+    ParticleMeshSolver<3> mesh(1.0, 16);
+    mesh.addForces(particles.data(), particles.size(), 0.0);
+    for(const Particle<3>& particle: particles) {
+        assert(particle.getForce()[0] == 0.0 && particle.getForce()[1] == 0.0 && particle.getForce()[2] == 0.0);
+    }
+    assert(mesh.getPotentialEnergy() == 0.0);
+}
+
+int main() {
+    testMultipole<2>(1e-3);
+    testMultipole<3>(1e-3);
+    testPeriodicRefused();
+    testPair();
+    testInvalidGridSize();
+    testOpenRefused();
+    return 0;
+}
@@ -0,0 +1,113 @@
+/// Unit tests for the NUMA helpers: topology parsing, pinned parallel loops, and the memory report of a universe.
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <thread>
+#include "quark/world/universe.hpp"
+#include "quark/world/interactions/lennard_jones.hpp"
+
+typedef Universe<2, 900, 40.0, 2.5> TestUniverse;
+
+LennardJonesInteractor<2> lj_interactor = LennardJonesInteractor<2>();
+
+TestUniverse* createUniverse() {
+    Particle<2>* particles = new Particle<2>[900];
+    std::default_random_engine rnd{42};
+    std::normal_distribution<double> noise(0.0, 0.5);
+    for(unsigned int i = 0; i < 900; i++) {
+        double pos[2] = {5 + (i % 30) * 1.12, 5 + (i / 30) * 1.12};
+        double vel[2] = {noise(rnd), noise(rnd)};
+        particles[i] = Particle<2>(Vector<double, 2>(pos), Vector<double, 2>(vel), Vector<double, 2>(), 1.0);
+    }
+    TestUniverse* universe = new TestUniverse(particles);
+    delete[] particles;
+    universe->set_border_type(BORDER_TYPE::reflexive);
+    universe->registerInteractor(&lj_interactor);
+    universe->setThreadCount(3);
+    universe->setReproducible(true);
+    return universe;
+}
+
+/// parallel loops leave the affinity of the calling thread alone, a single thread loop included, even when their threads are pinned
+void testCallerAffinity() {
+    cpu_set_t allowed;
+    assert(pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &allowed) == 0);
+    std::vector<int> cpus;
+    for(int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if(CPU_ISSET(cpu, &allowed)) {
+            cpus.push_back(cpu);
+        }
+    }
+    // run from a thread of its own, so the pin does not outlive the test
+    std::thread caller([&]() {
+        assert(pinCurrentThread(cpus.front()));
+        cpu_set_t pinned;
+        assert(pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &pinned) == 0);
+        // the loop threads go to another cpu when there is one
+        threadCpus() = {cpus.back()};
+        std::thread::id caller_id = std::this_thread::get_id();
+        for(unsigned int thread_count: {1u, 3u}) {
+            parallelFor(thread_count, 0, 30, [&](unsigned int begin, unsigned int end, unsigned int thread) {
+                if(std::this_thread::get_id() == caller_id) {
+                    cpu_set_t inside;
+                    assert(pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &inside) == 0);
+                    assert(CPU_EQUAL(&inside, &pinned));
+                }
+            });
+        }
+        threadCpus().clear();
+    });
+    caller.join();
+}
+
+int main() {
+    testCallerAffinity();
+
+    // sysfs lists
+    assert(NumaTopology::parseList("0-3,8,10-11") == std::vector<int>({0, 1, 2, 3, 8, 10, 11}));
+    assert(NumaTopology::parseList("5") == std::vector<int>({5}));
+    assert(NumaTopology::parseList("").empty());
+
+    // every cpu of the policies belongs to a node
+    const NumaTopology& topology = NumaTopology::get();
+    assert(topology.getNodeCount() >= 1);
+    for(AFFINITY affinity: {AFFINITY::compact, AFFINITY::scatter}) {
+        setThreadAffinity(affinity);
+        assert(!threadCpus().empty());
+        for(int cpu: threadCpus()) {
+            assert(topology.getCpuNode(cpu) >= 0);
+        }
+    }
+    setThreadAffinity(AFFINITY::none);
+    assert(threadCpus().empty() && threadNode(0) == -1);
+
+    // pinning does not change the results, and the report covers all the storage
+    TestUniverse* reference = createUniverse();
+    for(unsigned int step = 0; step < 50; step++) {
+        reference->step(0.001);
+    }
+    setThreadAffinity(AFFINITY::compact);
+    TestUniverse* universe = createUniverse();
+    universe->step(0.001);
+    universe->placeMemory();
+    for(unsigned int step = 1; step < 50; step++) {
+        universe->step(0.001);
+    }
+    for(unsigned int i = 0; i < 900; i++) {
+        assert(universe->getParticles()[i].getPosition() == reference->getParticles()[i].getPosition());
+    }
+    NumaReport report = universe->getNumaReport();
+    assert(report.pinned && report.thread_count == 3);
+    assert(report.regions.size() == 3);
+    assert(report.regions[0].pages >= 900 * sizeof(Particle<2>) / pageSize());
+    assert(report.regions[1].pages > 0);
+    assert(report.getRemoteRatio() >= 0.0 && report.getRemoteRatio() <= 1.0);
+    if(topology.getNodeCount() == 1) {
+        assert(report.getRemoteRatio() == 0.0);
+    }
+    report.write(std::cout);
+    setThreadAffinity(AFFINITY::none);
+    delete reference;
+    delete universe;
+}
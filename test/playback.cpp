@@ -0,0 +1,184 @@
+/// Unit tests for the frame sources and the playback driver: reading back recorded frames, and playing them in order,
+/// at any speed, backward and after a seek.
+#include <cassert>
+#include <cmath>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include "quark/world/universe.hpp"
+#include "quark/trajectory/trajectory_writer.hpp"
+#include "quark/trajectory/frame_source.hpp"
+#include "quark/trajectory/playback.hpp"
+#include "quark/visualizer/xml_visualizer.hpp"
+
+const unsigned int PARTICLES = 50;
+const unsigned int FRAMES = 20;
+const char* TRAJECTORY_FILE = "playback_test.qtrj";
+const char* VTU_PREFIX = "playback_test_";
+const int FIRST_ID = 5000;
+
+/// the first particle of a frame sits at x = frame, so the frame can be told from its particles
+std::vector<Particle<2>> generateFrame(unsigned int frame) {
+    std::vector<Particle<2>> particles(PARTICLES);
+    for(unsigned int i = 0; i < PARTICLES; i++) {
+        double pos[2] = {frame + 0.01 * i, 0.5 * i};
+        double vel[2] = {1.0, -0.1 * i};
+        particles[i] = Particle<2>(FIRST_ID + 2 * i, Vector<double, 2>(pos), Vector<double, 2>(vel), i % 2 ? 1.0 : 2.0);
+    }
+    return particles;
+}
+
+void checkFrame(const std::vector<Particle<2>>& read, unsigned int frame, double precision) {
+    std::vector<Particle<2>> expected = generateFrame(frame);
+    assert(read.size() == expected.size());
+    for(unsigned int i = 0; i < PARTICLES; i++) {
+        for(unsigned int dim = 0; dim < 2; dim++) {
+            assert(std::abs(read[i].getPosition()[dim] - expected[i].getPosition()[dim]) <= precision);
+            assert(std::abs(read[i].getVelocity()[dim] - expected[i].getVelocity()[dim]) <= precision);
+        }
+        assert(read[i].getMass() == expected[i].getMass());
+        assert(read[i].getId() == expected[i].getId());
+    }
+}
+
+/// the particles of a frame, as the visualizers see a universe
+struct RecordedFrame {
+    std::vector<Particle<2>> particles;
+
+    const std::vector<Particle<2>>& getParticles() const {
+        return this->particles;
+    }
+};
+
+/// source reading slower than the playback, and checking it is never read by two threads at once
+class SlowFrameSource : public FrameSource<2> {
+    private:
+    FrameSource<2>* source;
+    std::atomic<int> readers = 0;
+
+    public:
+    SlowFrameSource(FrameSource<2>* source) : source(source) {}
+
+    unsigned int getFrameCount() override {
+        return this->source->getFrameCount();
+    }
+
+    bool readFrame(unsigned int frame, std::vector<Particle<2>>& particles) override {
+        assert(this->readers.fetch_add(1) == 0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        bool success = this->source->readFrame(frame, particles);
+        this->readers.fetch_sub(1);
+        return success;
+    }
+};
+
+/// records the frames a playback shows
+class FrameRecorder : public Visualizer<Playback<2>> {
+    public:
+    std::vector<unsigned int> frames;
+
+    void draw(Playback<2>* playback) override {
+        this->frames.push_back(playback->getFrame());
+        checkFrame(playback->getParticles(), playback->getFrame(), 1e-4);
+    }
+};
+
+void writeRecordings() {
+    TrajectoryWriter<2> writer(TRAJECTORY_FILE, 1e-5, 1e-5, 8);
+    RecordedFrame recorded;
+    // the files hold the particles of the frame, whatever count the visualizer was built with
+    XMLVisualizer<RecordedFrame> xml_visualizer(PARTICLES + 10, 0, 2, VTU_PREFIX);
+    for(unsigned int frame = 0; frame < FRAMES; frame++) {
+        std::vector<Particle<2>> particles = generateFrame(frame);
+        writer.writeFrame(particles.data(), particles.size());
+        if(frame < 5) {
+            recorded.particles = particles;
+            xml_visualizer.draw(&recorded);
+        }
+    }
+    writer.close();
+}
+
+/// both sources give the frames back, in any order, and refuse the frames past the end
+void testFrameSources() {
+    TrajectoryFrameSource<2> trajectory(TRAJECTORY_FILE);
+    VTUFrameSource<2> vtu(VTU_PREFIX);
+    assert(trajectory.getFrameCount() == FRAMES);
+    assert(vtu.getFrameCount() == 5);
+    std::vector<Particle<2>> particles;
+    for(unsigned int frame: {7u, 0u, 19u, 8u}) {
+        assert(trajectory.readFrame(frame, particles));
+        checkFrame(particles, frame, 1e-5);
+    }
+    for(unsigned int frame: {3u, 0u, 4u}) {
+        assert(vtu.readFrame(frame, particles));
+        // the files are written with 6 significant digits
+        checkFrame(particles, frame, 1e-4);
+    }
+    assert(!trajectory.readFrame(FRAMES, particles));
+    assert(!vtu.readFrame(5, particles));
+    // the ids read back are never given to new particles
+    Particle<2> created(Vector<double, 2>(), Vector<double, 2>(), Vector<double, 2>(), 1.0);
+    assert(created.getId() > FIRST_ID + 2 * (int)(PARTICLES - 1));
+}
+
+/// the playback shows the frames under the playhead in order, waiting for the slow source, until it leaves the recording
+void testPlayback() {
+    TrajectoryFrameSource<2> trajectory(TRAJECTORY_FILE);
+    SlowFrameSource source(&trajectory);
+    {
+        Playback<2> playback(&source, 4);
+        FrameRecorder recorder;
+        playback.registerVisualizer(&recorder);
+        assert(playback.getFrameCount() == FRAMES);
+        while(playback.step()) {}
+        assert(recorder.frames.size() == FRAMES);
+        for(unsigned int frame = 0; frame < FRAMES; frame++) {
+            assert(recorder.frames[frame] == frame);
+        }
+    }
+    {
+        // the playhead moves by the speed, and shows the frame it is on
+        Playback<2> playback(&source);
+        FrameRecorder recorder;
+        playback.registerVisualizer(&recorder);
+        playback.setSpeed(2.5);
+        while(playback.step()) {}
+        std::vector<unsigned int> expected = {0, 2, 5, 7, 10, 12, 15, 17};
+        assert(recorder.frames == expected);
+    }
+    {
+        // backward from the end, then forward again from a seek
+        Playback<2> playback(&source);
+        FrameRecorder recorder;
+        playback.registerVisualizer(&recorder);
+        playback.seek(FRAMES + 10);
+        playback.setSpeed(-3);
+        for(unsigned int step = 0; step < 3; step++) {
+            assert(playback.step());
+        }
+        playback.seek(4);
+        playback.setSpeed(0.5);
+        assert(playback.step());
+        assert(playback.step());
+        assert(playback.step());
+        playback.setSpeed(-6);
+        assert(playback.step());
+        assert(!playback.step());
+        std::vector<unsigned int> expected = {19, 16, 13, 4, 4, 5, 5};
+        assert(recorder.frames == expected);
+    }
+}
+
+int main() {
+    writeRecordings();
+    testFrameSources();
+    testPlayback();
+    std::remove(TRAJECTORY_FILE);
+    for(unsigned int frame = 0; frame < 5; frame++) {
+        std::remove((VTU_PREFIX + std::to_string(frame) + ".vtu").c_str());
+    }
+    return 0;
+}
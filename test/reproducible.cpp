@@ -0,0 +1,87 @@
+/// Unit tests for the reproducible parallel mode: the trajectory must not depend on the thread count.
+#include <cassert>
+#include <cstring>
+#include <random>
+#include "quark/world/universe.hpp"
+#include "quark/world/interactions/lennard_jones.hpp"
+
+typedef Universe<2, 900, 40.0, 2.5> TestUniverse;
+
+LennardJonesInteractor<2> lj_interactor = LennardJonesInteractor<2>();
+
+/// a warm square crystal, always the same
+TestUniverse* createUniverse(unsigned int thread_count, bool reproducible) {
+    Particle<2>* particles = new Particle<2>[900];
+    std::default_random_engine rnd{42};
+    std::normal_distribution<double> noise(0.0, 0.5);
+    for(unsigned int i = 0; i < 900; i++) {
+        double pos[2] = {5 + (i % 30) * 1.12, 5 + (i / 30) * 1.12};
+        double vel[2] = {noise(rnd), noise(rnd)};
+        particles[i] = Particle<2>(Vector<double, 2>(pos), Vector<double, 2>(vel), Vector<double, 2>(), 1.0);
+    }
+    TestUniverse* universe = new TestUniverse(particles);
+    delete[] particles;
+    universe->set_border_type(BORDER_TYPE::reflexive);
+    universe->registerInteractor(&lj_interactor);
+    universe->setThreadCount(thread_count);
+    universe->setReproducible(reproducible);
+    return universe;
+}
+
+bool sameBits(double a, double b) {
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+int main() {
+    // the fixed order sum does not depend on the thread count
+    std::vector<double> terms(10000);
+    std::default_random_engine rnd{7};
+    std::uniform_real_distribution<double> dist(-1e6, 1e6);
+    for(double& term: terms) {
+        term = dist(rnd);
+    }
+    double reference_sum = deterministicSum<double>(1, terms.size(), [&](unsigned int i) { return terms[i]; });
+    for(unsigned int threads: {2, 3, 8, 64}) {
+        assert(sameBits(reference_sum, deterministicSum<double>(threads, terms.size(), [&](unsigned int i) { return terms[i]; })));
+    }
+
+    // the same run on 1 and on several threads gives the same trajectory, bit for bit
+    TestUniverse* reference = createUniverse(1, true);
+    for(unsigned int threads: {2, 5, 16}) {
+        TestUniverse* universe = createUniverse(threads, true);
+        if(threads == 2) {
+            for(unsigned int step = 0; step < 200; step++) {
+                reference->step(0.001);
+            }
+        }
+        for(unsigned int step = 0; step < 200; step++) {
+            universe->step(0.001);
+        }
+        auto expected = reference->getParticles();
+        auto particles = universe->getParticles();
+        for(unsigned int i = 0; i < 900; i++) {
+            for(unsigned int dim = 0; dim < 2; dim++) {
+                assert(sameBits(expected[i].getPosition()[dim], particles[i].getPosition()[dim]));
+                assert(sameBits(expected[i].getVelocity()[dim], particles[i].getVelocity()[dim]));
+            }
+        }
+        assert(sameBits(reference->getCineticEnergy(), universe->getCineticEnergy()));
+        delete universe;
+    }
+
+    // the fast parallel pass computes the same forces, up to rounding
+    TestUniverse* fast = createUniverse(4, false);
+    TestUniverse* sequential = createUniverse(1, false);
+    for(unsigned int step = 0; step < 10; step++) {
+        fast->step(0.001);
+        sequential->step(0.001);
+    }
+    auto expected = sequential->getParticles();
+    auto particles = fast->getParticles();
+    for(unsigned int i = 0; i < 900; i++) {
+        assert((expected[i].getPosition() - particles[i].getPosition()).sq_magnitude() < 1e-16);
+    }
+    delete fast;
+    delete sequential;
+    delete reference;
+}
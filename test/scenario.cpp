@@ -0,0 +1,201 @@
+/// Unit tests for the scenario files: the header and the particles go through a file unchanged,
+/// and the universe created from a scenario steps like the one built by hand.
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include "quark/scenario/scenario.hpp"
+
+const unsigned int COUNT = 1000;
+typedef Universe<2, 2 * COUNT, 60.0, 2.5> TestUniverse;
+
+ScenarioSettings createSettings() {
+    ScenarioSettings settings;
+    settings.length = 60.0;
+    settings.cut = 2.5;
+    settings.border = BORDER_TYPE::reflexive;
+    settings.thread_count = 2;
+    settings.time_step = 0.0005;
+    settings.steps = 50;
+    settings.wall = {"harmonic", "100", "0.5"};
+    settings.integrator = {"forest_ruth"};
+    settings.interactors = {{"lennard_jones", "1.0", "0.5"}};
+    settings.forces = {{"gravity", "9.81"}};
+    settings.outputs = {{"trajectory", "out.qtrj"}};
+    return settings;
+}
+
+/// a warm crystal, as the demos build them
+void createParticles(Particle<2>* particles) {
+    double corner[2] = {10.0, 10.0};
+    unsigned int cells[2] = {40, 25};
+    Initializers::cubic<2>(particles, Vector<double, 2>(corner), Vector<unsigned int, 2>(cells), 1.12);
+    Initializers::maxwellBoltzmann<2>(particles, COUNT, 0.1, 3);
+}
+
+void testRoundTrip() {
+    Particle<2> particles[COUNT];
+    createParticles(particles);
+    const char* file_name = "scenario_test.qsc";
+    assert(Scenario<2>::write(file_name, createSettings(), particles, COUNT));
+
+    Scenario<2> scenario(file_name);
+    assert(scenario.isOpen());
+    const ScenarioSettings& settings = scenario.getSettings();
+    assert(settings.length == 60.0 && settings.cut == 2.5);
+    assert(settings.border == BORDER_TYPE::reflexive);
+    assert(settings.time_step == 0.0005 && settings.steps == 50);
+    assert(settings.integrator == createSettings().integrator);
+    assert(settings.interactors == createSettings().interactors);
+    assert(settings.outputs == createSettings().outputs);
+    assert(scenario.getParticleCount() == COUNT);
+
+    Particle<2> loaded[COUNT];
+    assert(scenario.readParticles(loaded, COUNT, 3) == COUNT);
+    for(unsigned int i = 0; i < COUNT; i++) {
+        assert(loaded[i].getId() == particles[i].getId());
+        assert(loaded[i].getPosition() == particles[i].getPosition());
+        assert(loaded[i].getVelocity() == particles[i].getVelocity());
+        assert(loaded[i].getMass() == particles[i].getMass());
+    }
+
+    // the same physics, by hand
+    TestUniverse* universe = scenario.createUniverse<2 * COUNT, 60.0, 2.5>();
+    assert(universe != nullptr);
+    assert(universe->getActiveCount() == COUNT);
+    TestUniverse reference(particles, COUNT);
+    LennardJonesInteractor<2> lj_interactor(1.0, 0.5);
+    GravityForce<2> gravity(9.81);
+    HarmonicWall wall(100, 0.5);
+    ForestRuthIntegrator<2> integrator;
+    reference.setThreadCount(2);
+    reference.set_border_type(BORDER_TYPE::reflexive);
+    reference.setWall(&wall);
+    reference.setIntegrator(&integrator);
+    reference.registerInteractor(&lj_interactor);
+    reference.registerForce(&gravity);
+    for(unsigned int step = 0; step < settings.steps; step++) {
+        universe->step(settings.time_step);
+        reference.step(settings.time_step);
+    }
+    for(unsigned int i = 0; i < COUNT; i++) {
+        Vector<double, 2> difference = universe->getParticles()[i].getPosition() - reference.getParticles()[i].getPosition();
+        assert(difference.sq_magnitude() < 1e-20);
+    }
+    delete universe;
+
+    // a universe of another length does not fit
+    assert((scenario.createUniverse<2 * COUNT, 50.0, 2.5>() == nullptr));
+    std::remove(file_name);
+}
+
+/// hand edited headers: comments are skipped, unknown settings and truncated files are refused
+void testHeaders() {
+    const char* file_name = "scenario_header_test.qsc";
+    {
+        std::ofstream file(file_name);
+        file << "quark-scenario 1\n# a comment\n\ndimension 2\nlength 60\ncut 2.5\ninteractor gravity\nparticles 0\nend\n";
+    }
+    Scenario<2> valid(file_name);
+    assert(valid.isOpen());
+    assert(valid.getParticleCount() == 0);
+    TestUniverse* universe = valid.createUniverse<2 * COUNT, 60.0, 2.5>();
+    assert(universe != nullptr && universe->getActiveCount() == 0);
+    delete universe;
+    // the dimension does not match
+    Scenario<3> other(file_name);
+    assert(!other.isOpen());
+    {
+        std::ofstream file(file_name);
+        file << "quark-scenario 1\nlength sixty\nend\n";
+    }
+    assert(!Scenario<2>(file_name).isOpen());
+    {
+        std::ofstream file(file_name);
+        file << "quark-scenario 1\ndimension 2\nparticles 10\nend\n";
+    }
+    assert(!Scenario<2>(file_name).isOpen());
+    {
+        std::ofstream file(file_name);
+        file << "quark-scenario 1\ndimension 2\nlength 60\ncut 2.5\ninteractor coulomb\nparticles 0\nend\n";
+    }
+    Scenario<2> unknown(file_name);
+    assert(unknown.isOpen());
+    assert((unknown.createUniverse<2 * COUNT, 60.0, 2.5>() == nullptr));
+    std::remove(file_name);
+    assert(!Scenario<2>(file_name).isOpen());
+}
+
+/// the particle block is found from the end of the file, whatever the header became, and the ids it holds are reserved
+void testEditedHeader() {
+    const char* file_name = "scenario_edit_test.qsc";
+    const int FIRST_ID = Particle<2>::reserveIds(0) + 1000000;
+    Particle<2> particles[100];
+    for(unsigned int i = 0; i < 100; i++) {
+        double position[2] = {1.0 + i * 0.5, 3.0};
+        double velocity[2] = {0.1 * i, -0.2};
+        particles[i] = Particle<2>(FIRST_ID + i, Vector<double, 2>(position), Vector<double, 2>(velocity), 1.0 + i);
+    }
+    assert(Scenario<2>::write(file_name, createSettings(), particles, 100));
+    std::string content;
+    {
+        std::ifstream file(file_name, std::ios::binary);
+        content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    size_t end_line = content.find("\nend\n") + 1;
+    std::string header = content.substr(0, end_line);
+    std::string rest = content.substr(end_line + 4);
+    auto rewrite = [&](const std::string& text) {
+        std::ofstream file(file_name, std::ios::binary);
+        file << text;
+    };
+    auto checkParticles = [&](Scenario<2>& scenario) {
+        assert(scenario.isOpen());
+        Particle<2> loaded[100];
+        assert(scenario.readParticles(loaded, 100, 2) == 100);
+        for(unsigned int i = 0; i < 100; i++) {
+            assert(loaded[i].getId() == particles[i].getId());
+            assert(loaded[i].getPosition() == particles[i].getPosition());
+            assert(loaded[i].getVelocity() == particles[i].getVelocity());
+            assert(loaded[i].getMass() == particles[i].getMass());
+        }
+    };
+    // a longer header, with an indented end line without its new line, right before the block
+    size_t magic_end = header.find('\n') + 1;
+    rewrite(header.substr(0, magic_end) + "# a comment longer than the padding " + std::string(100, '-') + "\n" + header.substr(magic_end) + "  end" + rest);
+    {
+        Scenario<2> scenario(file_name);
+        checkParticles(scenario);
+        // particles created after the loaded ones get new ids
+        assert(Particle<2>::reserveIds(1) >= FIRST_ID + 100);
+    }
+    // a shorter header, with windows line endings
+    std::string short_header;
+    for(char c: header.substr(header.find("dimension"))) {
+        short_header += c == '\n' ? std::string("\r\n") : std::string(1, c);
+    }
+    rewrite("quark-scenario 1\r\n" + short_header + "end\r\n" + rest);
+    {
+        Scenario<2> scenario(file_name);
+        checkParticles(scenario);
+    }
+    // fewer particles than in the block, more, and no end line
+    size_t count_line = header.find("particles 100");
+    assert(count_line != std::string::npos);
+    rewrite(header.substr(0, count_line) + "particles 99" + header.substr(count_line + 13) + "end\n" + rest);
+    assert(!Scenario<2>(file_name).isOpen());
+    rewrite(header.substr(0, count_line) + "particles 101" + header.substr(count_line + 13) + "end\n" + rest);
+    assert(!Scenario<2>(file_name).isOpen());
+    rewrite(header);
+    assert(!Scenario<2>(file_name).isOpen());
+    rewrite(header + "ending\n");
+    assert(!Scenario<2>(file_name).isOpen());
+    std::remove(file_name);
+}
+
+int main() {
+    testRoundTrip();
+    testHeaders();
+    testEditedHeader();
+    return 0;
+}
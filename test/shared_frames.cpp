@@ -0,0 +1,162 @@
+/// Unit tests for the shared memory frames: round trip, dropped frames, torn frames, and a writer created again.
+#include <cassert>
+#include <thread>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "quark/world/universe.hpp"
+#include "quark/visualizer/shared_memory_visualizer.hpp"
+#include "quark/visualizer/shared_memory/shared_frame_reader.hpp"
+
+/// a segment name of its own, so runs of the test do not see each other
+std::string segmentName(const char* test) {
+    return "/quark-test-" + std::string(test) + "-" + std::to_string(getpid());
+}
+
+/// ids of the particles of the frames, above any id given in this process
+const int FIRST_ID = 1000000;
+
+/// count particles whose coordinates all give the frame number
+std::vector<Particle<2>> makeFrame(unsigned int frame, unsigned int count) {
+    std::vector<Particle<2>> particles(count);
+    for(unsigned int i = 0; i < count; i++) {
+        double pos[2] = {(double)frame, (double)i};
+        double vel[2] = {(double)frame, -(double)frame};
+        particles[i] = Particle<2>(FIRST_ID + i, Vector<double, 2>(pos), Vector<double, 2>(vel), 1.0 + frame);
+    }
+    return particles;
+}
+
+/// the reader gets the latest frame only, and waits for a writer that does not exist yet
+void testRoundTrip() {
+    std::string name = segmentName("round-trip");
+    SharedFrameReader<2> reader(name);
+    assert(!reader.isAttached());
+    assert(!reader.update());
+    SharedFrameWriter<2> writer(name, 100);
+    assert(writer.isOpen());
+    assert(!reader.update());
+    for(unsigned int frame = 1; frame <= 5; frame++) {
+        std::vector<Particle<2>> particles = makeFrame(frame, 10 * frame);
+        writer.writeFrame(particles.data(), particles.size(), 0.5 * frame);
+    }
+    assert(reader.update());
+    assert(reader.isAttached());
+    assert(reader.getFrame() == 5);
+    assert(reader.getTime() == 2.5);
+    assert(reader.getParticles().size() == 50);
+    for(unsigned int i = 0; i < 50; i++) {
+        const Particle<2>& particle = reader.getParticles()[i];
+        assert(particle.getId() == FIRST_ID + (int)i);
+        assert(particle.getPosition()[0] == 5 && particle.getPosition()[1] == i);
+        assert(particle.getVelocity()[1] == -5);
+        assert(particle.getMass() == 6);
+    }
+    // the ids read are never given to new particles
+    Particle<2> created(Vector<double, 2>(), Vector<double, 2>(), Vector<double, 2>(), 1.0);
+    assert(created.getId() > FIRST_ID + 49);
+    // nothing new
+    assert(!reader.update());
+    std::vector<Particle<2>> particles = makeFrame(8, 20);
+    writer.writeFrame(particles.data(), particles.size());
+    writer.writeFrame(particles.data(), particles.size());
+    assert(reader.update());
+    assert(reader.getFrame() == 7);
+    assert(reader.getDroppedFrameCount() == 1);
+    // frames larger than the segment are cut
+    particles = makeFrame(9, 150);
+    writer.writeFrame(particles.data(), particles.size());
+    assert(reader.update());
+    assert(reader.getParticles().size() == 100);
+}
+
+/// a reader racing a fast writer only ever keeps whole frames
+void testTornFrames() {
+    std::string name = segmentName("torn");
+    SharedFrameWriter<2> writer(name, 2000, 2);
+    std::atomic<bool> done = false;
+    std::thread producer([&]() {
+        std::vector<Particle<2>> particles = makeFrame(0, 2000);
+        for(unsigned int frame = 1; frame <= 3000; frame++) {
+            for(Particle<2>& particle: particles) {
+                double pos[2] = {(double)frame, particle.getPosition()[1]};
+                particle.setPosition(Vector<double, 2>(pos));
+            }
+            writer.writeFrame(particles.data(), particles.size());
+        }
+        done = true;
+    });
+    SharedFrameReader<2> reader(name);
+    unsigned int frames = 0;
+    while(!done) {
+        if(reader.update()) {
+            frames++;
+            for(const Particle<2>& particle: reader.getParticles()) {
+                assert(particle.getPosition()[0] == reader.getFrame());
+            }
+        }
+    }
+    producer.join();
+    assert(reader.update() || reader.getFrame() == 3000);
+    assert(reader.getFrame() == 3000);
+    assert(frames > 0);
+}
+
+/// the reader leaves a closed writer, and follows the next one under the same name
+void testReattach() {
+    std::string name = segmentName("reattach");
+    SharedFrameReader<2> reader(name);
+    {
+        SharedFrameWriter<2> writer(name, 10);
+        std::vector<Particle<2>> particles = makeFrame(1, 10);
+        writer.writeFrame(particles.data(), particles.size());
+        writer.writeFrame(particles.data(), particles.size());
+        assert(reader.update());
+        assert(reader.getFrame() == 2);
+    }
+    assert(!reader.update());
+    assert(!reader.isAttached());
+    // the last frame is kept while there is no writer
+    assert(reader.getParticles().size() == 10);
+    SharedFrameWriter<2> writer(name, 10);
+    std::vector<Particle<2>> particles = makeFrame(3, 4);
+    writer.writeFrame(particles.data(), particles.size());
+    assert(reader.update());
+    assert(reader.getFrame() == 1);
+    assert(reader.getParticles().size() == 4);
+}
+
+/// the visualizer publishes the particles and the time of a universe
+void testVisualizer() {
+    typedef Universe<2, 50, 20.0, 2.5> TestUniverse;
+    std::string name = segmentName("visualizer");
+    std::vector<Particle<2>> particles(50);
+    for(unsigned int i = 0; i < 50; i++) {
+        double pos[2] = {1.0 + (i % 10) * 1.5, 1.0 + (i / 10) * 1.5};
+        particles[i] = Particle<2>(i, Vector<double, 2>(pos), Vector<double, 2>(), 1.0);
+    }
+    TestUniverse universe(particles.data(), particles.size());
+    SharedMemoryVisualizer<TestUniverse> visualizer(name, 50);
+    visualizer.setMaxFrameRate(0);
+    universe.registerVisualizer(&visualizer);
+    SharedFrameReader<2> reader(name);
+    for(unsigned int step = 0; step < 3; step++) {
+        universe.step(0.01);
+    }
+    assert(visualizer.getFrameCount() == 3);
+    assert(reader.update());
+    assert(std::abs(reader.getTime() - 0.03) < 1e-12);
+    assert(reader.getParticles().size() == universe.getActiveCount());
+    for(unsigned int i = 0; i < universe.getActiveCount(); i++) {
+        assert(reader.getParticles()[i].getPosition() == universe.getParticles()[i].getPosition());
+    }
+}
+
+int main() {
+    testRoundTrip();
+    testTornFrames();
+    testReattach();
+    testVisualizer();
+    return 0;
+}
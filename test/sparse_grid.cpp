@@ -0,0 +1,128 @@
+/// Unit tests for the sparse grid of chunks: same forces as the dense grid, and a dilute universe far too large for the dense one.
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "quark/world/universe.hpp"
+#include "quark/world/interactions/lennard_jones.hpp"
+
+LennardJonesInteractor<2> lj_interactor_2d = LennardJonesInteractor<2>();
+LennardJonesInteractor<3> lj_interactor_3d = LennardJonesInteractor<3>();
+
+/// the map finds every key it was given, and nothing else
+void testChunkMap() {
+    ChunkMap map;
+    for(unsigned int i = 0; i < 10000; i++) {
+        map.insert((uint64_t)i * 7919, i);
+    }
+    assert(map.size() == 10000);
+    for(unsigned int i = 0; i < 10000; i++) {
+        assert(map.find((uint64_t)i * 7919) == (int)i);
+        assert(map.find((uint64_t)i * 7919 + 1) == -1);
+    }
+    map.clear();
+    assert(map.find(0) == -1);
+}
+
+/// a warm crystal in the middle of the universe gives the same trajectory on both grids
+void testSameTrajectory() {
+    typedef Universe<2, 400, 40.0, 2.5> TestUniverse;
+    Particle<2> particles[400];
+    std::default_random_engine rnd{3};
+    std::normal_distribution<double> noise(0.0, 0.5);
+    for(unsigned int i = 0; i < 400; i++) {
+        double pos[2] = {8 + (i % 20) * 1.12, 8 + (i / 20) * 1.12};
+        double vel[2] = {noise(rnd), noise(rnd)};
+        particles[i] = Particle<2>(Vector<double, 2>(pos), Vector<double, 2>(vel), Vector<double, 2>(), 1.0);
+    }
+    TestUniverse dense(particles);
+    TestUniverse sparse(particles);
+    sparse.setGridType(GRID_TYPE::sparse);
+    assert(dense.getGridType() == GRID_TYPE::dense);
+    assert(dense.getChunkCount() == 256);
+    assert(sparse.getChunkCount() < 256);
+    for(TestUniverse* universe: {&dense, &sparse}) {
+        universe->set_border_type(BORDER_TYPE::reflexive);
+        universe->registerInteractor(&lj_interactor_2d);
+    }
+    for(unsigned int step = 0; step < 200; step++) {
+        dense.step(0.001);
+        sparse.step(0.001);
+    }
+    for(unsigned int i = 0; i < 400; i++) {
+        Vector<double, 2> difference = dense.getParticles()[i].getPosition() - sparse.getParticles()[i].getPosition();
+        assert(difference.sq_magnitude() < 1e-18);
+    }
+}
+
+/// pairs of particles scattered in a 3D universe of 6.4e13 chunks: only the occupied ones exist
+void testDilute() {
+    typedef Universe<3, 200, 100000.0, 2.5> DiluteUniverse;
+    Particle<3> particles[200];
+    std::default_random_engine rnd{5};
+    std::uniform_real_distribution<double> place(10.0, 99990.0);
+    for(unsigned int i = 0; i < 200; i += 2) {
+        double pos[3] = {place(rnd), place(rnd), place(rnd)};
+        particles[i] = Particle<3>(Vector<double, 3>(pos), Vector<double, 3>(), Vector<double, 3>(), 1.0);
+        // a close neighbour, pushed away by the Lennard-Jones repulsion
+        pos[0] += 0.9;
+        particles[i + 1] = Particle<3>(Vector<double, 3>(pos), Vector<double, 3>(), Vector<double, 3>(), 1.0);
+    }
+    DiluteUniverse universe(particles);
+    assert(universe.getGridType() == GRID_TYPE::sparse);
+    assert(universe.getChunkCount() <= 200);
+    universe.registerInteractor(&lj_interactor_3d);
+    for(unsigned int step = 0; step < 100; step++) {
+        universe.step(0.001);
+    }
+    for(unsigned int i = 0; i < 200; i += 2) {
+        double gap = universe.getParticles()[i + 1].getPosition()[0] - universe.getParticles()[i].getPosition()[0];
+        assert(gap > 0.95);
+        // the momentum of each pair is kept
+        assert(std::abs(universe.getParticles()[i].getVelocity()[0] + universe.getParticles()[i + 1].getVelocity()[0]) < 1e-9);
+    }
+    // the chunks left empty are dropped along the way
+    assert(universe.getChunkCount() <= 2 * 200 + 27);
+}
+
+/// visiting the chunks of a box gives the particles inside it, on both grids, and the faces keep the particles beyond them
+void testVisitChunks() {
+    typedef Universe<2, 400, 40.0, 2.5> TestUniverse;
+    Particle<2> particles[400];
+    std::default_random_engine rnd{5};
+    std::uniform_real_distribution<double> position(0.0, 40.0);
+    for(unsigned int i = 0; i < 400; i++) {
+        double pos[2] = {position(rnd), position(rnd)};
+        particles[i] = Particle<2>(Vector<double, 2>(pos), Vector<double, 2>(), Vector<double, 2>(), 1.0);
+    }
+    TestUniverse dense(particles);
+    TestUniverse sparse(particles);
+    sparse.setGridType(GRID_TYPE::sparse);
+    double low[2] = {11.0, -5.0};
+    double high[2] = {19.0, 12.0};
+    for(TestUniverse* universe: {&dense, &sparse}) {
+        std::vector<bool> visited(400, false);
+        universe->visitChunks(Vector<double, 2>(low), Vector<double, 2>(high), [&](UniverseChunk<2>& chunk) {
+            for(auto part = chunk.getParticleBegin(); part != chunk.getParticleEnd(); ++part) {
+                assert(!visited[*part]);
+                visited[*part] = true;
+            }
+        });
+        for(unsigned int i = 0; i < 400; i++) {
+            const Vector<double, 2>& pos = universe->getParticles()[i].getPosition();
+            // chunks are 2.5 wide: the box is widened to the chunks it overlaps
+            bool inside = pos[0] >= 10.0 && pos[0] < 20.0 && pos[1] < 12.5;
+            assert(visited[i] == inside);
+        }
+        unsigned int visits = 0;
+        universe->visitChunks(Vector<double, 2>(high), Vector<double, 2>(low), [&](UniverseChunk<2>& chunk) { visits++; });
+        assert(visits == 0);
+    }
+}
+
+int main() {
+    testChunkMap();
+    testSameTrajectory();
+    testDilute();
+    testVisitChunks();
+}
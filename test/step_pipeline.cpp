@@ -0,0 +1,93 @@
+/// Unit tests for the step pipeline: snapshots reach every consumer in order, match the universe, and slow consumers hold the simulation back.
+#include <cassert>
+#include <map>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <future>
+#include "quark/world/universe.hpp"
+#include "quark/world/step_pipeline.hpp"
+#include "quark/world/interactions/lennard_jones.hpp"
+
+typedef Universe<2, 100, 20.0, 2.5> TestUniverse;
+
+/// records the first particle of each snapshot. A gated consumer holds its first snapshot until it is released.
+class RecordingConsumer : public Visualizer<Snapshot<2>> {
+    public:
+    std::map<unsigned long, Vector<double, 2>> positions;
+    std::vector<unsigned long> steps;
+    std::mutex mutex;
+    std::shared_future<void> gate;
+
+    RecordingConsumer() = default;
+    RecordingConsumer(std::shared_future<void> gate) : gate(gate) {}
+
+    void draw(Snapshot<2>* snapshot) override {
+        if(this->gate.valid()) {
+            this->gate.wait();
+        }
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->steps.push_back(snapshot->getStep());
+        this->positions[snapshot->getStep()] = snapshot->getParticles()[0].getPosition();
+    }
+
+    unsigned long getLastStep() {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return this->steps.empty() ? 0 : this->steps.back();
+    }
+};
+
+int main() {
+    LennardJonesInteractor<2> lj_interactor = LennardJonesInteractor<2>();
+    Particle<2> particles[100];
+    double corner[2] = {5, 5};
+    unsigned int cells[2] = {10, 10};
+    Initializers::cubic<2>(particles, Vector<double, 2>(corner), Vector<unsigned int, 2>(cells), 1.12);
+    Initializers::maxwellBoltzmann<2>(particles, 100, 0.5, 3);
+    TestUniverse* universe = new TestUniverse(particles);
+    universe->set_border_type(BORDER_TYPE::reflexive);
+    universe->registerInteractor(&lj_interactor);
+
+    std::promise<void> release;
+    RecordingConsumer fast;
+    RecordingConsumer slow(release.get_future().share());
+    std::map<unsigned long, Vector<double, 2>> expected;
+    {
+        StepPipeline<TestUniverse> pipeline(universe, 2);
+        pipeline.registerConsumer(&fast);
+        pipeline.registerConsumer(&slow);
+        pipeline.setPublishInterval(2);
+        std::thread simulation([&]() {
+            for(unsigned int step = 0; step < 100; step++) {
+                pipeline.step(0.001);
+                if(pipeline.getStepCount() % 2 == 0) {
+                    expected[pipeline.getStepCount()] = universe->getParticles()[0].getPosition();
+                }
+            }
+        });
+        // the slow consumer holds its first snapshot, so its queue fills up with the second one
+        // and the third publication waits for it
+        for(unsigned int poll = 0; poll < 10000 && pipeline.getStallCount() == 0; poll++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        assert(pipeline.getStallCount() >= 1);
+        // the waiting publication was not handed to the fast consumer either
+        assert(fast.getLastStep() <= 4);
+        release.set_value();
+        simulation.join();
+        // the future of a publication is ready once both consumers drew it
+        std::shared_future<void> done = pipeline.publish();
+        done.wait();
+        assert(slow.steps.back() == 100 && fast.steps.back() == 100);
+    }
+
+    // every consumer saw every snapshot, in order, with the particles of its step
+    assert(fast.steps.size() == 51 && slow.steps.size() == 51);
+    for(unsigned int i = 0; i < 50; i++) {
+        assert(fast.steps[i] == 2 * (i + 1));
+        assert(slow.steps[i] == 2 * (i + 1));
+        assert(fast.positions[2 * (i + 1)] == expected[2 * (i + 1)]);
+        assert(slow.positions[2 * (i + 1)] == expected[2 * (i + 1)]);
+    }
+    delete universe;
+}
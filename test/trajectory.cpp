@@ -0,0 +1,94 @@
+/// Unit tests for the compressed trajectory files: round trip, random access, compression, ids and interrupted runs.
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include "quark/trajectory/trajectory_writer.hpp"
+#include "quark/trajectory/trajectory_reader.hpp"
+
+const unsigned int PARTICLES = 1000;
+const unsigned int FRAMES = 200;
+const double PRECISION = 1e-4;
+/// ids of the particles, with gaps, as after absorptions
+const int FIRST_ID = 100000;
+
+/// particles on a lattice, oscillating around their site with a bit of noise, like a warm crystal
+std::vector<Particle<2>> generateFrame(unsigned int frame) {
+    std::default_random_engine rnd{frame};
+    std::normal_distribution<double> noise(0.0, 1e-4);
+    std::vector<Particle<2>> particles(PARTICLES);
+    for(unsigned int i = 0; i < PARTICLES; i++) {
+        double phase = 0.1 * i + 0.05 * frame;
+        double pos[2] = {(i % 40) * 1.12 + 0.1 * cos(phase) + noise(rnd), (i / 40) * 1.12 + 0.1 * sin(phase) + noise(rnd)};
+        double vel[2] = {-0.1 * sin(phase) + noise(rnd), 0.1 * cos(phase) + noise(rnd)};
+        particles[i] = Particle<2>(FIRST_ID + 3 * i, Vector<double, 2>(pos), Vector<double, 2>(vel), i < 500 ? 1.0 : 2.0);
+    }
+    return particles;
+}
+
+void checkFrame(const std::vector<Particle<2>>& read, unsigned int frame) {
+    std::vector<Particle<2>> expected = generateFrame(frame);
+    assert(read.size() == expected.size());
+    for(unsigned int i = 0; i < PARTICLES; i++) {
+        for(unsigned int dim = 0; dim < 2; dim++) {
+            assert(std::abs(read[i].getPosition()[dim] - expected[i].getPosition()[dim]) <= PRECISION * 0.5 + 1e-12);
+            assert(std::abs(read[i].getVelocity()[dim] - expected[i].getVelocity()[dim]) <= PRECISION * 0.5 + 1e-12);
+        }
+        assert(read[i].getMass() == expected[i].getMass());
+        assert(read[i].getId() == expected[i].getId());
+    }
+}
+
+int main() {
+    const char* file_name = "trajectory_test.qtrj";
+    uint64_t size;
+    {
+        TrajectoryWriter<2> writer(file_name, PRECISION, PRECISION, 50);
+        for(unsigned int frame = 0; frame < FRAMES; frame++) {
+            std::vector<Particle<2>> particles = generateFrame(frame);
+            writer.writeFrame(particles.data(), particles.size());
+        }
+        writer.close();
+        size = writer.getSize();
+    }
+
+    // at least 5 times smaller than the raw doubles
+    uint64_t raw_size = (uint64_t)FRAMES * PARTICLES * (2 * 2 + 1) * sizeof(double);
+    assert(size * 5 < raw_size);
+
+    // sequential and random access
+    TrajectoryReader<2> reader(file_name);
+    assert(reader.isOpen());
+    assert(reader.getFrameCount() == FRAMES);
+    std::vector<Particle<2>> particles;
+    for(unsigned int frame = 0; frame < FRAMES; frame++) {
+        assert(reader.readFrame(frame, particles));
+        checkFrame(particles, frame);
+    }
+    for(unsigned int frame: {137u, 3u, 199u, 50u, 49u, 51u}) {
+        assert(reader.readFrame(frame, particles));
+        checkFrame(particles, frame);
+    }
+    assert(!reader.readFrame(FRAMES, particles));
+
+    // the ids read back are never given to new particles
+    Particle<2> created(Vector<double, 2>(), Vector<double, 2>(), Vector<double, 2>(), 1.0);
+    assert(created.getId() > FIRST_ID + 3 * (int)(PARTICLES - 1));
+
+    // a run interrupted before writing the index can still be read
+    {
+        std::ifstream source(file_name, std::ios::binary);
+        std::vector<char> content((std::istreambuf_iterator<char>(source)), std::istreambuf_iterator<char>());
+        std::ofstream truncated("trajectory_test_truncated.qtrj", std::ios::binary);
+        truncated.write(content.data(), content.size() / 2);
+    }
+    TrajectoryReader<2> truncated_reader("trajectory_test_truncated.qtrj");
+    assert(truncated_reader.getFrameCount() > 0 && truncated_reader.getFrameCount() < FRAMES);
+    unsigned int last = truncated_reader.getFrameCount() - 1;
+    assert(truncated_reader.readFrame(last, particles));
+    checkFrame(particles, last);
+
+    std::remove(file_name);
+    std::remove("trajectory_test_truncated.qtrj");
+}
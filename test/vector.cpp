@@ -62,4 +62,37 @@ int main() {
 
     v_first.reset();
     assert(v_first == v_zero);
-}
\ No newline at end of file
+
+    // expressions are evaluated in one pass, without changing the results
+    double third[3] = {1, 2, 3};
+    Vector<double, 3> v_third(third);
+    Vector<double, 3> v_fused = (v_third + v_second * 2.0 - v_third / 2.0) * 0.5;
+    assert(v_fused[0] == (1 + 8 - 0.5) * 0.5);
+    assert(v_fused[1] == (2 + 10 - 1) * 0.5);
+    assert(v_fused[2] == (3 + 12 - 1.5) * 0.5);
+    assert(-(v_third - v_second) == v_second - v_third);
+    assert((v_second - v_third).sq_magnitude() == 27);
+
+    // a vector can appear on both sides of an assignment
+    v_fused = v_fused * 2 - v_fused;
+    assert(v_fused[0] == 4.25);
+    v_fused += v_third * 2;
+    assert(v_fused[0] == 6.25);
+    v_fused -= -v_third;
+    assert(v_fused[0] == 7.25);
+
+    // vectors stay the size of their elements
+    static_assert(sizeof(Vector<double, 3>) == 3 * sizeof(double));
+
+    // generator constructor
+    int counter = 0;
+    Vector<int, 3> v_generated([&]() { return counter++; });
+    assert(v_generated[0] == 0 && v_generated[1] == 1 && v_generated[2] == 2);
+
+    // concatenation
+    Vector<double, 6> v_concat = v_third << v_second;
+    for(unsigned int i = 0; i < 3; i++) {
+        assert(v_concat[i] == third[i]);
+        assert(v_concat[3 + i] == second[i]);
+    }
+}
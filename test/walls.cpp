@@ -0,0 +1,143 @@
+/// Unit tests for the wall kernels: sign and range of the forces, forces matching their potential, and walls in a universe.
+#include <cassert>
+#include <cmath>
+#include <vector>
+#include <functional>
+#include "quark/world/universe.hpp"
+#include "quark/world/walls/harmonic.hpp"
+#include "quark/world/walls/lennard_jones.hpp"
+#include "quark/world/walls/specular.hpp"
+
+/// runs the kernel of a wall on a single distance
+double wallForce(Wall& wall, double distance) {
+    double force;
+    wall.computeWallForces(&distance, &force, 1);
+    return force;
+}
+
+/// the wall pushes inward within its range, does nothing beyond, and its force is minus the derivative of the potential
+void checkWall(Wall& wall, const std::function<double(double)>& energy) {
+    double range = wall.getRange();
+    // a batch of distances gives the same forces as the distances one by one
+    std::vector<double> distances;
+    for(unsigned int i = 1; i <= 40; i++) {
+        distances.push_back(range * i / 20.0);
+    }
+    std::vector<double> forces(distances.size());
+    wall.computeWallForces(distances.data(), forces.data(), distances.size());
+    for(unsigned int i = 0; i < distances.size(); i++) {
+        assert(forces[i] == wallForce(wall, distances[i]));
+        if(distances[i] < range) {
+            assert(forces[i] > 0);
+        }
+        else {
+            assert(forces[i] == 0.0);
+        }
+    }
+    // central differences of the potential
+    const double h = 1e-6 * range;
+    for(unsigned int i = 1; i < 20; i++) {
+        double z = range * i / 20.0;
+        double derivative = (energy(z + h) - energy(z - h)) / (2 * h);
+        assert(std::abs(wallForce(wall, z) + derivative) < 1e-5 * std::max(1.0, std::abs(derivative)));
+    }
+    // the potential is cut where the force vanishes, so the force goes to zero at the range
+    assert(std::abs(wallForce(wall, range * (1 - 1e-6))) < 1e-4);
+}
+
+void testHarmonicWall() {
+    HarmonicWall wall(50.0, 0.8);
+    assert(wall.getRange() == 0.8);
+    checkWall(wall, [](double z) { return 0.5 * 50.0 * (0.8 - z) * (0.8 - z); });
+    // still pushing particles that went through the face
+    assert(wallForce(wall, -0.1) > wallForce(wall, 0.0));
+}
+
+void testLennardJonesMirrorWall() {
+    const double sigma = 1.5;
+    const double epsilon = 2.0;
+    LennardJonesMirrorWall wall(sigma, epsilon);
+    // cut at the minimum of the potential between the particle and its image
+    assert(std::abs(wall.getRange() - 0.5 * std::pow(2.0, 1.0 / 6.0) * sigma) < 1e-12);
+    // the image moves with the particle, so the potential of the particle is half the pair potential at twice the distance
+    checkWall(wall, [&](double z) {
+        double s6 = std::pow(sigma / (2 * z), 6);
+        return 0.5 * 4 * epsilon * (s6 * s6 - s6);
+    });
+    // particles that went through the face get a large but finite force
+    double through = wallForce(wall, -1.0);
+    assert(std::isfinite(through) && through > 0);
+}
+
+void testLennardJones93Wall() {
+    const double sigma = 1.2;
+    const double epsilon = 0.5;
+    LennardJones93Wall wall(sigma, epsilon);
+    assert(std::abs(wall.getRange() - std::pow(0.4, 1.0 / 6.0) * sigma) < 1e-12);
+    auto energy = [&](double z) { return epsilon * (2.0 / 15.0 * std::pow(sigma / z, 9) - std::pow(sigma / z, 3)); };
+    checkWall(wall, energy);
+    // beyond the minimum the 9-3 wall attracts, within a longer cutoff
+    LennardJones93Wall attractive(sigma, epsilon, 2.5 * sigma);
+    assert(attractive.getRange() == 2.5 * sigma);
+    assert(wallForce(attractive, 0.5 * sigma) > 0);
+    assert(wallForce(attractive, 1.5 * sigma) < 0);
+    assert(wallForce(attractive, 3.0 * sigma) == 0.0);
+    const double h = 1e-6;
+    double derivative = (energy(1.5 * sigma + h) - energy(1.5 * sigma - h)) / (2 * h);
+    assert(std::abs(wallForce(attractive, 1.5 * sigma) + derivative) < 1e-6);
+}
+
+void testSpecularWall() {
+    SpecularWall wall;
+    assert(wall.isSpecular());
+    assert(wall.getRange() == 0.0);
+    assert(wallForce(wall, 0.0) == 0.0);
+    assert(wallForce(wall, -0.5) == 0.0);
+}
+
+/// particles near the faces of a reflexive universe are pushed back inside, on both faces of each dimension,
+/// and the particles in the middle are left alone
+void testWallsInUniverse() {
+    typedef Universe<2, 5, 20.0, 2.5> WallUniverse;
+    double positions[5][2] = {{0.3, 10.0}, {19.7, 10.0}, {10.0, 0.3}, {10.0, 19.7}, {10.0, 10.0}};
+    double directions[5][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {0, 0}};
+    Particle<2> particles[5];
+    for(unsigned int i = 0; i < 5; i++) {
+        particles[i] = Particle<2>(Vector<double, 2>(positions[i]), Vector<double, 2>(), Vector<double, 2>(), 1.0);
+    }
+    HarmonicWall harmonic(10.0, 1.0);
+    LennardJonesMirrorWall mirror;
+    for(Wall* wall: std::vector<Wall*>{&harmonic, &mirror}) {
+        WallUniverse universe(particles);
+        universe.set_border_type(BORDER_TYPE::reflexive);
+        universe.setWall(wall);
+        universe.step(0.001);
+        for(unsigned int i = 0; i < 5; i++) {
+            Vector<double, 2> velocity = universe.getParticles()[i].getVelocity();
+            double along = velocity[0] * directions[i][0] + velocity[1] * directions[i][1];
+            double across = velocity[0] * directions[i][1] - velocity[1] * directions[i][0];
+            assert(i == 4 ? velocity[0] == 0.0 && velocity[1] == 0.0 : along > 0);
+            assert(across == 0.0);
+        }
+    }
+    // a hard wall mirrors back a particle that went through
+    double outside[2] = {0.05, 10.0};
+    double inward[2] = {-2.0, 0.0};
+    Particle<2> leaving[1] = {Particle<2>(Vector<double, 2>(outside), Vector<double, 2>(inward), Vector<double, 2>(), 1.0)};
+    Universe<2, 1, 20.0, 2.5> specular_universe(leaving);
+    SpecularWall specular;
+    specular_universe.set_border_type(BORDER_TYPE::reflexive);
+    specular_universe.setWall(&specular);
+    specular_universe.step(0.1);
+    assert(specular_universe.getParticles()[0].getPosition()[0] >= 0);
+    assert(specular_universe.getParticles()[0].getVelocity()[0] == 2.0);
+}
+
+int main() {
+    testHarmonicWall();
+    testLennardJonesMirrorWall();
+    testLennardJones93Wall();
+    testSpecularWall();
+    testWallsInUniverse();
+    return 0;
+}